@@ -61,6 +61,18 @@ IF (OONF_REMOVE_HELPTEXT)
     ADD_DEFINITIONS(-DREMOVE_HELPTEXT)
 ENDIF(OONF_REMOVE_HELPTEXT)
 
+IF (OONF_TIMER_WHEEL)
+    ADD_DEFINITIONS(-DOONF_TIMER_WHEEL)
+ENDIF(OONF_TIMER_WHEEL)
+
+IF (OONF_IO_URING)
+    ADD_DEFINITIONS(-DOONF_IO_URING)
+ENDIF(OONF_IO_URING)
+
+IF (OONF_CLASS_SLAB)
+    ADD_DEFINITIONS(-DOONF_CLASS_SLAB)
+ENDIF(OONF_CLASS_SLAB)
+
 # OS-specific compiler settings
 IF(ANDROID OR WIN32)
     # Android and windows don't compile well with c99
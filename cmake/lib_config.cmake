@@ -26,6 +26,18 @@ set (OONF_REMOVE_HELPTEXT false CACHE BOOL
 set (OONF_SANITIZE false CACHE BOOL
      "Activate the address sanitizer")
 
+# use hierarchical timer wheel instead of AVL tree for timer scheduler
+set (OONF_TIMER_WHEEL false CACHE BOOL
+     "Set if you want to use a hierarchical timer wheel for the timer scheduler")
+
+# use io_uring instead of epoll for the socket scheduler (Linux only)
+set (OONF_IO_URING false CACHE BOOL
+     "Set if you want to use io_uring for socket events, falls back to epoll if the kernel does not support it")
+
+# allocate memory class objects from page aligned slabs instead of calloc()
+set (OONF_CLASS_SLAB false CACHE BOOL
+     "Set if you want oonf_class to allocate objects from slabs and return empty slabs to the operating system")
+
 ######################################
 #### Install target configuration ####
 ######################################
@@ -0,0 +1,637 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "common/common_types.h"
+#include "common/list.h"
+#include "common/btree.h"
+
+/*! maximum number of entries of a page */
+#define BTREE_ORDER 32
+
+/*! a page (except the root) is rebalanced if it has less entries */
+#define BTREE_MIN_ENTRIES (BTREE_ORDER / 4)
+
+/*! maximum depth of a tree, enough for 2^32 nodes */
+#define BTREE_MAX_DEPTH 16
+
+/**
+ * A page of the btree. Leaf pages reference btree nodes, inner pages
+ * reference other pages. Each entry stores the smallest key (and its
+ * prefix) of the referenced node or subtree, so searching a page does
+ * not need to access the children.
+ */
+struct _btree_page {
+  /*! pointer to parent page, NULL for root */
+  struct _btree_page *parent;
+
+  /*! number of used entries */
+  uint32_t count;
+
+  /*! true if the entries are btree nodes */
+  bool leaf;
+
+  /*! prefixes of the keys */
+  struct btree_prefix prefix[BTREE_ORDER];
+
+  /*! smallest key of each entry */
+  const void *keys[BTREE_ORDER];
+
+  /*! pointers to btree nodes (leaf) or child pages */
+  void *ptrs[BTREE_ORDER];
+};
+
+static struct btree_node *_find_lower(const struct btree_tree *tree, const void *key);
+static void _get_prefix(const struct btree_tree *tree,
+    struct btree_prefix *prefix, const void *key);
+static struct _btree_page *_descend(const struct btree_tree *tree,
+    const void *key, const struct btree_prefix *prefix, bool upper, uint32_t *pos);
+static uint32_t _search(const struct btree_tree *tree, const struct _btree_page *page,
+    const void *key, const struct btree_prefix *prefix, bool upper);
+static void _page_insert(struct btree_tree *tree, struct _btree_page *page,
+    uint32_t pos, const void *key, const struct btree_prefix *prefix, void *ptr,
+    struct _btree_page **spare, uint32_t *spare_count);
+static void _page_remove(struct btree_tree *tree, struct _btree_page *page, uint32_t pos);
+static void _move_entries(struct _btree_page *dst, uint32_t dst_pos,
+    struct _btree_page *src, uint32_t src_pos, uint32_t count);
+static void _update_min(struct _btree_page *page);
+static uint32_t _index_of(const struct _btree_page *page, const void *ptr);
+
+/**
+ * Initialize a new btree struct
+ * @param tree pointer to btree
+ * @param comp pointer to comparator for the tree
+ * @param allow_dups true if the tree allows multiple
+ *   elements with the same
+ */
+void
+btree_init(struct btree_tree *tree,
+    int (*comp) (const void *k1, const void *k2),
+    bool allow_dups)
+{
+  list_init_head(&tree->list_head);
+  tree->_root = NULL;
+  tree->count = 0;
+  tree->comp = comp;
+  tree->prefix = NULL;
+  tree->allow_dups = allow_dups;
+}
+
+/**
+ * Finds a node in a btree with a certain key. If the tree
+ * contains multiple nodes with this key, the first one is returned.
+ * @param tree pointer to btree
+ * @param key pointer to key
+ * @return pointer to btree-node with key, NULL if no node with
+ *    this key exists.
+ */
+struct btree_node *
+btree_find(const struct btree_tree *tree, const void *key)
+{
+  struct btree_node *node;
+
+  node = _find_lower(tree, key);
+  if (node == NULL || tree->comp(key, node->key) != 0) {
+    return NULL;
+  }
+  return node;
+}
+
+/**
+ * Finds the first node in a btree with a key greater or equal
+ * than the specified key
+ * @param tree pointer to btree
+ * @param key pointer to specified key
+ * @return pointer to btree-node, NULL if no node with
+ *    key greater or equal specified key exists.
+ */
+struct btree_node *
+btree_find_greaterequal(const struct btree_tree *tree, const void *key)
+{
+  return _find_lower(tree, key);
+}
+
+/**
+ * Finds the last node in a btree with a key less or equal
+ * than the specified key
+ * @param tree pointer to btree
+ * @param key pointer to specified key
+ * @return pointer to btree-node, NULL if no node with
+ *    key less or equal specified key exists.
+ */
+struct btree_node *
+btree_find_lessequal(const struct btree_tree *tree, const void *key)
+{
+  struct btree_prefix prefix;
+  struct _btree_page *leaf;
+  uint32_t pos;
+
+  _get_prefix(tree, &prefix, key);
+  leaf = _descend(tree, key, &prefix, true, &pos);
+  if (leaf == NULL || pos == 0) {
+    /* all keys in the tree are larger */
+    return NULL;
+  }
+  return leaf->ptrs[pos-1];
+}
+
+/**
+ * Inserts a btree_node into a tree. Nodes with the same key
+ * are stored in the order of insertion.
+ * @param tree pointer to tree
+ * @param new pointer to node
+ * @return 0 if node was inserted successfully, -1 if it was not inserted
+ *   because of a key collision or because memory ran out
+ */
+int
+btree_insert(struct btree_tree *tree, struct btree_node *new)
+{
+  struct _btree_page *spare[BTREE_MAX_DEPTH], *leaf, *page;
+  struct btree_node *next;
+  struct btree_prefix prefix;
+  uint32_t spare_count, needed, pos;
+
+  _get_prefix(tree, &prefix, new->key);
+
+  if (!tree->allow_dups && btree_find(tree, new->key) != NULL) {
+    return -1;
+  }
+
+  leaf = _descend(tree, new->key, &prefix, true, &pos);
+
+  /* allocate all pages a split might need before changing the tree */
+  needed = 0;
+  for (page = leaf; page != NULL && page->count == BTREE_ORDER; page = page->parent) {
+    needed++;
+  }
+  if (page == NULL) {
+    /* new root page */
+    needed++;
+  }
+  if (needed > BTREE_MAX_DEPTH) {
+    return -1;
+  }
+  for (spare_count = 0; spare_count < needed; spare_count++) {
+    spare[spare_count] = calloc(1, sizeof(struct _btree_page));
+    if (spare[spare_count] == NULL) {
+      while (spare_count > 0) {
+        free(spare[--spare_count]);
+      }
+      return -1;
+    }
+  }
+
+  if (leaf == NULL) {
+    /* first node of the tree */
+    leaf = spare[--spare_count];
+    leaf->leaf = true;
+    tree->_root = leaf;
+    pos = 0;
+
+    list_add_tail(&tree->list_head, &new->list);
+  }
+  else if (pos < leaf->count) {
+    next = leaf->ptrs[pos];
+    list_add_before(&next->list, &new->list);
+  }
+  else {
+    next = leaf->ptrs[pos-1];
+    list_add_after(&next->list, &new->list);
+  }
+
+  _page_insert(tree, leaf, pos, new->key, &prefix, new, spare, &spare_count);
+  tree->count++;
+
+  while (spare_count > 0) {
+    free(spare[--spare_count]);
+  }
+  return 0;
+}
+
+/**
+ * Remove a btree_node from a btree. Does nothing if the node
+ * is not part of a tree.
+ * @param tree pointer to tree
+ * @param node pointer to node
+ */
+void
+btree_remove(struct btree_tree *tree, struct btree_node *node)
+{
+  struct _btree_page *leaf;
+
+  if (!list_is_node_added(&node->list)) {
+    return;
+  }
+
+  leaf = node->_leaf;
+  _page_remove(tree, leaf, _index_of(leaf, node));
+
+  list_remove(&node->list);
+  node->_leaf = NULL;
+  tree->count--;
+}
+
+/**
+ * Key prefix function for keys that are compared with memcmp()
+ * and are at least 16 bytes long (e.g. netaddr and os_route_key).
+ * @param prefix pointer to prefix buffer
+ * @param key pointer to key
+ */
+void
+btree_prefix_memcmp(struct btree_prefix *prefix, const void *key) {
+  const uint8_t *k = key;
+  int i;
+
+  prefix->high = 0;
+  prefix->low = 0;
+  for (i=0; i<8; i++) {
+    prefix->high = (prefix->high << 8) | k[i];
+    prefix->low = (prefix->low << 8) | k[i+8];
+  }
+}
+
+/**
+ * Find the first node with a key greater or equal than a key
+ * @param tree pointer to btree
+ * @param key pointer to key
+ * @return pointer to node, NULL if all keys are smaller
+ */
+static struct btree_node *
+_find_lower(const struct btree_tree *tree, const void *key) {
+  struct btree_prefix prefix;
+  struct _btree_page *leaf;
+  struct btree_node *last;
+  uint32_t pos;
+
+  _get_prefix(tree, &prefix, key);
+  leaf = _descend(tree, key, &prefix, false, &pos);
+  if (leaf == NULL) {
+    return NULL;
+  }
+  if (pos < leaf->count) {
+    return leaf->ptrs[pos];
+  }
+
+  /* first node of the next leaf */
+  last = leaf->ptrs[leaf->count - 1];
+  if (list_is_last(&tree->list_head, &last->list)) {
+    return NULL;
+  }
+  return container_of(last->list.next, struct btree_node, list);
+}
+
+/**
+ * Calculate the prefix of a key, all prefixes are zero if the
+ * tree has no prefix function.
+ * @param tree pointer to btree
+ * @param prefix pointer to prefix buffer
+ * @param key pointer to key
+ */
+static void
+_get_prefix(const struct btree_tree *tree,
+    struct btree_prefix *prefix, const void *key) {
+  if (tree->prefix) {
+    tree->prefix(prefix, key);
+  }
+  else {
+    prefix->high = 0;
+    prefix->low = 0;
+  }
+}
+
+/**
+ * Walk down the tree to the leaf that would contain a key
+ * @param tree pointer to btree
+ * @param key pointer to key
+ * @param prefix prefix of the key
+ * @param upper true to search the position behind all nodes with
+ *   the same key, false to search the position of the first one
+ * @param pos pointer to store the position within the leaf
+ * @return pointer to leaf, NULL if tree is empty
+ */
+static struct _btree_page *
+_descend(const struct btree_tree *tree, const void *key, const struct btree_prefix *prefix,
+    bool upper, uint32_t *pos) {
+  struct _btree_page *page;
+  uint32_t i;
+
+  page = tree->_root;
+  if (page == NULL) {
+    return NULL;
+  }
+
+  while (!page->leaf) {
+    /* last child whose smallest key is below (or equal to) the key */
+    i = _search(tree, page, key, prefix, upper);
+    page = page->ptrs[i > 0 ? i - 1 : 0];
+  }
+
+  *pos = _search(tree, page, key, prefix, upper);
+  return page;
+}
+
+/**
+ * Binary search within a page
+ * @param tree pointer to btree
+ * @param page pointer to page
+ * @param key pointer to key
+ * @param prefix prefix of the key
+ * @param upper true to find the first entry larger than the key,
+ *   false to find the first entry larger or equal
+ * @return index of entry, page->count if there is no such entry
+ */
+static uint32_t
+_search(const struct btree_tree *tree, const struct _btree_page *page,
+    const void *key, const struct btree_prefix *prefix, bool upper) {
+  uint32_t low, high, mid;
+  int diff;
+
+  low = 0;
+  high = page->count;
+  while (low < high) {
+    mid = (low + high) / 2;
+
+    if (prefix->high != page->prefix[mid].high) {
+      diff = prefix->high < page->prefix[mid].high ? -1 : 1;
+    }
+    else if (prefix->low != page->prefix[mid].low) {
+      diff = prefix->low < page->prefix[mid].low ? -1 : 1;
+    }
+    else {
+      diff = tree->comp(key, page->keys[mid]);
+    }
+
+    if (diff > 0 || (upper && diff == 0)) {
+      low = mid + 1;
+    }
+    else {
+      high = mid;
+    }
+  }
+  return low;
+}
+
+/**
+ * Insert an entry into a page, split the page if it is full.
+ * @param tree pointer to btree
+ * @param page pointer to page
+ * @param pos index for the new entry
+ * @param key smallest key of the entry
+ * @param prefix prefix of the key
+ * @param ptr pointer to btree node or page
+ * @param spare array of preallocated pages
+ * @param spare_count pointer to number of preallocated pages
+ */
+static void
+_page_insert(struct btree_tree *tree, struct _btree_page *page,
+    uint32_t pos, const void *key, const struct btree_prefix *prefix, void *ptr,
+    struct _btree_page **spare, uint32_t *spare_count) {
+  struct _btree_page *right, *root;
+  uint32_t half;
+
+  if (page->count == BTREE_ORDER) {
+    /* move upper half into a new page */
+    half = BTREE_ORDER / 2;
+
+    right = spare[--(*spare_count)];
+    right->leaf = page->leaf;
+    _move_entries(right, 0, page, half, BTREE_ORDER - half);
+
+    if (page->parent == NULL) {
+      root = spare[--(*spare_count)];
+      root->leaf = false;
+      root->prefix[0] = page->prefix[0];
+      root->keys[0] = page->keys[0];
+      root->ptrs[0] = page;
+      root->count = 1;
+      page->parent = root;
+      tree->_root = root;
+    }
+
+    _page_insert(tree, page->parent, _index_of(page->parent, page) + 1,
+        right->keys[0], &right->prefix[0], right, spare, spare_count);
+
+    if (pos > half) {
+      page = right;
+      pos -= half;
+    }
+  }
+
+  memmove(&page->prefix[pos+1], &page->prefix[pos], sizeof(page->prefix[0]) * (page->count - pos));
+  memmove(&page->keys[pos+1], &page->keys[pos], sizeof(page->keys[0]) * (page->count - pos));
+  memmove(&page->ptrs[pos+1], &page->ptrs[pos], sizeof(page->ptrs[0]) * (page->count - pos));
+
+  page->prefix[pos] = *prefix;
+  page->keys[pos] = key;
+  page->ptrs[pos] = ptr;
+  page->count++;
+
+  if (page->leaf) {
+    ((struct btree_node *)ptr)->_leaf = page;
+  }
+  else {
+    ((struct _btree_page *)ptr)->parent = page;
+  }
+
+  if (pos == 0) {
+    _update_min(page);
+  }
+}
+
+/**
+ * Remove an entry from a page, merge the page with a neighbor
+ * or take over an entry of the neighbor if it gets too small.
+ * @param tree pointer to btree
+ * @param page pointer to page
+ * @param pos index of entry
+ */
+static void
+_page_remove(struct btree_tree *tree, struct _btree_page *page, uint32_t pos) {
+  struct _btree_page *parent, *left, *right;
+  uint32_t idx;
+
+  page->count--;
+  memmove(&page->prefix[pos], &page->prefix[pos+1], sizeof(page->prefix[0]) * (page->count - pos));
+  memmove(&page->keys[pos], &page->keys[pos+1], sizeof(page->keys[0]) * (page->count - pos));
+  memmove(&page->ptrs[pos], &page->ptrs[pos+1], sizeof(page->ptrs[0]) * (page->count - pos));
+
+  parent = page->parent;
+  if (parent == NULL) {
+    if (page->count == 0) {
+      /* tree is empty */
+      tree->_root = NULL;
+      free(page);
+    }
+    else if (!page->leaf && page->count == 1) {
+      /* remove a level */
+      tree->_root = page->ptrs[0];
+      tree->_root->parent = NULL;
+      free(page);
+    }
+    return;
+  }
+
+  if (pos == 0) {
+    _update_min(page);
+  }
+
+  if (page->count >= BTREE_MIN_ENTRIES) {
+    return;
+  }
+
+  /* every page except the root has at least two entries, so there is a neighbor */
+  idx = _index_of(parent, page);
+  if (idx > 0) {
+    left = parent->ptrs[idx - 1];
+    right = page;
+  }
+  else {
+    left = page;
+    right = parent->ptrs[1];
+    idx = 1;
+  }
+
+  if (left->count + right->count <= BTREE_ORDER) {
+    /* merge right page into left one */
+    _move_entries(left, left->count, right, 0, right->count);
+    free(right);
+    _page_remove(tree, parent, idx);
+  }
+  else if (page == right) {
+    /* take over the last entry of the left neighbor */
+    _move_entries(right, 0, left, left->count - 1, 1);
+    _update_min(right);
+  }
+  else {
+    /* take over the first entry of the right neighbor */
+    _move_entries(left, left->count, right, 0, 1);
+    _update_min(right);
+  }
+}
+
+/**
+ * Move entries from one page to another one. The target
+ * page must have enough space, the moved entries are removed
+ * from the source page.
+ * @param dst pointer to target page
+ * @param dst_pos index of first entry in target page
+ * @param src pointer to source page
+ * @param src_pos index of first entry in source page
+ * @param count number of entries to move
+ */
+static void
+_move_entries(struct _btree_page *dst, uint32_t dst_pos,
+    struct _btree_page *src, uint32_t src_pos, uint32_t count) {
+  uint32_t i;
+
+  /* make room in target */
+  memmove(&dst->prefix[dst_pos + count], &dst->prefix[dst_pos], sizeof(dst->prefix[0]) * (dst->count - dst_pos));
+  memmove(&dst->keys[dst_pos + count], &dst->keys[dst_pos], sizeof(dst->keys[0]) * (dst->count - dst_pos));
+  memmove(&dst->ptrs[dst_pos + count], &dst->ptrs[dst_pos], sizeof(dst->ptrs[0]) * (dst->count - dst_pos));
+
+  memcpy(&dst->prefix[dst_pos], &src->prefix[src_pos], sizeof(dst->prefix[0]) * count);
+  memcpy(&dst->keys[dst_pos], &src->keys[src_pos], sizeof(dst->keys[0]) * count);
+  memcpy(&dst->ptrs[dst_pos], &src->ptrs[src_pos], sizeof(dst->ptrs[0]) * count);
+  dst->count += count;
+
+  /* close gap in source */
+  src->count -= count;
+  memmove(&src->prefix[src_pos], &src->prefix[src_pos + count], sizeof(src->prefix[0]) * (src->count - src_pos));
+  memmove(&src->keys[src_pos], &src->keys[src_pos + count], sizeof(src->keys[0]) * (src->count - src_pos));
+  memmove(&src->ptrs[src_pos], &src->ptrs[src_pos + count], sizeof(src->ptrs[0]) * (src->count - src_pos));
+
+  for (i=dst_pos; i<dst_pos + count; i++) {
+    if (dst->leaf) {
+      ((struct btree_node *)dst->ptrs[i])->_leaf = dst;
+    }
+    else {
+      ((struct _btree_page *)dst->ptrs[i])->parent = dst;
+    }
+  }
+}
+
+/**
+ * Propagate the smallest key of a page to its parents
+ * @param page pointer to page
+ */
+static void
+_update_min(struct _btree_page *page) {
+  struct _btree_page *parent;
+  uint32_t idx;
+
+  while (page->parent != NULL && page->count > 0) {
+    parent = page->parent;
+    idx = _index_of(parent, page);
+
+    parent->prefix[idx] = page->prefix[0];
+    parent->keys[idx] = page->keys[0];
+
+    if (idx != 0) {
+      return;
+    }
+    page = parent;
+  }
+}
+
+/**
+ * @param page pointer to page
+ * @param ptr pointer to btree node or page
+ * @return index of pointer within the page
+ */
+static uint32_t
+_index_of(const struct _btree_page *page, const void *ptr) {
+  uint32_t i;
+
+  for (i=0; i<page->count; i++) {
+    if (page->ptrs[i] == ptr) {
+      return i;
+    }
+  }
+
+  /* cannot happen */
+  return page->count;
+}
@@ -0,0 +1,513 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+
+#ifndef _BTREE_H
+#define _BTREE_H
+
+#include <stddef.h>
+
+#include "common/common_types.h"
+#include "list.h"
+#include "container_of.h"
+
+struct _btree_page;
+
+/**
+ * Prefix of a key that is stored inside the btree pages
+ */
+struct btree_prefix {
+  /*! first part of prefix */
+  uint64_t high;
+
+  /*! second part of prefix */
+  uint64_t low;
+};
+
+/**
+ * This element is a member of a btree. It must be contained in all
+ * larger structs that should be put into a tree.
+ */
+struct btree_node {
+  /**
+   * Linked list node for supporting easy iteration and multiple
+   * elments with the same key.
+   *
+   * this must be the first element of a btree_node to
+   * make casting for lists easier
+   */
+  struct list_entity list;
+
+  /**
+   * pointer to key of node
+   */
+  const void *key;
+
+  /**
+   * Pointer to the leaf page that references this node
+   */
+  struct _btree_page *_leaf;
+};
+
+/**
+ * This struct is the central management part of a btree.
+ * One of them is necessary for each btree.
+ *
+ * The tree stores the key pointers (and an optional 128 bit key prefix)
+ * of its nodes in arrays of BTREE_ORDER entries. A lookup only needs a
+ * few page accesses and, with a prefix function, rarely touches the
+ * nodes themselves.
+ */
+struct btree_tree {
+  /**
+   * Head of linked list node for supporting easy iteration
+   * and multiple elments with the same key.
+   */
+  struct list_entity list_head;
+
+  /**
+   * pointer to the root page of the btree, NULL if tree is empty
+   */
+  struct _btree_page *_root;
+
+  /**
+   * number of nodes in the btree
+   */
+  uint32_t count;
+
+  /**
+   * true if multiple nodes with the same key are
+   * allowed in the tree, false otherwise
+   */
+  bool allow_dups;
+
+  /**
+   * Prototype for btree comparators
+   * @param k1 first key
+   * @param k2 second key
+   * @return +1 if k1>k2, -1 if k1<k2, 0 if k1==k2
+   */
+  int (*comp)(const void *k1, const void *k2);
+
+  /**
+   * Optional function to calculate a 128 bit prefix of a key, can be
+   * set after btree_init() while the tree is empty.
+   * If prefix(k1) < prefix(k2) the comparator must return -1 for k1
+   * and k2, the comparator is only called for keys with the same
+   * prefix.
+   * @param prefix pointer to prefix buffer
+   * @param key pointer to key
+   */
+  void (*prefix)(struct btree_prefix *prefix, const void *key);
+};
+
+EXPORT void btree_init(struct btree_tree *,
+    int (*comp) (const void *k1, const void *k2), bool);
+EXPORT struct btree_node *btree_find(const struct btree_tree *, const void *);
+EXPORT struct btree_node *btree_find_greaterequal(const struct btree_tree *tree, const void *key);
+EXPORT struct btree_node *btree_find_lessequal(const struct btree_tree *tree, const void *key);
+EXPORT int btree_insert(struct btree_tree *, struct btree_node *);
+EXPORT void btree_remove(struct btree_tree *, struct btree_node *);
+
+EXPORT void btree_prefix_memcmp(struct btree_prefix *prefix, const void *key);
+
+/**
+ * @param tree pointer to btree
+ * @param node pointer to node of the tree
+ * @return true if node is the first one of the tree, false otherwise
+ */
+static INLINE bool
+btree_is_first(struct btree_tree *tree, struct btree_node *node) {
+  return tree->list_head.next == &node->list;
+}
+
+/**
+ * @param tree pointer to btree
+ * @param node pointer to node of the tree
+ * @return true if node is the last one of the tree, false otherwise
+ */
+static INLINE bool
+btree_is_last(struct btree_tree *tree, struct btree_node *node) {
+  return tree->list_head.prev == &node->list;
+}
+
+/**
+ * @param tree pointer to btree
+ * @return true if the tree is empty, false otherwise
+ */
+static INLINE bool
+btree_is_empty(struct btree_tree *tree) {
+  return tree->count == 0;
+}
+
+/**
+ * @param node pointer to btree node
+ * @return true if node is currently in a tree, false otherwise
+ */
+static INLINE bool
+btree_is_node_added(struct btree_node *node) {
+  return list_is_node_added(&node->list);
+}
+
+/**
+ * @param tree pointer to btree
+ * @param key pointer to key
+ * @param element pointer to a node element
+ *    (don't need to be initialized)
+ * @param node_element name of the btree_node element inside the
+ *    larger struct
+ * @return pointer to tree element with the specified key,
+ *    NULL if no element was found
+ */
+#define btree_find_element(tree, key, element, node_element) \
+  container_of_if_notnull(btree_find(tree, key), typeof(*(element)), node_element)
+
+/**
+ * @param tree pointer to btree
+ * @param key pointer to specified key
+ * @param element pointer to a node element
+ *    (don't need to be initialized)
+ * @param node_element name of the btree_node element inside the
+ *    larger struct
+ * return pointer to last tree element with less or equal key than specified key,
+ *    NULL if no element was found
+ */
+#define btree_find_le_element(tree, key, element, node_element) \
+  container_of_if_notnull(btree_find_lessequal(tree, key), typeof(*(element)), node_element)
+
+/**
+ * @param tree pointer to btree
+ * @param key pointer to specified key
+ * @param element pointer to a node element
+ *    (don't need to be initialized)
+ * @param node_element name of the btree_node element inside the
+ *    larger struct
+ * return pointer to first tree element with greater or equal key than specified key,
+ *    NULL if no element was found
+ */
+#define btree_find_ge_element(tree, key, element, node_element) \
+  container_of_if_notnull(btree_find_greaterequal(tree, key), typeof(*(element)), node_element)
+
+/**
+ * This function must not be called for an empty tree
+ *
+ * @param tree pointer to btree
+ * @param element pointer to a node element
+ *    (don't need to be initialized)
+ * @param node_member name of the btree_node element inside the
+ *    larger struct
+ * @return pointer to the first element of the btree
+ *    (automatically converted to type 'element')
+ */
+#define btree_first_element(tree, element, node_member) \
+  container_of((tree)->list_head.next, typeof(*(element)), node_member.list)
+
+/**
+ * @param tree pointer to btree
+ * @param element pointer to a node element
+ *    (don't need to be initialized)
+ * @param node_member name of the btree_node element inside the
+ *    larger struct
+ * @return pointer to the first element of the btree
+ *    (automatically converted to type 'element'),
+ *    NULL if tree is empty
+ */
+#define btree_first_element_safe(tree, element, node_member) \
+  (btree_is_empty(tree) ? NULL : btree_first_element(tree, element, node_member))
+
+/**
+ * This function must not be called for an empty tree
+ *
+ * @param tree pointer to tree
+ * @param element pointer to a node struct that contains the btree_node
+ *    (don't need to be initialized)
+ * @param node_member name of the btree_node element inside the
+ *    larger struct
+ * @return pointer to the last element of the btree
+ *    (automatically converted to type 'element')
+ */
+#define btree_last_element(tree, element, node_member) \
+  container_of((tree)->list_head.prev, typeof(*(element)), node_member.list)
+
+/**
+ * @param tree pointer to tree
+ * @param element pointer to a node struct that contains the btree_node
+ *    (don't need to be initialized)
+ * @param node_member name of the btree_node element inside the
+ *    larger struct
+ * @return pointer to the last element of the btree
+ *    (automatically converted to type 'element'),
+ *    NULL if tree is empty
+ */
+#define btree_last_element_safe(tree, element, node_member) \
+  (btree_is_empty(tree) ? NULL : btree_last_element(tree, element, node_member))
+
+/**
+ * This function must not be called for the last element of
+ * a btree
+ *
+ * @param element pointer to a node of the tree
+ * @param node_member name of the btree_node element inside the
+ *    larger struct
+ * @return pointer to the node after 'element'
+ *    (automatically converted to type 'element')
+ */
+#define btree_next_element(element, node_member) \
+  container_of((&(element)->node_member.list)->next, typeof(*(element)), node_member.list)
+
+/**
+ * @param tree pointer to btree
+ * @param element pointer to a node of the tree
+ * @param node_member name of the btree_node element inside the
+ *    larger struct
+ * @return pointer to the node after 'element'
+ *    (automatically converted to type 'element'),
+ *    NULL if there is no element after 'element' or
+ *    'element' is NULL
+ */
+#define btree_next_element_safe(tree, element, node_member) \
+  ((element) == NULL || btree_is_last(tree, &(element)->node_member) ? NULL : btree_next_element(element, node_member))
+
+/**
+ * This function must not be called for the first element of
+ * a btree
+ *
+ * @param element pointer to a node of the tree
+ * @param node_member name of the btree_node element inside the
+ *    larger struct
+ * @return pointer to the node before 'element'
+ *    (automatically converted to type 'element')
+ */
+#define btree_prev_element(element, node_member) \
+  container_of((&(element)->node_member.list)->prev, typeof(*(element)), node_member.list)
+
+/**
+ * @param tree pointer to btree
+ * @param element pointer to a node of the tree
+ * @param node_member name of the btree_node element inside the
+ *    larger struct
+ * @return pointer to the node before 'element'
+ *    (automatically converted to type 'element'),
+ *    NULL if there is no element before 'element' or
+ *    'element' is NULL
+ */
+#define btree_prev_element_safe(tree, element, node_member) \
+  ((element) == NULL || btree_is_first(tree, &(element)->node_member) ? NULL : btree_prev_element(element, node_member))
+
+/**
+ * Loop over a block of elements of a tree, used similar to a for() command.
+ * This loop should not be used if elements are removed from the tree during
+ * the loop.
+ *
+ * @param first pointer to first element of loop
+ * @param last pointer to last element of loop
+ * @param element pointer to a node of the tree, this element will
+ *    contain the current node of the list during the loop
+ * @param node_member name of the btree_node element inside the
+ *    larger struct
+ */
+#define btree_for_element_range(first, last, element, node_member) \
+  for (element = (first); \
+       element->node_member.list.prev != &(last)->node_member.list; \
+       element = btree_next_element(element, node_member))
+
+/**
+ * Loop over a block of elements of a tree backwards, used similar to a for() command.
+ * This loop should not be used if elements are removed from the tree during
+ * the loop.
+ *
+ * @param first pointer to first element of loop
+ * @param last pointer to last element of loop
+ * @param element pointer to a node of the tree, this element will
+ *    contain the current node of the list during the loop
+ * @param node_member name of the btree_node element inside the
+ *    larger struct
+ */
+#define btree_for_element_range_reverse(first, last, element, node_member) \
+  for (element = (last); \
+       element->node_member.list.next != &(first)->node_member.list; \
+       element = btree_prev_element(element, node_member))
+
+/**
+ * Loop over all elements of a btree, used similar to a for() command.
+ * This loop should not be used if elements are removed from the tree during
+ * the loop.
+ *
+ * @param tree pointer to btree
+ * @param element pointer to a node of the tree, this element will
+ *    contain the current node of the tree during the loop
+ * @param node_member name of the btree_node element inside the
+ *    larger struct
+ */
+#define btree_for_each_element(tree, element, node_member) \
+  btree_for_element_range(btree_first_element(tree, element, node_member), \
+                          btree_last_element(tree, element,  node_member), \
+                          element, node_member)
+
+/**
+ * Loop over all elements of a btree backwards, used similar to a for() command.
+ * This loop should not be used if elements are removed from the tree during
+ * the loop.
+ *
+ * @param tree pointer to btree
+ * @param element pointer to a node of the tree, this element will
+ *    contain the current node of the tree during the loop
+ * @param node_member name of the btree_node element inside the
+ *    larger struct
+ */
+#define btree_for_each_element_reverse(tree, element, node_member) \
+  btree_for_element_range_reverse(btree_first_element(tree, element, node_member), \
+                                  btree_last_element(tree, element,  node_member), \
+                                  element, node_member)
+
+/**
+ * Loop over a block of elements of a tree, used similar to a for() command.
+ * This loop should not be used if elements are removed from the tree during
+ * the loop.
+ * The loop runs from the element 'first' to the end of the tree.
+ *
+ * @param tree pointer to btree
+ * @param first pointer to first element of loop
+ * @param element pointer to a node of the tree, this element will
+ *    contain the current node of the list during the loop
+ * @param node_member name of the btree_node element inside the
+ *    larger struct
+ */
+#define btree_for_element_to_last(tree, first, element, node_member) \
+  btree_for_element_range(first, btree_last_element(tree, element, node_member), element, node_member)
+
+/**
+ * Loop over a block of elements of a tree with a certain key, used similar
+ * to a for() command.
+ * This loop should not be used if elements are removed from the tree during
+ * the loop.
+ *
+ * @param tree pointer to btree
+ * @param element pointer to a node of the tree, this element will
+ *    contain the current node of the list during the loop
+ * @param node_member name of the btree_node element inside the
+ *    larger struct
+ * @param search_key pointer to key
+ */
+#define btree_for_each_elements_with_key(tree, element, node_member, search_key) \
+  for (element = btree_find_element(tree, search_key, element, node_member); \
+       element != NULL && &element->node_member.list != &(tree)->list_head \
+         && (tree)->comp(element->node_member.key, search_key) == 0; \
+       element = btree_next_element(element, node_member))
+
+/**
+ * Loop over a block of nodes of a tree, used similar to a for() command.
+ * This loop can be used if the current element might be removed from
+ * the tree during the loop. Other elements should not be removed during
+ * the loop.
+ *
+ * @param first_element first element of loop
+ * @param last_element last element of loop
+ * @param element iterator pointer to tree element struct
+ * @param node_member name of btree_node within tree element struct
+ * @param ptr pointer to tree element struct which is used to store
+ *    the next node during the loop
+ */
+#define btree_for_element_range_safe(first_element, last_element, element, node_member, ptr) \
+  for (element = (first_element), ptr = btree_next_element(element, node_member); \
+       element->node_member.list.prev != &(last_element)->node_member.list; \
+       element = ptr, ptr = btree_next_element(ptr, node_member))
+
+/**
+ * Loop over a block of elements of a tree backwards, used similar to a for() command.
+ * This loop can be used if the current element might be removed from
+ * the tree during the loop. Other elements should not be removed during
+ * the loop.
+ *
+ * @param first_element first element of range (will be last returned by the loop)
+ * @param last_element last element of range (will be first returned by the loop)
+ * @param element iterator pointer to node element struct
+ * @param node_member name of btree_node within node element struct
+ * @param ptr pointer to node element struct which is used to store
+ *    the previous node during the loop
+ */
+#define btree_for_element_range_reverse_safe(first_element, last_element, element, node_member, ptr) \
+  for (element = (last_element), ptr = btree_prev_element(element, node_member); \
+       element->node_member.list.next != &(first_element)->node_member.list; \
+       element = ptr, ptr = btree_prev_element(ptr, node_member))
+
+/**
+ * Loop over all elements of a btree, used similar to a for() command.
+ * This loop can be used if the current element might be removed from
+ * the tree during the loop. Other elements should not be removed during
+ * the loop.
+ *
+ * @param tree pointer to btree
+ * @param element pointer to a node of the tree, this element will
+ *    contain the current node of the tree during the loop
+ * @param node_member name of the btree_node element inside the
+ *    larger struct
+ * @param ptr pointer to a tree element which is used to store
+ *    the next node during the loop
+ */
+#define btree_for_each_element_safe(tree, element, node_member, ptr) \
+  btree_for_element_range_safe(btree_first_element(tree, element, node_member), \
+                               btree_last_element(tree, element, node_member), \
+                               element, node_member, ptr)
+
+/**
+ * Loop over all elements of a btree backwards, used similar to a for() command.
+ * This loop can be used if the current element might be removed from
+ * the tree during the loop. Other elements should not be removed during
+ * the loop.
+ *
+ * @param tree pointer to btree
+ * @param element pointer to a node of the tree, this element will
+ *    contain the current node of the tree during the loop
+ * @param node_member name of the btree_node element inside the
+ *    larger struct
+ * @param ptr pointer to a tree element which is used to store
+ *    the next node during the loop
+ */
+#define btree_for_each_element_reverse_safe(tree, element, node_member, ptr) \
+  btree_for_element_range_reverse_safe(btree_first_element(tree, element, node_member), \
+                                       btree_last_element(tree, element, node_member), \
+                                       element, node_member, ptr)
+
+#endif /* _BTREE_H */
@@ -0,0 +1,128 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+
+#ifndef LATENCY_HISTOGRAM_H_
+#define LATENCY_HISTOGRAM_H_
+
+#include <string.h>
+
+#include "common/common_types.h"
+
+/*! number of buckets of a latency histogram */
+#define LATENCY_HISTOGRAM_BUCKETS 20
+
+/**
+ * Statistics of the runtime of a repeatedly called function.
+ *
+ * Bucket 0 counts calls below one microsecond, bucket i counts
+ * calls between 2^(i-1) and 2^i microseconds, the last bucket
+ * contains all longer calls.
+ */
+struct latency_histogram {
+  /*! number of recorded calls */
+  uint64_t count;
+
+  /*! sum of the runtime of all calls in nanoseconds */
+  uint64_t total;
+
+  /*! longest runtime of a call in nanoseconds */
+  uint64_t max;
+
+  /*! number of calls per logarithmic runtime bucket */
+  uint32_t bucket[LATENCY_HISTOGRAM_BUCKETS];
+};
+
+/**
+ * Reset a latency histogram
+ * @param hist pointer to histogram
+ */
+static INLINE void
+latency_histogram_clear(struct latency_histogram *hist) {
+  memset(hist, 0, sizeof(*hist));
+}
+
+/**
+ * Record the runtime of a call
+ * @param hist pointer to histogram
+ * @param duration runtime in nanoseconds
+ */
+static INLINE void
+latency_histogram_add(struct latency_histogram *hist, uint64_t duration) {
+  uint64_t usec;
+  int bucket;
+
+  hist->count++;
+  hist->total += duration;
+  if (duration > hist->max) {
+    hist->max = duration;
+  }
+
+  usec = duration / 1000;
+  for (bucket = 0; usec > 0 && bucket < LATENCY_HISTOGRAM_BUCKETS - 1; bucket++) {
+    usec >>= 1;
+  }
+  hist->bucket[bucket]++;
+}
+
+/**
+ * @param hist pointer to histogram
+ * @return average runtime of a call in nanoseconds, 0 if no call
+ *   was recorded
+ */
+static INLINE uint64_t
+latency_histogram_get_average(const struct latency_histogram *hist) {
+  return hist->count == 0 ? 0 : hist->total / hist->count;
+}
+
+/**
+ * @param bucket index of histogram bucket
+ * @return lowest runtime in microseconds counted in this bucket
+ */
+static INLINE uint64_t
+latency_histogram_get_lower_bound(int bucket) {
+  return bucket == 0 ? 0 : 1ull << (bucket - 1);
+}
+
+#endif /* LATENCY_HISTOGRAM_H_ */
@@ -0,0 +1,287 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "common/common_types.h"
+#include "common/list.h"
+#include "common/netaddr.h"
+#include "common/netaddr_hash.h"
+
+/*! number of buckets of a new hash table */
+#define NETADDR_HASH_MIN_SIZE 16
+
+/*! number of old buckets moved during each insert or remove */
+#define NETADDR_HASH_MIGRATE_STEP 8
+
+static struct netaddr_hash_node **_get_bucket(
+    const struct netaddr_hash *hash, uint32_t hashval);
+static void _grow(struct netaddr_hash *hash);
+static void _migrate(struct netaddr_hash *hash, uint32_t steps);
+static void _clear(struct netaddr_hash *hash);
+
+/**
+ * Initialize a new netaddr hash table
+ * @param hash pointer to netaddr hash
+ */
+void
+netaddr_hash_init(struct netaddr_hash *hash) {
+  memset(hash, 0, sizeof(*hash));
+  list_init_head(&hash->list_head);
+}
+
+/**
+ * Finds the node of a key in a netaddr hash
+ * @param hash pointer to netaddr hash
+ * @param key pointer to key
+ * @return pointer to hash node with key, NULL if no node with
+ *    this key exists
+ */
+struct netaddr_hash_node *
+netaddr_hash_find(const struct netaddr_hash *hash, const struct netaddr *key) {
+  struct netaddr_hash_node *node;
+  uint32_t hashval;
+
+  if (hash->count == 0) {
+    return NULL;
+  }
+
+  hashval = netaddr_hash_calculate(key);
+  for (node = *_get_bucket(hash, hashval); node != NULL; node = node->_next) {
+    if (node->_hash == hashval && memcmp(node->key, key, sizeof(*key)) == 0) {
+      return node;
+    }
+  }
+  return NULL;
+}
+
+/**
+ * Inserts a node into a netaddr hash. The key pointer of the
+ * node must be initialized.
+ * @param hash pointer to netaddr hash
+ * @param new pointer to node
+ * @return 0 if node was inserted, -1 if the key was already in the
+ *   hash or the hash table could not be allocated
+ */
+int
+netaddr_hash_insert(struct netaddr_hash *hash, struct netaddr_hash_node *new) {
+  struct netaddr_hash_node **bucket, *node;
+  uint32_t hashval;
+
+  if (hash->_buckets == NULL) {
+    hash->_buckets = calloc(NETADDR_HASH_MIN_SIZE, sizeof(*hash->_buckets));
+    if (hash->_buckets == NULL) {
+      return -1;
+    }
+    hash->_size = NETADDR_HASH_MIN_SIZE;
+  }
+  else {
+    _migrate(hash, NETADDR_HASH_MIGRATE_STEP);
+    if (hash->count >= hash->_size) {
+      _grow(hash);
+    }
+  }
+
+  hashval = netaddr_hash_calculate(new->key);
+  bucket = _get_bucket(hash, hashval);
+  for (node = *bucket; node != NULL; node = node->_next) {
+    if (node->_hash == hashval && memcmp(node->key, new->key, sizeof(*new->key)) == 0) {
+      return -1;
+    }
+  }
+
+  new->_hash = hashval;
+  new->_next = *bucket;
+  *bucket = new;
+
+  list_add_tail(&hash->list_head, &new->list);
+  hash->count++;
+  return 0;
+}
+
+/**
+ * Removes a node from a netaddr hash. Nothing happens if the
+ * node is not in the hash.
+ * @param hash pointer to netaddr hash
+ * @param node pointer to node
+ */
+void
+netaddr_hash_remove(struct netaddr_hash *hash, struct netaddr_hash_node *node) {
+  struct netaddr_hash_node **ptr;
+
+  if (!list_is_node_added(&node->list)) {
+    return;
+  }
+
+  for (ptr = _get_bucket(hash, node->_hash); *ptr != node; ptr = &(*ptr)->_next);
+  *ptr = node->_next;
+  node->_next = NULL;
+
+  list_remove(&node->list);
+  hash->count--;
+
+  if (hash->count == 0) {
+    _clear(hash);
+  }
+  else {
+    _migrate(hash, NETADDR_HASH_MIGRATE_STEP);
+  }
+}
+
+/**
+ * Calculate the hash value of a netaddr, including address type
+ * and prefix length
+ * @param key pointer to netaddr
+ * @return hash value
+ */
+uint32_t
+netaddr_hash_calculate(const struct netaddr *key) {
+  uint64_t words[2], hashval;
+
+  memcpy(words, key->_addr, sizeof(words));
+
+  hashval = words[0] * 0x9e3779b97f4a7c15ull;
+  hashval ^= (words[1] ^ ((uint64_t)key->_type << 8) ^ key->_prefix_len)
+      * 0xc2b2ae3d27d4eb4full;
+  hashval ^= hashval >> 29;
+  hashval *= 0x165667b19e3779f9ull;
+  hashval ^= hashval >> 32;
+  return (uint32_t)hashval;
+}
+
+/**
+ * Get the bucket a hash value belongs to. As long as an old bucket
+ * has not been moved into the new bucket array, its nodes (and new
+ * nodes with the same hash bits) stay in the old bucket.
+ * @param hash pointer to netaddr hash
+ * @param hashval hash value
+ * @return pointer to bucket
+ */
+static struct netaddr_hash_node **
+_get_bucket(const struct netaddr_hash *hash, uint32_t hashval) {
+  uint32_t idx;
+
+  if (hash->_old_buckets) {
+    idx = hashval & (hash->_old_size - 1);
+    if (idx >= hash->_migrated) {
+      return &hash->_old_buckets[idx];
+    }
+  }
+  return &hash->_buckets[hashval & (hash->_size - 1)];
+}
+
+/**
+ * Double the number of buckets. The nodes are moved into the new
+ * bucket array by the following calls of _migrate().
+ * Nothing happens if the new array cannot be allocated, the table
+ * just gets longer bucket chains.
+ * @param hash pointer to netaddr hash
+ */
+static void
+_grow(struct netaddr_hash *hash) {
+  struct netaddr_hash_node **buckets;
+
+  /* finish the last resize first */
+  _migrate(hash, hash->_old_size);
+
+  buckets = calloc(hash->_size * 2, sizeof(*buckets));
+  if (buckets == NULL) {
+    return;
+  }
+
+  hash->_old_buckets = hash->_buckets;
+  hash->_old_size = hash->_size;
+  hash->_migrated = 0;
+
+  hash->_buckets = buckets;
+  hash->_size *= 2;
+}
+
+/**
+ * Move a number of old buckets into the current bucket array
+ * @param hash pointer to netaddr hash
+ * @param steps maximum number of old buckets to move
+ */
+static void
+_migrate(struct netaddr_hash *hash, uint32_t steps) {
+  struct netaddr_hash_node *node, *next, **bucket;
+
+  while (hash->_old_buckets != NULL && steps > 0) {
+    for (node = hash->_old_buckets[hash->_migrated]; node != NULL; node = next) {
+      next = node->_next;
+
+      bucket = &hash->_buckets[node->_hash & (hash->_size - 1)];
+      node->_next = *bucket;
+      *bucket = node;
+    }
+
+    hash->_migrated++;
+    steps--;
+
+    if (hash->_migrated == hash->_old_size) {
+      free(hash->_old_buckets);
+      hash->_old_buckets = NULL;
+      hash->_old_size = 0;
+      hash->_migrated = 0;
+    }
+  }
+}
+
+/**
+ * Free the bucket arrays of an empty hash table
+ * @param hash pointer to netaddr hash
+ */
+static void
+_clear(struct netaddr_hash *hash) {
+  free(hash->_buckets);
+  free(hash->_old_buckets);
+
+  hash->_buckets = NULL;
+  hash->_size = 0;
+  hash->_old_buckets = NULL;
+  hash->_old_size = 0;
+  hash->_migrated = 0;
+}
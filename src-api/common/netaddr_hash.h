@@ -0,0 +1,183 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+
+#ifndef NETADDR_HASH_H_
+#define NETADDR_HASH_H_
+
+#include "common/common_types.h"
+#include "common/container_of.h"
+#include "common/list.h"
+#include "common/netaddr.h"
+
+/**
+ * This element is a member of a netaddr hash table. It must be
+ * contained in all larger structs that should be put into a hash.
+ */
+struct netaddr_hash_node {
+  /**
+   * Linked list node for supporting easy iteration,
+   * the elements are kept in insertion order
+   */
+  struct list_entity list;
+
+  /**
+   * pointer to key of node
+   */
+  const struct netaddr *key;
+
+  /*! next node in the same bucket */
+  struct netaddr_hash_node *_next;
+
+  /*! cached hash of key */
+  uint32_t _hash;
+};
+
+/**
+ * Hash table for exact-match lookups of netaddr keys. All keys in
+ * a table must be unique.
+ *
+ * When the table grows, the nodes are moved into the larger bucket
+ * array a few buckets at a time during the following inserts and
+ * removals, so no single operation has to rehash the whole table.
+ */
+struct netaddr_hash {
+  /**
+   * Head of linked list node for supporting easy iteration
+   */
+  struct list_entity list_head;
+
+  /**
+   * number of nodes in the hash table
+   */
+  uint32_t count;
+
+  /*! bucket array, NULL if table is empty */
+  struct netaddr_hash_node **_buckets;
+
+  /*! number of buckets, always a power of two */
+  uint32_t _size;
+
+  /*! bucket array that is still moved into _buckets, NULL if none */
+  struct netaddr_hash_node **_old_buckets;
+
+  /*! number of old buckets */
+  uint32_t _old_size;
+
+  /*! first old bucket that has not been moved yet */
+  uint32_t _migrated;
+};
+
+EXPORT void netaddr_hash_init(struct netaddr_hash *);
+EXPORT struct netaddr_hash_node *netaddr_hash_find(
+    const struct netaddr_hash *, const struct netaddr *key);
+EXPORT int netaddr_hash_insert(struct netaddr_hash *, struct netaddr_hash_node *);
+EXPORT void netaddr_hash_remove(struct netaddr_hash *, struct netaddr_hash_node *);
+EXPORT uint32_t netaddr_hash_calculate(const struct netaddr *key);
+
+/**
+ * @param hash pointer to netaddr hash
+ * @return true if the hash table is empty, false otherwise
+ */
+static INLINE bool
+netaddr_hash_is_empty(struct netaddr_hash *hash) {
+  return hash->count == 0;
+}
+
+/**
+ * @param node pointer to netaddr hash node
+ * @return true if node is currently in a hash table, false otherwise
+ */
+static INLINE bool
+netaddr_hash_is_node_added(struct netaddr_hash_node *node) {
+  return list_is_node_added(&node->list);
+}
+
+/**
+ * @param hash pointer to netaddr hash
+ * @param key pointer to key
+ * @param element pointer to a node element
+ *    (don't need to be initialized)
+ * @param node_element name of the netaddr_hash_node element inside the
+ *    larger struct
+ * @return pointer to hash element with the specified key,
+ *    NULL if no element was found
+ */
+#define netaddr_hash_find_element(hash, key, element, node_element) \
+  container_of_if_notnull(netaddr_hash_find(hash, key), typeof(*(element)), node_element)
+
+/**
+ * Loop over all elements of a netaddr hash in insertion order,
+ * used similar to a for() command.
+ * This loop should not be used if elements are removed from the hash
+ * during the loop.
+ *
+ * @param hash pointer to netaddr hash
+ * @param element pointer to a node of the hash, this element will
+ *    contain the current node of the hash during the loop
+ * @param node_member name of the netaddr_hash_node element inside the
+ *    larger struct
+ */
+#define netaddr_hash_for_each_element(hash, element, node_member) \
+  list_for_each_element(&(hash)->list_head, element, node_member.list)
+
+/**
+ * Loop over all elements of a netaddr hash in insertion order,
+ * used similar to a for() command.
+ * This loop can be used if the current element might be removed from
+ * the hash during the loop. Other elements should not be removed during
+ * the loop.
+ *
+ * @param hash pointer to netaddr hash
+ * @param element pointer to a node of the hash, this element will
+ *    contain the current node of the hash during the loop
+ * @param node_member name of the netaddr_hash_node element inside the
+ *    larger struct
+ * @param ptr pointer to a hash element which is used to store
+ *    the next node during the loop
+ */
+#define netaddr_hash_for_each_element_safe(hash, element, node_member, ptr) \
+  list_for_each_element_safe(&(hash)->list_head, element, node_member.list, ptr)
+
+#endif /* NETADDR_HASH_H_ */
@@ -0,0 +1,351 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+
+#include <string.h>
+
+#include "common/common_types.h"
+#include "common/list.h"
+#include "common/timer_wheel.h"
+
+static void _insert(struct timer_wheel *wheel, struct timer_wheel_node *node);
+static bool _find_next_slot(struct timer_wheel *wheel, unsigned *level, unsigned *slot);
+static uint64_t _get_slot_start(struct timer_wheel *wheel, unsigned level, unsigned slot);
+static void _cascade(struct timer_wheel *wheel, unsigned level, unsigned slot);
+static struct timer_wheel_node *_get_first_of_slots(struct timer_wheel *wheel, unsigned idx);
+
+/**
+ * Initialize a new timer wheel
+ * @param wheel pointer to timer wheel
+ * @param granularity length of a tick in units of the key
+ * @param now current value of the key
+ */
+void
+timer_wheel_init(struct timer_wheel *wheel, uint64_t granularity, uint64_t now) {
+  unsigned l, s;
+
+  memset(wheel, 0, sizeof(*wheel));
+  for (l = 0; l < TIMER_WHEEL_LEVELS; l++) {
+    for (s = 0; s < TIMER_WHEEL_SLOTS; s++) {
+      list_init_head(&wheel->_slots[l][s]);
+    }
+  }
+
+  wheel->granularity = granularity;
+  wheel->_current = now / granularity;
+}
+
+/**
+ * Add a node to a timer wheel. The node must not be part of a wheel.
+ * @param wheel pointer to timer wheel
+ * @param node pointer to node
+ * @param key absolute key of node
+ */
+void
+timer_wheel_add(struct timer_wheel *wheel, struct timer_wheel_node *node, uint64_t key) {
+  node->key = key;
+  node->_tick = key / wheel->granularity;
+
+  _insert(wheel, node);
+
+  if (wheel->count == 0) {
+    wheel->_next = node;
+  }
+  else if (wheel->_next != NULL && node->_tick < wheel->_next->_tick) {
+    wheel->_next = node;
+  }
+  wheel->count++;
+}
+
+/**
+ * Remove a node from a timer wheel
+ * @param wheel pointer to timer wheel
+ * @param node pointer to node
+ */
+void
+timer_wheel_remove(struct timer_wheel *wheel, struct timer_wheel_node *node) {
+  struct list_entity *head;
+  unsigned level, slot;
+
+  level = node->_slot / TIMER_WHEEL_SLOTS;
+  slot = node->_slot % TIMER_WHEEL_SLOTS;
+  head = &wheel->_slots[level][slot];
+
+  list_remove(&node->_node);
+  if (list_is_empty(head)) {
+    wheel->_used[level] &= ~(1ull << slot);
+  }
+
+  if (wheel->_next == node) {
+    wheel->_next = NULL;
+  }
+  wheel->count--;
+}
+
+/**
+ * @param wheel pointer to timer wheel
+ * @return node with the smallest key, NULL if wheel is empty
+ */
+struct timer_wheel_node *
+timer_wheel_get_next(struct timer_wheel *wheel) {
+  struct timer_wheel_node *node, *first;
+  unsigned level, slot;
+
+  if (wheel->count == 0) {
+    return NULL;
+  }
+  if (wheel->_next) {
+    return wheel->_next;
+  }
+
+  if (!_find_next_slot(wheel, &level, &slot)) {
+    /* should not happen */
+    return NULL;
+  }
+
+  first = list_first_element(&wheel->_slots[level][slot], first, _node);
+  if (level > 0) {
+    /* higher level slots are not sorted */
+    list_for_each_element(&wheel->_slots[level][slot], node, _node) {
+      if (node->_tick < first->_tick) {
+        first = node;
+      }
+    }
+  }
+
+  wheel->_next = first;
+  return first;
+}
+
+/**
+ * Returns the node with the smallest key if it is not larger than
+ * the current key. This function advances the wheel to 'now'. The
+ * node is not removed from the wheel.
+ * @param wheel pointer to timer wheel
+ * @param now current value of the key
+ * @return expired node with the smallest key, NULL if no node expired
+ */
+struct timer_wheel_node *
+timer_wheel_get_expired(struct timer_wheel *wheel, uint64_t now) {
+  struct timer_wheel_node *node;
+  uint64_t now_tick, start;
+  unsigned level, slot;
+
+  now_tick = now / wheel->granularity;
+
+  while (_find_next_slot(wheel, &level, &slot)) {
+    start = _get_slot_start(wheel, level, slot);
+    if (start > now_tick) {
+      break;
+    }
+
+    wheel->_current = start;
+    if (level == 0) {
+      return list_first_element(&wheel->_slots[0][slot], node, _node);
+    }
+
+    /* move nodes of higher level slot to the lower levels */
+    _cascade(wheel, level, slot);
+  }
+
+  /* all slots up to the current key are empty */
+  if (now_tick > wheel->_current) {
+    wheel->_current = now_tick;
+  }
+  return NULL;
+}
+
+/**
+ * @param wheel pointer to timer wheel
+ * @return first node of the wheel in iteration order,
+ *    NULL if wheel is empty
+ */
+struct timer_wheel_node *
+timer_wheel_get_first_node(struct timer_wheel *wheel) {
+  return _get_first_of_slots(wheel, 0);
+}
+
+/**
+ * @param wheel pointer to timer wheel
+ * @param node pointer to node of the wheel
+ * @return next node of the wheel in iteration order,
+ *    NULL if node was the last one
+ */
+struct timer_wheel_node *
+timer_wheel_get_next_node(struct timer_wheel *wheel, struct timer_wheel_node *node) {
+  struct list_entity *head;
+
+  head = &wheel->_slots[node->_slot / TIMER_WHEEL_SLOTS][node->_slot % TIMER_WHEEL_SLOTS];
+  if (!list_is_last(head, &node->_node)) {
+    return list_next_element(node, _node);
+  }
+  return _get_first_of_slots(wheel, node->_slot + 1u);
+}
+
+/**
+ * Hook a node into the slot matching its tick
+ * @param wheel pointer to timer wheel
+ * @param node pointer to node
+ */
+static void
+_insert(struct timer_wheel *wheel, struct timer_wheel_node *node) {
+  uint64_t tick, diff;
+  unsigned level, slot;
+
+  /* nodes in the past go into the current slot */
+  tick = node->_tick < wheel->_current ? wheel->_current : node->_tick;
+
+  /* the highest bit that differs from the current tick selects the level */
+  diff = tick ^ wheel->_current;
+  level = diff == 0 ? 0 : (63u - (unsigned)__builtin_clzll(diff)) / TIMER_WHEEL_BITS;
+  slot = (tick >> (level * TIMER_WHEEL_BITS)) & (TIMER_WHEEL_SLOTS - 1);
+
+  node->_slot = level * TIMER_WHEEL_SLOTS + slot;
+  list_add_tail(&wheel->_slots[level][slot], &node->_node);
+  wheel->_used[level] |= 1ull << slot;
+}
+
+/**
+ * Find the slot containing the node with the smallest tick.
+ * On level 0 all nodes of a slot have the same tick, on higher
+ * levels the slot contains the smallest tick, but is not sorted.
+ * @param wheel pointer to timer wheel
+ * @param level pointer to level of slot, will be set by this function
+ * @param slot pointer to slot index, will be set by this function
+ * @return true if a slot was found, false if wheel is empty
+ */
+static bool
+_find_next_slot(struct timer_wheel *wheel, unsigned *level, unsigned *slot) {
+  uint64_t mask;
+  unsigned l, idx;
+
+  for (l = 0; l < TIMER_WHEEL_LEVELS; l++) {
+    if (wheel->_used[l] == 0) {
+      continue;
+    }
+
+    idx = (wheel->_current >> (l * TIMER_WHEEL_BITS)) & (TIMER_WHEEL_SLOTS - 1);
+    if (l == 0) {
+      /* current slot of level 0 is still pending */
+      mask = ~((1ull << idx) - 1);
+    }
+    else {
+      /* current slot of higher levels has already been cascaded */
+      mask = ~((2ull << idx) - 1);
+    }
+
+    mask &= wheel->_used[l];
+    if (mask) {
+      *level = l;
+      *slot = (unsigned)__builtin_ctzll(mask);
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * @param wheel pointer to timer wheel
+ * @param level level of slot
+ * @param slot slot index
+ * @return first tick covered by the slot
+ */
+static uint64_t
+_get_slot_start(struct timer_wheel *wheel, unsigned level, unsigned slot) {
+  unsigned shift;
+  uint64_t base;
+
+  shift = (level + 1) * TIMER_WHEEL_BITS;
+  base = shift >= 64 ? 0 : (wheel->_current & ~((1ull << shift) - 1));
+
+  return base | ((uint64_t)slot << (level * TIMER_WHEEL_BITS));
+}
+
+/**
+ * Redistribute all nodes of a slot to the lower levels
+ * @param wheel pointer to timer wheel
+ * @param level level of slot
+ * @param slot slot index
+ */
+static void
+_cascade(struct timer_wheel *wheel, unsigned level, unsigned slot) {
+  struct timer_wheel_node *node, *it;
+  struct list_entity tmp;
+
+  list_init_head(&tmp);
+  list_merge(&tmp, &wheel->_slots[level][slot]);
+  wheel->_used[level] &= ~(1ull << slot);
+
+  list_for_each_element_safe(&tmp, node, _node, it) {
+    list_remove(&node->_node);
+    _insert(wheel, node);
+  }
+}
+
+/**
+ * @param wheel pointer to timer wheel
+ * @param idx index of first slot (level * TIMER_WHEEL_SLOTS + slot)
+ *    to look at
+ * @return first node of the first non-empty slot starting at idx,
+ *    NULL if there is none
+ */
+static struct timer_wheel_node *
+_get_first_of_slots(struct timer_wheel *wheel, unsigned idx) {
+  struct timer_wheel_node *node;
+  uint64_t mask;
+  unsigned l, s;
+
+  for (l = idx / TIMER_WHEEL_SLOTS; l < TIMER_WHEEL_LEVELS; l++) {
+    mask = wheel->_used[l];
+    if (l == idx / TIMER_WHEEL_SLOTS) {
+      s = idx % TIMER_WHEEL_SLOTS;
+      mask &= ~((1ull << s) - 1);
+    }
+    if (mask) {
+      s = (unsigned)__builtin_ctzll(mask);
+      return list_first_element(&wheel->_slots[l][s], node, _node);
+    }
+  }
+  return NULL;
+}
@@ -0,0 +1,186 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+
+#ifndef TIMER_WHEEL_H_
+#define TIMER_WHEEL_H_
+
+#include "common/common_types.h"
+#include "common/container_of.h"
+#include "common/list.h"
+
+/*! number of bits of the tick consumed by each level of the wheel */
+#define TIMER_WHEEL_BITS   6
+
+/*! number of slots of a single wheel level */
+#define TIMER_WHEEL_SLOTS  (1 << TIMER_WHEEL_BITS)
+
+/*! number of levels necessary to cover a 64 bit tick counter */
+#define TIMER_WHEEL_LEVELS ((64 + TIMER_WHEEL_BITS - 1) / TIMER_WHEEL_BITS)
+
+/**
+ * This element is a member of a hierarchical timer wheel. It must be
+ * contained in all larger structs that should be put into a wheel.
+ */
+struct timer_wheel_node {
+  /*! hook into the slot list */
+  struct list_entity _node;
+
+  /*! absolute key (e.g. timestamp) of the node */
+  uint64_t key;
+
+  /*! key divided by the granularity of the wheel */
+  uint64_t _tick;
+
+  /*! index of slot (level * TIMER_WHEEL_SLOTS + slot) the node is stored in */
+  uint16_t _slot;
+};
+
+/**
+ * Hierarchical timer wheel. Each level splits the tick counter into
+ * TIMER_WHEEL_SLOTS slots, a node is stored on the lowest level that
+ * resolves the difference between its tick and the current tick of the
+ * wheel. Higher level slots are cascaded into the lower levels when the
+ * current tick of the wheel reaches them.
+ *
+ * All keys within the same granularity interval are considered equal,
+ * nodes with the same tick are returned in insertion order.
+ */
+struct timer_wheel {
+  /*! lists of nodes, one per slot */
+  struct list_entity _slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+
+  /*! bitmap of non-empty slots, one per level */
+  uint64_t _used[TIMER_WHEEL_LEVELS];
+
+  /*! tick the wheel has been advanced to */
+  uint64_t _current;
+
+  /*! cached node with the smallest key, NULL if unknown */
+  struct timer_wheel_node *_next;
+
+  /*! length of a tick in units of the key */
+  uint64_t granularity;
+
+  /*! number of nodes in the wheel */
+  uint32_t count;
+};
+
+EXPORT void timer_wheel_init(struct timer_wheel *wheel, uint64_t granularity, uint64_t now);
+EXPORT void timer_wheel_add(struct timer_wheel *wheel, struct timer_wheel_node *node, uint64_t key);
+EXPORT void timer_wheel_remove(struct timer_wheel *wheel, struct timer_wheel_node *node);
+EXPORT struct timer_wheel_node *timer_wheel_get_next(struct timer_wheel *wheel);
+EXPORT struct timer_wheel_node *timer_wheel_get_expired(struct timer_wheel *wheel, uint64_t now);
+EXPORT struct timer_wheel_node *timer_wheel_get_first_node(struct timer_wheel *wheel);
+EXPORT struct timer_wheel_node *timer_wheel_get_next_node(
+    struct timer_wheel *wheel, struct timer_wheel_node *node);
+
+/**
+ * @param wheel pointer to timer wheel
+ * @return true if the wheel is empty, false otherwise
+ */
+static INLINE bool
+timer_wheel_is_empty(struct timer_wheel *wheel) {
+  return wheel->count == 0;
+}
+
+/**
+ * @param node pointer to timer wheel node
+ * @return true if node is currently in a wheel, false otherwise
+ */
+static INLINE bool
+timer_wheel_is_node_added(struct timer_wheel_node *node) {
+  return list_is_node_added(&node->_node);
+}
+
+/**
+ * @param wheel pointer to timer wheel
+ * @param element pointer to a node element
+ *    (don't need to be initialized)
+ * @param node_member name of the timer_wheel_node element inside the
+ *    larger struct
+ * @return pointer to the element with the smallest key,
+ *    NULL if the wheel is empty
+ */
+#define timer_wheel_next_element(wheel, element, node_member) \
+  container_of_if_notnull(timer_wheel_get_next(wheel), typeof(*(element)), node_member)
+
+/**
+ * @param wheel pointer to timer wheel
+ * @param now current value of the key
+ * @param element pointer to a node element
+ *    (don't need to be initialized)
+ * @param node_member name of the timer_wheel_node element inside the
+ *    larger struct
+ * @return pointer to the element with the smallest key if it is
+ *    not larger than 'now', NULL otherwise
+ */
+#define timer_wheel_expired_element(wheel, now, element, node_member) \
+  container_of_if_notnull(timer_wheel_get_expired(wheel, now), typeof(*(element)), node_member)
+
+/**
+ * Loop over all elements of a timer wheel (not sorted by key),
+ * used similar to a for() command.
+ * This loop can be used if the current element might be removed from
+ * the wheel during the loop. Other elements should not be removed during
+ * the loop.
+ *
+ * @param wheel pointer to timer wheel
+ * @param element pointer to a node of the wheel, this element will
+ *    contain the current node of the wheel during the loop
+ * @param node_member name of the timer_wheel_node element inside the
+ *    larger struct
+ * @param ptr pointer to a node element
+ *    (don't need to be initialized)
+ */
+#define timer_wheel_for_each_element_safe(wheel, element, node_member, ptr) \
+  for (element = container_of_if_notnull(timer_wheel_get_first_node(wheel), typeof(*(element)), node_member), \
+       ptr = element == NULL ? NULL : container_of_if_notnull( \
+           timer_wheel_get_next_node(wheel, &(element)->node_member), typeof(*(element)), node_member); \
+       element != NULL; \
+       element = ptr, \
+       ptr = element == NULL ? NULL : container_of_if_notnull( \
+           timer_wheel_get_next_node(wheel, &(element)->node_member), typeof(*(element)), node_member))
+
+#endif /* TIMER_WHEEL_H_ */
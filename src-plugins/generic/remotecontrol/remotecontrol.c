@@ -59,6 +59,8 @@
 #include "core/oonf_logging.h"
 #include "core/oonf_subsystem.h"
 #include "subsystems/oonf_class.h"
+#include "subsystems/oonf_packet_socket.h"
+#include "subsystems/oonf_socket.h"
 #include "subsystems/oonf_timer.h"
 #include "subsystems/oonf_telnet.h"
 #include "subsystems/os_routing.h"
@@ -106,6 +108,7 @@ static enum oonf_telnet_result _update_logfilter(struct oonf_telnet_data *data,
 
 static void _print_memory(struct autobuf *buf);
 static void _print_timer(struct autobuf *buf);
+static void _print_packet(struct autobuf *buf);
 
 static enum oonf_telnet_result _start_logging(struct oonf_telnet_data *data,
     struct _remotecontrol_session *rc_session);
@@ -139,6 +142,8 @@ static struct _remotecontrol_cfg _remotecontrol_config;
 /* plugin declaration */
 static const char *_dependencies[] = {
   OONF_CLASS_SUBSYSTEM,
+  OONF_PACKET_SUBSYSTEM,
+  OONF_SOCKET_SUBSYSTEM,
   OONF_TELNET_SUBSYSTEM,
   OONF_TIMER_SUBSYSTEM,
   OONF_OS_ROUTING_SUBSYSTEM,
@@ -162,7 +167,9 @@ DECLARE_OONF_PLUGIN(_oonf_remotecontrol_subsystem);
 static struct oonf_telnet_command _telnet_cmds[] = {
   TELNET_CMD("resources", _cb_handle_resource,
       "\"resources memory\": display information about memory usage\n"
-      "\"resources timer\": display information about active timers\n",
+      "\"resources timer\": display information about active timers\n"
+      "\"resources packet\": display receive and send statistics of packet sockets\n"
+      "\"resources socket\": display statistics of the socket scheduler\n",
       .acl = &_remotecontrol_config.acl),
   TELNET_CMD("log", _cb_handle_log,
       "\"log\":      continuous output of logging to this console\n"
@@ -257,12 +264,19 @@ _print_memory(struct autobuf *buf) {
 
   avl_for_each_element(oonf_class_get_tree(), c, _node) {
     abuf_appendf(buf, "%-25s (MEMORY) size: %"PRINTF_SIZE_T_SPECIFIER
-        " usage: %u freelist: %u allocations: %u/%u\n",
+        " usage: %u freelist: %u allocations: %u/%u"
+        " memory: %"PRINTF_SIZE_T_SPECIFIER" slabs: %u fragmentation: %u%%"
+        " changes: %u/%u\n",
         c->name, c->size,
         oonf_class_get_usage(c),
         oonf_class_get_free(c),
         oonf_class_get_allocations(c),
-        oonf_class_get_recycled(c));
+        oonf_class_get_recycled(c),
+        oonf_class_get_memory(c),
+        oonf_class_get_slabs(c),
+        oonf_class_get_fragmentation(c),
+        oonf_class_get_change_events(c),
+        oonf_class_get_suppressed_events(c));
   }
 }
 
@@ -280,6 +294,52 @@ _print_timer(struct autobuf *buf) {
   }
 }
 
+/**
+ * Print receive and send statistics of packet sockets
+ * @param buf output buffer
+ */
+static void
+_print_packet(struct autobuf *buf) {
+  struct oonf_packet_socket *p;
+  struct netaddr_str nbuf;
+  int i;
+
+  list_for_each_element(oonf_packet_get_list(), p, node) {
+    abuf_appendf(buf, "%-25s (PACKET) if: %s events: %u syscalls: %u packets: %u max_batch: %u batches:",
+        netaddr_socket_to_string(&nbuf, &p->local_socket),
+        p->os_if != NULL ? p->os_if->name : "any",
+        p->stats.rx_events, p->stats.rx_syscalls,
+        p->stats.rx_packets, p->stats.rx_max_batch);
+    for (i=0; i<OONF_PACKET_BATCH_HISTOGRAM; i++) {
+      abuf_appendf(buf, "%c%u", i == 0 ? ' ' : '/', p->stats.rx_batch[i]);
+    }
+    abuf_appendf(buf, "\n%-25s tx_packets: %u tx_syscalls: %u queued: %u queue: %u/%u max_queue: %u dropped: %u errors: %u\n",
+        "", p->stats.tx_packets, p->stats.tx_syscalls, p->stats.tx_queued,
+        oonf_packet_get_send_queue_depth(p), p->config.send_queue,
+        p->stats.tx_max_queue, p->stats.tx_dropped, p->stats.tx_errors);
+  }
+}
+
+/**
+ * Print statistics of the socket scheduler
+ * @param buf output buffer
+ */
+static void
+_print_socket(struct autobuf *buf) {
+  const struct oonf_socket_statistics *stats;
+  int i;
+
+  stats = oonf_socket_get_statistics();
+  abuf_appendf(buf, "wakeups: %u timeouts: %u events: %u max_events: %u"
+      " full: %u array: %d histogram:",
+      stats->wakeups, stats->timeouts, stats->events, stats->max_events,
+      stats->full, oonf_socket_get_event_array_size());
+  for (i=0; i<OONF_SOCKET_EVENT_HISTOGRAM; i++) {
+    abuf_appendf(buf, "%c%u", i == 0 ? ' ' : '/', stats->histogram[i]);
+  }
+  abuf_puts(buf, "\n");
+}
+
 /**
  * Handle resource command
  * @param data pointer to telnet data
@@ -296,6 +356,16 @@ _cb_handle_resource(struct oonf_telnet_data *data) {
     abuf_puts(data->out, "\nTimer cookies:\n");
     _print_timer(data->out);
   }
+
+  if (data->parameter == NULL || strcasecmp(data->parameter, "packet") == 0) {
+    abuf_puts(data->out, "\nPacket sockets:\n");
+    _print_packet(data->out);
+  }
+
+  if (data->parameter == NULL || strcasecmp(data->parameter, "socket") == 0) {
+    abuf_puts(data->out, "\nSocket scheduler:\n");
+    _print_socket(data->out);
+  }
   return TELNET_RESULT_ACTIVE;
 }
 
@@ -0,0 +1,463 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+
+#include <stdio.h>
+
+#include "common/common_types.h"
+#include "common/autobuf.h"
+#include "common/isonumber.h"
+#include "common/latency_histogram.h"
+#include "common/list.h"
+#include "common/string.h"
+#include "common/template.h"
+
+#include "core/oonf_logging.h"
+#include "core/oonf_subsystem.h"
+#include "subsystems/oonf_socket.h"
+#include "subsystems/oonf_telnet.h"
+#include "subsystems/oonf_timer.h"
+#include "subsystems/oonf_viewer.h"
+
+#include "schedulerinfo/schedulerinfo.h"
+
+/* definitions */
+#define LOG_SCHEDULERINFO _oonf_schedulerinfo_subsystem.logging
+
+/*! telnet parameter to reset all statistics */
+#define RESET_PARAMETER "reset"
+
+/**
+ * Buffer for a latency histogram in text form
+ */
+struct _histogram_str {
+  /*! buffer for bucket counters separated by '/' */
+  char buf[LATENCY_HISTOGRAM_BUCKETS * 11];
+};
+
+/* prototypes */
+static int _init(void);
+static void _cleanup(void);
+
+static enum oonf_telnet_result _cb_schedulerinfo(struct oonf_telnet_data *con);
+static enum oonf_telnet_result _cb_schedulerinfo_help(struct oonf_telnet_data *con);
+
+static const char *_time_to_string(struct isonumber_str *buf,
+    uint64_t duration, bool raw);
+static void _initialize_profile_values(struct oonf_viewer_template *template,
+    const struct latency_histogram *profile);
+static void _initialize_timer_values(struct oonf_viewer_template *template,
+    struct oonf_timer_class *tclass);
+static void _initialize_socket_values(struct oonf_viewer_template *template,
+    struct oonf_socket_entry *entry);
+static void _initialize_loop_values(struct oonf_viewer_template *template);
+
+static int _cb_create_text_timer(struct oonf_viewer_template *);
+static int _cb_create_text_socket(struct oonf_viewer_template *);
+static int _cb_create_text_loop(struct oonf_viewer_template *);
+
+/*
+ * list of template keys and corresponding buffers for values.
+ *
+ * The keys are API, so they should not be changed after published
+ */
+
+/*! template key for number of profiled calls */
+#define KEY_PROFILE_CALLS               "calls"
+
+/*! template key for total runtime of profiled calls */
+#define KEY_PROFILE_TOTAL               "total"
+
+/*! template key for average runtime of profiled calls */
+#define KEY_PROFILE_AVERAGE             "average"
+
+/*! template key for maximum runtime of profiled calls */
+#define KEY_PROFILE_MAX                 "max"
+
+/*! template key for logarithmic runtime histogram (<1us/1us/2us/4us/...) */
+#define KEY_PROFILE_HISTOGRAM           "histogram"
+
+/*! template key for timer class name */
+#define KEY_TIMER_NAME                  "timer_name"
+
+/*! template key for name of socket handler */
+#define KEY_SOCKET_NAME                 "socket_name"
+
+/*! template key for file descriptor of socket handler */
+#define KEY_SOCKET_FD                   "socket_fd"
+
+/*! template key for time spent waiting for events */
+#define KEY_LOOP_IDLE                   "loop_idle"
+
+/*! template key for time spent handling events */
+#define KEY_LOOP_BUSY                   "loop_busy"
+
+/*! template key for percentage of busy time */
+#define KEY_LOOP_LOAD                   "loop_load"
+
+/*! template key for number of scheduler wakeups with events */
+#define KEY_LOOP_WAKEUPS                "loop_wakeups"
+
+/*! template key for number of scheduler wakeups without events */
+#define KEY_LOOP_TIMEOUTS               "loop_timeouts"
+
+/*! template key for number of socket events */
+#define KEY_LOOP_EVENTS                 "loop_events"
+
+/*
+ * buffer space for values that will be assembled
+ * into the output of the plugin
+ */
+static char                             _value_profile_calls[21];
+static struct isonumber_str             _value_profile_total;
+static struct isonumber_str             _value_profile_average;
+static struct isonumber_str             _value_profile_max;
+static struct _histogram_str            _value_profile_histogram;
+
+static char                             _value_timer_name[64];
+
+static char                             _value_socket_name[64];
+static char                             _value_socket_fd[12];
+
+static struct isonumber_str             _value_loop_idle;
+static struct isonumber_str             _value_loop_busy;
+static char                             _value_loop_load[8];
+static char                             _value_loop_wakeups[11];
+static char                             _value_loop_timeouts[11];
+static char                             _value_loop_events[11];
+
+/* definition of the template data entries for JSON and table output */
+static struct abuf_template_data_entry _tde_profile[] = {
+    { KEY_PROFILE_CALLS, _value_profile_calls, false },
+    { KEY_PROFILE_TOTAL, _value_profile_total.buf, false },
+    { KEY_PROFILE_AVERAGE, _value_profile_average.buf, false },
+    { KEY_PROFILE_MAX, _value_profile_max.buf, false },
+    { KEY_PROFILE_HISTOGRAM, _value_profile_histogram.buf, true },
+};
+
+static struct abuf_template_data_entry _tde_timer_key[] = {
+    { KEY_TIMER_NAME, _value_timer_name, true },
+};
+
+static struct abuf_template_data_entry _tde_socket_key[] = {
+    { KEY_SOCKET_NAME, _value_socket_name, true },
+    { KEY_SOCKET_FD, _value_socket_fd, false },
+};
+
+static struct abuf_template_data_entry _tde_loop[] = {
+    { KEY_LOOP_IDLE, _value_loop_idle.buf, false },
+    { KEY_LOOP_BUSY, _value_loop_busy.buf, false },
+    { KEY_LOOP_LOAD, _value_loop_load, false },
+    { KEY_LOOP_WAKEUPS, _value_loop_wakeups, false },
+    { KEY_LOOP_TIMEOUTS, _value_loop_timeouts, false },
+    { KEY_LOOP_EVENTS, _value_loop_events, false },
+};
+
+static struct abuf_template_storage _template_storage;
+
+/* Template Data objects (contain one or more Template Data Entries) */
+static struct abuf_template_data _td_timer[] = {
+    { _tde_timer_key, ARRAYSIZE(_tde_timer_key) },
+    { _tde_profile, ARRAYSIZE(_tde_profile) },
+};
+static struct abuf_template_data _td_socket[] = {
+    { _tde_socket_key, ARRAYSIZE(_tde_socket_key) },
+    { _tde_profile, ARRAYSIZE(_tde_profile) },
+};
+static struct abuf_template_data _td_loop[] = {
+    { _tde_loop, ARRAYSIZE(_tde_loop) },
+};
+
+/* OONF viewer templates (based on Template Data arrays) */
+static struct oonf_viewer_template _templates[] = {
+    {
+        .data = _td_timer,
+        .data_size = ARRAYSIZE(_td_timer),
+        .json_name = "timer",
+        .cb_function = _cb_create_text_timer,
+    },
+    {
+        .data = _td_socket,
+        .data_size = ARRAYSIZE(_td_socket),
+        .json_name = "socket",
+        .cb_function = _cb_create_text_socket,
+    },
+    {
+        .data = _td_loop,
+        .data_size = ARRAYSIZE(_td_loop),
+        .json_name = "loop",
+        .cb_function = _cb_create_text_loop,
+    },
+};
+
+/* telnet command of this plugin */
+static struct oonf_telnet_command _telnet_commands[] = {
+    TELNET_CMD(OONF_SCHEDULERINFO_SUBSYSTEM, _cb_schedulerinfo,
+        "", .help_handler = _cb_schedulerinfo_help),
+};
+
+/* plugin declaration */
+static const char *_dependencies[] = {
+  OONF_SOCKET_SUBSYSTEM,
+  OONF_TELNET_SUBSYSTEM,
+  OONF_TIMER_SUBSYSTEM,
+  OONF_VIEWER_SUBSYSTEM,
+};
+
+static struct oonf_subsystem _oonf_schedulerinfo_subsystem = {
+  .name = OONF_SCHEDULERINFO_SUBSYSTEM,
+  .dependencies = _dependencies,
+  .dependencies_count = ARRAYSIZE(_dependencies),
+  .descr = "OONF scheduler runtime profile plugin",
+  .author = "Henning Rogge",
+  .init = _init,
+  .cleanup = _cleanup,
+};
+DECLARE_OONF_PLUGIN(_oonf_schedulerinfo_subsystem);
+
+/**
+ * Initialize plugin
+ * @return -1 if an error happened, 0 otherwise
+ */
+static int
+_init(void) {
+  oonf_telnet_add(&_telnet_commands[0]);
+  return 0;
+}
+
+/**
+ * Cleanup plugin
+ */
+static void
+_cleanup(void) {
+  oonf_telnet_remove(&_telnet_commands[0]);
+}
+
+/**
+ * Callback for the telnet command of this plugin
+ * @param con pointer to telnet session data
+ * @return telnet result value
+ */
+static enum oonf_telnet_result
+_cb_schedulerinfo(struct oonf_telnet_data *con) {
+  struct oonf_timer_class *tclass;
+
+  if (con->parameter != NULL && strcasecmp(con->parameter, RESET_PARAMETER) == 0) {
+    list_for_each_element(oonf_timer_get_list(), tclass, _node) {
+      latency_histogram_clear(&tclass->profile);
+    }
+    oonf_socket_clear_statistics();
+
+    abuf_puts(con->out, "Scheduler statistics cleared\n");
+    return TELNET_RESULT_ACTIVE;
+  }
+
+  return oonf_viewer_telnet_handler(con->out, &_template_storage,
+      OONF_SCHEDULERINFO_SUBSYSTEM, con->parameter,
+      _templates, ARRAYSIZE(_templates));
+}
+
+/**
+ * Callback for the help output of this plugin
+ * @param con pointer to telnet session data
+ * @return telnet result value
+ */
+static enum oonf_telnet_result
+_cb_schedulerinfo_help(struct oonf_telnet_data *con) {
+  enum oonf_telnet_result result;
+
+  result = oonf_viewer_telnet_help(con->out, OONF_SCHEDULERINFO_SUBSYSTEM,
+      con->parameter, _templates, ARRAYSIZE(_templates));
+
+  abuf_puts(con->out, "  " RESET_PARAMETER ": reset all scheduler statistics\n");
+  return result;
+}
+
+/**
+ * Convert a duration into a string
+ * @param buf output buffer
+ * @param duration duration in nanoseconds
+ * @param raw true to print the raw number of seconds with full
+ *   precision, false to use an iso prefix
+ * @return pointer to output buffer
+ */
+static const char *
+_time_to_string(struct isonumber_str *buf, uint64_t duration, bool raw) {
+  if (!raw) {
+    return isonumber_from_u64(buf, duration, "s", 9, false, false);
+  }
+
+  snprintf(buf->buf, sizeof(*buf), "%"PRIu64".%09"PRIu64,
+      duration / 1000000000, duration % 1000000000);
+  return buf->buf;
+}
+
+/**
+ * Initialize the value buffers for a runtime profile
+ * @param template viewer template
+ * @param profile latency histogram
+ */
+static void
+_initialize_profile_values(struct oonf_viewer_template *template,
+    const struct latency_histogram *profile) {
+  size_t len;
+  int i;
+
+  snprintf(_value_profile_calls, sizeof(_value_profile_calls),
+      "%"PRIu64, profile->count);
+  _time_to_string(&_value_profile_total,
+      profile->total, template->create_raw);
+  _time_to_string(&_value_profile_average,
+      latency_histogram_get_average(profile), template->create_raw);
+  _time_to_string(&_value_profile_max,
+      profile->max, template->create_raw);
+
+  len = 0;
+  for (i=0; i<LATENCY_HISTOGRAM_BUCKETS; i++) {
+    len += snprintf(&_value_profile_histogram.buf[len],
+        sizeof(_value_profile_histogram) - len,
+        i == 0 ? "%u" : "/%u", profile->bucket[i]);
+  }
+}
+
+/**
+ * Initialize the value buffers for a timer class
+ * @param template viewer template
+ * @param tclass timer class
+ */
+static void
+_initialize_timer_values(struct oonf_viewer_template *template,
+    struct oonf_timer_class *tclass) {
+  strscpy(_value_timer_name, tclass->name, sizeof(_value_timer_name));
+  _initialize_profile_values(template, &tclass->profile);
+}
+
+/**
+ * Initialize the value buffers for a socket handler
+ * @param template viewer template
+ * @param entry socket handler
+ */
+static void
+_initialize_socket_values(struct oonf_viewer_template *template,
+    struct oonf_socket_entry *entry) {
+  strscpy(_value_socket_name, entry->name ? entry->name : "unnamed",
+      sizeof(_value_socket_name));
+  snprintf(_value_socket_fd, sizeof(_value_socket_fd),
+      "%d", os_fd_get_fd(&entry->fd));
+  _initialize_profile_values(template, &entry->profile);
+}
+
+/**
+ * Initialize the value buffers for the main loop statistics
+ * @param template viewer template
+ */
+static void
+_initialize_loop_values(struct oonf_viewer_template *template) {
+  const struct oonf_socket_statistics *stats;
+  uint64_t total;
+
+  stats = oonf_socket_get_statistics();
+  total = stats->idle_time + stats->busy_time;
+
+  _time_to_string(&_value_loop_idle,
+      stats->idle_time, template->create_raw);
+  _time_to_string(&_value_loop_busy,
+      stats->busy_time, template->create_raw);
+  snprintf(_value_loop_load, sizeof(_value_loop_load), "%"PRIu64,
+      total == 0 ? 0 : stats->busy_time * 100 / total);
+  snprintf(_value_loop_wakeups, sizeof(_value_loop_wakeups), "%u", stats->wakeups);
+  snprintf(_value_loop_timeouts, sizeof(_value_loop_timeouts), "%u", stats->timeouts);
+  snprintf(_value_loop_events, sizeof(_value_loop_events), "%u", stats->events);
+}
+
+/**
+ * Callback to generate text/json description of all timer classes
+ * @param template viewer template
+ * @return -1 if an error happened, 0 otherwise
+ */
+static int
+_cb_create_text_timer(struct oonf_viewer_template *template) {
+  struct oonf_timer_class *tclass;
+
+  list_for_each_element(oonf_timer_get_list(), tclass, _node) {
+    _initialize_timer_values(template, tclass);
+
+    /* generate template output */
+    oonf_viewer_output_print_line(template);
+  }
+  return 0;
+}
+
+/**
+ * Callback to generate text/json description of all socket handlers
+ * @param template viewer template
+ * @return -1 if an error happened, 0 otherwise
+ */
+static int
+_cb_create_text_socket(struct oonf_viewer_template *template) {
+  struct oonf_socket_entry *entry;
+
+  list_for_each_element(oonf_socket_get_list(), entry, _node) {
+    _initialize_socket_values(template, entry);
+
+    /* generate template output */
+    oonf_viewer_output_print_line(template);
+  }
+  return 0;
+}
+
+/**
+ * Callback to generate text/json description of the main loop
+ * @param template viewer template
+ * @return -1 if an error happened, 0 otherwise
+ */
+static int
+_cb_create_text_loop(struct oonf_viewer_template *template) {
+  /* initialize values */
+  _initialize_loop_values(template);
+
+  /* generate template output */
+  oonf_viewer_output_print_line(template);
+  return 0;
+}
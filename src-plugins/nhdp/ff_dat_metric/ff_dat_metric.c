@@ -146,6 +146,15 @@ struct link_datff_data {
   /*! estimated number of neighbors of this link */
   uint32_t link_neigborhood;
 
+  /*! kernel receive timestamp of last multicast HELLO in ns, 0 if unknown */
+  uint64_t last_rx_timestamp;
+
+  /*! time between the last two multicast HELLOs in ns, 0 if unknown */
+  uint64_t last_interarrival;
+
+  /*! smoothed variation of the HELLO inter-arrival time in ns */
+  uint64_t rx_jitter;
+
   /*! history ringbuffer */
   struct link_datff_bucket buckets[0];
 };
@@ -173,8 +182,12 @@ static void _cb_hello_lost(struct oonf_timer_instance *);
 
 static enum rfc5444_result _cb_process_packet(
       struct rfc5444_reader_tlvblock_context *context);
+static enum rfc5444_result _cb_process_hello(
+      struct rfc5444_reader_tlvblock_context *context);
+static struct nhdp_laddr *_get_input_link_addr(void);
 
 static void _reset_missed_hello_timer(struct link_datff_data *);
+static void _update_rx_jitter(struct link_datff_data *, uint64_t timestamp);
 
 static const char *_link_to_string(
     struct nhdp_metric_str *buf, uint32_t metric);
@@ -277,6 +290,12 @@ static struct rfc5444_reader_tlvblock_consumer _packet_consumer = {
   .start_callback = _cb_process_packet,
 };
 
+static struct rfc5444_reader_tlvblock_consumer _hello_consumer = {
+  .order = RFC5444_LQ_PARSER_PRIORITY,
+  .msg_id = RFC6130_MSGTYPE_HELLO,
+  .start_callback = _cb_process_hello,
+};
+
 /* storage extension and listeners */
 static struct oonf_class_extension _link_extenstion = {
   .ext_name = "datff linkmetric",
@@ -394,6 +413,7 @@ _cb_enable_metric(void) {
   }
 
   rfc5444_reader_add_packet_consumer(&_protocol->reader, &_packet_consumer, NULL, 0);
+  rfc5444_reader_add_message_consumer(&_protocol->reader, &_hello_consumer, NULL, 0);
   oonf_timer_set(&_sampling_timer, _datff_config.interval);
 }
 
@@ -402,6 +422,7 @@ _cb_disable_metric(void) {
   struct nhdp_link *lnk;
 
   oonf_timer_stop(&_sampling_timer);
+  rfc5444_reader_remove_message_consumer(&_protocol->reader, &_hello_consumer);
   rfc5444_reader_remove_packet_consumer(&_protocol->reader, &_packet_consumer);
 
   list_for_each_element(nhdp_db_get_link_list(), lnk, _global_node) {
@@ -818,7 +839,6 @@ _cb_hello_lost(struct oonf_timer_instance *ptr) {
 static enum rfc5444_result
 _cb_process_packet(struct rfc5444_reader_tlvblock_context *context) {
   struct link_datff_data *ldata;
-  struct nhdp_interface *interf;
   struct nhdp_laddr *laddr;
   struct nhdp_link *lnk;
   int total;
@@ -836,16 +856,9 @@ _cb_process_packet(struct rfc5444_reader_tlvblock_context *context) {
     return RFC5444_OKAY;
   }
 
-  /* get interface and link */
-  interf = nhdp_interface_get(_protocol->input_interface->name);
-  if (interf == NULL) {
-    /* silently ignore unknown interface */
-    return RFC5444_OKAY;
-  }
-
-  laddr = nhdp_interface_get_link_addr(interf, _protocol->input_address);
+  laddr = _get_input_link_addr();
   if (laddr == NULL) {
-    /* silently ignore unknown link*/
+    /* silently ignore unknown interface or link */
     return RFC5444_OKAY;
   }
 
@@ -904,6 +917,80 @@ _cb_process_packet(struct rfc5444_reader_tlvblock_context *context) {
   return RFC5444_OKAY;
 }
 
+/**
+ * Callback to process multicast HELLO messages for the inter-arrival
+ * jitter of a link. Other messages (e.g. TCs) are forwarded and
+ * aggregated independently of the HELLO interval of the neighbor.
+ * @param context
+ * @return
+ */
+static enum rfc5444_result
+_cb_process_hello(struct rfc5444_reader_tlvblock_context *context) {
+  struct link_datff_data *ldata;
+  struct nhdp_laddr *laddr;
+
+  if (!_protocol->input_is_multicast || context->pkt_timestamp == 0) {
+    return RFC5444_OKAY;
+  }
+
+  laddr = _get_input_link_addr();
+  if (laddr == NULL) {
+    return RFC5444_OKAY;
+  }
+
+  ldata = oonf_class_get_extension(&_link_extenstion, laddr->link);
+  _update_rx_jitter(ldata, context->pkt_timestamp);
+  return RFC5444_OKAY;
+}
+
+/**
+ * @return link address of the source of the current incoming packet,
+ *   NULL if interface or link are unknown
+ */
+static struct nhdp_laddr *
+_get_input_link_addr(void) {
+  struct nhdp_interface *interf;
+
+  interf = nhdp_interface_get(_protocol->input_interface->name);
+  if (interf == NULL) {
+    return NULL;
+  }
+  return nhdp_interface_get_link_addr(interf, _protocol->input_address);
+}
+
+/**
+ * Update the HELLO inter-arrival jitter estimation of a link with the
+ * kernel receive timestamp of a HELLO. Uses the smoothing of
+ * the RFC 3550 interarrival jitter.
+ * @param ldata datff link data
+ * @param timestamp receive timestamp in nanoseconds
+ */
+static void
+_update_rx_jitter(struct link_datff_data *ldata, uint64_t timestamp) {
+  uint64_t interarrival, diff;
+
+  if (ldata->last_rx_timestamp == 0 || timestamp <= ldata->last_rx_timestamp) {
+    ldata->last_rx_timestamp = timestamp;
+    return;
+  }
+
+  interarrival = timestamp - ldata->last_rx_timestamp;
+  ldata->last_rx_timestamp = timestamp;
+
+  if (ldata->last_interarrival != 0) {
+    if (interarrival > ldata->last_interarrival) {
+      diff = interarrival - ldata->last_interarrival;
+    }
+    else {
+      diff = ldata->last_interarrival - interarrival;
+    }
+
+    /* J = J + (|D| - J) / 16 */
+    ldata->rx_jitter = ldata->rx_jitter - ldata->rx_jitter / 16 + diff / 16;
+  }
+  ldata->last_interarrival = interarrival;
+}
+
 static void
 _reset_missed_hello_timer(struct link_datff_data *data) {
   oonf_timer_set(&data->hello_lost_timer, (data->hello_interval * 3) / 2);
@@ -970,10 +1057,11 @@ _int_link_to_string(struct nhdp_metric_str *buf, struct nhdp_link *lnk) {
   }
 
   snprintf(buf->buf, sizeof(*buf), "p_recv=%"PRId64",p_total=%"PRId64","
-      "speed=%"PRId64",success=%u,missed_hello=%d,lastseq=%u,lneigh=%d",
+      "speed=%"PRId64",success=%u,missed_hello=%d,lastseq=%u,lneigh=%d,"
+      "jitter_us=%"PRIu64,
       received, total, (int64_t)_get_median_rx_linkspeed(ldata) * (int64_t)1024,
       ldata->last_packet_success_rate, ldata->missed_hellos,
-      ldata->last_seq_nr, ldata->link_neigborhood);
+      ldata->last_seq_nr, ldata->link_neigborhood, ldata->rx_jitter / 1000);
   return buf->buf;
 }
 
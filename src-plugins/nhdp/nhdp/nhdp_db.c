@@ -48,6 +48,7 @@
 #include "common/avl_comp.h"
 #include "common/list.h"
 #include "common/netaddr.h"
+#include "common/netaddr_hash.h"
 
 #include "core/oonf_logging.h"
 #include "subsystems/oonf_class.h"
@@ -80,11 +81,13 @@ static const char *_LINK_LOST      = "lost";
 static struct oonf_class _neigh_info = {
   .name = NHDP_CLASS_NEIGHBOR,
   .size = sizeof(struct nhdp_neighbor),
+  .defer_changes = true,
 };
 
 static struct oonf_class _link_info = {
   .name = NHDP_CLASS_LINK,
   .size = sizeof(struct nhdp_link),
+  .defer_changes = true,
 };
 
 static struct oonf_class _laddr_info = {
@@ -130,6 +133,9 @@ static struct oonf_timer_class _l2hop_vtime_info = {
 /* global tree of neighbor addresses */
 static struct avl_tree _naddr_tree;
 
+/* hash of neighbor addresses for exact-match lookups */
+static struct netaddr_hash _naddr_hash;
+
 /* list of neighbors */
 static struct list_entity _neigh_list;
 
@@ -145,6 +151,7 @@ static struct list_entity _link_list;
 void
 nhdp_db_init(void) {
   avl_init(&_naddr_tree, avl_comp_netaddr, false);
+  netaddr_hash_init(&_naddr_hash);
   list_init_head(&_neigh_list);
   avl_init(&_neigh_originator_tree, avl_comp_netaddr, false);
   list_init_head(&_link_list);
@@ -352,6 +359,12 @@ nhdp_db_neighbor_addr_add(struct nhdp_neighbor *neigh,
   memcpy(&naddr->neigh_addr, addr, sizeof(naddr->neigh_addr));
   naddr->_neigh_node.key = &naddr->neigh_addr;
   naddr->_global_node.key = &naddr->neigh_addr;
+  naddr->_global_hash_node.key = &naddr->neigh_addr;
+
+  if (netaddr_hash_insert(&_naddr_hash, &naddr->_global_hash_node)) {
+    oonf_class_free(&_naddr_info, naddr);
+    return NULL;
+  }
 
   /* initialize backward link */
   naddr->neigh = neigh;
@@ -380,6 +393,7 @@ nhdp_db_neighbor_addr_remove(struct nhdp_naddr *naddr) {
 
   /* remove from trees */
   avl_remove(&_naddr_tree, &naddr->_global_node);
+  netaddr_hash_remove(&_naddr_hash, &naddr->_global_hash_node);
   avl_remove(&naddr->neigh->_neigh_addresses, &naddr->_neigh_node);
 
   /* stop timer */
@@ -857,6 +871,15 @@ nhdp_db_get_naddr_tree(void) {
   return &_naddr_tree;
 }
 
+/**
+ * get global hash of nhdp neighbor addresses
+ * @return neighbor address hash
+ */
+struct netaddr_hash *
+nhdp_db_get_naddr_hash(void) {
+  return &_naddr_hash;
+}
+
 /**
  * get global tree of nhdp originators
  * @return originator tree
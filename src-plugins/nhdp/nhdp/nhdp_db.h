@@ -55,6 +55,7 @@ struct nhdp_laddr;
 #include "common/avl.h"
 #include "common/list.h"
 #include "common/netaddr.h"
+#include "common/netaddr_hash.h"
 #include "subsystems/oonf_rfc5444.h"
 #include "subsystems/oonf_timer.h"
 
@@ -329,6 +330,9 @@ struct nhdp_naddr {
   /*! member entry for global neighbor address tree */
   struct avl_node _global_node;
 
+  /*! member entry for global neighbor address hash */
+  struct netaddr_hash_node _global_hash_node;
+
   /**
    * temporary variables for NHDP Hello processing
    * true if address is part of the local interface
@@ -376,6 +380,7 @@ EXPORT const char *nhdp_db_link_status_to_string(struct nhdp_link *);
 EXPORT struct list_entity *nhdp_db_get_neigh_list(void);
 EXPORT struct list_entity *nhdp_db_get_link_list(void);
 EXPORT struct avl_tree *nhdp_db_get_naddr_tree(void);
+EXPORT struct netaddr_hash *nhdp_db_get_naddr_hash(void);
 EXPORT struct avl_tree *nhdp_db_get_neigh_originator_tree(void);
 
 /**
@@ -385,7 +390,7 @@ EXPORT struct avl_tree *nhdp_db_get_neigh_originator_tree(void);
 static INLINE struct nhdp_naddr *
 nhdp_db_neighbor_addr_get(const struct netaddr *addr) {
   struct nhdp_naddr *naddr;
-  return avl_find_element(nhdp_db_get_naddr_tree(), addr, naddr, _global_node);
+  return netaddr_hash_find_element(nhdp_db_get_naddr_hash(), addr, naddr, _global_hash_node);
 }
 
 /**
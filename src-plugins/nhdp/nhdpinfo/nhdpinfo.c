@@ -50,6 +50,7 @@
 #include "core/oonf_logging.h"
 #include "core/oonf_subsystem.h"
 #include "subsystems/oonf_clock.h"
+#include "subsystems/oonf_rfc5444.h"
 #include "subsystems/oonf_telnet.h"
 #include "subsystems/oonf_viewer.h"
 
@@ -71,6 +72,9 @@ static enum oonf_telnet_result _cb_nhdpinfo_help(struct oonf_telnet_data *con);
 
 static void _initialize_interface_values(struct nhdp_interface *nhdp_if);
 static void _initialize_interface_address_values(struct nhdp_interface_addr *if_addr);
+static void _initialize_interface_tx_class_values(struct nhdp_interface *nhdp_if,
+    enum oonf_rfc5444_tx_class tx_class);
+static void _initialize_writer_values(struct rfc5444_writer *writer);
 static void _initialize_nhdp_link_values(struct nhdp_link *lnk);
 static void _initialize_nhdp_domain_metric_values(struct nhdp_domain *domain,
     struct nhdp_metric *metric);
@@ -85,6 +89,8 @@ static void _initialize_nhdp_neighbor_address_values(struct nhdp_naddr *naddr);
 
 static int _cb_create_text_interface(struct oonf_viewer_template *);
 static int _cb_create_text_if_address(struct oonf_viewer_template *);
+static int _cb_create_text_if_tx_class(struct oonf_viewer_template *);
+static int _cb_create_text_writer(struct oonf_viewer_template *);
 static int _cb_create_text_link(struct oonf_viewer_template *);
 static int _cb_create_text_link_address(struct oonf_viewer_template *);
 static int _cb_create_text_link_twohop(struct oonf_viewer_template *);
@@ -127,6 +133,54 @@ static int _cb_create_text_neighbor_address(struct oonf_viewer_template *);
 /*! template key for validity time of a lost interface address */
 #define KEY_IF_ADDRESS_LOST_VTIME   "if_address_lost_vtime"
 
+/*! template key for the name of a transmit class */
+#define KEY_IF_TX_CLASS             "if_tx_class"
+
+/*! template key for the number of packets sent in a transmit class */
+#define KEY_IF_TX_PACKETS           "if_tx_packets"
+
+/*! template key for the number of packets that had to wait in a transmit class */
+#define KEY_IF_TX_QUEUED            "if_tx_queued"
+
+/*! template key for the number of packets currently waiting in a transmit class */
+#define KEY_IF_TX_QUEUE             "if_tx_queue"
+
+/*! template key for the maximum number of waiting packets of a transmit class */
+#define KEY_IF_TX_QUEUE_LIMIT       "if_tx_queue_limit"
+
+/*! template key for the number of dropped packets of a transmit class */
+#define KEY_IF_TX_DROPPED           "if_tx_dropped"
+
+/*! template key for the average queueing delay of a transmit class */
+#define KEY_IF_TX_DELAY_AVG         "if_tx_delay_avg"
+
+/*! template key for the maximum queueing delay of a transmit class */
+#define KEY_IF_TX_DELAY_MAX         "if_tx_delay_max"
+
+/*! template key for the number of messages seen by the address planner */
+#define KEY_WRITER_PLANNED          "writer_planned"
+
+/*! template key for the number of messages with reordered addresses */
+#define KEY_WRITER_REORDERED        "writer_reordered"
+
+/*! template key for the estimated bytes saved by the address planner */
+#define KEY_WRITER_BYTES_SAVED      "writer_bytes_saved"
+
+/*! template key for the estimated bytes saved in the last planned message */
+#define KEY_WRITER_LAST_BYTES_SAVED "writer_last_bytes_saved"
+
+/*! template key for the number of messages serialized into a shared buffer */
+#define KEY_WRITER_FANOUT_MESSAGES  "writer_fanout_messages"
+
+/*! template key for the number of packets referencing a shared message */
+#define KEY_WRITER_FANOUT_REFERENCES "writer_fanout_references"
+
+/*! template key for the number of packets sent as multiple fragments */
+#define KEY_WRITER_FANOUT_PACKETS   "writer_fanout_packets"
+
+/*! template key for the number of shared messages copied into a packet */
+#define KEY_WRITER_FANOUT_COPIED    "writer_fanout_copied"
+
 /*! template key for the links remote socket IP address */
 #define KEY_LINK_BINDTO             "link_bindto"
 
@@ -243,6 +297,23 @@ static char                       _value_if_dualstack_mode[5];
 static struct netaddr_str         _value_if_address;
 static char                       _value_if_address_lost[TEMPLATE_JSON_BOOL_LENGTH];
 static struct isonumber_str       _value_if_address_vtime;
+static char                       _value_if_tx_class[16];
+static char                       _value_if_tx_packets[12];
+static char                       _value_if_tx_queued[12];
+static char                       _value_if_tx_queue[12];
+static char                       _value_if_tx_queue_limit[12];
+static char                       _value_if_tx_dropped[12];
+static struct isonumber_str       _value_if_tx_delay_avg;
+static struct isonumber_str       _value_if_tx_delay_max;
+
+static char                       _value_writer_planned[21];
+static char                       _value_writer_reordered[21];
+static char                       _value_writer_bytes_saved[21];
+static char                       _value_writer_last_bytes_saved[12];
+static char                       _value_writer_fanout_messages[21];
+static char                       _value_writer_fanout_references[21];
+static char                       _value_writer_fanout_packets[21];
+static char                       _value_writer_fanout_copied[21];
 
 static struct netaddr_str         _value_link_bindto;
 static struct isonumber_str       _value_link_vtime_value;
@@ -375,6 +446,28 @@ static struct abuf_template_data_entry _tde_neigh_addr[] = {
     { KEY_NEIGHBOR_ADDRESS_VTIME, _value_neighbor_address_lost_vtime.buf, false },
 };
 
+static struct abuf_template_data_entry _tde_if_tx_class[] = {
+    { KEY_IF_TX_CLASS, _value_if_tx_class, true },
+    { KEY_IF_TX_PACKETS, _value_if_tx_packets, false },
+    { KEY_IF_TX_QUEUED, _value_if_tx_queued, false },
+    { KEY_IF_TX_QUEUE, _value_if_tx_queue, false },
+    { KEY_IF_TX_QUEUE_LIMIT, _value_if_tx_queue_limit, false },
+    { KEY_IF_TX_DROPPED, _value_if_tx_dropped, false },
+    { KEY_IF_TX_DELAY_AVG, _value_if_tx_delay_avg.buf, false },
+    { KEY_IF_TX_DELAY_MAX, _value_if_tx_delay_max.buf, false },
+};
+
+static struct abuf_template_data_entry _tde_writer[] = {
+    { KEY_WRITER_PLANNED, _value_writer_planned, false },
+    { KEY_WRITER_REORDERED, _value_writer_reordered, false },
+    { KEY_WRITER_BYTES_SAVED, _value_writer_bytes_saved, false },
+    { KEY_WRITER_LAST_BYTES_SAVED, _value_writer_last_bytes_saved, false },
+    { KEY_WRITER_FANOUT_MESSAGES, _value_writer_fanout_messages, false },
+    { KEY_WRITER_FANOUT_REFERENCES, _value_writer_fanout_references, false },
+    { KEY_WRITER_FANOUT_PACKETS, _value_writer_fanout_packets, false },
+    { KEY_WRITER_FANOUT_COPIED, _value_writer_fanout_copied, false },
+};
+
 static struct abuf_template_storage _template_storage;
 
 /* Template Data objects (contain one or more Template Data Entries) */
@@ -385,6 +478,13 @@ static struct abuf_template_data _td_if_addr[] = {
     { _tde_if_key, ARRAYSIZE(_tde_if_key) },
     { _tde_if_addr, ARRAYSIZE(_tde_if_addr) },
 };
+static struct abuf_template_data _td_if_tx_class[] = {
+    { _tde_if_key, ARRAYSIZE(_tde_if_key) },
+    { _tde_if_tx_class, ARRAYSIZE(_tde_if_tx_class) },
+};
+static struct abuf_template_data _td_writer[] = {
+    { _tde_writer, ARRAYSIZE(_tde_writer) },
+};
 static struct abuf_template_data _td_link[] = {
     { _tde_if_key, ARRAYSIZE(_tde_if_key) },
     { _tde_link, ARRAYSIZE(_tde_link) },
@@ -429,6 +529,18 @@ static struct oonf_viewer_template _templates[] = {
         .json_name = "if_addr",
         .cb_function = _cb_create_text_if_address,
     },
+    {
+        .data = _td_if_tx_class,
+        .data_size = ARRAYSIZE(_td_if_tx_class),
+        .json_name = "if_tx_class",
+        .cb_function = _cb_create_text_if_tx_class,
+    },
+    {
+        .data = _td_writer,
+        .data_size = ARRAYSIZE(_td_writer),
+        .json_name = "writer",
+        .cb_function = _cb_create_text_writer,
+    },
     {
         .data = _td_link,
         .data_size = ARRAYSIZE(_td_link),
@@ -472,6 +584,7 @@ static const char *_dependencies[] = {
   OONF_CLOCK_SUBSYSTEM,
   OONF_TELNET_SUBSYSTEM,
   OONF_VIEWER_SUBSYSTEM,
+  OONF_RFC5444_SUBSYSTEM,
   OONF_NHDP_SUBSYSTEM,
 };
 static struct oonf_subsystem _olsrv2_nhdpinfo_subsystem = {
@@ -587,6 +700,60 @@ _initialize_interface_address_values(struct nhdp_interface_addr *if_addr) {
   }
 }
 
+/**
+ * Initialize the value buffers for a transmit class of a NHDP interface
+ * @param nhdp_if nhdp interface
+ * @param tx_class transmit class
+ */
+static void
+_initialize_interface_tx_class_values(struct nhdp_interface *nhdp_if,
+    enum oonf_rfc5444_tx_class tx_class) {
+  struct oonf_rfc5444_tx_class_data *tx;
+
+  tx = &nhdp_if->rfc5444_if.interface->tx_class[tx_class];
+
+  strscpy(_value_if_tx_class, oonf_rfc5444_get_tx_class_name(tx_class),
+      sizeof(_value_if_tx_class));
+  snprintf(_value_if_tx_packets, sizeof(_value_if_tx_packets),
+      "%u", tx->stats.packets);
+  snprintf(_value_if_tx_queued, sizeof(_value_if_tx_queued),
+      "%u", tx->stats.queued);
+  snprintf(_value_if_tx_queue, sizeof(_value_if_tx_queue),
+      "%u", tx->_queue_count);
+  snprintf(_value_if_tx_queue_limit, sizeof(_value_if_tx_queue_limit),
+      "%d", tx->queue_limit);
+  snprintf(_value_if_tx_dropped, sizeof(_value_if_tx_dropped),
+      "%u", tx->stats.dropped);
+
+  oonf_clock_toIntervalString(&_value_if_tx_delay_avg,
+      tx->stats.packets > 0 ? tx->stats.delay_total / tx->stats.packets : 0);
+  oonf_clock_toIntervalString(&_value_if_tx_delay_max, tx->stats.delay_max);
+}
+
+/**
+ * Initialize the value buffers for the statistics of a rfc5444 writer
+ * @param writer rfc5444 writer
+ */
+static void
+_initialize_writer_values(struct rfc5444_writer *writer) {
+  snprintf(_value_writer_planned, sizeof(_value_writer_planned),
+      "%"PRIu64, writer->planner_stats.messages);
+  snprintf(_value_writer_reordered, sizeof(_value_writer_reordered),
+      "%"PRIu64, writer->planner_stats.reordered);
+  snprintf(_value_writer_bytes_saved, sizeof(_value_writer_bytes_saved),
+      "%"PRIu64, writer->planner_stats.bytes_saved);
+  snprintf(_value_writer_last_bytes_saved, sizeof(_value_writer_last_bytes_saved),
+      "%u", writer->planner_stats.last_bytes_saved);
+  snprintf(_value_writer_fanout_messages, sizeof(_value_writer_fanout_messages),
+      "%"PRIu64, writer->fanout_stats.messages);
+  snprintf(_value_writer_fanout_references, sizeof(_value_writer_fanout_references),
+      "%"PRIu64, writer->fanout_stats.references);
+  snprintf(_value_writer_fanout_packets, sizeof(_value_writer_fanout_packets),
+      "%"PRIu64, writer->fanout_stats.packets);
+  snprintf(_value_writer_fanout_copied, sizeof(_value_writer_fanout_copied),
+      "%"PRIu64, writer->fanout_stats.copied);
+}
+
 /**
  * Initialize the value buffers for a NHDP link
  * @param lnk NHDP link
@@ -784,6 +951,31 @@ _cb_create_text_if_address(struct oonf_viewer_template *template) {
   return 0;
 }
 
+/**
+ * Displays the transmit classes of a NHDP interface.
+ * @param template oonf viewer template
+ * @return -1 if an error happened, 0 otherwise
+ */
+static int
+_cb_create_text_if_tx_class(struct oonf_viewer_template *template) {
+  struct nhdp_interface *nhdp_if;
+  int i;
+
+  avl_for_each_element(nhdp_interface_get_tree(), nhdp_if, _node) {
+    /* fill output buffers for template engine */
+    _initialize_interface_values(nhdp_if);
+
+    for (i=0; i<OONF_RFC5444_TX_CLASS_COUNT; i++) {
+      /* fill transmit class specific output buffers for template engine */
+      _initialize_interface_tx_class_values(nhdp_if, i);
+
+      /* generate template output */
+      oonf_viewer_output_print_line(template);
+    }
+  }
+  return 0;
+}
+
 /**
  * Displays the data of a NHDP link.
  * @param template oonf viewer template
@@ -910,6 +1102,28 @@ _cb_create_text_neighbor(struct oonf_viewer_template *template) {
   return 0;
 }
 
+/**
+ * Displays the address planner and fan-out statistics of the
+ * rfc5444 writer used by NHDP.
+ * @param template oonf viewer template
+ * @return -1 if an error happened, 0 otherwise
+ */
+static int
+_cb_create_text_writer(struct oonf_viewer_template *template) {
+  struct oonf_rfc5444_protocol *protocol;
+
+  protocol = oonf_rfc5444_get_default_protocol();
+  if (protocol == NULL) {
+    return -1;
+  }
+
+  _initialize_writer_values(&protocol->writer);
+
+  /* generate template output */
+  oonf_viewer_output_print_line(template);
+  return 0;
+}
+
 /**
  * Displays the addresses of a NHDP neighbor.
  * @param template oonf viewer template
@@ -283,7 +283,7 @@ _print_graph(struct json_session *session,
   struct olsrv2_tc_edge *edge;
   struct olsrv2_tc_attachment *attached;
   struct olsrv2_lan_entry *lan;
-  struct avl_tree *rt_tree;
+  struct btree_tree *rt_tree;
   struct olsrv2_routing_entry *rt_entry;
   struct domain_id_str dbuf;
 
@@ -305,7 +305,7 @@ _print_graph(struct json_session *session,
       _create_domain_id(&dbuf, domain, af_type));
 
   json_start_array(session, "nodes");
-  avl_for_each_element(olsrv2_tc_get_tree(), node, _originator_node) {
+  btree_for_each_element(olsrv2_tc_get_tree(), node, _originator_node) {
     if (netaddr_get_address_family(&node->target.prefix.dst) == af_type) {
       _print_graph_node(session, &node->target.prefix.dst);
     }
@@ -320,7 +320,7 @@ _print_graph(struct json_session *session,
   avl_for_each_element(nhdp_db_get_neigh_originator_tree(), neigh, _originator_node) {
     if (netaddr_get_address_family(&neigh->originator) == af_type
         && neigh->symmetric > 0) {
-      rt_entry = avl_find_element(rt_tree, &neigh->originator, rt_entry, _node);
+      rt_entry = btree_find_element(rt_tree, &neigh->originator, rt_entry, _node);
       outgoing = rt_entry != NULL
           && netaddr_cmp(&rt_entry->last_originator, originator) == 0;
 
@@ -339,7 +339,7 @@ _print_graph(struct json_session *session,
   }
 
   /* print remote node links to neighbors and prefixes */
-  avl_for_each_element(olsrv2_tc_get_tree(), node, _originator_node) {
+  btree_for_each_element(olsrv2_tc_get_tree(), node, _originator_node) {
     if (netaddr_get_address_family(&node->target.prefix.dst) == af_type) {
       avl_for_each_element(&node->_edges, edge, _node) {
         if (!edge->virtual) {
@@ -348,7 +348,7 @@ _print_graph(struct json_session *session,
             continue;
           }
 
-          rt_entry = avl_find_element(rt_tree, &edge->dst->target.prefix.dst, rt_entry, _node);
+          rt_entry = btree_find_element(rt_tree, &edge->dst->target.prefix.dst, rt_entry, _node);
           outgoing = rt_entry != NULL
               && netaddr_cmp(&rt_entry->last_originator, &node->target.prefix.dst) == 0;
 
@@ -377,7 +377,7 @@ _print_graph(struct json_session *session,
   }
 
   /* print remote nodes neighbors */
-  avl_for_each_element(olsrv2_tc_get_tree(), node, _originator_node) {
+  btree_for_each_element(olsrv2_tc_get_tree(), node, _originator_node) {
     if (netaddr_get_address_family(&node->target.prefix.dst) == af_type) {
       avl_for_each_element(&node->_attached_networks, attached, _src_node) {
         _print_graph_end(session, domain,
@@ -447,7 +447,7 @@ _print_routing_tree(struct json_session *session,
 
   json_start_array(session, JSON_NAME_ROUTE);
 
-  avl_for_each_element(olsrv2_routing_get_tree(domain), rtentry, _node) {
+  btree_for_each_element(olsrv2_routing_get_tree(domain), rtentry, _node) {
     if (rtentry->route.p.family == af_type) {
       json_start_object(session, NULL);
       _print_json_netaddr(session, "destination", &rtentry->route.p.key.dst);
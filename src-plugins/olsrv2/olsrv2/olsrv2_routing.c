@@ -47,6 +47,7 @@
 
 #include "common/avl.h"
 #include "common/avl_comp.h"
+#include "common/btree.h"
 #include "common/common_types.h"
 #include "common/list.h"
 #include "common/netaddr.h"
@@ -118,7 +119,7 @@ static struct nhdp_domain_listener _nhdp_listener = {
 static bool _trigger_dijkstra = false;
 
 /* global datastructures for routing */
-static struct avl_tree _routing_tree[NHDP_MAXIMUM_DOMAINS];
+static struct btree_tree _routing_tree[NHDP_MAXIMUM_DOMAINS];
 static struct list_entity _routing_filter_list;
 
 static struct avl_tree _dijkstra_working_tree;
@@ -137,7 +138,8 @@ olsrv2_routing_init(void) {
   oonf_timer_add(&_dijkstra_timer_info);
 
   for (i=0; i<NHDP_MAXIMUM_DOMAINS; i++) {
-    avl_init(&_routing_tree[i], os_routing_avl_cmp_route_key, false);
+    btree_init(&_routing_tree[i], os_routing_avl_cmp_route_key, false);
+    _routing_tree[i].prefix = btree_prefix_memcmp;
   }
   list_init_head(&_routing_filter_list);
   avl_init(&_dijkstra_working_tree, avl_comp_uint32, true);
@@ -159,7 +161,7 @@ olsrv2_routing_initiate_shutdown(void) {
 
   /* remove all routes */
   for (i=0; i<NHDP_MAXIMUM_DOMAINS; i++) {
-    avl_for_each_element_safe(&_routing_tree[i], entry, _node, e_it) {
+    btree_for_each_element_safe(&_routing_tree[i], entry, _node, e_it) {
       /* stop internal route processing */
       entry->route.cb_finished = NULL;
       os_routing_interrupt(&entry->route);
@@ -189,7 +191,7 @@ olsrv2_routing_cleanup(void) {
   oonf_timer_stop(&_rate_limit_timer);
 
   for (i=0; i<NHDP_MAXIMUM_DOMAINS; i++) {
-    avl_for_each_element_safe(&_routing_tree[i], entry, _node, e_it) {
+    btree_for_each_element_safe(&_routing_tree[i], entry, _node, e_it) {
       /* remove entry from database */
       _remove_entry(entry);
     }
@@ -323,13 +325,13 @@ olsrv2_routing_set_domain_parameter(struct nhdp_domain *domain,
   /* copy parameters */
   memcpy(&_domain_parameter[domain->index], parameter, sizeof(*parameter));
 
-  if (avl_is_empty(&_routing_tree[domain->index])) {
+  if (btree_is_empty(&_routing_tree[domain->index])) {
     /* no routes present */
     return;
   }
 
   /* remove old kernel routes */
-  avl_for_each_element(&_routing_tree[domain->index], rtentry, _node) {
+  btree_for_each_element(&_routing_tree[domain->index], rtentry, _node) {
     if (rtentry->set) {
       rtentry->set = false;
 
@@ -354,7 +356,7 @@ olsrv2_routing_set_domain_parameter(struct nhdp_domain *domain,
  * @param domain nhdp domain
  * @return tree of routing entries
  */
-struct avl_tree *
+struct btree_tree *
 olsrv2_routing_get_tree(struct nhdp_domain *domain) {
   return &_routing_tree[domain->index];
 }
@@ -402,7 +404,7 @@ static struct olsrv2_routing_entry *
 _add_entry(struct nhdp_domain *domain, struct os_route_key *prefix) {
   struct olsrv2_routing_entry *rtentry;
 
-  rtentry = avl_find_element(
+  rtentry = btree_find_element(
       &_routing_tree[domain->index], prefix, rtentry, _node);
   if (rtentry) {
     return rtentry;
@@ -428,7 +430,10 @@ _add_entry(struct nhdp_domain *domain, struct os_route_key *prefix) {
 
   rtentry->route.p.type = OS_ROUTE_UNICAST;
 
-  avl_insert(&_routing_tree[domain->index], &rtentry->_node);
+  if (btree_insert(&_routing_tree[domain->index], &rtentry->_node)) {
+    oonf_class_free(&_rtset_entry, rtentry);
+    return NULL;
+  }
   return rtentry;
 }
 
@@ -443,7 +448,7 @@ _remove_entry(struct olsrv2_routing_entry *entry) {
   os_routing_interrupt(&entry->route);
 
   /* remove entry from database */
-  avl_remove(&_routing_tree[entry->domain->index], &entry->_node);
+  btree_remove(&_routing_tree[entry->domain->index], &entry->_node);
   oonf_class_free(&_rtset_entry, entry);
 }
 
@@ -627,7 +632,7 @@ static void
 _prepare_routes(struct nhdp_domain *domain) {
   struct olsrv2_routing_entry *rtentry;
   /* prepare all existing routing entries and put them into the working queue */
-  avl_for_each_element(&_routing_tree[domain->index], rtentry, _node) {
+  btree_for_each_element(&_routing_tree[domain->index], rtentry, _node) {
     rtentry->set = false;
     memcpy(&rtentry->_old, &rtentry->route.p, sizeof(rtentry->_old));
   }
@@ -645,7 +650,7 @@ _prepare_nodes(void) {
   struct olsrv2_tc_node *node;
 
   /* initialize private dijkstra data on nodes */
-  avl_for_each_element(olsrv2_tc_get_tree(), node, _originator_node) {
+  btree_for_each_element(olsrv2_tc_get_tree(), node, _originator_node) {
     node->target._dijkstra.first_hop = NULL;
     node->target._dijkstra.path_cost = RFC7181_METRIC_INFINITE_PATH;
     node->target._dijkstra.path_hops = 255;
@@ -680,7 +685,7 @@ _check_ssnode_split(struct nhdp_domain *domain, int af_family) {
   full_count = 0;
   ssnode_prefix = false;
 
-  avl_for_each_element(olsrv2_tc_get_tree(), node, _originator_node) {
+  btree_for_each_element(olsrv2_tc_get_tree(), node, _originator_node) {
     /* count number of source specific nodes */
     if (netaddr_get_address_family(&node->target.prefix.dst) == af_family) {
       full_count++;
@@ -974,7 +979,7 @@ _process_dijkstra_result(struct nhdp_domain *domain) {
   struct olsrv2_routing_entry *rtentry;
   struct olsrv2_routing_filter *filter;
 
-  avl_for_each_element(&_routing_tree[domain->index], rtentry, _node) {
+  btree_for_each_element(&_routing_tree[domain->index], rtentry, _node) {
     /* initialize rest of route parameters */
     rtentry->route.p.table = _domain_parameter[rtentry->domain->index].table;
     rtentry->route.p.protocol = _domain_parameter[rtentry->domain->index].protocol;
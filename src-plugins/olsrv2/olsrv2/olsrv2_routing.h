@@ -47,6 +47,7 @@
 #define OLSRV2_ROUTING_H_
 
 #include "common/avl.h"
+#include "common/btree.h"
 #include "common/common_types.h"
 #include "common/list.h"
 #include "common/netaddr.h"
@@ -133,7 +134,7 @@ struct olsrv2_routing_entry {
   struct list_entity _working_node;
 
   /*! global node */
-  struct avl_node _node;
+  struct btree_node _node;
 };
 
 /**
@@ -188,7 +189,7 @@ EXPORT void olsrv2_routing_trigger_update(void);
 EXPORT const struct olsrv2_routing_domain *
     olsrv2_routing_get_parameters(struct nhdp_domain *);
 
-EXPORT struct avl_tree *olsrv2_routing_get_tree(struct nhdp_domain *domain);
+EXPORT struct btree_tree *olsrv2_routing_get_tree(struct nhdp_domain *domain);
 EXPORT struct list_entity *olsrv2_routing_get_filter_list(void);
 
 /**
@@ -45,8 +45,10 @@
 
 #include "common/avl.h"
 #include "common/avl_comp.h"
+#include "common/btree.h"
 #include "common/common_types.h"
 #include "common/netaddr.h"
+#include "common/netaddr_hash.h"
 #include "subsystems/oonf_class.h"
 #include "subsystems/oonf_rfc5444.h"
 #include "subsystems/oonf_timer.h"
@@ -89,7 +91,8 @@ static struct oonf_timer_class _validity_info = {
 };
 
 /* global trees for tc nodes and endpoints */
-static struct avl_tree _tc_tree;
+static struct btree_tree _tc_tree;
+static struct netaddr_hash _tc_hash;
 static struct avl_tree _tc_endpoint_tree;
 
 /**
@@ -102,7 +105,9 @@ olsrv2_tc_init(void) {
   oonf_class_add(&_tc_attached_class);
   oonf_class_add(&_tc_endpoint_class);
 
-  avl_init(&_tc_tree, avl_comp_netaddr, false);
+  btree_init(&_tc_tree, avl_comp_netaddr, false);
+  _tc_tree.prefix = btree_prefix_memcmp;
+  netaddr_hash_init(&_tc_hash);
   avl_init(&_tc_endpoint_tree, os_routing_avl_cmp_route_key, true);
 }
 
@@ -115,7 +120,7 @@ olsrv2_tc_cleanup(void) {
   struct olsrv2_tc_edge *edge, *e_it;
   struct olsrv2_tc_attachment *a_end, *ae_it;
 
-  avl_for_each_element(&_tc_tree, node, _originator_node) {
+  btree_for_each_element(&_tc_tree, node, _originator_node) {
     avl_for_each_element_safe(&node->_edges, edge, _node, e_it) {
       /* remove edge without cleaning up the node */
       _remove_edge(edge, false);
@@ -126,7 +131,7 @@ olsrv2_tc_cleanup(void) {
     }
   }
 
-  avl_for_each_element_safe(&_tc_tree, node, _originator_node, n_it) {
+  btree_for_each_element_safe(&_tc_tree, node, _originator_node, n_it) {
     olsrv2_tc_node_remove(node);
   }
 
@@ -148,8 +153,8 @@ olsrv2_tc_node_add(struct netaddr *originator,
     uint64_t vtime, uint16_t ansn) {
   struct olsrv2_tc_node *node;
 
-  node = avl_find_element(
-      &_tc_tree, originator, node, _originator_node);
+  node = netaddr_hash_find_element(
+      &_tc_hash, originator, node, _originator_hash_node);
   if (!node) {
     node = oonf_class_malloc(&_tc_node_class);
     if (node == NULL) {
@@ -159,6 +164,18 @@ olsrv2_tc_node_add(struct netaddr *originator,
     /* copy key and attach it to node */
     os_routing_init_sourcespec_prefix(&node->target.prefix, originator);
     node->_originator_node.key = &node->target.prefix.dst;
+    node->_originator_hash_node.key = &node->target.prefix.dst;
+
+    /* hook into global tree and hash */
+    if (btree_insert(&_tc_tree, &node->_originator_node)) {
+      oonf_class_free(&_tc_node_class, node);
+      return NULL;
+    }
+    if (netaddr_hash_insert(&_tc_hash, &node->_originator_hash_node)) {
+      btree_remove(&_tc_tree, &node->_originator_node);
+      oonf_class_free(&_tc_node_class, node);
+      return NULL;
+    }
 
     /* initialize node */
     avl_init(&node->_edges, avl_comp_netaddr, false);
@@ -172,9 +189,6 @@ olsrv2_tc_node_add(struct netaddr *originator,
     node->target.type = OLSRV2_NODE_TARGET;
     olsrv2_routing_dijkstra_node_init(&node->target._dijkstra);
 
-    /* hook into global tree */
-    avl_insert(&_tc_tree, &node->_originator_node);
-
     /* fire event */
     oonf_class_event(&_tc_node_class, node, OONF_OBJECT_ADDED);
   }
@@ -217,7 +231,8 @@ olsrv2_tc_node_remove(struct olsrv2_tc_node *node) {
 
   /* remove from global tree and free memory if node is not needed anymore*/
   if (node->_edges.count == 0) {
-    avl_remove(&_tc_tree, &node->_originator_node);
+    btree_remove(&_tc_tree, &node->_originator_node);
+    netaddr_hash_remove(&_tc_hash, &node->_originator_hash_node);
     oonf_class_free(&_tc_node_class, node);
   }
 }
@@ -262,7 +277,7 @@ olsrv2_tc_edge_add(struct olsrv2_tc_node *src, struct netaddr *addr) {
   }
 
   /* find or allocate destination node */
-  dst = avl_find_element(&_tc_tree, addr, dst, _originator_node);
+  dst = netaddr_hash_find_element(&_tc_hash, addr, dst, _originator_hash_node);
   if (dst == NULL) {
     /* create virtual node */
     dst = olsrv2_tc_node_add(addr, 0, 0);
@@ -421,11 +436,20 @@ olsrv2_tc_trigger_change(struct olsrv2_tc_node *node) {
  * Get tree of olsrv2 tc nodes
  * @return node tree
  */
-struct avl_tree *
+struct btree_tree *
 olsrv2_tc_get_tree(void) {
   return &_tc_tree;
 }
 
+/**
+ * Get hash of olsrv2 tc nodes
+ * @return node hash
+ */
+struct netaddr_hash *
+olsrv2_tc_get_hash(void) {
+  return &_tc_hash;
+}
+
 /**
  * Get tree of olsrv2 tc endpoints
  * @return endpoint tree
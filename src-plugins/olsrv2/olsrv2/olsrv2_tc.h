@@ -47,8 +47,10 @@
 #define OLSRV2_TC_H_
 
 #include "common/avl.h"
+#include "common/btree.h"
 #include "common/common_types.h"
 #include "common/netaddr.h"
+#include "common/netaddr_hash.h"
 
 #include "subsystems/oonf_timer.h"
 
@@ -133,7 +135,10 @@ struct olsrv2_tc_node {
   struct avl_tree _attached_networks;
 
   /*! node for tree of tc_nodes */
-  struct avl_node _originator_node;
+  struct btree_node _originator_node;
+
+  /*! node for hash of tc_nodes */
+  struct netaddr_hash_node _originator_hash_node;
 };
 
 /**
@@ -227,7 +232,8 @@ EXPORT void olsrv2_tc_endpoint_remove(
 
 void olsrv2_tc_trigger_change(struct olsrv2_tc_node *);
 
-EXPORT struct avl_tree *olsrv2_tc_get_tree(void);
+EXPORT struct btree_tree *olsrv2_tc_get_tree(void);
+EXPORT struct netaddr_hash *olsrv2_tc_get_hash(void);
 EXPORT struct avl_tree *olsrv2_tc_get_endpoint_tree(void);
 
 /**
@@ -238,7 +244,7 @@ static INLINE struct olsrv2_tc_node *
 olsrv2_tc_node_get(struct netaddr *originator) {
   struct olsrv2_tc_node *node;
 
-  return avl_find_element(olsrv2_tc_get_tree(), originator, node, _originator_node);
+  return netaddr_hash_find_element(olsrv2_tc_get_hash(), originator, node, _originator_hash_node);
 }
 
 /**
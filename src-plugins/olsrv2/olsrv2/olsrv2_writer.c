@@ -44,6 +44,7 @@
  */
 
 #include "common/avl.h"
+#include "common/autobuf.h"
 #include "common/common_types.h"
 #include "common/list.h"
 #include "common/netaddr.h"
@@ -83,8 +84,22 @@ enum olsrv2_addrtlv_idx {
   IDX_ADDRTLV_GATEWAY_SRC_PREFIX,
 };
 
+/**
+ * serialized TC message of one address family, reused as long
+ * as the content key of the TC does not change
+ */
+struct _tc_cache {
+  /*! content key of the cached TC */
+  struct autobuf key;
+
+  /*! binary TC message, empty if no TC is cached */
+  struct autobuf msg;
+};
+
 /* Prototypes */
 static void _send_tc(int af_type);
+static int _get_tc_content_key(struct autobuf *key, int af_type);
+static void _append_netaddr(struct autobuf *key, const struct netaddr *addr);
 #if 0
 static bool _cb_tc_interface_selector(struct rfc5444_writer *,
     struct rfc5444_writer_target *rfc5444_target, void *ptr);
@@ -100,6 +115,9 @@ static void _cb_addAddresses(struct rfc5444_writer *);
 static void _cb_finishMessageTLVs(struct rfc5444_writer *,
   struct rfc5444_writer_address *start,
   struct rfc5444_writer_address *end, bool complete);
+static void _cb_messageGenerated(struct rfc5444_writer *,
+    struct rfc5444_writer_message *, const uint8_t *buffer, size_t len,
+    bool complete);
 
 /* definition of NHDP writer */
 static struct rfc5444_writer_message *_olsrv2_message = NULL;
@@ -128,6 +146,11 @@ static struct oonf_rfc5444_protocol *_protocol;
 static bool _cleanedup = false;
 static size_t _mprtypes_size;
 
+/* cached TCs for IPv4 and IPv6 */
+static struct _tc_cache _tc_cache[2];
+static struct _tc_cache *_current_tc_cache = NULL;
+static struct autobuf _tc_key;
+
 /**
  * initialize olsrv2 writer
  * @param protocol rfc5444 protocol
@@ -135,6 +158,8 @@ static size_t _mprtypes_size;
  */
 int
 olsrv2_writer_init(struct oonf_rfc5444_protocol *protocol) {
+  size_t i;
+
   _protocol = protocol;
 
   _olsrv2_message = rfc5444_writer_register_message(
@@ -146,6 +171,7 @@ olsrv2_writer_init(struct oonf_rfc5444_protocol *protocol) {
 
   _olsrv2_message->addMessageHeader = _cb_addMessageHeader;
   _olsrv2_message->finishMessageHeader = _cb_finishMessageHeader;
+  _olsrv2_message->messageGenerated = _cb_messageGenerated;
   _olsrv2_message->forward_target_selector = nhdp_forwarding_selector;
 
   if (rfc5444_writer_register_msgcontentprovider(
@@ -157,6 +183,11 @@ olsrv2_writer_init(struct oonf_rfc5444_protocol *protocol) {
     return -1;
   }
 
+  abuf_init(&_tc_key);
+  for (i=0; i<ARRAYSIZE(_tc_cache); i++) {
+    abuf_init(&_tc_cache[i].key);
+    abuf_init(&_tc_cache[i].msg);
+  }
   return 0;
 }
 
@@ -165,8 +196,17 @@ olsrv2_writer_init(struct oonf_rfc5444_protocol *protocol) {
  */
 void
 olsrv2_writer_cleanup(void) {
+  size_t i;
+
   _cleanedup = true;
 
+  /* free TC cache */
+  abuf_free(&_tc_key);
+  for (i=0; i<ARRAYSIZE(_tc_cache); i++) {
+    abuf_free(&_tc_cache[i].key);
+    abuf_free(&_tc_cache[i].msg);
+  }
+
   /* remove pbb writer */
   rfc5444_writer_unregister_content_provider(
       &_protocol->writer, &_olsrv2_msgcontent_provider,
@@ -207,19 +247,162 @@ olsrv2_writer_set_forwarding_selector(
 }
 
 /**
- * Send a TC for a specified address family if the originator is set
+ * Send a TC for a specified address family if the originator is set.
+ * If the content of the TC did not change since the last one, the
+ * cached binary TC is sent again with a new sequence number.
  * @param af_type address family type
  */
 static void
 _send_tc(int af_type) {
   const struct netaddr *originator;
+  struct _tc_cache *cache;
+  uint8_t *ptr;
+  uint16_t seqno;
+  uint8_t addr_len;
 
   originator = olsrv2_originator_get(af_type);
-  if (netaddr_get_address_family(originator) == af_type) {
-    OONF_INFO(LOG_OLSRV2_W, "Emit IPv%d TC message.", af_type == AF_INET ? 4 : 6);
-    oonf_rfc5444_send_all(_protocol, RFC7181_MSGTYPE_TC,
-        af_type == AF_INET ? 4 : 16, nhdp_flooding_selector);
+  if (netaddr_get_address_family(originator) != af_type) {
+    return;
+  }
+
+  addr_len = af_type == AF_INET ? 4 : 16;
+  cache = &_tc_cache[af_type == AF_INET ? 0 : 1];
+
+  if (_get_tc_content_key(&_tc_key, af_type) == 0
+      && abuf_getlen(&cache->msg) > 0
+      && abuf_getlen(&cache->key) == abuf_getlen(&_tc_key)
+      && memcmp(abuf_getptr(&cache->key), abuf_getptr(&_tc_key),
+          abuf_getlen(&_tc_key)) == 0) {
+    /* header: type, flags, size, originator, hoplimit, hopcount, seqno */
+    ptr = (uint8_t *)abuf_getptr(&cache->msg) + 4 + addr_len + 2;
+    seqno = oonf_rfc5444_get_next_message_seqno(_protocol);
+    ptr[0] = seqno >> 8;
+    ptr[1] = seqno & 255;
+
+    OONF_INFO(LOG_OLSRV2_W, "Emit cached IPv%d TC message (seqno %u).",
+        af_type == AF_INET ? 4 : 6, seqno);
+    if (oonf_rfc5444_send_all_binary(_protocol,
+        (uint8_t *)abuf_getptr(&cache->msg), abuf_getlen(&cache->msg),
+        nhdp_flooding_selector) == RFC5444_OKAY) {
+      return;
+    }
+    OONF_INFO(LOG_OLSRV2_W, "Cached TC does not fit, regenerate it.");
+  }
+
+  /* remember the content key of the new TC */
+  abuf_clear(&cache->msg);
+  abuf_clear(&cache->key);
+  if (!abuf_has_failed(&_tc_key)
+      && _olsrv2_message->_provider_tree.count == 1) {
+    abuf_memcpy(&cache->key, abuf_getptr(&_tc_key), abuf_getlen(&_tc_key));
+  }
+
+  OONF_INFO(LOG_OLSRV2_W, "Emit IPv%d TC message.", af_type == AF_INET ? 4 : 6);
+  _current_tc_cache = cache;
+  oonf_rfc5444_send_all(_protocol, RFC7181_MSGTYPE_TC,
+      addr_len, nhdp_flooding_selector);
+  _current_tc_cache = NULL;
+}
+
+/**
+ * Calculate a key for the content of a TC. Two TCs with the same
+ * key have the same content except for the sequence number.
+ * @param key autobuffer for key
+ * @param af_type address family of TC
+ * @return -1 if an error happened, 0 otherwise
+ */
+static int
+_get_tc_content_key(struct autobuf *key, int af_type) {
+  const struct netaddr_acl *routable_acl;
+  struct nhdp_neighbor_domaindata *neigh_domain;
+  struct nhdp_neighbor *neigh;
+  struct nhdp_naddr *naddr;
+  struct nhdp_domain *domain;
+  struct olsrv2_lan_entry *lan;
+  struct olsrv2_lan_domaindata *lan_data;
+  uint8_t mprtypes[NHDP_MAXIMUM_DOMAINS];
+  bool any_advertised;
+
+  routable_acl = olsrv2_get_routable();
+  abuf_clear(key);
+
+  /* message header and message TLVs */
+  _append_netaddr(key, olsrv2_originator_get(af_type));
+  abuf_append_uint16(key, olsrv2_update_ansn());
+  abuf_append_uint8(key, rfc5497_timetlv_encode(olsrv2_get_tc_interval()));
+  abuf_append_uint8(key, rfc5497_timetlv_encode(olsrv2_get_tc_validity()));
+  abuf_append_uint8(key, os_routing_supports_source_specific(af_type));
+  if (nhdp_domain_get_count() > 1) {
+    abuf_memcpy(key, mprtypes,
+        nhdp_domain_encode_mprtypes_tlvvalue(mprtypes, sizeof(mprtypes)));
+  }
+
+  /* advertised neighbors, see _cb_addAddresses() */
+  list_for_each_element(nhdp_db_get_neigh_list(), neigh, _global_node) {
+    if (!neigh->symmetric) {
+      continue;
+    }
+
+    any_advertised = false;
+    list_for_each_element(nhdp_domain_get_list(), domain, _node) {
+      if (nhdp_domain_get_neighbordata(domain, neigh)->local_is_mpr) {
+        any_advertised = true;
+        break;
+      }
+    }
+    if (!any_advertised) {
+      continue;
+    }
+
+    avl_for_each_element(&neigh->_neigh_addresses, naddr, _neigh_node) {
+      if (netaddr_get_address_family(&naddr->neigh_addr) != af_type) {
+        continue;
+      }
+
+      _append_netaddr(key, &naddr->neigh_addr);
+      abuf_append_uint8(key,
+          netaddr_acl_check_accept(routable_acl, &naddr->neigh_addr));
+      abuf_append_uint8(key,
+          netaddr_cmp(&neigh->originator, &naddr->neigh_addr) == 0);
+
+      list_for_each_element(nhdp_domain_get_list(), domain, _node) {
+        neigh_domain = nhdp_domain_get_neighbordata(domain, neigh);
+        abuf_append_uint8(key, neigh_domain->local_is_mpr);
+        abuf_append_uint32(key, neigh_domain->metric.in);
+        abuf_append_uint32(key, neigh_domain->metric.out);
+      }
+    }
   }
+
+  /* locally attached networks */
+  avl_for_each_element(olsrv2_lan_get_tree(), lan, _node) {
+    if (netaddr_get_address_family(&lan->prefix.dst) != af_type) {
+      continue;
+    }
+
+    _append_netaddr(key, &lan->prefix.dst);
+    _append_netaddr(key, &lan->prefix.src);
+    abuf_append_uint8(key, lan->same_distance);
+
+    list_for_each_element(nhdp_domain_get_list(), domain, _node) {
+      lan_data = olsrv2_lan_get_domaindata(domain, lan);
+      abuf_append_uint32(key, lan_data->outgoing_metric);
+      abuf_append_uint8(key, lan_data->distance);
+    }
+  }
+  return abuf_has_failed(key) ? -1 : 0;
+}
+
+/**
+ * Append an address and its prefix length to a TC content key
+ * @param key autobuffer for key
+ * @param addr network address
+ */
+static void
+_append_netaddr(struct autobuf *key, const struct netaddr *addr) {
+  abuf_append_uint8(key, netaddr_get_address_family(addr));
+  abuf_append_uint8(key, netaddr_get_prefix_length(addr));
+  abuf_memcpy(key, netaddr_get_binptr(addr), netaddr_get_binlength(addr));
 }
 
 /**
@@ -567,3 +750,31 @@ _cb_finishMessageTLVs(struct rfc5444_writer *writer,
       complete ? RFC7181_CONT_SEQ_NUM_COMPLETE : RFC7181_CONT_SEQ_NUM_INCOMPLETE,
       &ansn, sizeof(ansn));
 }
+
+/**
+ * Callback triggered when a TC has been serialized
+ * @param writer
+ * @param message
+ * @param buffer pointer to binary TC
+ * @param len length of binary TC
+ * @param complete true if TC has not been fragmented
+ */
+static void
+_cb_messageGenerated(struct rfc5444_writer *writer __attribute__((unused)),
+    struct rfc5444_writer_message *message __attribute__((unused)),
+    const uint8_t *buffer, size_t len, bool complete) {
+  if (_current_tc_cache == NULL || abuf_getlen(&_current_tc_cache->key) == 0) {
+    return;
+  }
+
+  abuf_clear(&_current_tc_cache->msg);
+  if (!complete) {
+    /* fragmented TCs are generated from scratch every time */
+    abuf_clear(&_current_tc_cache->key);
+    return;
+  }
+
+  if (abuf_memcpy(&_current_tc_cache->msg, buffer, len)) {
+    abuf_clear(&_current_tc_cache->msg);
+  }
+}
@@ -676,7 +676,7 @@ static int
 _cb_create_text_node(struct oonf_viewer_template *template) {
   struct olsrv2_tc_node *node;
 
-  avl_for_each_element(olsrv2_tc_get_tree(), node, _originator_node) {
+  btree_for_each_element(olsrv2_tc_get_tree(), node, _originator_node) {
     if (olsrv2_tc_is_node_virtual(node)) {
       continue;
     }
@@ -698,7 +698,7 @@ _cb_create_text_attached_network(struct oonf_viewer_template *template) {
   struct olsrv2_tc_attachment *attached;
   struct nhdp_domain *domain;
 
-  avl_for_each_element(olsrv2_tc_get_tree(), node, _originator_node) {
+  btree_for_each_element(olsrv2_tc_get_tree(), node, _originator_node) {
     _initialize_node_values(node);
 
     if (olsrv2_tc_is_node_virtual(node)) {
@@ -734,7 +734,7 @@ _cb_create_text_edge(struct oonf_viewer_template *template) {
   struct nhdp_domain *domain;
   uint32_t metric;
 
-  avl_for_each_element(olsrv2_tc_get_tree(), node, _originator_node) {
+  btree_for_each_element(olsrv2_tc_get_tree(), node, _originator_node) {
     _initialize_node_values(node);
 
     if (olsrv2_tc_is_node_virtual(node)) {
@@ -774,7 +774,7 @@ _cb_create_text_route(struct oonf_viewer_template *template) {
   list_for_each_element(nhdp_domain_get_list(), domain, _node) {
     _initialize_domain_values(domain);
 
-    avl_for_each_element(olsrv2_routing_get_tree(domain),
+    btree_for_each_element(olsrv2_routing_get_tree(domain),
         route, _node) {
       _initialize_domain_path_metric_values(
           domain, route->path_cost, route->path_hops);
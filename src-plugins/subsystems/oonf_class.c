@@ -45,6 +45,10 @@
 
 #include <assert.h>
 #include <stdlib.h>
+#ifdef OONF_CLASS_SLAB
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 
 #include "common/avl.h"
 #include "common/avl_comp.h"
@@ -52,15 +56,43 @@
 #include "core/oonf_subsystem.h"
 
 #include "subsystems/oonf_class.h"
+#include "subsystems/oonf_socket.h"
 
 /* Definitions */
 #define LOG_CLASS (_oonf_class_subsystem.logging)
 
+/*! minimum number of objects per slab */
+#define OONF_CLASS_SLAB_MIN_OBJECTS 8
+
+/**
+ * Header at the start of each slab, the objects of the slab follow
+ * directly behind it. Slabs are aligned to their size, so the slab of
+ * an object can be calculated from its address.
+ */
+struct _class_slab {
+  /*! node for the list of slabs with free objects */
+  struct list_entity _node;
+
+  /*! singly linked list of freed objects */
+  void *free_objects;
+
+  /*! first object that was never used */
+  char *unused;
+
+  /*! number of objects in use */
+  uint32_t used;
+};
+
 /* prototypes */
 static int _init(void);
 static void _cleanup(void);
 
+static void *_alloc_object(struct oonf_class *ci, bool *reuse);
+static void _free_object(struct oonf_class *ci, void *ptr, bool *reuse);
 static void _free_freelist(struct oonf_class *);
+static void _fire_event(struct oonf_class *c, void *ptr, enum oonf_class_event evt);
+static void _cancel_change(struct oonf_class *c, void *ptr);
+static void _cb_iteration_end(void);
 static size_t _roundup(size_t);
 static const char *_cb_to_keystring(struct oonf_objectkey_str *,
     struct oonf_class *, void *);
@@ -68,6 +100,22 @@ static const char *_cb_to_keystring(struct oonf_objectkey_str *,
 /* list of memory cookies */
 static struct avl_tree _classes_tree;
 
+/* list of classes with pending change events */
+static struct list_entity _pending_classes;
+
+/* deliver pending change events at the end of each scheduler iteration */
+static struct oonf_socket_iteration_hook _flush_hook = {
+  .cb_iteration_end = _cb_iteration_end,
+};
+
+#ifdef OONF_CLASS_SLAB
+static struct _class_slab *_add_slab(struct oonf_class *ci);
+static void _remove_slab(struct oonf_class *ci, struct _class_slab *slab);
+
+/* size of a memory page */
+static size_t _page_size;
+#endif
+
 /* name of event types */
 static const char *OONF_CLASS_EVENT_NAME[] = {
   [OONF_OBJECT_ADDED] = "added",
@@ -76,8 +124,14 @@ static const char *OONF_CLASS_EVENT_NAME[] = {
 };
 
 /* subsystem definition */
+static const char *_dependencies[] = {
+  OONF_SOCKET_SUBSYSTEM,
+};
+
 static struct oonf_subsystem _oonf_class_subsystem = {
   .name = OONF_CLASS_SUBSYSTEM,
+  .dependencies = _dependencies,
+  .dependencies_count = ARRAYSIZE(_dependencies),
   .init = _init,
   .cleanup = _cleanup,
 };
@@ -90,6 +144,11 @@ DECLARE_OONF_PLUGIN(_oonf_class_subsystem);
 static int
 _init(void) {
   avl_init(&_classes_tree, avl_comp_strcasecmp, false);
+  list_init_head(&_pending_classes);
+#ifdef OONF_CLASS_SLAB
+  _page_size = sysconf(_SC_PAGESIZE);
+#endif
+  oonf_socket_add_iteration_hook(&_flush_hook);
   return 0;
 }
 
@@ -101,6 +160,8 @@ _cleanup(void)
 {
   struct oonf_class *info, *iterator;
 
+  oonf_socket_remove_iteration_hook(&_flush_hook);
+
   /*
    * Walk the full index range and kill 'em all.
    */
@@ -121,6 +182,12 @@ oonf_class_add(struct oonf_class *ci)
   /* round up size to make block extendable */
   ci->total_size = _roundup(ci->size);
 
+  if (ci->defer_changes) {
+    /* reserve a list node for pending change events */
+    ci->_event_offset = ci->total_size;
+    ci->total_size = _roundup(ci->total_size + sizeof(struct list_entity));
+  }
+
   /* hook into tree */
   ci->_node.key = ci->name;
   avl_insert(&_classes_tree, &ci->_node);
@@ -132,7 +199,9 @@ oonf_class_add(struct oonf_class *ci)
 
   /* Init list heads */
   list_init_head(&ci->_free_list);
+  list_init_head(&ci->_slabs);
   list_init_head(&ci->_extensions);
+  list_init_head(&ci->_pending_changes);
 
   OONF_DEBUG(LOG_CLASS, "Class %s added: %" PRINTF_SIZE_T_SPECIFIER " bytes\n",
              ci->name, ci->total_size);
@@ -150,6 +219,14 @@ oonf_class_remove(struct oonf_class *ci)
   /* remove memcookie from tree */
   avl_remove(&_classes_tree, &ci->_node);
 
+  /* drop pending change events */
+  while (!list_is_empty(&ci->_pending_changes)) {
+    list_remove(ci->_pending_changes.next);
+  }
+  if (list_is_node_added(&ci->_pending_node)) {
+    list_remove(&ci->_pending_node);
+  }
+
   /* remove all free memory blocks */
   _free_freelist(ci);
 
@@ -169,43 +246,13 @@ oonf_class_remove(struct oonf_class *ci)
 void *
 oonf_class_malloc(struct oonf_class *ci)
 {
-  struct list_entity *entity;
   void *ptr;
-
-#ifdef OONF_LOG_DEBUG_INFO
   bool reuse = false;
-#endif
 
-  /*
-   * Check first if we have reusable memory.
-   */
-  if (list_is_empty(&ci->_free_list)) {
-    /*
-     * No reusable memory block on the free_list.
-     * Allocate a fresh one.
-     */
-    ptr = calloc(1, ci->total_size);
-    if (ptr == NULL) {
-      OONF_WARN(LOG_CLASS, "Out of memory for: %s", ci->name);
-      return NULL;
-    }
-    ci->_allocated++;
-  } else {
-    /*
-     * There is a memory block on the free list.
-     * Carve it out of the list, and clean.
-     */
-    entity = ci->_free_list.next;
-    list_remove(entity);
-
-    memset(entity, 0, ci->total_size);
-    ptr = entity;
-
-    ci->_free_list_size--;
-    ci->_recycled++;
-#ifdef OONF_LOG_DEBUG_INFO
-    reuse = true;
-#endif
+  ptr = _alloc_object(ci, &reuse);
+  if (ptr == NULL) {
+    OONF_WARN(LOG_CLASS, "Out of memory for: %s", ci->name);
+    return NULL;
   }
 
   /* Stats keeping */
@@ -224,32 +271,14 @@ oonf_class_malloc(struct oonf_class *ci)
 void
 oonf_class_free(struct oonf_class *ci, void *ptr)
 {
-  struct list_entity *item;
-#ifdef OONF_LOG_DEBUG_INFO
   bool reuse = false;
-#endif
-
-  /*
-   * Rather than freeing the memory right away, try to reuse at a later
-   * point. Keep at least ten percent of the active used blocks or at least
-   * ten blocks on the free list.
-   */
-  if (ci->_free_list_size < ci->min_free_count
-      || (ci->_free_list_size < ci->_current_usage / 10)) {
-    item = ptr;
-
-    list_add_tail(&ci->_free_list, item);
-
-    ci->_free_list_size++;
-#ifdef OONF_LOG_DEBUG_INFO
-    reuse = true;
-#endif
-  } else {
 
-    /* No interest in reusing memory. */
-    free(ptr);
+  if (ci->defer_changes) {
+    _cancel_change(ci, ptr);
   }
 
+  _free_object(ci, ptr, &reuse);
+
   /* Stats keeping */
   ci->_current_usage--;
 
@@ -319,13 +348,100 @@ oonf_class_extension_remove(struct oonf_class_extension *ext) {
 }
 
 /**
- * Fire an event for a class
+ * Fire an event for a class. Change events of classes with
+ * defer_changes are queued until oonf_class_flush_events() is called.
  * @param c pointer to class
  * @param ptr pointer to object
  * @param evt type of event
  */
 void
 oonf_class_event(struct oonf_class *c, void *ptr, enum oonf_class_event evt) {
+  struct list_entity *node;
+
+  if (evt == OONF_OBJECT_CHANGED) {
+    c->_changes++;
+
+    if (c->defer_changes) {
+      node = (struct list_entity *)(((char *)ptr) + c->_event_offset);
+      if (list_is_node_added(node)) {
+        /* already pending */
+        c->_suppressed++;
+        return;
+      }
+
+      if (list_is_empty(&c->_pending_changes)) {
+        list_add_tail(&_pending_classes, &c->_pending_node);
+      }
+      list_add_tail(&c->_pending_changes, node);
+      return;
+    }
+  }
+  else if (evt == OONF_OBJECT_REMOVED && c->defer_changes) {
+    _cancel_change(c, ptr);
+  }
+
+  _fire_event(c, ptr, evt);
+}
+
+/**
+ * Deliver all pending change events, each object gets only one
+ * change event. This is called by the socket scheduler iteration
+ * hook. Change events triggered by the listeners are delivered
+ * in the same call.
+ */
+void
+oonf_class_flush_events(void) {
+  struct oonf_class *c;
+  struct list_entity *node;
+
+  while (!list_is_empty(&_pending_classes)) {
+    c = list_first_element(&_pending_classes, c, _pending_node);
+
+    node = c->_pending_changes.next;
+    list_remove(node);
+    if (list_is_empty(&c->_pending_changes)) {
+      list_remove(&c->_pending_node);
+    }
+
+    _fire_event(c, ((char *)node) - c->_event_offset, OONF_OBJECT_CHANGED);
+  }
+}
+
+/**
+ * Callback at the end of each scheduler iteration
+ */
+static void
+_cb_iteration_end(void) {
+  oonf_class_flush_events();
+}
+
+/**
+ * get tree of memory classes
+ * @return class tree
+ */
+struct avl_tree *
+oonf_class_get_tree(void) {
+  return &_classes_tree;
+}
+
+/**
+ * get name of memory class event
+ * @param event type of event
+ * @return name of event
+ */
+const char *
+oonf_class_get_event_name(enum oonf_class_event event) {
+  return OONF_CLASS_EVENT_NAME[event];
+}
+
+/**
+ * Call the listeners of a class for an event
+ * @param c pointer to class
+ * @param ptr pointer to object
+ * @param evt type of event
+ */
+static void
+_fire_event(struct oonf_class *c, void *ptr, enum oonf_class_event evt) {
   struct oonf_class_extension *ext;
 #ifdef OONF_LOG_DEBUG_INFO
   struct oonf_objectkey_str buf;
@@ -351,22 +467,25 @@ oonf_class_event(struct oonf_class *c, void *ptr, enum oonf_class_event evt) {
 }
 
 /**
- * get tree of memory classes
- * @return class tree
+ * Drop the pending change event of an object
+ * @param c pointer to class
+ * @param ptr pointer to object
  */
-struct avl_tree *
-oonf_class_get_tree(void) {
-  return &_classes_tree;
-}
+static void
+_cancel_change(struct oonf_class *c, void *ptr) {
+  struct list_entity *node;
 
-/**
- * get name of memory class event
- * @param event type of event
- * @return name of event
- */
-const char *
-oonf_class_get_event_name(enum oonf_class_event event) {
-  return OONF_CLASS_EVENT_NAME[event];
+  node = (struct list_entity *)(((char *)ptr) + c->_event_offset);
+  if (!list_is_node_added(node)) {
+    return;
+  }
+
+  list_remove(node);
+  c->_suppressed++;
+
+  if (list_is_empty(&c->_pending_changes)) {
+    list_remove(&c->_pending_node);
+  }
 }
 
 /**
@@ -381,6 +500,269 @@ _roundup(size_t size) {
   return size;
 }
 
+#ifdef OONF_CLASS_SLAB
+/**
+ * Get a zeroed object from the first slab with free objects,
+ * allocate a new slab if necessary.
+ * @param ci pointer to memory cookie
+ * @param reuse will be set to true if a freed object was recycled
+ * @return pointer to object, NULL if out of memory
+ */
+static void *
+_alloc_object(struct oonf_class *ci, bool *reuse) {
+  struct _class_slab *slab;
+  void *ptr;
+
+  if (list_is_empty(&ci->_slabs)) {
+    slab = _add_slab(ci);
+    if (slab == NULL) {
+      return NULL;
+    }
+  }
+  else {
+    slab = list_first_element(&ci->_slabs, slab, _node);
+  }
+
+  if (slab->used == 0) {
+    ci->_empty_slabs--;
+  }
+
+  if (slab->free_objects) {
+    /* recycle a freed object */
+    ptr = slab->free_objects;
+    slab->free_objects = *((void **)ptr);
+
+    memset(ptr, 0, ci->total_size);
+    ci->_recycled++;
+    *reuse = true;
+  }
+  else {
+    /* take a fresh object, mmap() already cleared it */
+    ptr = slab->unused;
+    slab->unused += ci->total_size;
+    ci->_allocated++;
+  }
+
+  slab->used++;
+  ci->_free_list_size--;
+
+  if (slab->used == ci->_slab_objects) {
+    /* slab is full */
+    list_remove(&slab->_node);
+  }
+  return ptr;
+}
+
+/**
+ * Return an object into its slab. Empty slabs are returned to the
+ * operating system, except for one per class (or more to keep
+ * min_free_count objects available).
+ * @param ci pointer to memory cookie
+ * @param ptr pointer to object
+ * @param reuse will be set to true if the slab of the object is kept
+ */
+static void
+_free_object(struct oonf_class *ci, void *ptr, bool *reuse) {
+  struct _class_slab *slab;
+
+  slab = (struct _class_slab *)((uintptr_t)ptr & ~(uintptr_t)(ci->_slab_size - 1));
+
+  *((void **)ptr) = slab->free_objects;
+  slab->free_objects = ptr;
+
+  if (slab->used == ci->_slab_objects) {
+    /* slab was full, prefer it for the next allocation */
+    list_add_head(&ci->_slabs, &slab->_node);
+  }
+
+  slab->used--;
+  ci->_free_list_size++;
+  *reuse = true;
+
+  if (slab->used > 0) {
+    return;
+  }
+
+  if (ci->_empty_slabs > 0
+      && ci->_free_list_size - ci->_slab_objects >= ci->min_free_count) {
+    _remove_slab(ci, slab);
+    *reuse = false;
+  }
+  else {
+    /* keep empty slab, but use partially filled slabs first */
+    ci->_empty_slabs++;
+    list_remove(&slab->_node);
+    list_add_tail(&ci->_slabs, &slab->_node);
+  }
+}
+
+/**
+ * Allocate a new slab for a class and add it to the list
+ * of slabs with free objects.
+ * @param ci pointer to memory cookie
+ * @return pointer to slab, NULL if out of memory
+ */
+static struct _class_slab *
+_add_slab(struct oonf_class *ci) {
+  struct _class_slab *slab;
+  size_t header, object_size, size, offset;
+  char *ptr;
+
+  /* the size of a class cannot change while it has slabs */
+  header = _roundup(sizeof(struct _class_slab));
+  object_size = ci->total_size;
+
+  size = _page_size;
+  while ((size - header) / object_size < OONF_CLASS_SLAB_MIN_OBJECTS) {
+    size <<= 1;
+  }
+
+  ptr = mmap(NULL, size, PROT_READ | PROT_WRITE,
+      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (ptr == MAP_FAILED) {
+    return NULL;
+  }
+
+  if ((uintptr_t)ptr & (size - 1)) {
+    /* map twice the size and cut out an aligned slab */
+    munmap(ptr, size);
+
+    ptr = mmap(NULL, size * 2, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ptr == MAP_FAILED) {
+      return NULL;
+    }
+
+    offset = size - ((uintptr_t)ptr & (size - 1));
+    munmap(ptr, offset);
+    munmap(ptr + offset + size, size - offset);
+    ptr += offset;
+  }
+
+  ci->_slab_size = size;
+  ci->_slab_objects = (size - header) / object_size;
+
+  slab = (struct _class_slab *)ptr;
+  slab->unused = ptr + header;
+  list_add_head(&ci->_slabs, &slab->_node);
+
+  ci->_slab_count++;
+  ci->_empty_slabs++;
+  ci->_free_list_size += ci->_slab_objects;
+  ci->_memory += size;
+
+  OONF_DEBUG(LOG_CLASS, "Class %s: new slab with %u objects, %"
+      PRINTF_SIZE_T_SPECIFIER " bytes\n", ci->name, ci->_slab_objects, size);
+  return slab;
+}
+
+/**
+ * Return an empty slab to the operating system
+ * @param ci pointer to memory cookie
+ * @param slab pointer to slab
+ */
+static void
+_remove_slab(struct oonf_class *ci, struct _class_slab *slab) {
+  list_remove(&slab->_node);
+
+  ci->_slab_count--;
+  ci->_free_list_size -= ci->_slab_objects;
+  ci->_memory -= ci->_slab_size;
+
+  munmap(slab, ci->_slab_size);
+}
+
+/**
+ * Return all empty slabs of a memory cookie to the operating system.
+ * Slabs with objects still in use are kept.
+ * @param ci pointer to memory cookie
+ */
+static void
+_free_freelist(struct oonf_class *ci) {
+  struct _class_slab *slab, *iterator;
+
+  list_for_each_element_safe(&ci->_slabs, slab, _node, iterator) {
+    if (slab->used == 0) {
+      _remove_slab(ci, slab);
+    }
+  }
+  ci->_empty_slabs = 0;
+}
+#else
+/**
+ * Get a zeroed object from the free list or allocate a new one.
+ * @param ci pointer to memory cookie
+ * @param reuse will be set to true if a freed object was recycled
+ * @return pointer to object, NULL if out of memory
+ */
+static void *
+_alloc_object(struct oonf_class *ci, bool *reuse) {
+  struct list_entity *entity;
+  void *ptr;
+
+  /*
+   * Check first if we have reusable memory.
+   */
+  if (list_is_empty(&ci->_free_list)) {
+    /*
+     * No reusable memory block on the free_list.
+     * Allocate a fresh one.
+     */
+    ptr = calloc(1, ci->total_size);
+    if (ptr == NULL) {
+      return NULL;
+    }
+    ci->_allocated++;
+    ci->_memory += ci->total_size;
+  } else {
+    /*
+     * There is a memory block on the free list.
+     * Carve it out of the list, and clean.
+     */
+    entity = ci->_free_list.next;
+    list_remove(entity);
+
+    memset(entity, 0, ci->total_size);
+    ptr = entity;
+
+    ci->_free_list_size--;
+    ci->_recycled++;
+    *reuse = true;
+  }
+  return ptr;
+}
+
+/**
+ * Put an object into the free list or free it.
+ * @param ci pointer to memory cookie
+ * @param ptr pointer to object
+ * @param reuse will be set to true if the object was put into the free list
+ */
+static void
+_free_object(struct oonf_class *ci, void *ptr, bool *reuse) {
+  struct list_entity *item;
+
+  /*
+   * Rather than freeing the memory right away, try to reuse at a later
+   * point. Keep at least ten percent of the active used blocks or at least
+   * ten blocks on the free list.
+   */
+  if (ci->_free_list_size < ci->min_free_count
+      || (ci->_free_list_size < ci->_current_usage / 10)) {
+    item = ptr;
+
+    list_add_tail(&ci->_free_list, item);
+
+    ci->_free_list_size++;
+    *reuse = true;
+  } else {
+
+    /* No interest in reusing memory. */
+    free(ptr);
+    ci->_memory -= ci->total_size;
+  }
+}
+
 /**
  * Free all objects in the free_list of a memory cookie
  * @param ci pointer to memory cookie
@@ -393,9 +775,11 @@ _free_freelist(struct oonf_class *ci) {
 
     list_remove(item);
     free(item);
+    ci->_memory -= ci->total_size;
   }
   ci->_free_list_size = 0;
 }
+#endif
 
 /**
  * Default keystring creator
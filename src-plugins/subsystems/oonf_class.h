@@ -91,6 +91,16 @@ struct oonf_class {
    */
   uint32_t min_free_count;
 
+  /**
+   * true if OONF_OBJECT_CHANGED events should be queued and delivered
+   * only once per object at the end of the current scheduler iteration.
+   * Added and removed events are still delivered immediately.
+   * nhdp_db.c sets this for the NHDP neighbor and link classes, so all
+   * of their change listeners run after the triggering callback has
+   * returned instead of during oonf_class_event().
+   */
+  bool defer_changes;
+
   /**
    * Callback to convert object pointer into a human readable string
    * @param buf output buffer for text
@@ -110,10 +120,28 @@ struct oonf_class {
   /*! List head for recyclable blocks */
   struct list_entity _free_list;
 
+  /*! List head for slabs with free objects (slab backend) */
+  struct list_entity _slabs;
+
   /*! extensions of this class */
   struct list_entity _extensions;
 
-  /*! Length of free list */
+  /*! Size of a slab in bytes, slabs are aligned to their size */
+  size_t _slab_size;
+
+  /*! Number of objects in one slab */
+  uint32_t _slab_objects;
+
+  /*! Stats, number of slabs */
+  uint32_t _slab_count;
+
+  /*! Number of slabs without used objects */
+  uint32_t _empty_slabs;
+
+  /*! Stats, bytes of memory currently allocated by this class */
+  size_t _memory;
+
+  /*! Length of free list (number of free objects in slabs) */
   uint32_t _free_list_size;
 
   /*! Stats, resource usage */
@@ -124,6 +152,21 @@ struct oonf_class {
 
   /*! Stats, recycled memory blocks */
   uint32_t _recycled;
+
+  /*! offset of the pending change event node within the memory block */
+  size_t _event_offset;
+
+  /*! objects with a pending change event */
+  struct list_entity _pending_changes;
+
+  /*! node for the list of classes with pending change events */
+  struct list_entity _pending_node;
+
+  /*! Stats, change events */
+  uint32_t _changes;
+
+  /*! Stats, change events merged into a pending one or dropped by removal */
+  uint32_t _suppressed;
 };
 
 /**
@@ -180,6 +223,7 @@ EXPORT int oonf_class_extension_add(struct oonf_class_extension *);
 EXPORT void oonf_class_extension_remove(struct oonf_class_extension *);
 
 EXPORT void oonf_class_event(struct oonf_class *, void *, enum oonf_class_event);
+EXPORT void oonf_class_flush_events(void);
 
 EXPORT struct avl_tree *oonf_class_get_tree(void);
 EXPORT const char *oonf_class_get_event_name(enum oonf_class_event);
@@ -220,6 +264,60 @@ oonf_class_get_recycled(struct oonf_class *ci) {
   return ci->_recycled;
 }
 
+/**
+ * @param ci pointer to class
+ * @return total number of change events during runtime
+ */
+static INLINE uint32_t
+oonf_class_get_change_events(struct oonf_class *ci) {
+  return ci->_changes;
+}
+
+/**
+ * @param ci pointer to class
+ * @return number of change events that were not delivered because
+ *   they were coalesced with a pending one
+ */
+static INLINE uint32_t
+oonf_class_get_suppressed_events(struct oonf_class *ci) {
+  return ci->_suppressed;
+}
+
+/**
+ * @param ci pointer to class
+ * @return number of bytes currently allocated for this class,
+ *   including free blocks and slab overhead
+ */
+static INLINE size_t
+oonf_class_get_memory(struct oonf_class *ci) {
+  return ci->_memory;
+}
+
+/**
+ * @param ci pointer to class
+ * @return number of slabs allocated for this class,
+ *   always 0 without slab backend
+ */
+static INLINE uint32_t
+oonf_class_get_slabs(struct oonf_class *ci) {
+  return ci->_slab_count;
+}
+
+/**
+ * @param ci pointer to class
+ * @return percentage of allocated memory not used by objects
+ */
+static INLINE uint32_t
+oonf_class_get_fragmentation(struct oonf_class *ci) {
+  size_t used;
+
+  if (ci->_memory == 0) {
+    return 0;
+  }
+  used = (size_t)ci->_current_usage * ci->total_size;
+  return 100 - (uint32_t)(used * 100 / ci->_memory);
+}
+
 /**
  * @param ext extension data structure
  * @param ptr pointer to base block
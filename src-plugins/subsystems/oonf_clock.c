@@ -64,8 +64,17 @@
 /* definitions */
 #define LOG_CLOCK _oonf_clock_subsystem.logging
 
+/**
+ * Configuration of clock subsystem
+ */
+struct _clock_config {
+  /*! true if the clock is driven by the scheduler instead of the OS */
+  bool simulation;
+};
+
 /* prototypes */
 static int _init(void);
+static void _cb_config_changed(void);
 
 /* absolute monotonic clock measured in milliseconds compared to start time */
 static uint64_t now_times;
@@ -73,6 +82,25 @@ static uint64_t now_times;
 /* arbitrary timestamp that represents the time oonf_clock_init() was called */
 static uint64_t start_time;
 
+/* true if the clock only moves by oonf_clock_advance() */
+static bool _virtual_clock = false;
+
+/* configuration of clock subsystem */
+static struct cfg_schema_entry _clock_entries[] = {
+  CFG_MAP_BOOL(_clock_config, simulation, "simulation", "false",
+      "Run on a virtual clock that jumps to the next timer event"
+      " if no socket event is pending, for simulations and benchmarks"),
+};
+
+static struct cfg_schema_section _clock_section = {
+  .type = OONF_CLOCK_SUBSYSTEM,
+  .mode = CFG_SSMODE_UNNAMED,
+  .help = "Settings for the internal clock",
+  .cb_delta_handler = _cb_config_changed,
+  .entries = _clock_entries,
+  .entry_count = ARRAYSIZE(_clock_entries),
+};
+
 /* subsystem definition */
 static const char *_dependencies[] = {
   OONF_OS_CLOCK_SUBSYSTEM,
@@ -83,6 +111,7 @@ static struct oonf_subsystem _oonf_clock_subsystem = {
   .dependencies = _dependencies,
   .dependencies_count = ARRAYSIZE(_dependencies),
   .init = _init,
+  .cfg_section = &_clock_section,
 };
 DECLARE_OONF_PLUGIN(_oonf_clock_subsystem);
 
@@ -98,6 +127,7 @@ _init(void) {
   }
 
   now_times = 0;
+  _virtual_clock = false;
 
   return 0;
 }
@@ -110,6 +140,11 @@ int
 oonf_clock_update(void)
 {
   uint64_t now;
+
+  if (_virtual_clock) {
+    /* time only moves forward by oonf_clock_advance() */
+    return 0;
+  }
   if (os_clock_gettime64(&now)) {
     OONF_WARN(LOG_CLOCK, "OS clock is not working: %s (%d)\n", strerror(errno), errno);
     return -1;
@@ -128,6 +163,53 @@ oonf_clock_getNow(void) {
   return now_times;
 }
 
+/**
+ * Switch between the OS clock and a virtual clock. The internal time
+ * never jumps backward, switching back to the OS clock continues from
+ * the current virtual time.
+ * @param virtual true to use a virtual clock, false to use the OS clock
+ */
+void
+oonf_clock_set_virtual(bool virtual) {
+  uint64_t now;
+
+  if (_virtual_clock == virtual) {
+    return;
+  }
+
+  if (!virtual && os_clock_gettime64(&now) == 0) {
+    start_time = now - now_times;
+  }
+  _virtual_clock = virtual;
+
+  OONF_INFO(LOG_CLOCK, "Switched to %s clock at %"PRIu64" ms",
+      virtual ? "virtual" : "OS", now_times);
+}
+
+/**
+ * @return true if the clock only moves by oonf_clock_advance()
+ */
+bool
+oonf_clock_is_virtual(void) {
+  return _virtual_clock;
+}
+
+/**
+ * Move the virtual clock forward to a new timestamp
+ * @param absolute new internal time
+ * @return -1 if clock is not virtual or timestamp is in the past,
+ *   0 otherwise
+ */
+int
+oonf_clock_advance(uint64_t absolute) {
+  if (!_virtual_clock || absolute < now_times) {
+    return -1;
+  }
+
+  now_times = absolute;
+  return 0;
+}
+
 /**
  * Format an internal time value into a string.
  * Displays hours:minutes:seconds.millisecond.
@@ -148,3 +230,19 @@ oonf_clock_toClockString(struct isonumber_str *buf, uint64_t clk)
 
   return buf->buf;
 }
+
+/**
+ * Apply changed configuration of clock subsystem
+ */
+static void
+_cb_config_changed(void) {
+  struct _clock_config config;
+
+  if (cfg_schema_tobin(&config, _clock_section.post,
+      _clock_entries, ARRAYSIZE(_clock_entries))) {
+    OONF_WARN(LOG_CLOCK, "Cannot convert clock configuration");
+    return;
+  }
+
+  oonf_clock_set_virtual(config.simulation);
+}
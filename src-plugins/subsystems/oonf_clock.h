@@ -165,6 +165,10 @@ EXPORT int oonf_clock_update(void) __attribute__((warn_unused_result));
 
 EXPORT uint64_t oonf_clock_getNow(void);
 
+EXPORT void oonf_clock_set_virtual(bool virtual);
+EXPORT bool oonf_clock_is_virtual(void);
+EXPORT int oonf_clock_advance(uint64_t absolute);
+
 EXPORT const char *oonf_clock_toClockString(struct isonumber_str *, uint64_t);
 
 /**
@@ -43,13 +43,13 @@
  * @file
  */
 
-#include "common/avl.h"
-#include "common/avl_comp.h"
+#include <stdlib.h>
+
 #include "common/common_types.h"
 #include "common/netaddr.h"
 #include "rfc5444/rfc5444.h"
 #include "core/oonf_subsystem.h"
-#include "subsystems/oonf_class.h"
+#include "subsystems/oonf_clock.h"
 #include "subsystems/oonf_timer.h"
 
 #include "subsystems/oonf_duplicate_set.h"
@@ -63,21 +63,21 @@ static void _cleanup(void);
 
 static enum oonf_duplicate_result _test(struct oonf_duplicate_set *,
     struct oonf_duplicate_entry *, uint64_t seqno, bool set);
-static int _avl_cmp_dupkey(const void *, const void*);
+static uint32_t _hash_key(const struct oonf_duplicate_entry_key *key);
+static struct oonf_duplicate_entry *_lookup(struct oonf_duplicate_set *set,
+    const struct oonf_duplicate_entry_key *key, uint32_t hash);
+static struct oonf_duplicate_entry *_get_slot(struct oonf_duplicate_entry *entries,
+    uint32_t size, uint32_t hash);
+static int _resize(struct oonf_duplicate_set *set, uint32_t size);
+static void _schedule_expiry(struct oonf_duplicate_set *set, uint32_t expiry);
 
 static void _cb_vtime(struct oonf_timer_instance *);
-static void _remove_duplicate_entry(struct oonf_duplicate_entry *entry);
 
 static struct oonf_timer_class _vtime_info = {
   .name = "Valdity time for duplicate set",
   .callback = _cb_vtime,
 };
 
-static struct oonf_class _dupset_class = {
-  .name = "Duplicate set",
-  .size = sizeof(struct oonf_duplicate_entry),
-};
-
 /* dupset result names */
 static const char *OONF_DUPSET_RESULT_STR[] = {
   [OONF_DUPSET_TOO_OLD]   = "too old",
@@ -90,7 +90,7 @@ static const char *OONF_DUPSET_RESULT_STR[] = {
 
 /* subsystem definition */
 static const char *_dependencies[] = {
-  OONF_CLASS_SUBSYSTEM,
+  OONF_CLOCK_SUBSYSTEM,
   OONF_TIMER_SUBSYSTEM,
 };
 
@@ -116,7 +116,6 @@ static const int64_t _mask_values[] = {
  */
 static int
 _init(void) {
-  oonf_class_add(&_dupset_class);
   oonf_timer_add(&_vtime_info);
   return 0;
 }
@@ -127,7 +126,6 @@ _init(void) {
 static void
 _cleanup(void) {
   oonf_timer_remove(&_vtime_info);
-  oonf_class_remove(&_dupset_class);
 }
 
 /**
@@ -138,7 +136,7 @@ _cleanup(void) {
 void
 oonf_duplicate_set_add(struct oonf_duplicate_set *set, enum oonf_dupset_type type) {
   memset(set, 0, sizeof(*set));
-  avl_init(&set->_tree, _avl_cmp_dupkey, false);
+  set->_expiry_timer.class = &_vtime_info;
 
   if (type != OONF_DUPSET_64BIT) {
     set->_mask   = _mask_values[type];
@@ -153,11 +151,12 @@ oonf_duplicate_set_add(struct oonf_duplicate_set *set, enum oonf_dupset_type typ
  */
 void
 oonf_duplicate_set_remove(struct oonf_duplicate_set *set) {
-  struct oonf_duplicate_entry *entry, *it;
+  oonf_timer_stop(&set->_expiry_timer);
 
-  avl_for_each_element_safe(&set->_tree, entry, _node, it) {
-    _remove_duplicate_entry(entry);
-  }
+  free(set->_entries);
+  set->_entries = NULL;
+  set->_size = 0;
+  set->_count = 0;
 }
 
 /**
@@ -179,6 +178,7 @@ oonf_duplicate_entry_add(struct oonf_duplicate_set *set, uint8_t msg_type,
   struct oonf_duplicate_entry *entry;
   struct oonf_duplicate_entry_key key;
   enum oonf_duplicate_result result;
+  uint32_t hash;
 
 #ifdef OONF_LOG_DEBUG_INFO
   struct netaddr_str nbuf;
@@ -187,30 +187,30 @@ oonf_duplicate_entry_add(struct oonf_duplicate_set *set, uint8_t msg_type,
   /* generate combined key */
   memcpy(&key.addr, originator, sizeof(*originator));
   key.msg_type = msg_type;
+  hash = _hash_key(&key);
 
-  entry = avl_find_element(&set->_tree, &key, entry, _node);
+  entry = _lookup(set, &key, hash);
   if (!entry) {
-    entry = oonf_class_malloc(&_dupset_class);
-    if (entry == NULL) {
+    /* keep the load factor of the hash table below 3/4 */
+    if ((set->_count + 1) * 4 > set->_size * 3
+        && _resize(set, set->_size ? set->_size * 2 : OONF_DUPSET_MINIMUM_SIZE)) {
       return OONF_DUPSET_TOO_OLD;
     }
 
+    entry = _get_slot(set->_entries, set->_size, hash);
+    set->_count++;
+
+    /* set key */
+    memcpy(&entry->key, &key, sizeof(key));
+    entry->_hash = hash;
+    entry->_expiry = 0;
+  }
+
+  if (entry->_expiry == 0) {
     /* initialize history and current sequence number */
     entry->current = seqno;
     entry->history = 1;
-
-    /* initialize backpointer */
-    entry->set = set;
-
-    /* initialize vtime */
-    entry->_vtime.class = &_vtime_info;
-
-    oonf_timer_start(&entry->_vtime, vtime);
-
-    /* set key and link entry to set */
-    memcpy(&entry->key, &key, sizeof(key));
-    entry->_node.key = &entry->key;
-    avl_insert(&set->_tree, &entry->_node);
+    entry->too_old_count = 0;
 
     result = OONF_DUPSET_FIRST;
   }
@@ -222,8 +222,9 @@ oonf_duplicate_entry_add(struct oonf_duplicate_set *set, uint8_t msg_type,
       OONF_DUPSET_RESULT_STR[result]);
 
   if (oonf_duplicate_is_new(result)) {
-    /* reset validity timer */
-    oonf_timer_set(&entry->_vtime, vtime);
+    /* reset validity time, rounded up to the next generation */
+    entry->_expiry = ((oonf_clock_getNow() + vtime) >> OONF_DUPSET_GENERATION_SHIFT) + 1;
+    _schedule_expiry(set, entry->_expiry);
   }
   return result;
 }
@@ -254,8 +255,8 @@ oonf_duplicate_test(struct oonf_duplicate_set *set, uint8_t msg_type,
   memcpy(&key.addr, originator, sizeof(*originator));
   key.msg_type = msg_type;
 
-  entry = avl_find_element(&set->_tree, &key, entry, _node);
-  if (!entry) {
+  entry = _lookup(set, &key, _hash_key(&key));
+  if (!entry || entry->_expiry == 0) {
     result = OONF_DUPSET_FIRST;
   }
   else {
@@ -269,6 +270,38 @@ oonf_duplicate_test(struct oonf_duplicate_set *set, uint8_t msg_type,
   return result;
 }
 
+/**
+ * Test a originator/sequence number pair against a duplicate set
+ * without changing the set. In contrast to oonf_duplicate_test()
+ * a too old sequence number does not count towards the reset of
+ * the entry, so the caller can check a message before it is
+ * handed to the code that adds it to the set.
+ * @param set duplicate set
+ * @param msg_type message type with incoming sequence number
+ * @param originator originator of sequence number
+ * @param seqno sequence number
+ * @return result oonf_duplicate_test() would return
+ */
+enum oonf_duplicate_result
+oonf_duplicate_peek(struct oonf_duplicate_set *set, uint8_t msg_type,
+    struct netaddr *originator, uint64_t seqno) {
+  struct oonf_duplicate_entry *entry, copy;
+  struct oonf_duplicate_entry_key key;
+
+  /* generate combined key */
+  memcpy(&key.addr, originator, sizeof(*originator));
+  key.msg_type = msg_type;
+
+  entry = _lookup(set, &key, _hash_key(&key));
+  if (!entry || entry->_expiry == 0) {
+    return OONF_DUPSET_FIRST;
+  }
+
+  /* _test() updates the counter of too old sequence numbers */
+  memcpy(&copy, entry, sizeof(copy));
+  return _test(set, &copy, seqno, false);
+}
+
 static int64_t
 _seqno_difference(struct oonf_duplicate_set *set, uint64_t seqno1, uint64_t seqno2) {
   uint64_t diff;
@@ -368,51 +401,182 @@ oonf_duplicate_get_result_str(enum oonf_duplicate_result result) {
 }
 
 /**
- * Comparator for duplicate entry keys
- * @param p1 key1
- * @param p2 key2
- * @return <0 if p1<p2, 0 if p1==p2, >0 if p1>p2
+ * Calculate the hash of a duplicate entry key
+ * @param key duplicate entry key
+ * @return hash value, never 0
+ */
+static uint32_t
+_hash_key(const struct oonf_duplicate_entry_key *key) {
+  uint64_t words[2], hash;
+
+  memcpy(words, key->addr._addr, sizeof(words));
+
+  hash = words[0] * 0x9e3779b97f4a7c15ull;
+  hash ^= (words[1] ^ ((uint64_t)key->addr._type << 16)
+      ^ ((uint64_t)key->addr._prefix_len << 8) ^ key->msg_type) * 0xc2b2ae3d27d4eb4full;
+  hash ^= hash >> 29;
+  hash *= 0x165667b19e3779f9ull;
+  hash ^= hash >> 32;
+
+  /* 0 marks an unused slot */
+  return (uint32_t)hash != 0 ? (uint32_t)hash : 1;
+}
+
+/**
+ * Find the entry of a key in the hash table of a duplicate set.
+ * Expired entries are reset, so the caller can treat them as new.
+ * @param set duplicate set
+ * @param key duplicate entry key
+ * @param hash hash of key
+ * @return duplicate entry, NULL if not found
+ */
+static struct oonf_duplicate_entry *
+_lookup(struct oonf_duplicate_set *set,
+    const struct oonf_duplicate_entry_key *key, uint32_t hash) {
+  struct oonf_duplicate_entry *entry;
+  uint32_t idx, mask;
+
+  if (set->_size == 0) {
+    return NULL;
+  }
+
+  mask = set->_size - 1;
+  for (idx = hash & mask; set->_entries[idx]._hash != 0; idx = (idx + 1) & mask) {
+    entry = &set->_entries[idx];
+    if (entry->_hash == hash && entry->key.msg_type == key->msg_type
+        && memcmp(&entry->key.addr, &key->addr, sizeof(key->addr)) == 0) {
+      if (entry->_expiry != 0
+          && entry->_expiry <= (oonf_clock_getNow() >> OONF_DUPSET_GENERATION_SHIFT)) {
+        /* validity time is over, but the expiry timer did not run yet */
+        entry->_expiry = 0;
+      }
+      return entry;
+    }
+  }
+  return NULL;
+}
+
+/**
+ * @param entries hash table
+ * @param size number of slots of hash table
+ * @param hash hash of a new key
+ * @return first unused slot for the key
+ */
+static struct oonf_duplicate_entry *
+_get_slot(struct oonf_duplicate_entry *entries, uint32_t size, uint32_t hash) {
+  uint32_t idx;
+
+  idx = hash & (size - 1);
+  while (entries[idx]._hash != 0) {
+    idx = (idx + 1) & (size - 1);
+  }
+  return &entries[idx];
+}
+
+/**
+ * Copy all valid entries of a duplicate set into a new hash table
+ * and drop the expired ones
+ * @param set duplicate set
+ * @param size number of slots of the new hash table
+ * @return -1 if out of memory, 0 otherwise
  */
 static int
-_avl_cmp_dupkey(const void *p1, const void *p2) {
-  const struct oonf_duplicate_entry_key *k1, *k2;
+_resize(struct oonf_duplicate_set *set, uint32_t size) {
+  struct oonf_duplicate_entry *entries, *entry;
+  uint32_t i, generation;
+
+  entries = calloc(size, sizeof(*entries));
+  if (entries == NULL) {
+    OONF_WARN(LOG_DUPLICATE_SET, "Out of memory for %u duplicate entries", size);
+    return -1;
+  }
 
-  k1 = p1;
-  k2 = p2;
+  generation = oonf_clock_getNow() >> OONF_DUPSET_GENERATION_SHIFT;
 
-  if (k1->msg_type != k2->msg_type) {
-    return (int)(k1->msg_type) - (int)(k2->msg_type);
+  set->_count = 0;
+  set->_next_expiry = UINT32_MAX;
+  for (i = 0; i < set->_size; i++) {
+    entry = &set->_entries[i];
+    if (entry->_hash == 0 || entry->_expiry <= generation) {
+      /* unused or expired */
+      continue;
+    }
+
+    memcpy(_get_slot(entries, size, entry->_hash), entry, sizeof(*entry));
+    set->_count++;
+
+    if (entry->_expiry < set->_next_expiry) {
+      set->_next_expiry = entry->_expiry;
+    }
   }
 
-  return avl_comp_netaddr(&k1->addr, &k2->addr);
+  free(set->_entries);
+  set->_entries = entries;
+  set->_size = size;
+  return 0;
 }
 
 /**
- * Callback fired when duplicate entry times out
- * @param ptr timer instance that fired
+ * Make sure the expiry timer of a duplicate set runs
+ * not later than a generation
+ * @param set duplicate set
+ * @param expiry expiry generation of an entry
  */
 static void
-_cb_vtime(struct oonf_timer_instance *ptr) {
-  struct oonf_duplicate_entry *entry;
-#ifdef OONF_LOG_DEBUG_INFO
-  struct netaddr_str nbuf;
-#endif
+_schedule_expiry(struct oonf_duplicate_set *set, uint32_t expiry) {
+  uint64_t now, due;
+
+  if (oonf_timer_is_active(&set->_expiry_timer) && set->_next_expiry <= expiry) {
+    /* timer will fire early enough */
+    return;
+  }
 
-  entry = container_of(ptr, struct oonf_duplicate_entry, _vtime);
-  OONF_DEBUG(LOG_DUPLICATE_SET, "Duplicate entry timed out: %s/%u",
-      netaddr_to_string(&nbuf, &entry->key.addr), entry->key.msg_type);
+  now = oonf_clock_getNow();
+  due = (uint64_t)expiry << OONF_DUPSET_GENERATION_SHIFT;
 
-  _remove_duplicate_entry(entry);
+  set->_next_expiry = expiry;
+  oonf_timer_set(&set->_expiry_timer, due > now ? due - now : 1);
 }
 
 /**
- * Remove a duplicate entry
- * @param entry duplicate entry
+ * Callback fired when the first entries of a duplicate set
+ * might have expired. Refreshed entries expire later than the
+ * timer, so only the entries that really timed out are removed.
+ * @param ptr timer instance that fired
  */
 static void
-_remove_duplicate_entry(struct oonf_duplicate_entry *entry) {
-  oonf_timer_stop(&entry->_vtime);
-  avl_remove(&entry->set->_tree, &entry->_node);
+_cb_vtime(struct oonf_timer_instance *ptr) {
+  struct oonf_duplicate_set *set;
+  uint32_t i, size, count, generation;
 
-  oonf_class_free(&_dupset_class, entry);
+  set = container_of(ptr, struct oonf_duplicate_set, _expiry_timer);
+
+  /* count the entries that survive this expiry */
+  generation = oonf_clock_getNow() >> OONF_DUPSET_GENERATION_SHIFT;
+  count = 0;
+  for (i = 0; i < set->_size; i++) {
+    if (set->_entries[i]._hash != 0 && set->_entries[i]._expiry > generation) {
+      count++;
+    }
+  }
+
+  /* shrink table if it is mostly empty */
+  size = set->_size;
+  while (size > OONF_DUPSET_MINIMUM_SIZE && count * 8 < size) {
+    size /= 2;
+  }
+
+  if (_resize(set, size)) {
+    /* try again later */
+    oonf_timer_set(&set->_expiry_timer, 1 << OONF_DUPSET_GENERATION_SHIFT);
+    return;
+  }
+
+  OONF_DEBUG(LOG_DUPLICATE_SET, "Duplicate set expiry: %u entries left in %u slots",
+      set->_count, set->_size);
+
+  if (set->_count > 0) {
+    oonf_timer_stop(&set->_expiry_timer);
+    _schedule_expiry(set, set->_next_expiry);
+  }
 }
@@ -46,7 +46,6 @@
 #ifndef OONF_DUPLICATE_SET_H_
 #define OONF_DUPLICATE_SET_H_
 
-#include "common/avl.h"
 #include "common/common_types.h"
 #include "common/netaddr.h"
 #include "subsystems/oonf_timer.h"
@@ -62,7 +61,13 @@ enum {
    * number of consecutive 'too old' sequence numbers before
    * algorithm resets
    */
-  OONF_DUPSET_MAXIMUM_TOO_OLD = 8
+  OONF_DUPSET_MAXIMUM_TOO_OLD = 8,
+
+  /*! duration of an expiry generation is 2^OONF_DUPSET_GENERATION_SHIFT ms */
+  OONF_DUPSET_GENERATION_SHIFT = 10,
+
+  /*! minimal number of slots of the hash table */
+  OONF_DUPSET_MINIMUM_SIZE = 16,
 };
 
 /**
@@ -92,8 +97,20 @@ enum oonf_duplicate_result {
  * session data for detecting duplicate sequence numbers for addresses
  */
 struct oonf_duplicate_set {
-  /*! tree of duplicate entries */
-  struct avl_tree _tree;
+  /*! open addressing hash table (linear probing) of duplicate entries */
+  struct oonf_duplicate_entry *_entries;
+
+  /*! number of slots of the hash table, 0 or a power of 2 */
+  uint32_t _size;
+
+  /*! number of used slots of the hash table */
+  uint32_t _count;
+
+  /*! no entry expires before this generation */
+  uint32_t _next_expiry;
+
+  /*! timer to remove expired entries from the hash table */
+  struct oonf_timer_instance _expiry_timer;
 
   /*! mask for detecting overflow */
   int64_t _mask;
@@ -132,14 +149,11 @@ struct oonf_duplicate_entry {
   /*! number of too old consecutive sequence numbers without a newer one */
   uint16_t too_old_count;
 
-  /*! back pointer to duplicate set */
-  struct oonf_duplicate_set *set;
-
-  /*! node for tree of duplicate set */
-  struct avl_node _node;
+  /*! hash of key, 0 if the slot of the hash table is unused */
+  uint32_t _hash;
 
-  /*! timer for removing outdated duplicate set data */
-  struct oonf_timer_instance _vtime;
+  /*! first generation the entry is not valid anymore */
+  uint32_t _expiry;
 };
 
 /**
@@ -170,6 +184,10 @@ EXPORT enum oonf_duplicate_result oonf_duplicate_test(
     struct oonf_duplicate_set *, uint8_t msg_type,
     struct netaddr *, uint64_t seqno);
 
+EXPORT enum oonf_duplicate_result oonf_duplicate_peek(
+    struct oonf_duplicate_set *, uint8_t msg_type,
+    struct netaddr *, uint64_t seqno);
+
 EXPORT const char *oonf_duplicate_get_result_str(enum oonf_duplicate_result);
 
 /**
@@ -47,6 +47,7 @@
 #include "common/avl_comp.h"
 #include "common/common_types.h"
 #include "common/netaddr.h"
+#include "common/netaddr_hash.h"
 #include "config/cfg_schema.h"
 #include "core/oonf_subsystem.h"
 #include "subsystems/oonf_class.h"
@@ -221,6 +222,7 @@ oonf_layer2_net_add(const char *ifname) {
 
   /* initialize tree of neighbors and proxies */
   avl_init(&l2net->neighbors, avl_comp_netaddr, false);
+  netaddr_hash_init(&l2net->_neighbor_hash);
 
   /* initialize interface listener */
   l2net->if_listener.name = l2net->name;
@@ -346,8 +348,13 @@ oonf_layer2_neigh_add(struct oonf_layer2_net *l2net,
 
   memcpy(&l2neigh->addr, neigh, sizeof(*neigh));
   l2neigh->_node.key = &l2neigh->addr;
+  l2neigh->_hash_node.key = &l2neigh->addr;
   l2neigh->network = l2net;
 
+  if (netaddr_hash_insert(&l2net->_neighbor_hash, &l2neigh->_hash_node)) {
+    oonf_class_free(&_l2neighbor_class, l2neigh);
+    return NULL;
+  }
   avl_insert(&l2net->neighbors, &l2neigh->_node);
 
   avl_init(&l2neigh->destinations, avl_comp_netaddr, false);
@@ -653,5 +660,6 @@ _neigh_remove(struct oonf_layer2_neigh *l2neigh) {
 
   /* free resources for mac entry */
   avl_remove(&l2neigh->network->neighbors, &l2neigh->_node);
+  netaddr_hash_remove(&l2neigh->network->_neighbor_hash, &l2neigh->_hash_node);
   oonf_class_free(&_l2neighbor_class, l2neigh);
 }
@@ -48,6 +48,7 @@
 
 #include "common/avl.h"
 #include "common/common_types.h"
+#include "common/netaddr_hash.h"
 #include "core/oonf_subsystem.h"
 #include "subsystems/os_interface.h"
 
@@ -206,6 +207,9 @@ struct oonf_layer2_net {
   /*! tree of remote neighbors */
   struct avl_tree neighbors;
 
+  /*! hash of remote neighbors */
+  struct netaddr_hash _neighbor_hash;
+
   /*! absolute timestamp when network has been active last */
   uint64_t last_seen;
 
@@ -240,6 +244,9 @@ struct oonf_layer2_neigh {
 
   /*! node to hook into tree of layer2 network */
   struct avl_node _node;
+
+  /*! node to hook into hash of layer2 network */
+  struct netaddr_hash_node _hash_node;
 };
 
 /**
@@ -335,7 +342,7 @@ static INLINE struct oonf_layer2_neigh *
 oonf_layer2_neigh_get(const struct oonf_layer2_net *l2net,
     const struct netaddr *addr) {
   struct oonf_layer2_neigh *l2neigh;
-  return avl_find_element(&l2net->neighbors, addr, l2neigh, _node);
+  return netaddr_hash_find_element(&l2net->_neighbor_hash, addr, l2neigh, _hash_node);
 }
 
 static INLINE struct oonf_layer2_destination *
@@ -44,6 +44,7 @@
  */
 
 #include <errno.h>
+#include <stdlib.h>
 
 #include "common/common_types.h"
 #include "common/list.h"
@@ -53,13 +54,41 @@
 #include "core/oonf_logging.h"
 #include "core/oonf_subsystem.h"
 #include "subsystems/os_interface.h"
+#include "subsystems/oonf_clock.h"
 #include "subsystems/oonf_socket.h"
+#include "subsystems/oonf_timer.h"
 #include "subsystems/os_fd.h"
 #include "subsystems/oonf_packet_socket.h"
 
 /* Defintions */
 #define LOG_PACKET _oonf_packet_socket_subsystem.logging
 
+/**
+ * Datagram in transit on a packet bus
+ */
+struct _bus_datagram {
+  /*! hook into queue of packet bus */
+  struct list_entity _node;
+
+  /*! sending socket, NULL if it has been removed in the meantime */
+  struct oonf_packet_socket *sender;
+
+  /*! source of datagram */
+  union netaddr_socket src;
+
+  /*! destination of datagram */
+  union netaddr_socket dst;
+
+  /*! absolute time the datagram will be delivered */
+  uint64_t due;
+
+  /*! length of datagram */
+  size_t length;
+
+  /*! payload of datagram */
+  uint8_t data[];
+};
+
 /* prototypes */
 static int _init(void);
 static void _cleanup(void);
@@ -78,13 +107,34 @@ static int _apply_managed_socket(struct oonf_packet_managed *managed,
 static void _cb_packet_event_unicast(struct oonf_socket_entry *);
 static void _cb_packet_event_multicast(struct oonf_socket_entry *);
 static void _cb_packet_event(struct oonf_socket_entry *, bool mc);
+static int _alloc_receive_ring(struct oonf_packet_socket *pktsocket);
+static void _receive_single(struct oonf_packet_socket *pktsocket, bool multicast);
+static bool _receive_batch(struct oonf_packet_socket *pktsocket, bool multicast);
+static bool _is_receive_ring_lost(struct oonf_packet_socket *pktsocket);
+static void _handle_packet(struct oonf_packet_socket *pktsocket, bool multicast,
+    union netaddr_socket *sock, uint8_t *buf, ssize_t length, uint64_t timestamp);
+static void _update_receive_statistics(
+    struct oonf_packet_socket *pktsocket, int received);
+static int _enqueue_packet(struct oonf_packet_socket *pktsocket,
+    union netaddr_socket *remote, const struct iovec *iov, int iovcnt);
+static void _compact_send_queue(struct oonf_packet_socket *pktsocket);
+static void _flush_send_queue(struct oonf_packet_socket *pktsocket);
 static int _cb_interface_listener(struct os_interface_listener *l);
+static int _bus_send(struct oonf_packet_socket *pktsocket,
+    union netaddr_socket *remote, const struct iovec *iov, int iovcnt);
+static bool _bus_accepts(struct oonf_packet_socket *pktsocket,
+    union netaddr_socket *dst, bool *multicast);
+static struct oonf_packet_socket *_bus_next_socket(struct oonf_packet_bus *bus,
+    struct oonf_packet_socket *pktsocket);
+static void _cb_bus_delivery(struct oonf_timer_instance *);
 
 /* subsystem definition */
 static const char *_dependencies[] = {
   OONF_OS_INTERFACE_SUBSYSTEM,
   OONF_SOCKET_SUBSYSTEM,
   OONF_OS_FD_SUBSYSTEM,
+  OONF_CLOCK_SUBSYSTEM,
+  OONF_TIMER_SUBSYSTEM,
 };
 
 static struct oonf_subsystem _oonf_packet_socket_subsystem = {
@@ -100,6 +150,11 @@ DECLARE_OONF_PLUGIN(_oonf_packet_socket_subsystem);
 static struct list_entity _packet_sockets = { NULL, NULL };
 static char _input_buffer[65536];
 
+static struct oonf_timer_class _bus_delivery_class = {
+  .name = "packet bus delivery",
+  .callback = _cb_bus_delivery,
+};
+
 /**
  * Initialize packet socket handler
  * @return always returns 0
@@ -107,6 +162,7 @@ static char _input_buffer[65536];
 static int
 _init(void) {
   list_init_head(&_packet_sockets);
+  oonf_timer_add(&_bus_delivery_class);
   return 0;
 }
 
@@ -122,6 +178,7 @@ _cleanup(void) {
 
     oonf_packet_remove(skt, true);
   }
+  oonf_timer_remove(&_bus_delivery_class);
 }
 
 /**
@@ -173,10 +230,6 @@ static void
 _packet_add(struct oonf_packet_socket *pktsocket,
     union netaddr_socket *local, struct os_interface *interf) {
   pktsocket->os_if = interf;
-  pktsocket->scheduler_entry.process = _cb_packet_event_unicast;
-
-  oonf_socket_add(&pktsocket->scheduler_entry);
-  oonf_socket_set_read(&pktsocket->scheduler_entry, true);
 
   abuf_init(&pktsocket->out);
   list_add_tail(&_packet_sockets, &pktsocket->node);
@@ -186,6 +239,34 @@ _packet_add(struct oonf_packet_socket *pktsocket,
     pktsocket->config.input_buffer = _input_buffer;
     pktsocket->config.input_buffer_length = sizeof(_input_buffer);
   }
+
+  if (pktsocket->config.send_queue == 0) {
+    pktsocket->config.send_queue = OONF_PACKET_DEFAULT_SEND_QUEUE;
+  }
+
+  memset(&pktsocket->stats, 0, sizeof(pktsocket->stats));
+  pktsocket->_rx_timestamp = 0;
+
+  if (pktsocket->config.rx_timestamp
+      && os_fd_set_rx_timestamp(&pktsocket->scheduler_entry.fd, true)) {
+    OONF_WARN(LOG_PACKET, "Could not activate receive timestamps for socket: %s (%d)",
+        strerror(errno), errno);
+  }
+
+  /* receive timestamps are only reported by the batch receive path */
+  if ((pktsocket->config.receive_batch > 1 || pktsocket->config.rx_timestamp)
+      && _alloc_receive_ring(pktsocket)) {
+    OONF_WARN(LOG_PACKET, "Could not allocate receive ring for %u datagrams,"
+        " falling back to single datagram mode", pktsocket->config.receive_batch);
+  }
+
+  /* batch mode drains the socket, so it can use edge triggered events */
+  pktsocket->scheduler_entry.name = "packet";
+  pktsocket->scheduler_entry.process = _cb_packet_event_unicast;
+  pktsocket->scheduler_entry.edge_triggered = pktsocket->_rx_ring != NULL;
+
+  oonf_socket_add(&pktsocket->scheduler_entry);
+  oonf_socket_set_read(&pktsocket->scheduler_entry, true);
 }
 
 /**
@@ -197,16 +278,117 @@ _packet_add(struct oonf_packet_socket *pktsocket,
 void
 oonf_packet_remove(struct oonf_packet_socket *pktsocket,
     bool force __attribute__((unused))) {
+  struct _bus_datagram *dgram;
+
   // TODO: implement non-force behavior for UDP sockets
   if (list_is_node_added(&pktsocket->node)) {
-    oonf_socket_remove(&pktsocket->scheduler_entry);
-    os_fd_close(&pktsocket->scheduler_entry.fd);
+    if (pktsocket->_bus) {
+      /* datagrams in transit stay on the bus */
+      list_for_each_element(&pktsocket->_bus->_queue, dgram, _node) {
+        if (dgram->sender == pktsocket) {
+          dgram->sender = NULL;
+        }
+      }
+      if (pktsocket->_bus->_next_receiver == pktsocket) {
+        /* removed by a receive callback during delivery */
+        pktsocket->_bus->_next_receiver = _bus_next_socket(pktsocket->_bus, pktsocket);
+      }
+      list_remove(&pktsocket->_bus_node);
+      pktsocket->_bus = NULL;
+    }
+    else {
+      oonf_socket_remove(&pktsocket->scheduler_entry);
+      os_fd_close(&pktsocket->scheduler_entry.fd);
+    }
     abuf_free(&pktsocket->out);
 
+    free(pktsocket->_rx_ring);
+    pktsocket->_rx_ring = NULL;
+    pktsocket->_rx_ring_size = 0;
+
+    free(pktsocket->_tx_queue);
+    pktsocket->_tx_queue = NULL;
+    pktsocket->_tx_first = 0;
+    pktsocket->_tx_count = 0;
+
     list_remove(&pktsocket->node);
   }
 }
 
+/**
+ * Initialize a packet bus
+ * @param bus pointer to packet bus, name and latency must be set
+ */
+void
+oonf_packet_bus_add(struct oonf_packet_bus *bus) {
+  list_init_head(&bus->_sockets);
+  list_init_head(&bus->_queue);
+
+  if (bus->latency == 0) {
+    bus->latency = OONF_PACKET_BUS_DEFAULT_LATENCY;
+  }
+
+  bus->sent = 0;
+  bus->delivered = 0;
+  bus->lost = 0;
+  bus->_next_receiver = NULL;
+  bus->_delivery_timer.class = &_bus_delivery_class;
+}
+
+/**
+ * Remove a packet bus, all datagrams in transit are dropped
+ * and all sockets attached to the bus are removed. This can be
+ * called from the receive callback of a socket on the bus.
+ * @param bus pointer to packet bus
+ */
+void
+oonf_packet_bus_remove(struct oonf_packet_bus *bus) {
+  struct oonf_packet_socket *pktsocket, *pkt_it;
+  struct _bus_datagram *dgram, *dgram_it;
+
+  oonf_timer_stop(&bus->_delivery_timer);
+
+  list_for_each_element_safe(&bus->_queue, dgram, _node, dgram_it) {
+    list_remove(&dgram->_node);
+    free(dgram);
+  }
+
+  list_for_each_element_safe(&bus->_sockets, pktsocket, _bus_node, pkt_it) {
+    oonf_packet_remove(pktsocket, true);
+  }
+}
+
+/**
+ * Attach a packet socket to a packet bus instead of a kernel socket.
+ * The socket receives datagrams sent to its local address and port
+ * by other sockets on the same bus.
+ * @param pktsocket pointer to an initialized packet socket struct
+ * @param bus pointer to initialized packet bus
+ * @param local address and port of the socket on the bus
+ * @return always returns 0
+ */
+int
+oonf_packet_bus_socket_add(struct oonf_packet_socket *pktsocket,
+    struct oonf_packet_bus *bus, union netaddr_socket *local) {
+  pktsocket->os_if = NULL;
+
+  abuf_init(&pktsocket->out);
+  list_add_tail(&_packet_sockets, &pktsocket->node);
+  memcpy(&pktsocket->local_socket, local, sizeof(pktsocket->local_socket));
+
+  if (pktsocket->config.input_buffer_length == 0) {
+    pktsocket->config.input_buffer = _input_buffer;
+    pktsocket->config.input_buffer_length = sizeof(_input_buffer);
+  }
+
+  memset(&pktsocket->stats, 0, sizeof(pktsocket->stats));
+  pktsocket->_rx_timestamp = 0;
+
+  pktsocket->_bus = bus;
+  list_add_tail(&bus->_sockets, &pktsocket->_bus_node);
+  return 0;
+}
+
 /**
  * Send a data packet through a packet socket. The transmission might not
  * be happen synchronously if the socket would block.
@@ -219,15 +401,41 @@ oonf_packet_remove(struct oonf_packet_socket *pktsocket,
 int
 oonf_packet_send(struct oonf_packet_socket *pktsocket, union netaddr_socket *remote,
     const void *data, size_t length) {
+  struct iovec iov;
+
+  iov.iov_base = (void *)data;
+  iov.iov_len = length;
+  return oonf_packet_sendv(pktsocket, remote, &iov, 1);
+}
+
+/**
+ * Send a data packet assembled from several buffers through a packet
+ * socket without copying it into a single buffer first. The buffers
+ * are only copied if the socket would block.
+ * @param pktsocket pointer to packet socket
+ * @param remote ip/address to send packet to
+ * @param iov array of buffers
+ * @param iovcnt number of buffers
+ * @return -1 if an error happened, 0 otherwise
+ */
+int
+oonf_packet_sendv(struct oonf_packet_socket *pktsocket, union netaddr_socket *remote,
+    const struct iovec *iov, int iovcnt) {
   int result;
   struct netaddr_str buf;
 
-  if (abuf_getlen(&pktsocket->out) == 0) {
+  if (pktsocket->_bus) {
+    return _bus_send(pktsocket, remote, iov, iovcnt);
+  }
+
+  if (pktsocket->_tx_count == 0) {
     /* no backlog of outgoing packets, try to send directly */
-    result = os_fd_sendto(&pktsocket->scheduler_entry.fd, data, length, remote,
+    result = os_fd_sendmsg(&pktsocket->scheduler_entry.fd, iov, iovcnt, remote,
         pktsocket->config.dont_route);
+    pktsocket->stats.tx_syscalls++;
     if (result > 0) {
       /* successful */
+      pktsocket->stats.tx_packets++;
       OONF_DEBUG(LOG_PACKET, "Sent %d bytes to %s %s",
           result, netaddr_socket_to_string(&buf, remote),
           pktsocket->os_if != NULL ? pktsocket->os_if->name : "");
@@ -237,22 +445,12 @@ oonf_packet_send(struct oonf_packet_socket *pktsocket, union netaddr_socket *rem
     if (errno != EINTR && errno != EAGAIN && errno != EWOULDBLOCK) {
       OONF_WARN(LOG_PACKET, "Cannot send UDP packet to %s: %s (%d)",
           netaddr_socket_to_string(&buf, remote), strerror(errno), errno);
+      pktsocket->stats.tx_errors++;
       return -1;
     }
   }
 
-  /* append destination */
-  abuf_memcpy(&pktsocket->out, remote, sizeof(*remote));
-
-  /* append data length */
-  abuf_append_uint16(&pktsocket->out, length);
-
-  /* append data */
-  abuf_memcpy(&pktsocket->out, data, length);
-
-  /* activate outgoing socket scheduler */
-  oonf_socket_set_write(&pktsocket->scheduler_entry, true);
-  return 0;
+  return _enqueue_packet(pktsocket, remote, iov, iovcnt);
 }
 
 /**
@@ -340,6 +538,27 @@ oonf_packet_apply_managed(struct oonf_packet_managed *managed,
 int
 oonf_packet_send_managed(struct oonf_packet_managed *managed,
     union netaddr_socket *remote, const void *data, size_t length) {
+  struct iovec iov;
+
+  iov.iov_base = (void *)data;
+  iov.iov_len = length;
+  return oonf_packet_sendv_managed(managed, remote, &iov, 1);
+}
+
+/**
+ * Send a packet assembled from several buffers out over one of the
+ * managed sockets, depending on the address family type of the
+ * remote address
+ * @param managed pointer to managed packet socket
+ * @param remote pointer to remote socket
+ * @param iov array of buffers
+ * @param iovcnt number of buffers
+ * @return -1 if an error happened, 0 if packet was sent, 1 if this
+ *    type of address was switched off
+ */
+int
+oonf_packet_sendv_managed(struct oonf_packet_managed *managed,
+    union netaddr_socket *remote, const struct iovec *iov, int iovcnt) {
 #ifdef OONF_LOG_DEBUG_INFO
   struct netaddr_str buf;
 #endif
@@ -350,11 +569,11 @@ oonf_packet_send_managed(struct oonf_packet_managed *managed,
 
   if (list_is_node_added(&managed->socket_v4.scheduler_entry._node)
       && netaddr_socket_get_addressfamily(remote) == AF_INET) {
-    return oonf_packet_send(&managed->socket_v4, remote, data, length);
+    return oonf_packet_sendv(&managed->socket_v4, remote, iov, iovcnt);
   }
   if (list_is_node_added(&managed->socket_v6.scheduler_entry._node)
       && netaddr_socket_get_addressfamily(remote) == AF_INET6) {
-    return oonf_packet_send(&managed->socket_v6, remote, data, length);
+    return oonf_packet_sendv(&managed->socket_v6, remote, iov, iovcnt);
   }
   errno = 0;
   OONF_DEBUG(LOG_PACKET,
@@ -377,11 +596,31 @@ oonf_packet_send_managed(struct oonf_packet_managed *managed,
 int
 oonf_packet_send_managed_multicast(struct oonf_packet_managed *managed,
     const void *data, size_t length, int af_type) {
+  struct iovec iov;
+
+  iov.iov_base = (void *)data;
+  iov.iov_len = length;
+  return oonf_packet_sendv_managed_multicast(managed, &iov, 1, af_type);
+}
+
+/**
+ * Send a packet assembled from several buffers out over one of the
+ * managed sockets to the multicast address of an address family
+ * @param managed pointer to managed packet socket
+ * @param iov array of buffers
+ * @param iovcnt number of buffers
+ * @param af_type address family to send multicast
+ * @return -1 if an error happened, 0 if packet was sent, 1 if this
+ *    type of address was switched off
+ */
+int
+oonf_packet_sendv_managed_multicast(struct oonf_packet_managed *managed,
+    const struct iovec *iov, int iovcnt, int af_type) {
   if (af_type == AF_INET) {
-    return oonf_packet_send_managed(managed, &managed->multicast_v4.local_socket, data, length);
+    return oonf_packet_sendv_managed(managed, &managed->multicast_v4.local_socket, iov, iovcnt);
   }
   else if (af_type == AF_INET6) {
-    return oonf_packet_send_managed(managed, &managed->multicast_v6.local_socket, data, length);
+    return oonf_packet_sendv_managed(managed, &managed->multicast_v6.local_socket, iov, iovcnt);
   }
   errno = 0;
   return 1;
@@ -438,6 +677,15 @@ oonf_packet_free_managed_config(struct oonf_packet_managed_config *config) {
   netaddr_acl_remove(&config->bindto);
 }
 
+/**
+ * get list of active packet sockets
+ * @return packet socket list
+ */
+struct list_entity *
+oonf_packet_get_list(void) {
+  return &_packet_sockets;
+}
+
 /**
  * Apply a new configuration to all attached sockets
  * @param managed pointer to managed socket
@@ -567,6 +815,7 @@ _apply_managed_socketpair(int af_type, struct oonf_packet_managed *managed,
       /* settings really changed */
       *changed = true;
 
+      mc_sock->scheduler_entry.name = "packet multicast";
       mc_sock->scheduler_entry.process = _cb_packet_event_multicast;
 
       /* join multicast group */
@@ -713,99 +962,416 @@ static void
 _cb_packet_event(struct oonf_socket_entry *entry,
     bool multicast __attribute__((unused))) {
   struct oonf_packet_socket *pktsocket;
-  union netaddr_socket sock;
-  uint16_t length;
-  char *pkt;
-  ssize_t result;
-  struct netaddr_str netbuf;
-
-#ifdef OONF_LOG_DEBUG_INFO
-  const char *interf = "";
-#endif
 
   pktsocket = container_of(entry, typeof(*pktsocket), scheduler_entry);
 
-#ifdef OONF_LOG_DEBUG_INFO
-  if (pktsocket->os_if) {
-    interf = pktsocket->os_if->name;
-  }
-#endif
-
   if (oonf_socket_is_read(entry)) {
-    uint8_t *buf;
-
-    /* clear recvfrom memory */
-    memset(&sock, 0, sizeof(sock));
-
-    /* handle incoming data */
-    buf = pktsocket->config.input_buffer;
-
-    result = os_fd_recvfrom(&entry->fd,
-        buf, pktsocket->config.input_buffer_length-1, &sock,
-        pktsocket->os_if);
-    if (result > 0 && pktsocket->config.receive_data != NULL) {
-      /* handle raw socket */
-      if (pktsocket->protocol) {
-        buf = os_fd_skip_rawsocket_prefix(buf, &result, pktsocket->local_socket.std.sa_family);
-        if (!buf) {
-          OONF_WARN(LOG_PACKET, "Error while skipping IP header for socket %s:",
-              netaddr_socket_to_string(&netbuf, &pktsocket->local_socket));
-          return;
-        }
-      }
-      /* null terminate it */
-      buf[result] = 0;
-
-      /* received valid packet */
-      OONF_DEBUG(LOG_PACKET, "Received %"PRINTF_SSIZE_T_SPECIFIER" bytes from %s %s (%s)",
-          result, netaddr_socket_to_string(&netbuf, &sock),
-          interf, multicast ? "multicast" : "unicast");
-      pktsocket->config.receive_data(pktsocket, &sock, buf, result);
+    pktsocket->stats.rx_events++;
+
+    if (pktsocket->_rx_ring) {
+      /* edge triggered sockets must be read until they would block */
+      while (_receive_batch(pktsocket, multicast)
+          && oonf_socket_is_edge_triggered(entry));
     }
-    else if (result < 0 && (errno != EINTR && errno != EAGAIN && errno != EWOULDBLOCK)) {
-      OONF_WARN(LOG_PACKET, "Cannot read packet from socket %s: %s (%d)",
-          netaddr_socket_to_string(&netbuf, &pktsocket->local_socket), strerror(errno), errno);
+    else {
+      _receive_single(pktsocket, multicast);
+    }
+
+    if (!oonf_packet_is_active(pktsocket)) {
+      /* socket was removed by the receive callback */
+      return;
     }
   }
 
-  if (oonf_socket_is_write(entry) && abuf_getlen(&pktsocket->out) > 0) {
+  if (oonf_socket_is_write(entry) && pktsocket->_tx_count > 0) {
     /* handle outgoing data */
-    pkt = abuf_getptr(&pktsocket->out);
+    _flush_send_queue(pktsocket);
+
+    if (pktsocket->_tx_count == 0 && pktsocket->config.send_queue_empty) {
+      /* give the user the chance to send more data */
+      pktsocket->config.send_queue_empty(pktsocket);
+    }
+  }
+
+  if (pktsocket->_tx_count == 0) {
+    /* nothing left to send, disable outgoing events */
+    oonf_socket_set_write(&pktsocket->scheduler_entry, false);
+  }
+}
+
+/**
+ * Append a datagram to the transmit queue of a packet socket
+ * @param pktsocket packet socket
+ * @param remote destination of datagram
+ * @param iov array of buffers of datagram
+ * @param iovcnt number of buffers
+ * @return -1 if the datagram was dropped, 0 otherwise
+ */
+static int
+_enqueue_packet(struct oonf_packet_socket *pktsocket,
+    union netaddr_socket *remote, const struct iovec *iov, int iovcnt) {
+  struct oonf_packet_tx_entry *entry;
+  struct netaddr_str buf;
+  size_t length;
+  int i;
+
+  if (pktsocket->_tx_queue == NULL) {
+    pktsocket->_tx_queue = calloc(pktsocket->config.send_queue, sizeof(*entry));
+    if (pktsocket->_tx_queue == NULL) {
+      OONF_WARN(LOG_PACKET, "Could not allocate transmit queue for %u datagrams",
+          pktsocket->config.send_queue);
+      pktsocket->stats.tx_dropped++;
+      return -1;
+    }
+  }
+
+  if (pktsocket->_tx_count >= pktsocket->config.send_queue) {
+    OONF_DEBUG(LOG_PACKET, "Transmit queue full, dropped packet to %s",
+        netaddr_socket_to_string(&buf, remote));
+    pktsocket->stats.tx_dropped++;
+    return -1;
+  }
+
+  if (pktsocket->_tx_first + pktsocket->_tx_count == pktsocket->config.send_queue) {
+    /* no free descriptor at the end of the array */
+    _compact_send_queue(pktsocket);
+  }
+
+  entry = &pktsocket->_tx_queue[pktsocket->_tx_first + pktsocket->_tx_count];
+  entry->offset = abuf_getlen(&pktsocket->out);
+  memcpy(&entry->remote, remote, sizeof(entry->remote));
+
+  length = 0;
+  for (i=0; i<iovcnt; i++) {
+    if (abuf_memcpy(&pktsocket->out, iov[i].iov_base, iov[i].iov_len)) {
+      OONF_WARN(LOG_PACKET, "Could not queue packet to %s, out of memory",
+          netaddr_socket_to_string(&buf, remote));
+      abuf_setlen(&pktsocket->out, entry->offset);
+      pktsocket->stats.tx_dropped++;
+      return -1;
+    }
+    length += iov[i].iov_len;
+  }
+  entry->length = length;
+
+  pktsocket->_tx_count++;
+  pktsocket->stats.tx_queued++;
+  if (pktsocket->_tx_count > pktsocket->stats.tx_max_queue) {
+    pktsocket->stats.tx_max_queue = pktsocket->_tx_count;
+  }
+
+  /* activate outgoing socket scheduler */
+  oonf_socket_set_write(&pktsocket->scheduler_entry, true);
+  return 0;
+}
+
+/**
+ * Move the queued datagrams (and their payload) to the beginning
+ * of the transmit queue to free the space of the sent ones
+ * @param pktsocket packet socket
+ */
+static void
+_compact_send_queue(struct oonf_packet_socket *pktsocket) {
+  struct oonf_packet_tx_entry *queue;
+  size_t sent_bytes;
+  uint32_t i;
 
-    /* copy remote socket */
-    memcpy(&sock, pkt, sizeof(sock));
-    pkt += sizeof(sock);
+  queue = pktsocket->_tx_queue;
+  sent_bytes = queue[pktsocket->_tx_first].offset;
 
-    /* copy length */
-    memcpy(&length, pkt, 2);
-    pkt += 2;
+  abuf_pull(&pktsocket->out, sent_bytes);
+  memmove(&queue[0], &queue[pktsocket->_tx_first],
+      sizeof(*queue) * pktsocket->_tx_count);
+
+  for (i=0; i<pktsocket->_tx_count; i++) {
+    queue[i].offset -= sent_bytes;
+  }
+  pktsocket->_tx_first = 0;
+}
+
+/**
+ * Send as much of the transmit queue as possible, using a single
+ * system call for up to OS_FD_MAX_DATAGRAMS datagrams
+ * @param pktsocket packet socket
+ */
+static void
+_flush_send_queue(struct oonf_packet_socket *pktsocket) {
+  struct os_fd_datagram dgrams[OS_FD_MAX_DATAGRAMS];
+  struct oonf_packet_tx_entry *entry;
+  struct netaddr_str netbuf;
+  uint8_t *payload;
+  int i, count, result;
+
+  while (pktsocket->_tx_count > 0) {
+    payload = (uint8_t *)abuf_getptr(&pktsocket->out);
+
+    count = pktsocket->_tx_count;
+    if (count > OS_FD_MAX_DATAGRAMS) {
+      count = OS_FD_MAX_DATAGRAMS;
+    }
+
+    for (i=0; i<count; i++) {
+      entry = &pktsocket->_tx_queue[pktsocket->_tx_first + i];
+
+      dgrams[i].buf = &payload[entry->offset];
+      dgrams[i].length = entry->length;
+      memcpy(&dgrams[i].remote, &entry->remote, sizeof(dgrams[i].remote));
+    }
+
+    result = os_fd_sendmmsg(&pktsocket->scheduler_entry.fd,
+        dgrams, count, pktsocket->config.dont_route);
+    pktsocket->stats.tx_syscalls++;
 
-    /* try to send packet */
-    result = os_fd_sendto(&entry->fd, pkt, length, &sock, pktsocket->config.dont_route);
     if (result < 0 && (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK)) {
+      if (errno == EINTR) {
+        /* interrupted, edge triggered sockets will not get another event */
+        continue;
+      }
+
       /* try again later */
       OONF_DEBUG(LOG_PACKET, "Sending to %s %s could block, try again later",
-          netaddr_socket_to_string(&netbuf, &sock), interf);
+          netaddr_socket_to_string(&netbuf, &dgrams[0].remote),
+          pktsocket->os_if != NULL ? pktsocket->os_if->name : "");
       return;
     }
 
     if (result < 0) {
-      /* display error message */
+      /* drop the first datagram (the one which triggered the error) */
       OONF_WARN(LOG_PACKET, "Cannot send UDP packet to %s: %s (%d)",
-          netaddr_socket_to_string(&netbuf, &sock), strerror(errno), errno);
+          netaddr_socket_to_string(&netbuf, &dgrams[0].remote), strerror(errno), errno);
+      pktsocket->stats.tx_errors++;
+      result = 1;
     }
     else {
-      OONF_DEBUG(LOG_PACKET, "Sent %"PRINTF_SSIZE_T_SPECIFIER" bytes to %s %s",
-          result, netaddr_socket_to_string(&netbuf, &sock), interf);
+      OONF_DEBUG(LOG_PACKET, "Sent %d of %u queued packets %s",
+          result, pktsocket->_tx_count,
+          pktsocket->os_if != NULL ? pktsocket->os_if->name : "");
+      pktsocket->stats.tx_packets += result;
     }
-    /* remove data from outgoing buffer (both for success and for final error */
-    abuf_pull(&pktsocket->out, sizeof(sock) + 2 + length);
+
+    pktsocket->_tx_first += result;
+    pktsocket->_tx_count -= result;
   }
 
-  if (abuf_getlen(&pktsocket->out) == 0) {
-    /* nothing left to send, disable outgoing events */
-    oonf_socket_set_write(&pktsocket->scheduler_entry, false);
+  /* queue is empty, reuse the outgoing buffer from the start */
+  pktsocket->_tx_first = 0;
+  abuf_clear(&pktsocket->out);
+}
+
+/**
+ * Allocate the ring of receive buffers for batch mode
+ * @param pktsocket packet socket
+ * @return -1 if an error happened, 0 otherwise
+ */
+static int
+_alloc_receive_ring(struct oonf_packet_socket *pktsocket) {
+  struct os_fd_datagram *ring;
+  uint8_t *buffers;
+  uint32_t i, count;
+  size_t length;
+
+  count = pktsocket->config.receive_batch;
+  if (count > OS_FD_MAX_DATAGRAMS) {
+    count = OS_FD_MAX_DATAGRAMS;
+  }
+  else if (count == 0) {
+    count = 1;
+  }
+  length = pktsocket->config.input_buffer_length;
+
+  /* datagram descriptors and buffers share a single allocation */
+  ring = calloc(count, sizeof(*ring) + length);
+  if (ring == NULL) {
+    return -1;
+  }
+
+  buffers = (uint8_t *)(&ring[count]);
+  for (i=0; i<count; i++) {
+    ring[i].buf = &buffers[i * length];
+
+    /* keep space for the null termination */
+    ring[i].length = length - 1;
+  }
+
+  pktsocket->_rx_ring = ring;
+  pktsocket->_rx_ring_size = count;
+  return 0;
+}
+
+/**
+ * Read a single datagram from a packet socket
+ * @param pktsocket packet socket
+ * @param multicast true if socket is a multicast socket
+ */
+static void
+_receive_single(struct oonf_packet_socket *pktsocket, bool multicast) {
+  union netaddr_socket sock;
+  struct netaddr_str netbuf;
+  ssize_t result;
+  uint8_t *buf;
+
+  /* clear recvfrom memory */
+  memset(&sock, 0, sizeof(sock));
+
+  /* handle incoming data */
+  buf = pktsocket->config.input_buffer;
+
+  result = os_fd_recvfrom(&pktsocket->scheduler_entry.fd,
+      buf, pktsocket->config.input_buffer_length-1, &sock,
+      pktsocket->os_if);
+  _update_receive_statistics(pktsocket, result > 0 ? 1 : 0);
+
+  if (result > 0) {
+    _handle_packet(pktsocket, multicast, &sock, buf, result, 0);
+  }
+  else if (result < 0 && (errno != EINTR && errno != EAGAIN && errno != EWOULDBLOCK)) {
+    OONF_WARN(LOG_PACKET, "Cannot read packet from socket %s: %s (%d)",
+        netaddr_socket_to_string(&netbuf, &pktsocket->local_socket), strerror(errno), errno);
+  }
+}
+
+/**
+ * Read up to receive_batch datagrams from a packet socket with
+ * a single system call and handle them in order
+ * @param pktsocket packet socket
+ * @param multicast true if socket is a multicast socket
+ * @return true if the receive ring was filled completely or the
+ *   system call was interrupted and more datagrams might be waiting,
+ *   false otherwise
+ */
+static bool
+_receive_batch(struct oonf_packet_socket *pktsocket, bool multicast) {
+  struct os_fd_datagram *ring;
+  struct netaddr_str netbuf;
+  bool interrupted;
+  int i, result;
+
+  /*
+   * take ownership of the ring, the receive callback might remove
+   * (and even re-add) the socket.
+   */
+  ring = pktsocket->_rx_ring;
+  pktsocket->_rx_ring = NULL;
+
+  result = os_fd_recvmmsg(&pktsocket->scheduler_entry.fd,
+      ring, pktsocket->_rx_ring_size, pktsocket->os_if);
+  interrupted = result < 0 && errno == EINTR;
+  _update_receive_statistics(pktsocket, result > 0 ? result : 0);
+
+  if (result < 0 && (errno != EINTR && errno != EAGAIN && errno != EWOULDBLOCK)) {
+    OONF_WARN(LOG_PACKET, "Cannot read packets from socket %s: %s (%d)",
+        netaddr_socket_to_string(&netbuf, &pktsocket->local_socket), strerror(errno), errno);
+  }
+
+  for (i=0; i<result; i++) {
+    if (ring[i].truncated) {
+      OONF_WARN(LOG_PACKET, "Dropped truncated packet from %s on socket %s",
+          netaddr_socket_to_string(&netbuf, &ring[i].remote),
+          netaddr_socket_to_string(&netbuf, &pktsocket->local_socket));
+      continue;
+    }
+    if (ring[i].received > 0) {
+      _handle_packet(pktsocket, multicast, &ring[i].remote,
+          ring[i].buf, ring[i].received, ring[i].timestamp);
+    }
+
+    if (_is_receive_ring_lost(pktsocket)) {
+      /* socket was removed or reinitialized by the receive callback */
+      break;
+    }
+  }
+
+  if (_is_receive_ring_lost(pktsocket)) {
+    free(ring);
+    return false;
   }
+
+  /* give ring back to socket */
+  pktsocket->_rx_ring = ring;
+  return interrupted || result == (int)pktsocket->_rx_ring_size;
+}
+
+/**
+ * Check if a socket has been removed or reinitialized while its
+ * receive ring was in use
+ * @param pktsocket packet socket
+ * @return true if the receive ring does not belong to the socket anymore
+ */
+static bool
+_is_receive_ring_lost(struct oonf_packet_socket *pktsocket) {
+  return !oonf_packet_is_active(pktsocket)
+      || pktsocket->_rx_ring != NULL || pktsocket->_rx_ring_size == 0;
+}
+
+/**
+ * Hand a received datagram to the user of the packet socket
+ * @param pktsocket packet socket
+ * @param multicast true if socket is a multicast socket
+ * @param sock source of datagram
+ * @param buf pointer to datagram, must have space for one additional byte
+ * @param length length of datagram
+ * @param timestamp kernel receive timestamp of datagram, 0 if not available
+ */
+static void
+_handle_packet(struct oonf_packet_socket *pktsocket, bool multicast,
+    union netaddr_socket *sock, uint8_t *buf, ssize_t length, uint64_t timestamp) {
+  struct netaddr_str netbuf;
+
+  if (pktsocket->config.receive_data == NULL) {
+    return;
+  }
+
+  /* handle raw socket */
+  if (pktsocket->protocol) {
+    buf = os_fd_skip_rawsocket_prefix(buf, &length, pktsocket->local_socket.std.sa_family);
+    if (!buf) {
+      OONF_WARN(LOG_PACKET, "Error while skipping IP header for socket %s:",
+          netaddr_socket_to_string(&netbuf, &pktsocket->local_socket));
+      return;
+    }
+  }
+  /* null terminate it */
+  buf[length] = 0;
+
+  /* received valid packet */
+  OONF_DEBUG(LOG_PACKET, "Received %"PRINTF_SSIZE_T_SPECIFIER" bytes from %s %s (%s)",
+      length, netaddr_socket_to_string(&netbuf, sock),
+      pktsocket->os_if != NULL ? pktsocket->os_if->name : "",
+      multicast ? "multicast" : "unicast");
+
+  pktsocket->_rx_timestamp = timestamp;
+  pktsocket->config.receive_data(pktsocket, sock, buf, length);
+}
+
+/**
+ * Update the receive statistics of a packet socket after a receive
+ * system call (recvfrom or recvmmsg)
+ * @param pktsocket packet socket
+ * @param received number of datagrams received by the call
+ */
+static void
+_update_receive_statistics(struct oonf_packet_socket *pktsocket, int received) {
+  struct oonf_packet_statistics *stats;
+  int bucket;
+
+  stats = &pktsocket->stats;
+  stats->rx_syscalls++;
+
+  if (received <= 0) {
+    return;
+  }
+
+  stats->rx_packets += received;
+  if ((uint32_t)received > stats->rx_max_batch) {
+    stats->rx_max_batch = received;
+  }
+
+  /* logarithmic histogram bucket */
+  bucket = 31 - __builtin_clz((unsigned)received);
+  if (bucket >= OONF_PACKET_BATCH_HISTOGRAM) {
+    bucket = OONF_PACKET_BATCH_HISTOGRAM - 1;
+  }
+  stats->rx_batch[bucket]++;
 }
 
 /**
@@ -828,3 +1394,154 @@ _cb_interface_listener(struct os_interface_listener *l) {
 
   return result;
 }
+
+/**
+ * Copy an outgoing datagram into the queue of a packet bus
+ * @param pktsocket sending packet socket
+ * @param remote destination of datagram
+ * @param iov array of buffers
+ * @param iovcnt number of buffers
+ * @return -1 if an error happened, 0 otherwise
+ */
+static int
+_bus_send(struct oonf_packet_socket *pktsocket,
+    union netaddr_socket *remote, const struct iovec *iov, int iovcnt) {
+  struct oonf_packet_bus *bus;
+  struct _bus_datagram *dgram;
+  size_t length;
+  int i;
+
+  bus = pktsocket->_bus;
+
+  length = 0;
+  for (i=0; i<iovcnt; i++) {
+    length += iov[i].iov_len;
+  }
+
+  dgram = malloc(sizeof(*dgram) + length);
+  if (!dgram) {
+    OONF_WARN(LOG_PACKET, "Out of memory for datagram on packet bus %s", bus->name);
+    pktsocket->stats.tx_errors++;
+    return -1;
+  }
+
+  dgram->sender = pktsocket;
+  memcpy(&dgram->src, &pktsocket->local_socket, sizeof(dgram->src));
+  memcpy(&dgram->dst, remote, sizeof(dgram->dst));
+  dgram->due = oonf_clock_get_absolute(bus->latency);
+  dgram->length = 0;
+  for (i=0; i<iovcnt; i++) {
+    memcpy(&dgram->data[dgram->length], iov[i].iov_base, iov[i].iov_len);
+    dgram->length += iov[i].iov_len;
+  }
+
+  /* constant latency keeps the queue ordered by delivery time */
+  list_add_tail(&bus->_queue, &dgram->_node);
+  if (!oonf_timer_is_active(&bus->_delivery_timer)) {
+    oonf_timer_set(&bus->_delivery_timer, bus->latency);
+  }
+
+  bus->sent++;
+  pktsocket->stats.tx_packets++;
+  return 0;
+}
+
+/**
+ * Check if a socket on a packet bus receives a datagram
+ * @param pktsocket packet socket attached to a bus
+ * @param dst destination of datagram
+ * @param multicast set to true if the destination is a multicast address
+ * @return true if the socket receives the datagram, false otherwise
+ */
+static bool
+_bus_accepts(struct oonf_packet_socket *pktsocket,
+    union netaddr_socket *dst, bool *multicast) {
+  struct netaddr local, dst_addr;
+
+  if (netaddr_socket_get_addressfamily(&pktsocket->local_socket)
+      != netaddr_socket_get_addressfamily(dst)) {
+    return false;
+  }
+  if (netaddr_socket_get_port(&pktsocket->local_socket)
+      != netaddr_socket_get_port(dst)) {
+    return false;
+  }
+
+  netaddr_from_socket(&local, &pktsocket->local_socket);
+  netaddr_from_socket(&dst_addr, dst);
+
+  *multicast = netaddr_is_in_subnet(&NETADDR_IPV4_MULTICAST, &dst_addr)
+      || netaddr_is_in_subnet(&NETADDR_IPV6_MULTICAST, &dst_addr);
+  if (*multicast) {
+    return true;
+  }
+  return netaddr_is_unspec(&local) || netaddr_cmp(&local, &dst_addr) == 0;
+}
+
+/**
+ * @param bus packet bus
+ * @param pktsocket socket attached to the bus
+ * @return socket after pktsocket in the socket list of the bus,
+ *   NULL if pktsocket is the last one
+ */
+static struct oonf_packet_socket *
+_bus_next_socket(struct oonf_packet_bus *bus, struct oonf_packet_socket *pktsocket) {
+  if (list_is_last(&bus->_sockets, &pktsocket->_bus_node)) {
+    return NULL;
+  }
+  return list_next_element(pktsocket, _bus_node);
+}
+
+/**
+ * Deliver all datagrams of a packet bus that are due. Receive callbacks
+ * may remove any socket of the bus (or the whole bus), so the next
+ * receiver is kept in the bus and updated by oonf_packet_remove().
+ * @param ptr timer instance that fired
+ */
+static void
+_cb_bus_delivery(struct oonf_timer_instance *ptr) {
+  struct oonf_packet_bus *bus;
+  struct oonf_packet_socket *pktsocket;
+  struct _bus_datagram *dgram;
+  bool multicast, received;
+
+  bus = container_of(ptr, struct oonf_packet_bus, _delivery_timer);
+
+  while (!list_is_empty(&bus->_queue)) {
+    dgram = list_first_element(&bus->_queue, dgram, _node);
+    if (dgram->due > oonf_clock_getNow()) {
+      /* datagrams sent during delivery are due later */
+      oonf_timer_set(&bus->_delivery_timer, oonf_clock_get_relative(dgram->due));
+      return;
+    }
+    list_remove(&dgram->_node);
+
+    received = false;
+    bus->_next_receiver = list_is_empty(&bus->_sockets)
+        ? NULL : list_first_element(&bus->_sockets, pktsocket, _bus_node);
+    while (bus->_next_receiver) {
+      pktsocket = bus->_next_receiver;
+      bus->_next_receiver = _bus_next_socket(bus, pktsocket);
+
+      if (pktsocket == dgram->sender
+          || !_bus_accepts(pktsocket, &dgram->dst, &multicast)
+          || dgram->length >= pktsocket->config.input_buffer_length) {
+        continue;
+      }
+
+      /* receivers get their own copy, just like from a kernel socket */
+      memcpy(pktsocket->config.input_buffer, dgram->data, dgram->length);
+      pktsocket->stats.rx_packets++;
+      bus->delivered++;
+      received = true;
+
+      _handle_packet(pktsocket, multicast, &dgram->src,
+          (uint8_t *)pktsocket->config.input_buffer, dgram->length, 0);
+    }
+
+    if (!received) {
+      bus->lost++;
+    }
+    free(dgram);
+  }
+}
@@ -53,6 +53,9 @@
 #include "common/netaddr_acl.h"
 #include "subsystems/os_interface.h"
 #include "subsystems/oonf_socket.h"
+#include "subsystems/oonf_timer.h"
+
+#include <sys/uio.h>
 
 #ifndef _WIN32
 #include <net/if.h>
@@ -61,8 +64,63 @@
 /*! subsystem identifier */
 #define OONF_PACKET_SUBSYSTEM "packet_socket"
 
+/*! number of buckets of the receive batch size histogram */
+#define OONF_PACKET_BATCH_HISTOGRAM 7
+
+/*! default maximum number of datagrams in the transmit queue of a socket */
+#define OONF_PACKET_DEFAULT_SEND_QUEUE 256
+
+/*! default delay between sending and delivery of a datagram on a packet bus */
+#define OONF_PACKET_BUS_DEFAULT_LATENCY 1
+
 struct oonf_packet_socket;
 
+/**
+ * In-memory medium that connects packet sockets without kernel sockets.
+ * It allows to run several protocol instances inside a single process,
+ * typically together with the virtual clock (see oonf_clock_set_virtual())
+ * to simulate a network faster than realtime.
+ *
+ * Multicast datagrams are delivered to all other sockets
+ * on the bus bound to the destination port, unicast datagrams to the
+ * sockets bound to the destination address and port.
+ */
+struct oonf_packet_bus {
+  /*! name of the bus for logging */
+  const char *name;
+
+  /**
+   * delay between sending and delivery of datagrams in milliseconds,
+   * 0 for default. Delivery is done by a timer, so it is rounded up
+   * to the next timer slice.
+   */
+  uint64_t latency;
+
+  /*! number of datagrams sent into the bus */
+  uint32_t sent;
+
+  /*! number of times a datagram was delivered to a socket */
+  uint32_t delivered;
+
+  /*! number of datagrams that had no receiver */
+  uint32_t lost;
+
+  /*! list of packet sockets attached to the bus */
+  struct list_entity _sockets;
+
+  /**
+   * next socket that receives the datagram currently delivered,
+   * advanced by oonf_packet_remove() if a receive callback removes it
+   */
+  struct oonf_packet_socket *_next_receiver;
+
+  /*! list of datagrams in transit, ordered by delivery time */
+  struct list_entity _queue;
+
+  /*! timer to deliver the datagrams in transit */
+  struct oonf_timer_instance _delivery_timer;
+};
+
 /**
  * Configuraten of a packet socket
  */
@@ -73,6 +131,21 @@ struct oonf_packet_config {
   /*! length of input buffer */
   size_t input_buffer_length;
 
+  /**
+   * maximum number of datagrams read with a single system call
+   * for each read event, 0 or 1 to read a single datagram per event.
+   * Each datagram gets its own buffer of input_buffer_length bytes,
+   * input_buffer is not used in this case.
+   */
+  uint32_t receive_batch;
+
+  /**
+   * maximum number of outgoing datagrams waiting for the socket
+   * to become writable, 0 for OONF_PACKET_DEFAULT_SEND_QUEUE.
+   * Datagrams beyond this limit are dropped.
+   */
+  uint32_t send_queue;
+
   /**
    * Callback triggered when an UDP packet has been received
    * @param psock packet socket
@@ -83,13 +156,85 @@ struct oonf_packet_config {
   void (*receive_data)(struct oonf_packet_socket *psock,
       union netaddr_socket *from, void *ptr, size_t length);
 
+  /**
+   * Callback triggered when the transmit queue of the socket has
+   * been sent completely, NULL if not used
+   * @param psock packet socket
+   */
+  void (*send_queue_empty)(struct oonf_packet_socket *psock);
+
   /*! true if the outgoing UDP traffic should not be routed */
   bool dont_route;
 
+  /**
+   * true if the kernel should timestamp incoming datagrams,
+   * see oonf_packet_get_rx_timestamp(). This uses the batch
+   * receive path, even if receive_batch is 0 or 1.
+   */
+  bool rx_timestamp;
+
   /*! user defined pointer */
   void *user;
 };
 
+/**
+ * Statistics of a packet socket
+ */
+struct oonf_packet_statistics {
+  /*! number of read events */
+  uint32_t rx_events;
+
+  /**
+   * number of receive system calls (recvfrom or recvmmsg batches),
+   * edge triggered sockets need more than one per read event
+   */
+  uint32_t rx_syscalls;
+
+  /*! number of received packets */
+  uint32_t rx_packets;
+
+  /*! highest number of packets received by a single system call */
+  uint32_t rx_max_batch;
+
+  /**
+   * number of receive system calls by packets received during the
+   * call, logarithmic buckets (1, 2-3, 4-7, 8-15, 16-31, 32-63, 64+)
+   */
+  uint32_t rx_batch[OONF_PACKET_BATCH_HISTOGRAM];
+
+  /*! number of sent packets */
+  uint32_t tx_packets;
+
+  /*! number of send system calls */
+  uint32_t tx_syscalls;
+
+  /*! number of packets that had to wait in the transmit queue */
+  uint32_t tx_queued;
+
+  /*! highest number of packets in transmit queue */
+  uint32_t tx_max_queue;
+
+  /*! number of packets dropped because the transmit queue was full */
+  uint32_t tx_dropped;
+
+  /*! number of packets dropped because of a send error */
+  uint32_t tx_errors;
+};
+
+/**
+ * Descriptor of an outgoing datagram in the transmit queue
+ */
+struct oonf_packet_tx_entry {
+  /*! destination of datagram */
+  union netaddr_socket remote;
+
+  /*! offset of datagram in the outgoing buffer */
+  size_t offset;
+
+  /*! length of datagram */
+  size_t length;
+};
+
 /**
  * Definition of a packet socket
  */
@@ -106,7 +251,7 @@ struct oonf_packet_socket {
   /*! IP protocol number for raw sockets */
   int protocol;
 
-  /*! outgoing buffer */
+  /*! outgoing buffer, contains the payload of all queued datagrams */
   struct autobuf out;
 
   /*! interface data the socket is bound to */
@@ -114,6 +259,33 @@ struct oonf_packet_socket {
 
   /*! configuration of packet socket */
   struct oonf_packet_config config;
+
+  /*! statistics of packet socket */
+  struct oonf_packet_statistics stats;
+
+  /*! ring of receive buffers for batch mode, NULL if not used */
+  struct os_fd_datagram *_rx_ring;
+
+  /*! number of datagrams in receive ring */
+  uint32_t _rx_ring_size;
+
+  /*! array of transmit queue descriptors, NULL if not allocated yet */
+  struct oonf_packet_tx_entry *_tx_queue;
+
+  /*! index of first queued datagram in the descriptor array */
+  uint32_t _tx_first;
+
+  /*! number of queued datagrams */
+  uint32_t _tx_count;
+
+  /*! kernel receive timestamp of the datagram handled by receive_data */
+  uint64_t _rx_timestamp;
+
+  /*! packet bus the socket is attached to, NULL for a kernel socket */
+  struct oonf_packet_bus *_bus;
+
+  /*! hook into socket list of packet bus */
+  struct list_entity _bus_node;
 };
 
 /**
@@ -204,6 +376,11 @@ EXPORT int oonf_packet_raw_add(struct oonf_packet_socket *, int protocol,
     union netaddr_socket *local, struct os_interface *os_if);
 EXPORT void oonf_packet_remove(struct oonf_packet_socket *, bool);
 
+EXPORT void oonf_packet_bus_add(struct oonf_packet_bus *bus);
+EXPORT void oonf_packet_bus_remove(struct oonf_packet_bus *bus);
+EXPORT int oonf_packet_bus_socket_add(struct oonf_packet_socket *,
+    struct oonf_packet_bus *bus, union netaddr_socket *local);
+
 EXPORT int oonf_packet_send(struct oonf_packet_socket *,
     union netaddr_socket *remote, const void *data, size_t length);
 EXPORT int oonf_packet_send_managed(struct oonf_packet_managed *,
@@ -211,6 +388,13 @@ EXPORT int oonf_packet_send_managed(struct oonf_packet_managed *,
 EXPORT int oonf_packet_send_managed_multicast(
     struct oonf_packet_managed *managed,
     const void *data, size_t length, int af_type);
+EXPORT int oonf_packet_sendv(struct oonf_packet_socket *,
+    union netaddr_socket *remote, const struct iovec *iov, int iovcnt);
+EXPORT int oonf_packet_sendv_managed(struct oonf_packet_managed *,
+    union netaddr_socket *remote, const struct iovec *iov, int iovcnt);
+EXPORT int oonf_packet_sendv_managed_multicast(
+    struct oonf_packet_managed *managed,
+    const struct iovec *iov, int iovcnt, int af_type);
 EXPORT void oonf_packet_add_managed(struct oonf_packet_managed *);
 EXPORT int oonf_packet_apply_managed(struct oonf_packet_managed *,
     const struct oonf_packet_managed_config *);
@@ -223,6 +407,8 @@ EXPORT void oonf_packet_copy_managed_config(
 EXPORT void oonf_packet_free_managed_config(
     struct oonf_packet_managed_config *config);
 
+EXPORT struct list_entity *oonf_packet_get_list(void);
+
 /**
  * @param sock pointer to packet socket
  * @return true if the socket is active to send data, false otherwise
@@ -232,4 +418,25 @@ oonf_packet_is_active(struct oonf_packet_socket *sock) {
   return list_is_node_added(&sock->node);
 }
 
+/**
+ * @param sock pointer to packet socket
+ * @return number of datagrams waiting in the transmit queue
+ */
+static INLINE uint32_t
+oonf_packet_get_send_queue_depth(struct oonf_packet_socket *sock) {
+  return sock->_tx_count;
+}
+
+/**
+ * Get the kernel receive timestamp of the datagram that is currently
+ * handed to the receive_data callback of a socket.
+ * @param sock pointer to packet socket
+ * @return receive timestamp in nanoseconds (wall clock),
+ *   0 if not available
+ */
+static INLINE uint64_t
+oonf_packet_get_rx_timestamp(struct oonf_packet_socket *sock) {
+  return sock->_rx_timestamp;
+}
+
 #endif /* OONF_PACKET_SOCKET_H_ */
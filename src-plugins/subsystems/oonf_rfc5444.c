@@ -52,10 +52,12 @@
 #include "rfc5444/rfc5444_print.h"
 #include "rfc5444/rfc5444_reader.h"
 #include "rfc5444/rfc5444_writer.h"
+#include "core/oonf_cfg.h"
 #include "core/oonf_logging.h"
 #include "core/oonf_subsystem.h"
 #include "core/os_core.h"
 #include "subsystems/oonf_class.h"
+#include "subsystems/oonf_clock.h"
 #include "subsystems/oonf_duplicate_set.h"
 #include "subsystems/oonf_packet_socket.h"
 #include "subsystems/oonf_timer.h"
@@ -75,13 +77,65 @@ struct _rfc5444_config {
   /*! IP protocol number to be used for RFC5444 communication */
   int ip_proto;
 
+  /*! true to reorder addresses for better address compression */
+  bool address_planner;
+
+  /*! true to share interface independent messages between targets */
+  bool message_fanout;
+
   /**
-   * interval to wait for aggregating
-   * RFC5444 messages on the same target
+   * interval to wait for aggregating originated and forwarded
+   * RFC5444 messages on the same target, if the interface section
+   * does not set the interval of the transmit class
    */
   uint64_t aggregation_interval;
 };
 
+/**
+ * Configuration of a transmit class of an interface
+ */
+struct _tx_class_config {
+  /*! interval to wait for aggregating messages of this class */
+  uint64_t aggregation_interval;
+
+  /*! maximum number of packets waiting in the class queue */
+  int32_t queue_limit;
+};
+
+/**
+ * RFC5444 interface configuration
+ */
+struct _interface_config {
+  /*! socket configuration of interface */
+  struct oonf_packet_managed_config socket;
+
+  /*! settings of the transmit classes */
+  struct _tx_class_config tx[OONF_RFC5444_TX_CLASS_COUNT];
+};
+
+/**
+ * Packet waiting in the queue of a transmit class
+ */
+struct _tx_packet {
+  /*! destination of packet */
+  union netaddr_socket dst;
+
+  /*! true if packet is sent to the multicast address of the interface */
+  bool multicast;
+
+  /*! timestamp when the first message of the packet was generated */
+  uint64_t start;
+
+  /*! length of packet */
+  size_t length;
+
+  /*! node for queue of transmit class */
+  struct list_entity _node;
+
+  /*! packet data */
+  uint8_t data[RFC5444_MAX_PACKET_SIZE];
+};
+
 /* prototypes */
 static int _init(void);
 static void _cleanup(void);
@@ -96,28 +150,39 @@ static void _cb_send_unicast_packet(
     struct rfc5444_writer *, struct rfc5444_writer_target *, void *, size_t);
 static void _cb_send_multicast_packet(
     struct rfc5444_writer *, struct rfc5444_writer_target *, void *, size_t);
+static void _cb_send_unicast_packetv(struct rfc5444_writer *,
+    struct rfc5444_writer_target *, const struct iovec *, int);
+static void _cb_send_multicast_packetv(struct rfc5444_writer *,
+    struct rfc5444_writer_target *, const struct iovec *, int);
 static void _cb_forward_message(struct rfc5444_reader_tlvblock_context *context,
     uint8_t *buffer, size_t length);
+static bool _cb_prefilter_message(struct rfc5444_reader_tlvblock_context *context);
+static bool _is_duplicate(struct oonf_duplicate_set *set,
+    struct rfc5444_reader_tlvblock_context *context);
 static void _cb_forwarding_notifier(struct rfc5444_writer_target *);
+static void _cb_send_queue_empty(struct oonf_packet_socket *);
+
+static void _add_to_tx_class(struct oonf_rfc5444_target *, enum oonf_rfc5444_tx_class);
+static void _send_packet(struct oonf_rfc5444_target *,
+    union netaddr_socket *dst, bool multicast, const struct iovec *iov, int iovcnt);
+static void _transmit_packet(struct oonf_rfc5444_interface *,
+    struct oonf_rfc5444_tx_class_data *, union netaddr_socket *dst,
+    bool multicast, const struct iovec *iov, int iovcnt, uint64_t start);
+static void _drain_tx_queues(struct oonf_rfc5444_interface *);
+static void _clear_tx_queues(struct oonf_rfc5444_interface *);
 
 static bool _cb_single_target_selector(struct rfc5444_writer *, struct rfc5444_writer_target *, void *);
 static bool _cb_filtered_targets_selector(struct rfc5444_writer *writer,
     struct rfc5444_writer_target *rfc5444_target, void *ptr);
 
-static struct rfc5444_reader_addrblock_entry *_alloc_addrblock_entry(void);
-static struct rfc5444_reader_tlvblock_entry *_alloc_tlvblock_entry(void);
-static struct rfc5444_writer_address *_alloc_address_entry(void);
-static struct rfc5444_writer_addrtlv *_alloc_addrtlv_entry(void);
-static void _free_addrblock_entry(struct rfc5444_reader_addrblock_entry* addrblock);
-static void _free_tlvblock_entry(struct rfc5444_reader_tlvblock_entry *tlvblock);
-static void _free_address_entry(struct rfc5444_writer_address *);
-static void _free_addrtlv_entry(struct rfc5444_writer_addrtlv *);
 
 static void _cb_add_seqno(struct rfc5444_writer *, struct rfc5444_writer_target *);
 static void _cb_aggregation_event (struct oonf_timer_instance *);
 
 static void _cb_cfg_rfc5444_changed(void);
 static void _cb_cfg_interface_changed(void);
+static void _apply_default_aggregation(struct oonf_rfc5444_interface *interf,
+    struct cfg_named_section *named);
 static void _cb_interface_changed(struct oonf_packet_managed *managed, bool);
 
 /* memory block for rfc5444 targets plus MTU sized packet buffer */
@@ -136,28 +201,9 @@ static struct oonf_class _target_memcookie = {
   .size = sizeof(struct oonf_rfc5444_target),
 };
 
-static struct oonf_class _tlvblock_memcookie = {
-  .name = "RFC5444 TLVblock",
-  .size = sizeof(struct rfc5444_reader_tlvblock_entry),
-  .min_free_count = 32,
-};
-
-static struct oonf_class _addrblock_memcookie = {
-  .name = "RFC5444 Addrblock",
-  .size = sizeof(struct rfc5444_reader_addrblock_entry),
-  .min_free_count = 32,
-};
-
-static struct oonf_class _address_memcookie = {
-  .name = "RFC5444 Address",
-  .size = sizeof(struct rfc5444_writer_address),
-  .min_free_count = 32,
-};
-
-static struct oonf_class _addrtlv_memcookie = {
-  .name = "RFC5444 AddrTLV",
-  .size = sizeof(struct rfc5444_writer_addrtlv),
-  .min_free_count = 32,
+static struct oonf_class _tx_packet_memcookie = {
+  .name = RFC5444_CLASS_TX_PACKET,
+  .size = sizeof(struct _tx_packet),
 };
 
 /* timer for aggregating multiple rfc5444 messages to the same target */
@@ -172,8 +218,15 @@ static struct cfg_schema_entry _rfc5444_entries[] = {
     "UDP port for RFC5444 interface", 0, false, 1, 65535),
   CFG_MAP_INT32_MINMAX(_rfc5444_config, ip_proto, "ip_proto", RFC5444_MANET_IPPROTO_TXT,
     "IP protocol for RFC5444 interface", 0, false, 1, 255),
+  CFG_MAP_BOOL(_rfc5444_config, address_planner, "address_planner", "false",
+    "Reorder the addresses of generated messages by prefix length and common"
+    " head if this is estimated to result in smaller messages"),
+  CFG_MAP_BOOL(_rfc5444_config, message_fanout, "message_fanout", "true",
+    "Generate interface independent messages only once for all interfaces"
+    " and send them without copying them into every packet buffer"),
   CFG_MAP_CLOCK(_rfc5444_config, aggregation_interval, "agregation_interval", "0.100",
-    "Interval in seconds for message aggregation"),
+    "Default interval in seconds for aggregating originated and forwarded messages,"
+    " the tx_*_aggregation settings of the interface section overwrite it"),
 };
 
 static struct cfg_schema_section _rfc5444_section = {
@@ -185,19 +238,42 @@ static struct cfg_schema_section _rfc5444_section = {
 };
 
 static struct cfg_schema_entry _interface_entries[] = {
-  CFG_MAP_ACL_V46(oonf_packet_managed_config, acl, "acl", ACL_DEFAULT_ACCEPT,
+  CFG_MAP_ACL_V46(_interface_config, socket.acl, "acl", ACL_DEFAULT_ACCEPT,
     "Access control list for RFC5444 interface"),
-  CFG_MAP_ACL_V46(oonf_packet_managed_config, bindto, "bindto",
+  CFG_MAP_ACL_V46(_interface_config, socket.bindto, "bindto",
       "-127.0.0.0/8\0" "-::1\0" ACL_DEFAULT_ACCEPT,
     "Bind RFC5444 socket to an address matching this filter (both IPv4 and IPv6)"),
-  CFG_MAP_NETADDR_V4(oonf_packet_managed_config, multicast_v4, "multicast_v4", RFC5444_MANET_MULTICAST_V4_TXT,
+  CFG_MAP_NETADDR_V4(_interface_config, socket.multicast_v4, "multicast_v4", RFC5444_MANET_MULTICAST_V4_TXT,
     "ipv4 multicast address of this socket", false, true),
-  CFG_MAP_NETADDR_V6(oonf_packet_managed_config, multicast_v6, "multicast_v6", RFC5444_MANET_MULTICAST_V6_TXT,
+  CFG_MAP_NETADDR_V6(_interface_config, socket.multicast_v6, "multicast_v6", RFC5444_MANET_MULTICAST_V6_TXT,
     "ipv6 multicast address of this socket", false, true),
-  CFG_MAP_INT32_MINMAX(oonf_packet_managed_config, dscp, "dscp", "192",
+  CFG_MAP_INT32_MINMAX(_interface_config, socket.dscp, "dscp", "192",
     "DSCP field for outgoing UDP protocol traffic", 0, false, 0, 255),
-  CFG_MAP_BOOL(oonf_packet_managed_config, rawip, "rawip", "false",
+  CFG_MAP_BOOL(_interface_config, socket.rawip, "rawip", "false",
     "True if a raw IP socket should be used, false to use UDP"),
+
+  CFG_MAP_CLOCK(_interface_config, tx[OONF_RFC5444_TX_HELLO].aggregation_interval,
+      "tx_hello_aggregation", "0.050",
+      "Interval in seconds for aggregating HELLO messages with other messages"),
+  CFG_MAP_INT32_MINMAX(_interface_config, tx[OONF_RFC5444_TX_HELLO].queue_limit,
+      "tx_hello_queue", "4",
+      "Maximum number of HELLO packets waiting for a congested socket", 0, false, 0, 1024),
+  CFG_MAP_CLOCK(_interface_config, tx[OONF_RFC5444_TX_ORIGINATED].aggregation_interval,
+      "tx_originated_aggregation", "0.100",
+      "Interval in seconds for aggregating other locally generated messages,"
+      " default is the agregation_interval of the "CFG_RFC5444_SECTION" section"),
+  CFG_MAP_INT32_MINMAX(_interface_config, tx[OONF_RFC5444_TX_ORIGINATED].queue_limit,
+      "tx_originated_queue", "16",
+      "Maximum number of packets with locally generated messages waiting for a congested socket",
+      0, false, 0, 1024),
+  CFG_MAP_CLOCK(_interface_config, tx[OONF_RFC5444_TX_FORWARDED].aggregation_interval,
+      "tx_forwarded_aggregation", "0.100",
+      "Interval in seconds for aggregating forwarded messages,"
+      " default is the agregation_interval of the "CFG_RFC5444_SECTION" section"),
+  CFG_MAP_INT32_MINMAX(_interface_config, tx[OONF_RFC5444_TX_FORWARDED].queue_limit,
+      "tx_forwarded_queue", "32",
+      "Maximum number of packets with forwarded messages waiting for a congested socket",
+      0, false, 0, 1024),
 };
 
 static struct cfg_schema_section _interface_section = {
@@ -209,21 +285,39 @@ static struct cfg_schema_section _interface_section = {
   .next_section = &_rfc5444_section,
 };
 
-static uint64_t _aggregation_interval;
+/*
+ * transmit class settings of interfaces without configuration section,
+ * the aggregation of originated and forwarded messages is set by the
+ * agregation_interval of the rfc5444 section
+ */
+static struct _tx_class_config _tx_class_defaults[OONF_RFC5444_TX_CLASS_COUNT] = {
+  [OONF_RFC5444_TX_HELLO]      = { .aggregation_interval = 50,  .queue_limit = 4 },
+  [OONF_RFC5444_TX_ORIGINATED] = { .aggregation_interval = 100, .queue_limit = 16 },
+  [OONF_RFC5444_TX_FORWARDED]  = { .aggregation_interval = 100, .queue_limit = 32 },
+};
+
+/* interface section keys of the transmit class aggregation intervals */
+static const char *_tx_aggregation_keys[OONF_RFC5444_TX_CLASS_COUNT] = {
+  [OONF_RFC5444_TX_HELLO]      = "tx_hello_aggregation",
+  [OONF_RFC5444_TX_ORIGINATED] = "tx_originated_aggregation",
+  [OONF_RFC5444_TX_FORWARDED]  = "tx_forwarded_aggregation",
+};
+
+static const char *_tx_class_names[OONF_RFC5444_TX_CLASS_COUNT] = {
+  [OONF_RFC5444_TX_HELLO]      = "hello",
+  [OONF_RFC5444_TX_ORIGINATED] = "originated",
+  [OONF_RFC5444_TX_FORWARDED]  = "forwarded",
+};
+
+/* transmit class of the message the writer is currently generating */
+static enum oonf_rfc5444_tx_class _current_tx_class = OONF_RFC5444_TX_CLASS_COUNT;
 
 /* rfc5444 handling */
 static const struct rfc5444_reader _reader_template = {
   .forward_message = _cb_forward_message,
-  .malloc_addrblock_entry = _alloc_addrblock_entry,
-  .malloc_tlvblock_entry = _alloc_tlvblock_entry,
-  .free_addrblock_entry = _free_addrblock_entry,
-  .free_tlvblock_entry = _free_tlvblock_entry,
+  .prefilter_message = _cb_prefilter_message,
 };
 static const struct rfc5444_writer _writer_template = {
-  .malloc_address_entry = _alloc_address_entry,
-  .malloc_addrtlv_entry = _alloc_addrtlv_entry,
-  .free_address_entry = _free_address_entry,
-  .free_addrtlv_entry = _free_addrtlv_entry,
   .msg_size = RFC5444_MAX_MESSAGE_SIZE,
   .addrtlv_size = RFC5444_ADDRTLV_BUFFER,
 };
@@ -232,12 +326,7 @@ static const struct rfc5444_writer _writer_template = {
 static struct autobuf _printer_buffer;
 static struct rfc5444_print_session _printer_session;
 
-static struct rfc5444_reader _printer = {
-  .malloc_addrblock_entry = _alloc_addrblock_entry,
-  .malloc_tlvblock_entry = _alloc_tlvblock_entry,
-  .free_addrblock_entry = _free_addrblock_entry,
-  .free_tlvblock_entry = _free_tlvblock_entry,
-};
+static struct rfc5444_reader _printer;
 
 /* configuration for RFC5444 socket */
 static uint8_t _incoming_buffer[RFC5444_MAX_PACKET_SIZE];
@@ -245,7 +334,10 @@ static uint8_t _incoming_buffer[RFC5444_MAX_PACKET_SIZE];
 static struct oonf_packet_config _socket_config = {
   .input_buffer = _incoming_buffer,
   .input_buffer_length = sizeof(_incoming_buffer),
+  .receive_batch = 16,
   .receive_data = _cb_receive_data,
+  .send_queue_empty = _cb_send_queue_empty,
+  .rx_timestamp = true,
 };
 
 /* tree of active rfc5444 protocols */
@@ -261,6 +353,7 @@ static const struct const_strarray _unicast_bindto_acl_value =
 /* subsystem definition */
 static const char *_dependencies[] = {
   OONF_CLASS_SUBSYSTEM,
+  OONF_CLOCK_SUBSYSTEM,
   OONF_DUPSET_SUBSYSTEM,
   OONF_PACKET_SUBSYSTEM,
   OONF_TIMER_SUBSYSTEM,
@@ -292,10 +385,7 @@ _init(void) {
 
   oonf_class_add(&_protocol_memcookie);
   oonf_class_add(&_target_memcookie);
-  oonf_class_add(&_addrblock_memcookie);
-  oonf_class_add(&_tlvblock_memcookie);
-  oonf_class_add(&_address_memcookie);
-  oonf_class_add(&_addrtlv_memcookie);
+  oonf_class_add(&_tx_packet_memcookie);
 
   oonf_timer_add(&_aggregation_timer);
 
@@ -368,10 +458,7 @@ _cleanup(void) {
   oonf_class_remove(&_protocol_memcookie);
   oonf_class_remove(&_interface_memcookie);
   oonf_class_remove(&_target_memcookie);
-  oonf_class_remove(&_tlvblock_memcookie);
-  oonf_class_remove(&_addrblock_memcookie);
-  oonf_class_remove(&_address_memcookie);
-  oonf_class_remove(&_addrtlv_memcookie);
+  oonf_class_remove(&_tx_packet_memcookie);
   return;
 }
 
@@ -383,6 +470,7 @@ _cleanup(void) {
  */
 enum rfc5444_result oonf_rfc5444_send_if(
     struct oonf_rfc5444_target *target, uint8_t msgid) {
+  enum rfc5444_result result;
   uint8_t addr_len;
 
   #ifdef OONF_LOG_INFO
@@ -394,10 +482,9 @@ enum rfc5444_result oonf_rfc5444_send_if(
     return RFC5444_OKAY;
   }
 
-  if (!oonf_timer_is_active(&target->_aggregation)) {
-    /* activate aggregation timer */
-    oonf_timer_start(&target->_aggregation, _aggregation_interval);
-  }
+  _current_tx_class = msgid == RFC6130_MSGTYPE_HELLO
+      ? OONF_RFC5444_TX_HELLO : OONF_RFC5444_TX_ORIGINATED;
+  _add_to_tx_class(target, _current_tx_class);
 
   /* create message */
   OONF_INFO(LOG_RFC5444, "Create message id %d for protocol %s/target %s on interface %s",
@@ -405,8 +492,11 @@ enum rfc5444_result oonf_rfc5444_send_if(
       target->interface->name);
 
   addr_len = netaddr_get_address_family(&target->dst) == AF_INET ? 4 : 16;
-  return rfc5444_writer_create_message(&target->interface->protocol->writer,
+  result = rfc5444_writer_create_message(&target->interface->protocol->writer,
       msgid, addr_len, _cb_single_target_selector, target);
+
+  _current_tx_class = OONF_RFC5444_TX_CLASS_COUNT;
+  return result;
 }
 
 /**
@@ -420,11 +510,43 @@ enum rfc5444_result oonf_rfc5444_send_if(
 enum rfc5444_result
 oonf_rfc5444_send_all(struct oonf_rfc5444_protocol *protocol,
     uint8_t msgid, uint8_t addr_len, rfc5444_writer_targetselector useIf) {
+  enum rfc5444_result result;
+
   /* create message */
   OONF_INFO(LOG_RFC5444, "Create message id %d", msgid);
 
-  return rfc5444_writer_create_message(&protocol->writer,
+  _current_tx_class = msgid == RFC6130_MSGTYPE_HELLO
+      ? OONF_RFC5444_TX_HELLO : OONF_RFC5444_TX_ORIGINATED;
+  result = rfc5444_writer_create_message(&protocol->writer,
       msgid, addr_len, _cb_filtered_targets_selector, useIf);
+
+  _current_tx_class = OONF_RFC5444_TX_CLASS_COUNT;
+  return result;
+}
+
+/**
+ * Add an already serialized RFC5444 message to the packets of
+ * a group of interfaces
+ * @param protocol protocol for outgoing message
+ * @param msg pointer to binary message
+ * @param len length of binary message
+ * @param useIf callback to selector for interfaces
+ * @return return code of rfc5444 writer
+ */
+enum rfc5444_result
+oonf_rfc5444_send_all_binary(struct oonf_rfc5444_protocol *protocol,
+    const uint8_t *msg, size_t len, rfc5444_writer_targetselector useIf) {
+  enum rfc5444_result result;
+
+  OONF_INFO(LOG_RFC5444, "Add binary message id %d", msg[0]);
+
+  _current_tx_class = msg[0] == RFC6130_MSGTYPE_HELLO
+      ? OONF_RFC5444_TX_HELLO : OONF_RFC5444_TX_ORIGINATED;
+  result = rfc5444_writer_add_binary_msg(&protocol->writer,
+      msg, len, _cb_filtered_targets_selector, useIf);
+
+  _current_tx_class = OONF_RFC5444_TX_CLASS_COUNT;
+  return result;
 }
 
 /**
@@ -567,6 +689,7 @@ oonf_rfc5444_add_interface(struct oonf_rfc5444_protocol *protocol,
     struct oonf_rfc5444_interface_listener *listener, const char *name) {
   struct oonf_rfc5444_interface *interf;
   uint16_t rnd;
+  int i;
 
   interf = oonf_rfc5444_get_interface(protocol, name);
   if (interf == NULL) {
@@ -610,6 +733,13 @@ oonf_rfc5444_add_interface(struct oonf_rfc5444_protocol *protocol,
     /* initialize listener list */
     list_init_head(&interf->_listener);
 
+    /* initialize transmit classes */
+    for (i=0; i<OONF_RFC5444_TX_CLASS_COUNT; i++) {
+      interf->tx_class[i].aggregation_interval = _tx_class_defaults[i].aggregation_interval;
+      interf->tx_class[i].queue_limit = _tx_class_defaults[i].queue_limit;
+      list_init_head(&interf->tx_class[i]._queue);
+    }
+
     /* increase protocol refcount */
     protocol->_refcount++;
   }
@@ -671,6 +801,9 @@ oonf_rfc5444_remove_interface(struct oonf_rfc5444_interface *interf,
   /* decrease protocol refcount */
   oonf_rfc5444_remove_protocol(interf->protocol);
 
+  /* drop packets waiting for the socket */
+  _clear_tx_queues(interf);
+
   /* remove socket */
   oonf_packet_remove_managed(&interf->_socket, false);
 
@@ -904,6 +1037,18 @@ oonf_rfc5444_block_output(bool block) {
   _block_output = block;
 }
 
+/**
+ * @param tx_class transmit class
+ * @return name of transmit class
+ */
+const char *
+oonf_rfc5444_get_tx_class_name(enum oonf_rfc5444_tx_class tx_class) {
+  if (tx_class >= OONF_RFC5444_TX_CLASS_COUNT) {
+    return "unknown";
+  }
+  return _tx_class_names[tx_class];
+}
+
 /**
  * Create a new rfc5444 target
  * @param interf rfc5444 interface
@@ -933,9 +1078,11 @@ _create_target(struct oonf_rfc5444_interface *interf,
   target->rfc5444_target.addPacketHeader = _cb_add_seqno;
   if (unicast) {
     target->rfc5444_target.sendPacket = _cb_send_unicast_packet;
+    target->rfc5444_target.sendPacketv = _cb_send_unicast_packetv;
   }
   else {
     target->rfc5444_target.sendPacket = _cb_send_multicast_packet;
+    target->rfc5444_target.sendPacketv = _cb_send_multicast_packetv;
   }
   rfc5444_writer_register_target(
       &interf->protocol->writer, &target->rfc5444_target);
@@ -955,6 +1102,9 @@ _create_target(struct oonf_rfc5444_interface *interf,
   /* initialize pktseqno */
   target->_pktseqno = rnd;
 
+  /* packet buffer is empty */
+  target->_tx_class = OONF_RFC5444_TX_CLASS_COUNT;
+
   return target;
 }
 
@@ -1013,6 +1163,43 @@ _print_packet_to_buffer(enum oonf_log_source source,
   }
 }
 
+/**
+ * Print a rfc5444 packet assembled from several fragments
+ * to the logging system
+ * @param sock socket the packet is reffering to
+ * @param interf pointer to rfc5444 interface
+ * @param iov array of packet fragments
+ * @param iovcnt number of packet fragments
+ * @param success text prefix for successful printing
+ * @param error text prefix when error happens during packet parsing
+ */
+static void
+_print_packetv_to_buffer(enum oonf_log_source source,
+    union netaddr_socket *sock, struct oonf_rfc5444_interface *interf,
+    const struct iovec *iov, int iovcnt,
+    const char *success, const char *error) {
+  static uint8_t packet[RFC5444_MAX_PACKET_SIZE];
+  size_t len;
+  int i;
+
+  if (iovcnt == 1) {
+    _print_packet_to_buffer(source, sock, interf,
+        iov[0].iov_base, iov[0].iov_len, success, error);
+    return;
+  }
+  if (!oonf_log_mask_test(log_global_mask, source, LOG_SEVERITY_DEBUG)) {
+    return;
+  }
+
+  /* the packet parser needs a contiguous packet */
+  len = 0;
+  for (i=0; i<iovcnt; i++) {
+    memcpy(&packet[len], iov[i].iov_base, iov[i].iov_len);
+    len += iov[i].iov_len;
+  }
+  _print_packet_to_buffer(source, sock, interf, packet, len, success, error);
+}
+
 /**
  * Handle incoming packet from a socket
  * @param sock pointer to packet socket
@@ -1056,6 +1243,7 @@ _cb_receive_data(struct oonf_packet_socket *sock,
       "Incoming RFC5444 packet from",
       "Error while parsing incoming RFC5444 packet from");
 
+  protocol->reader.rx_timestamp = oonf_packet_get_rx_timestamp(sock);
   result = rfc5444_reader_handle_packet(
       &protocol->reader, ptr, length);
   if (result < 0) {
@@ -1077,8 +1265,43 @@ _cb_receive_data(struct oonf_packet_socket *sock,
  * @param size_t length of buffer
  */
 static void
-_cb_send_multicast_packet(struct rfc5444_writer *writer __attribute__((unused)),
+_cb_send_multicast_packet(struct rfc5444_writer *writer,
     struct rfc5444_writer_target *target, void *ptr, size_t len) {
+  struct iovec iov;
+
+  iov.iov_base = ptr;
+  iov.iov_len = len;
+  _cb_send_multicast_packetv(writer, target, &iov, 1);
+}
+
+/**
+ * Callback for sending an unicast packet to a rfc5444 target
+ * @param writer rfc5444 writer
+ * @param interf rfc5444 interface
+ * @param ptr pointer to outgoing buffer
+ * @param size_t length of buffer
+ */
+static void
+_cb_send_unicast_packet(struct rfc5444_writer *writer,
+    struct rfc5444_writer_target *target, void *ptr, size_t len) {
+  struct iovec iov;
+
+  iov.iov_base = ptr;
+  iov.iov_len = len;
+  _cb_send_unicast_packetv(writer, target, &iov, 1);
+}
+
+/**
+ * Callback for sending a multicast packet assembled from
+ * several fragments to a rfc5444 target
+ * @param writer rfc5444 writer
+ * @param interf rfc5444 interface
+ * @param iov array of packet fragments
+ * @param iovcnt number of packet fragments
+ */
+static void
+_cb_send_multicast_packetv(struct rfc5444_writer *writer __attribute__((unused)),
+    struct rfc5444_writer_target *target, const struct iovec *iov, int iovcnt) {
   struct oonf_rfc5444_target *t;
   struct os_interface_listener *if_listener;
   union netaddr_socket sock;
@@ -1089,28 +1312,29 @@ _cb_send_multicast_packet(struct rfc5444_writer *writer __attribute__((unused)),
   netaddr_socket_init(&sock, &t->dst, t->interface->protocol->port,
       if_listener->data->index);
 
-  _print_packet_to_buffer(LOG_RFC5444_W, &sock, t->interface, ptr, len,
+  _print_packetv_to_buffer(LOG_RFC5444_W, &sock, t->interface, iov, iovcnt,
       "Outgoing RFC5444 packet to",
       "Error while parsing outgoing RFC5444 packet to");
 
   if (_block_output) {
     OONF_DEBUG(LOG_RFC5444, "Output blocked");
+    t->_tx_class = OONF_RFC5444_TX_CLASS_COUNT;
     return;
   }
-  oonf_packet_send_managed_multicast(&t->interface->_socket,
-      ptr, len, netaddr_get_address_family(&t->dst));
+  _send_packet(t, &sock, true, iov, iovcnt);
 }
 
 /**
- * Callback for sending an unicast packet to a rfc5444 target
+ * Callback for sending an unicast packet assembled from
+ * several fragments to a rfc5444 target
  * @param writer rfc5444 writer
  * @param interf rfc5444 interface
- * @param ptr pointer to outgoing buffer
- * @param size_t length of buffer
+ * @param iov array of packet fragments
+ * @param iovcnt number of packet fragments
  */
 static void
-_cb_send_unicast_packet(struct rfc5444_writer *writer __attribute__((unused)),
-    struct rfc5444_writer_target *target, void *ptr, size_t len) {
+_cb_send_unicast_packetv(struct rfc5444_writer *writer __attribute__((unused)),
+    struct rfc5444_writer_target *target, const struct iovec *iov, int iovcnt) {
   struct oonf_rfc5444_target *t;
   union netaddr_socket sock;
   struct os_interface_listener *interf;
@@ -1121,16 +1345,292 @@ _cb_send_unicast_packet(struct rfc5444_writer *writer __attribute__((unused)),
   netaddr_socket_init(&sock, &t->dst, t->interface->protocol->port,
       interf->data->index);
 
-  _print_packet_to_buffer(LOG_RFC5444_W, &sock, t->interface, ptr, len,
+  _print_packetv_to_buffer(LOG_RFC5444_W, &sock, t->interface, iov, iovcnt,
       "Outgoing RFC5444 packet to",
       "Error while parsing outgoing RFC5444 packet to");
 
   if (_block_output) {
     OONF_DEBUG(LOG_RFC5444, "Output blocked");
+    t->_tx_class = OONF_RFC5444_TX_CLASS_COUNT;
+    return;
+  }
+
+  _send_packet(t, &sock, false, iov, iovcnt);
+}
+
+/**
+ * Add a message of a transmit class to the packet buffer of a target
+ * and make sure the aggregation timer fires in time for this class
+ * @param target rfc5444 target
+ * @param tx_class transmit class of the message
+ */
+static void
+_add_to_tx_class(struct oonf_rfc5444_target *target,
+    enum oonf_rfc5444_tx_class tx_class) {
+  uint64_t interval;
+
+  if (tx_class >= OONF_RFC5444_TX_CLASS_COUNT) {
+    tx_class = OONF_RFC5444_TX_ORIGINATED;
+  }
+
+  if (target->_tx_class == OONF_RFC5444_TX_CLASS_COUNT) {
+    /* first message of the packet */
+    target->_tx_start = oonf_clock_getNow();
+  }
+  if (tx_class < target->_tx_class) {
+    target->_tx_class = tx_class;
+  }
+
+  interval = target->interface->tx_class[tx_class].aggregation_interval;
+  if (!oonf_timer_is_active(&target->_aggregation)
+      || oonf_timer_get_due(&target->_aggregation) > (int64_t)interval) {
+    /* activate aggregation timer or shorten it for this class */
+    oonf_timer_start(&target->_aggregation, interval);
+  }
+}
+
+/**
+ * @param interf rfc5444 interface
+ * @return true if one of the interface sockets has datagrams
+ *   waiting in its transmit queue
+ */
+static bool
+_is_congested(struct oonf_rfc5444_interface *interf) {
+  return oonf_packet_get_send_queue_depth(&interf->_socket.socket_v4) > 0
+      || oonf_packet_get_send_queue_depth(&interf->_socket.socket_v6) > 0;
+}
+
+/**
+ * Send a generated packet of a target or queue it in its transmit
+ * class if the interface socket is congested
+ * @param target rfc5444 target
+ * @param dst destination of packet
+ * @param multicast true if packet is sent to the multicast address
+ * @param iov array of packet fragments
+ * @param iovcnt number of packet fragments
+ */
+static void
+_send_packet(struct oonf_rfc5444_target *target,
+    union netaddr_socket *dst, bool multicast, const struct iovec *iov, int iovcnt) {
+  struct oonf_rfc5444_interface *interf;
+  struct oonf_rfc5444_tx_class_data *tx;
+  enum oonf_rfc5444_tx_class tx_class;
+  struct _tx_packet *pkt;
+  uint64_t start;
+  int i;
+
+  interf = target->interface;
+
+  tx_class = target->_tx_class;
+  start = target->_tx_start;
+  if (tx_class == OONF_RFC5444_TX_CLASS_COUNT) {
+    /* forced packet without messages */
+    tx_class = OONF_RFC5444_TX_ORIGINATED;
+    start = oonf_clock_getNow();
+  }
+
+  /* packet buffer is empty again */
+  target->_tx_class = OONF_RFC5444_TX_CLASS_COUNT;
+  if (_current_tx_class != OONF_RFC5444_TX_CLASS_COUNT) {
+    /* the writer flushed the buffer to make room for a new message */
+    _add_to_tx_class(target, _current_tx_class);
+  }
+
+  tx = &interf->tx_class[tx_class];
+  if (!_is_congested(interf)) {
+    _transmit_packet(interf, tx, dst, multicast, iov, iovcnt, start);
     return;
   }
 
-  oonf_packet_send_managed(&t->interface->_socket, &sock, ptr, len);
+  if (tx->_queue_count > 0 && tx->_queue_count >= (uint32_t)tx->queue_limit) {
+    /* drop the oldest packet, its content is most likely outdated */
+    pkt = list_first_element(&tx->_queue, pkt, _node);
+    list_remove(&pkt->_node);
+    tx->_queue_count--;
+    tx->stats.dropped++;
+    oonf_class_free(&_tx_packet_memcookie, pkt);
+  }
+
+  if (tx->queue_limit == 0
+      || (pkt = oonf_class_malloc(&_tx_packet_memcookie)) == NULL) {
+    tx->stats.dropped++;
+    return;
+  }
+
+  memcpy(&pkt->dst, dst, sizeof(pkt->dst));
+  pkt->multicast = multicast;
+  pkt->start = start;
+  pkt->length = 0;
+  for (i=0; i<iovcnt; i++) {
+    memcpy(&pkt->data[pkt->length], iov[i].iov_base, iov[i].iov_len);
+    pkt->length += iov[i].iov_len;
+  }
+
+  list_add_tail(&tx->_queue, &pkt->_node);
+  tx->_queue_count++;
+  tx->stats.queued++;
+  if (tx->_queue_count > tx->stats.max_queue) {
+    tx->stats.max_queue = tx->_queue_count;
+  }
+
+  OONF_DEBUG(LOG_RFC5444, "Interface %s congested, queued %s packet (%u waiting)",
+      interf->name, _tx_class_names[tx_class], tx->_queue_count);
+}
+
+/**
+ * Hand a packet to the interface socket and update the statistics
+ * of its transmit class
+ * @param interf rfc5444 interface
+ * @param tx transmit class of packet
+ * @param dst destination of packet
+ * @param multicast true if packet is sent to the multicast address
+ * @param iov array of packet fragments
+ * @param iovcnt number of packet fragments
+ * @param start timestamp of the first message of the packet
+ */
+static void
+_transmit_packet(struct oonf_rfc5444_interface *interf,
+    struct oonf_rfc5444_tx_class_data *tx, union netaddr_socket *dst,
+    bool multicast, const struct iovec *iov, int iovcnt, uint64_t start) {
+  uint64_t now, delay;
+
+  now = oonf_clock_getNow();
+  delay = now > start ? now - start : 0;
+
+  tx->stats.packets++;
+  tx->stats.delay_total += delay;
+  if (delay > tx->stats.delay_max) {
+    tx->stats.delay_max = delay;
+  }
+
+  if (multicast) {
+    oonf_packet_sendv_managed_multicast(&interf->_socket,
+        iov, iovcnt, netaddr_socket_get_addressfamily(dst));
+  }
+  else {
+    oonf_packet_sendv_managed(&interf->_socket, dst, iov, iovcnt);
+  }
+}
+
+/**
+ * Send queued packets in order of their transmit class priority
+ * until the interface socket is congested again
+ * @param interf rfc5444 interface
+ */
+static void
+_drain_tx_queues(struct oonf_rfc5444_interface *interf) {
+  struct oonf_rfc5444_tx_class_data *tx;
+  struct _tx_packet *pkt;
+  struct iovec iov;
+  int i;
+
+  for (i=0; i<OONF_RFC5444_TX_CLASS_COUNT; i++) {
+    tx = &interf->tx_class[i];
+
+    while (tx->_queue_count > 0) {
+      if (_is_congested(interf)) {
+        return;
+      }
+
+      pkt = list_first_element(&tx->_queue, pkt, _node);
+      list_remove(&pkt->_node);
+      tx->_queue_count--;
+
+      iov.iov_base = pkt->data;
+      iov.iov_len = pkt->length;
+      _transmit_packet(interf, tx, &pkt->dst, pkt->multicast,
+          &iov, 1, pkt->start);
+      oonf_class_free(&_tx_packet_memcookie, pkt);
+    }
+  }
+}
+
+/**
+ * Drop all packets waiting in the transmit classes of an interface
+ * @param interf rfc5444 interface
+ */
+static void
+_clear_tx_queues(struct oonf_rfc5444_interface *interf) {
+  struct oonf_rfc5444_tx_class_data *tx;
+  struct _tx_packet *pkt, *it;
+  int i;
+
+  for (i=0; i<OONF_RFC5444_TX_CLASS_COUNT; i++) {
+    tx = &interf->tx_class[i];
+
+    list_for_each_element_safe(&tx->_queue, pkt, _node, it) {
+      list_remove(&pkt->_node);
+      oonf_class_free(&_tx_packet_memcookie, pkt);
+    }
+    tx->_queue_count = 0;
+  }
+}
+
+/**
+ * Callback triggered when the transmit queue of an interface
+ * socket has been sent completely
+ * @param sock packet socket
+ */
+static void
+_cb_send_queue_empty(struct oonf_packet_socket *sock) {
+  struct oonf_rfc5444_interface *interf;
+
+  interf = sock->config.user;
+  _drain_tx_queues(interf);
+}
+
+/**
+ * Check the header of an incoming message against the processed and
+ * forwarded set of the protocol, before the reader decodes its blocks.
+ * A message that was already processed and either was already forwarded
+ * or cannot be forwarded is skipped.
+ * @param context rfc5444 message context, only header fields are valid
+ * @return true if message should be parsed, false otherwise
+ */
+static bool
+_cb_prefilter_message(struct rfc5444_reader_tlvblock_context *context) {
+  struct oonf_rfc5444_protocol *protocol;
+#ifdef OONF_LOG_DEBUG_INFO
+  struct netaddr_str nbuf;
+#endif
+
+  if (!context->has_origaddr || !context->has_seqno) {
+    /* message cannot be in a duplicate set */
+    return true;
+  }
+
+  protocol = container_of(context->reader, struct oonf_rfc5444_protocol, reader);
+  if (!_is_duplicate(&protocol->processed_set, context)) {
+    return true;
+  }
+
+  if (context->has_hoplimit && context->hoplimit > 1
+      && !_is_duplicate(&protocol->forwarded_set, context)) {
+    /* message might still need forwarding */
+    return true;
+  }
+
+  OONF_DEBUG(LOG_RFC5444, "Skip duplicate message type %u from %s with seqno %u",
+      context->msg_type, netaddr_to_string(&nbuf, &context->orig_addr),
+      context->seqno);
+  return false;
+}
+
+/**
+ * Test if a message has already been added to a duplicate set
+ * @param set duplicate set
+ * @param context rfc5444 message context
+ * @return true if sequence number of message is already in the set
+ */
+static bool
+_is_duplicate(struct oonf_duplicate_set *set,
+    struct rfc5444_reader_tlvblock_context *context) {
+  enum oonf_duplicate_result result;
+
+  /* the protocol adds the message to the set, do not touch it here */
+  result = oonf_duplicate_peek(set, context->msg_type,
+      &context->orig_addr, context->seqno);
+  return result == OONF_DUPSET_DUPLICATE || result == OONF_DUPSET_CURRENT;
 }
 
 /**
@@ -1164,10 +1664,7 @@ _cb_forwarding_notifier(struct rfc5444_writer_target *rfc5444target) {
   struct oonf_rfc5444_target *target;
 
   target = container_of(rfc5444target, struct oonf_rfc5444_target, rfc5444_target);
-  if (!oonf_timer_is_active(&target->_aggregation)) {
-    /* activate aggregation timer */
-    oonf_timer_start(&target->_aggregation, _aggregation_interval);
-  }
+  _add_to_tx_class(target, OONF_RFC5444_TX_FORWARDED);
 }
 
 /**
@@ -1214,10 +1711,7 @@ _cb_filtered_targets_selector(struct rfc5444_writer *writer,
     return false;
   }
 
-  if (!oonf_timer_is_active(&target->_aggregation)) {
-    /* activate aggregation timer */
-    oonf_timer_start(&target->_aggregation, _aggregation_interval);
-  }
+  _add_to_tx_class(target, _current_tx_class);
 
   /* create message */
   OONF_INFO(LOG_RFC5444, "Send message to protocol %s/target %s on interface %s",
@@ -1227,78 +1721,6 @@ _cb_filtered_targets_selector(struct rfc5444_writer *writer,
   return true;
 }
 
-/**
- * Internal memory allocation function for addrblock
- * @return pointer to cleared addrblock
- */
-static struct rfc5444_reader_addrblock_entry *
-_alloc_addrblock_entry(void) {
-  return oonf_class_malloc(&_addrblock_memcookie);
-}
-
-/**
- * Internal memory allocation function for rfc5444_reader_tlvblock_entry
- * @return pointer to cleared rfc5444_reader_tlvblock_entry
- */
-static struct rfc5444_reader_tlvblock_entry *
-_alloc_tlvblock_entry(void) {
-  return oonf_class_malloc(&_tlvblock_memcookie);
-}
-
-/**
- * Internal memory allocation function for rfc5444_writer_address
- * @return pointer to cleared rfc5444_writer_address
- */
-static struct rfc5444_writer_address *
-_alloc_address_entry(void) {
-  return oonf_class_malloc(&_address_memcookie);
-}
-
-/**
- * Internal memory allocation function for rfc5444_writer_addrtlv
- * @return pointer to cleared rfc5444_writer_addrtlv
- */
-static struct rfc5444_writer_addrtlv *
-_alloc_addrtlv_entry(void) {
-  return oonf_class_malloc(&_addrtlv_memcookie);
-}
-
-/**
- * Free an addrblock entry
- * @param pointer to addrblock
- */
-static void
-_free_addrblock_entry(struct rfc5444_reader_addrblock_entry* addrblock) {
-  oonf_class_free(&_addrblock_memcookie, addrblock);
-}
-
-/**
- * Free a tlvblock entry
- * @param pointer to tlvblock
- */
-static void
-_free_tlvblock_entry(struct rfc5444_reader_tlvblock_entry *tlvblock) {
-  oonf_class_free(&_tlvblock_memcookie, tlvblock);
-}
-
-/**
- * Free a tlvblock entry
- * @param pointer to tlvblock
- */
-static void
-_free_address_entry(struct rfc5444_writer_address *address) {
-  oonf_class_free(&_address_memcookie, address);
-}
-
-/**
- * Free a tlvblock entry
- * @param pointer to tlvblock
- */
-static void
-_free_addrtlv_entry(struct rfc5444_writer_addrtlv *addrtlv) {
-  oonf_class_free(&_addrtlv_memcookie, addrtlv);
-}
-
 /**
  * Callback to add sequence number to outgoing RFC5444 packet
  * @param writer pointer to rfc5444 writer
@@ -1341,6 +1763,7 @@ _cb_aggregation_event (struct oonf_timer_instance *ptr) {
 static void
 _cb_cfg_rfc5444_changed(void) {
   struct _rfc5444_config config;
+  struct oonf_rfc5444_interface *interf;
   int result;
 
   memset(&config, 0, sizeof(config));
@@ -1356,7 +1779,18 @@ _cb_cfg_rfc5444_changed(void) {
   /* apply values */
   oonf_rfc5444_reconfigure_protocol(_rfc5444_protocol,
       config.port, config.ip_proto);
-  _aggregation_interval = config.aggregation_interval;
+  _rfc5444_protocol->writer.plan_addresses = config.address_planner;
+  _rfc5444_protocol->writer.fanout = config.message_fanout;
+
+  _tx_class_defaults[OONF_RFC5444_TX_ORIGINATED].aggregation_interval =
+      config.aggregation_interval;
+  _tx_class_defaults[OONF_RFC5444_TX_FORWARDED].aggregation_interval =
+      config.aggregation_interval;
+
+  avl_for_each_element(&_rfc5444_protocol->_interface_tree, interf, _node) {
+    _apply_default_aggregation(interf, cfg_db_find_namedsection(
+        oonf_cfg_get_db(), CFG_INTERFACE_SECTION, interf->name));
+  }
 }
 
 /**
@@ -1364,10 +1798,10 @@ _cb_cfg_rfc5444_changed(void) {
  */
 static void
 _cb_cfg_interface_changed(void) {
-  struct oonf_packet_managed_config config;
+  struct _interface_config config;
 
   struct oonf_rfc5444_interface *interf;
-  int result;
+  int i, result;
 
   interf = avl_find_element(
       &_rfc5444_protocol->_interface_tree,
@@ -1402,11 +1836,36 @@ _cb_cfg_interface_changed(void) {
     }
   }
 
-  oonf_rfc5444_reconfigure_interface(interf, &config);
+  for (i=0; i<OONF_RFC5444_TX_CLASS_COUNT; i++) {
+    interf->tx_class[i].aggregation_interval = config.tx[i].aggregation_interval;
+    interf->tx_class[i].queue_limit = config.tx[i].queue_limit;
+  }
+  _apply_default_aggregation(interf, _interface_section.post);
+
+  oonf_rfc5444_reconfigure_interface(interf, &config.socket);
 
   /* fall through */
 interface_changed_cleanup:
-  oonf_packet_free_managed_config(&config);
+  oonf_packet_free_managed_config(&config.socket);
+}
+
+/**
+ * Set the aggregation intervals of all transmit classes of an
+ * interface that are not set by its configuration section to
+ * their default values
+ * @param interf rfc5444 interface
+ * @param named configuration section of interface, NULL if none
+ */
+static void
+_apply_default_aggregation(struct oonf_rfc5444_interface *interf,
+    struct cfg_named_section *named) {
+  int i;
+
+  for (i=0; i<OONF_RFC5444_TX_CLASS_COUNT; i++) {
+    if (named == NULL || cfg_db_get_entry(named, _tx_aggregation_keys[i]) == NULL) {
+      interf->tx_class[i].aggregation_interval = _tx_class_defaults[i].aggregation_interval;
+    }
+  }
 }
 
 /**
@@ -48,6 +48,7 @@
 
 #include "common/common_types.h"
 #include "common/avl.h"
+#include "common/list.h"
 #include "common/netaddr.h"
 #include "subsystems/rfc5444/rfc5444.h"
 #include "subsystems/rfc5444/rfc5444_context.h"
@@ -100,8 +101,78 @@ enum {
 /*! memory class for rfc5444 target */
 #define RFC5444_CLASS_TARGET    "RFC5444 target"
 
+/*! memory class for packets waiting in a transmit class queue */
+#define RFC5444_CLASS_TX_PACKET "RFC5444 tx packet"
+
 struct oonf_rfc5444_target;
 
+/**
+ * Transmit classes of outgoing RFC5444 packets. A lower value
+ * means a higher priority. A packet belongs to the class with the
+ * highest priority of the messages within the packet.
+ */
+enum oonf_rfc5444_tx_class {
+  /*! locally generated HELLO messages */
+  OONF_RFC5444_TX_HELLO,
+
+  /*! other locally generated messages (e.g. TCs) */
+  OONF_RFC5444_TX_ORIGINATED,
+
+  /*! messages forwarded for other routers */
+  OONF_RFC5444_TX_FORWARDED,
+
+  /*! number of transmit classes */
+  OONF_RFC5444_TX_CLASS_COUNT,
+};
+
+/**
+ * Statistics of a transmit class of a rfc5444 interface
+ */
+struct oonf_rfc5444_tx_statistics {
+  /*! number of packets handed to the socket */
+  uint32_t packets;
+
+  /*! number of packets that had to wait in the class queue */
+  uint32_t queued;
+
+  /*! number of packets dropped because the class queue was full */
+  uint32_t dropped;
+
+  /*! maximum number of packets in the class queue */
+  uint32_t max_queue;
+
+  /**
+   * sum of the queueing delay of all packets in milliseconds,
+   * measured from the first message of a packet until the packet
+   * is handed to the socket.
+   */
+  uint64_t delay_total;
+
+  /*! maximum queueing delay of a packet in milliseconds */
+  uint64_t delay_max;
+};
+
+/**
+ * Settings, queue and statistics of a transmit class
+ * of a rfc5444 interface
+ */
+struct oonf_rfc5444_tx_class_data {
+  /*! interval to wait for aggregating messages of this class */
+  uint64_t aggregation_interval;
+
+  /*! maximum number of packets waiting in the class queue */
+  int32_t queue_limit;
+
+  /*! statistics of transmit class */
+  struct oonf_rfc5444_tx_statistics stats;
+
+  /*! list of packets waiting for the socket */
+  struct list_entity _queue;
+
+  /*! number of packets in queue */
+  uint32_t _queue_count;
+};
+
 /**
  * Representation of a rfc5444 based protocol
  */
@@ -198,6 +269,9 @@ struct oonf_rfc5444_interface {
   /*! pointer to ipv6 multicast targets for this interface */
   struct oonf_rfc5444_target *multicast6;
 
+  /*! transmit classes of this interface */
+  struct oonf_rfc5444_tx_class_data tx_class[OONF_RFC5444_TX_CLASS_COUNT];
+
   /*! number of users of this interface */
   int _refcount;
 };
@@ -249,6 +323,15 @@ struct oonf_rfc5444_target {
   /*! last packet sequence number used for this target */
   uint16_t _pktseqno;
 
+  /**
+   * transmit class of the packet in the buffer,
+   * OONF_RFC5444_TX_CLASS_COUNT if the buffer is empty
+   */
+  enum oonf_rfc5444_tx_class _tx_class;
+
+  /*! timestamp when the first message was added to the packet buffer */
+  uint64_t _tx_start;
+
   /*! packet output buffer for target */
   uint8_t _packet_buffer[RFC5444_MAX_PACKET_SIZE];
 };
@@ -281,9 +364,14 @@ EXPORT enum rfc5444_result oonf_rfc5444_send_if(
 EXPORT enum rfc5444_result oonf_rfc5444_send_all(
     struct oonf_rfc5444_protocol *protocol,
     uint8_t msgid, uint8_t addr_len, rfc5444_writer_targetselector useIf);
+EXPORT enum rfc5444_result oonf_rfc5444_send_all_binary(
+    struct oonf_rfc5444_protocol *protocol,
+    const uint8_t *msg, size_t len, rfc5444_writer_targetselector useIf);
 
 EXPORT void oonf_rfc5444_block_output(bool block);
 
+EXPORT const char *oonf_rfc5444_get_tx_class_name(enum oonf_rfc5444_tx_class);
+
 /**
  * @param protocol RFC5444 protocol
  * @param name interface name
@@ -296,6 +384,15 @@ oonf_rfc5444_get_interface(
   return avl_find_element(&protocol->_interface_tree, name, interf, _node);
 }
 
+/**
+ * @param protocol RFC5444 protocol
+ * @return tree of RFC5444 interfaces of the protocol
+ */
+static INLINE struct avl_tree *
+oonf_rfc5444_get_interface_tree(struct oonf_rfc5444_protocol *protocol) {
+  return &protocol->_interface_tree;
+}
+
 /**
  * Flush a target and send out the message/packet immediately
  * @param target rfc5444 target
@@ -51,6 +51,7 @@
 
 #include "common/avl.h"
 #include "common/avl_comp.h"
+#include "config/cfg_schema.h"
 #include "subsystems/oonf_clock.h"
 #include "core/oonf_logging.h"
 #include "core/oonf_main.h"
@@ -63,6 +64,17 @@
 /* Definitions */
 #define LOG_SOCKET _oonf_socket_subsystem.logging
 
+/**
+ * Configuration of socket scheduler
+ */
+struct _socket_config {
+  /*! maximum number of events handled per scheduler wakeup */
+  int32_t max_events;
+
+  /*! true if sockets that support it use edge triggered events */
+  bool edge_triggered;
+};
+
 /* prototypes */
 static int _init(void);
 static void _cleanup(void);
@@ -70,6 +82,9 @@ static void _initiate_shutdown(void);
 
 static bool _shall_end_scheduler(void);
 static int _handle_scheduling(void);
+static void _update_statistics(int events);
+static void _advance_virtual_clock(void);
+static void _cb_config_changed(void);
 
 /* time until the scheduler should run */
 static uint64_t _scheduler_time_limit;
@@ -77,9 +92,43 @@ static uint64_t _scheduler_time_limit;
 /* List of all active sockets in scheduler */
 static struct list_entity _socket_head;
 
+/* List of hooks called at the end of each scheduler iteration */
+static struct list_entity _iteration_hooks;
+
 /* socket event scheduler */
 struct os_fd_select _socket_events;
 
+/* statistics of socket scheduler */
+static struct oonf_socket_statistics _stats;
+
+/* end of the last wait for events */
+static uint64_t _last_wakeup;
+
+/* socket handler currently in callback, NULL if it has been removed */
+static struct oonf_socket_entry *_entry_in_callback;
+
+/* true if edge triggered events are enabled */
+static bool _edge_triggered = false;
+
+/* configuration of socket scheduler */
+static struct cfg_schema_entry _socket_entries[] = {
+  CFG_MAP_INT32_MINMAX(_socket_config, max_events, "max_events", "256",
+      "Maximum number of socket events handled by a single scheduler wakeup,"
+      " the event array grows on demand up to this size", 0, false, 1, 65536),
+  CFG_MAP_BOOL(_socket_config, edge_triggered, "edge_triggered", "false",
+      "Use edge triggered events for sockets that drain their data"
+      " until they would block"),
+};
+
+static struct cfg_schema_section _socket_section = {
+  .type = OONF_SOCKET_SUBSYSTEM,
+  .mode = CFG_SSMODE_UNNAMED,
+  .help = "Settings for the socket scheduler",
+  .cb_delta_handler = _cb_config_changed,
+  .entries = _socket_entries,
+  .entry_count = ARRAYSIZE(_socket_entries),
+};
+
 /* subsystem definition */
 static const char *_dependencies[] = {
   OONF_TIMER_SUBSYSTEM,
@@ -93,6 +142,7 @@ static struct oonf_subsystem _oonf_socket_subsystem = {
   .init = _init,
   .cleanup = _cleanup,
   .initiate_shutdown = _initiate_shutdown,
+  .cfg_section = &_socket_section,
 };
 DECLARE_OONF_PLUGIN(_oonf_socket_subsystem);
 
@@ -107,6 +157,7 @@ _init(void) {
   }
 
   list_init_head(&_socket_head);
+  list_init_head(&_iteration_hooks);
   os_fd_event_add(&_socket_events);
 
   _scheduler_time_limit = ~0ull;
@@ -149,8 +200,14 @@ oonf_socket_add(struct oonf_socket_entry *entry)
   OONF_DEBUG(LOG_SOCKET, "Adding socket entry %d to scheduler\n",
       os_fd_get_fd(&entry->fd));
 
+  latency_histogram_clear(&entry->profile);
+
   list_add_before(&_socket_head, &entry->_node);
   os_fd_event_socket_add(&_socket_events, &entry->fd);
+
+  if (entry->edge_triggered && _edge_triggered) {
+    os_fd_event_socket_edge_triggered(&_socket_events, &entry->fd, true);
+  }
 }
 
 /**
@@ -166,6 +223,10 @@ oonf_socket_remove(struct oonf_socket_entry *entry)
 
     list_remove(&entry->_node);
     os_fd_event_socket_remove(&_socket_events, &entry->fd);
+
+    if (_entry_in_callback == entry) {
+      _entry_in_callback = NULL;
+    }
   }
 }
 
@@ -179,6 +240,64 @@ oonf_socket_set_write(struct oonf_socket_entry *entry, bool event_write) {
   os_fd_event_socket_write(&_socket_events, &entry->fd, event_write);
 }
 
+/**
+ * Add a hook that is called at the end of each scheduler iteration
+ * @param hook pointer to initialized iteration hook
+ */
+void
+oonf_socket_add_iteration_hook(struct oonf_socket_iteration_hook *hook) {
+  list_add_tail(&_iteration_hooks, &hook->_node);
+}
+
+/**
+ * Remove a scheduler iteration hook
+ * @param hook pointer to iteration hook
+ */
+void
+oonf_socket_remove_iteration_hook(struct oonf_socket_iteration_hook *hook) {
+  if (list_is_node_added(&hook->_node)) {
+    list_remove(&hook->_node);
+  }
+}
+
+/**
+ * @return statistics of socket scheduler
+ */
+const struct oonf_socket_statistics *
+oonf_socket_get_statistics(void) {
+  return &_stats;
+}
+
+/**
+ * Reset the statistics of the socket scheduler and the runtime
+ * statistics of all socket handlers
+ */
+void
+oonf_socket_clear_statistics(void) {
+  struct oonf_socket_entry *entry;
+
+  memset(&_stats, 0, sizeof(_stats));
+  list_for_each_element(&_socket_head, entry, _node) {
+    latency_histogram_clear(&entry->profile);
+  }
+}
+
+/**
+ * @return list of all socket handlers
+ */
+struct list_entity *
+oonf_socket_get_list(void) {
+  return &_socket_head;
+}
+
+/**
+ * @return current number of events handled by a single scheduler wakeup
+ */
+int
+oonf_socket_get_event_array_size(void) {
+  return os_fd_event_get_size(&_socket_events);
+}
+
 static bool
 _shall_end_scheduler(void) {
   return _scheduler_time_limit == ~0ull && oonf_main_shall_stop_scheduler();
@@ -192,11 +311,16 @@ int
 _handle_scheduling(void)
 {
   struct oonf_socket_entry *sock_entry = NULL;
+  struct oonf_socket_iteration_hook *hook, *hook_it;
   struct os_fd *sock;
   uint64_t next_event;
   uint64_t start_time, end_time;
   int i, n;
 
+  if (_last_wakeup == 0) {
+    os_clock_gettime64_ns(&_last_wakeup);
+  }
+
   while (true) {
     /* Update time since this is much used by the parsing functions */
     if (oonf_clock_update()) {
@@ -209,6 +333,10 @@ _handle_scheduling(void)
 
     oonf_timer_walk();
 
+    list_for_each_element_safe(&_iteration_hooks, hook, _node, hook_it) {
+      hook->cb_iteration_end();
+    }
+
     if (_shall_end_scheduler()) {
       return 0;
     }
@@ -218,10 +346,18 @@ _handle_scheduling(void)
       next_event = _scheduler_time_limit;
     }
 
+    if (oonf_clock_is_virtual() && next_event != ~0ull) {
+      /* only poll for pending events, the clock jumps to the next timer */
+      next_event = oonf_clock_getNow();
+    }
+
     if (os_fd_event_get_deadline(&_socket_events) != next_event) {
       os_fd_event_set_deadline(&_socket_events, next_event);
     }
 
+    os_clock_gettime64_ns(&start_time);
+    _stats.busy_time += start_time - _last_wakeup;
+
     do {
       if (_shall_end_scheduler()) {
         return 0;
@@ -230,7 +366,14 @@ _handle_scheduling(void)
       n = os_fd_event_wait(&_socket_events);
     } while (n == -1 && errno == EINTR);
 
+    os_clock_gettime64_ns(&_last_wakeup);
+    _stats.idle_time += _last_wakeup - start_time;
+
     if (n == 0) {               /* timeout! */
+      _stats.timeouts++;
+      if (oonf_clock_is_virtual()) {
+        _advance_virtual_clock();
+      }
       return 0;
     }
     if (n < 0) {              /* Did something go wrong? */
@@ -238,6 +381,8 @@ _handle_scheduling(void)
       return -1;
     }
 
+    _update_statistics(n);
+
     /* Update time since this is much used by the parsing functions */
     if (oonf_clock_update()) {
       return -1;
@@ -260,16 +405,92 @@ _handle_scheduling(void)
             os_fd_event_is_read(sock) ? "true" : "false",
             os_fd_event_is_write(sock) ? "true" : "false");
 
-        os_clock_gettime64(&start_time);
+        _entry_in_callback = sock_entry;
+
+        os_clock_gettime64_ns(&start_time);
         sock_entry->process(sock_entry);
-        os_clock_gettime64(&end_time);
+        os_clock_gettime64_ns(&end_time);
 
-        if (end_time - start_time > OONF_TIMER_SLICE) {
-          OONF_WARN(LOG_SOCKET, "Socket %d scheduling took %"PRIu64" ms",
-              os_fd_get_fd(&sock_entry->fd), end_time - start_time);
+        /* the socket handler might have been removed (and freed) by the callback */
+        if (_entry_in_callback) {
+          latency_histogram_add(&sock_entry->profile, end_time - start_time);
+        }
+        if (end_time - start_time > OONF_TIMER_SLICE * 1000000ull) {
+          OONF_WARN(LOG_SOCKET, "Socket %s scheduling took %"PRIu64" ms",
+              _entry_in_callback && sock_entry->name ? sock_entry->name : "unnamed",
+              (end_time - start_time) / 1000000);
         }
+        _entry_in_callback = NULL;
       }
     }
   }
   return 0;
 }
+
+/**
+ * Move the virtual clock to the next timer event (or the end of the
+ * scheduler) if no socket has pending events
+ */
+static void
+_advance_virtual_clock(void) {
+  uint64_t next_event;
+
+  next_event = oonf_timer_getNextEvent();
+  if (next_event > _scheduler_time_limit) {
+    next_event = _scheduler_time_limit;
+  }
+  if (next_event != ~0ull && next_event > oonf_clock_getNow()) {
+    oonf_clock_advance(next_event);
+  }
+}
+
+/**
+ * Update the scheduler statistics after a wakeup
+ * @param events number of events of the wakeup
+ */
+static void
+_update_statistics(int events) {
+  int bucket;
+
+  _stats.wakeups++;
+  _stats.events += events;
+  if ((uint32_t)events > _stats.max_events) {
+    _stats.max_events = events;
+  }
+  if (events == os_fd_event_get_size(&_socket_events)) {
+    _stats.full++;
+  }
+
+  for (bucket = 0; bucket < OONF_SOCKET_EVENT_HISTOGRAM - 1 && events > 1; bucket++) {
+    events >>= 1;
+  }
+  _stats.histogram[bucket]++;
+}
+
+/**
+ * Apply changed configuration of socket scheduler
+ */
+static void
+_cb_config_changed(void) {
+  struct _socket_config config;
+  struct oonf_socket_entry *entry;
+
+  if (cfg_schema_tobin(&config, _socket_section.post,
+      _socket_entries, ARRAYSIZE(_socket_entries))) {
+    OONF_WARN(LOG_SOCKET, "Cannot convert socket scheduler configuration");
+    return;
+  }
+
+  os_fd_event_set_max_events(&_socket_events, config.max_events);
+
+  if (_edge_triggered != config.edge_triggered) {
+    _edge_triggered = config.edge_triggered;
+
+    list_for_each_element(&_socket_head, entry, _node) {
+      if (entry->edge_triggered) {
+        os_fd_event_socket_edge_triggered(
+            &_socket_events, &entry->fd, _edge_triggered);
+      }
+    }
+  }
+}
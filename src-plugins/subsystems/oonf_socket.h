@@ -49,16 +49,23 @@
 #include "common/common_types.h"
 #include "common/list.h"
 #include "common/avl.h"
+#include "common/latency_histogram.h"
 #include "common/netaddr_acl.h"
 #include "subsystems/os_fd.h"
 
 /*! subsystem identifier */
 #define OONF_SOCKET_SUBSYSTEM "socket"
 
+/*! number of buckets of the events per wakeup histogram */
+#define OONF_SOCKET_EVENT_HISTOGRAM 8
+
 /**
  * registered socket handler
  */
 struct oonf_socket_entry {
+  /*! name of socket handler, used for statistics */
+  const char *name;
+
   /*! file descriptor of the socket */
   struct os_fd fd;
 
@@ -68,10 +75,64 @@ struct oonf_socket_entry {
    */
   void (*process) (struct oonf_socket_entry *entry);
 
+  /**
+   * true if the process callback reads and writes the socket
+   * until it would block, which allows the scheduler to use
+   * edge triggered events for this socket
+   */
+  bool edge_triggered;
+
+  /*! Stats, runtime of the process callback */
+  struct latency_histogram profile;
+
   /*! list of socket handlers */
   struct list_entity _node;
 };
 
+/**
+ * hook that is called once per scheduler iteration, after the timers
+ * have been processed and before the scheduler waits for socket events
+ */
+struct oonf_socket_iteration_hook {
+  /*! callback at the end of the scheduler iteration */
+  void (*cb_iteration_end)(void);
+
+  /*! hook into list of iteration hooks */
+  struct list_entity _node;
+};
+
+/**
+ * statistics of the socket scheduler
+ */
+struct oonf_socket_statistics {
+  /*! number of wait calls that returned socket events */
+  uint32_t wakeups;
+
+  /*! number of wait calls that ended with a timeout */
+  uint32_t timeouts;
+
+  /*! total number of socket events */
+  uint32_t events;
+
+  /*! highest number of events returned by a single wait call */
+  uint32_t max_events;
+
+  /*! number of wait calls that filled the whole event array */
+  uint32_t full;
+
+  /**
+   * number of wakeups by events per wakeup, logarithmic buckets
+   * (1, 2-3, 4-7, 8-15, 16-31, 32-63, 64-127, 128+)
+   */
+  uint32_t histogram[OONF_SOCKET_EVENT_HISTOGRAM];
+
+  /*! time spent waiting for events in nanoseconds */
+  uint64_t idle_time;
+
+  /*! time spent handling timers and socket events in nanoseconds */
+  uint64_t busy_time;
+};
+
 EXPORT void oonf_socket_add(struct oonf_socket_entry *);
 EXPORT void oonf_socket_remove(struct oonf_socket_entry *);
 EXPORT void oonf_socket_set_read(
@@ -79,6 +140,14 @@ EXPORT void oonf_socket_set_read(
 EXPORT void oonf_socket_set_write(
     struct oonf_socket_entry *entry, bool event_write);
 
+EXPORT void oonf_socket_add_iteration_hook(struct oonf_socket_iteration_hook *);
+EXPORT void oonf_socket_remove_iteration_hook(struct oonf_socket_iteration_hook *);
+
+EXPORT const struct oonf_socket_statistics *oonf_socket_get_statistics(void);
+EXPORT void oonf_socket_clear_statistics(void);
+EXPORT struct list_entity *oonf_socket_get_list(void);
+EXPORT int oonf_socket_get_event_array_size(void);
+
 static INLINE bool
 oonf_socket_is_read(struct oonf_socket_entry *entry) {
   return os_fd_event_is_read(&entry->fd);
@@ -87,4 +156,14 @@ static INLINE bool
 oonf_socket_is_write(struct oonf_socket_entry *entry) {
   return os_fd_event_is_write(&entry->fd);
 }
+
+/**
+ * @param entry socket entry
+ * @return true if the socket is registered for edge triggered events
+ *   and must be drained until it would block
+ */
+static INLINE bool
+oonf_socket_is_edge_triggered(struct oonf_socket_entry *entry) {
+  return os_fd_event_is_edge_triggered(&entry->fd);
+}
 #endif /* OONF_SOCKET_H_ */
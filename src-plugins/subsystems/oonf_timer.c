@@ -50,6 +50,7 @@
 
 #include "common/avl.h"
 #include "common/common_types.h"
+#include "common/timer_wheel.h"
 #include "core/oonf_logging.h"
 #include "core/oonf_subsystem.h"
 #include "core/os_core.h"
@@ -66,10 +67,20 @@ static int _init(void);
 static void _cleanup(void);
 
 static void _calc_clock(struct oonf_timer_instance *timer, uint64_t rel_time);
+static void _add_timer(struct oonf_timer_instance *timer);
+static void _remove_timer(struct oonf_timer_instance *timer);
+static struct oonf_timer_instance *_get_first_timer(void);
+static struct oonf_timer_instance *_get_expired_timer(void);
+
+#ifdef OONF_TIMER_WHEEL
+/* wheel of all timers */
+static struct timer_wheel _timer_wheel;
+#else
 static int _avlcomp_timer(const void *p1, const void *p2);
 
 /* tree of all timers */
 static struct avl_tree _timer_tree;
+#endif
 
 /* true if scheduler is active */
 static bool _scheduling_now;
@@ -100,7 +111,11 @@ _init(void)
 {
   OONF_INFO(LOG_TIMER, "Initializing timer scheduler.\n");
 
+#ifdef OONF_TIMER_WHEEL
+  timer_wheel_init(&_timer_wheel, OONF_TIMER_SLICE, oonf_clock_getNow());
+#else
   avl_init(&_timer_tree, _avlcomp_timer, true);
+#endif
   _scheduling_now = false;
 
   list_init_head(&_timer_info_list);
@@ -146,7 +161,11 @@ oonf_timer_remove(struct oonf_timer_class *info) {
 	return;
   }
 
+#ifdef OONF_TIMER_WHEEL
+  timer_wheel_for_each_element_safe(&_timer_wheel, timer, _node, iterator) {
+#else
   avl_for_each_element_safe(&_timer_tree, timer, _node, iterator) {
+#endif
     if (timer->class == info) {
       oonf_timer_stop(timer);
     }
@@ -172,10 +191,9 @@ oonf_timer_start_ext(struct oonf_timer_instance *timer, uint64_t first, uint64_t
   assert(timer->jitter_pct <= 100);
 
   if (timer->_clock) {
-    avl_remove(&_timer_tree, &timer->_node);
+    _remove_timer(timer);
   }
   else {
-    timer->_node.key = timer;
     timer->class->usage++;
   }
   timer->class->changes++;
@@ -196,8 +214,8 @@ oonf_timer_start_ext(struct oonf_timer_instance *timer, uint64_t first, uint64_t
   /* Singleshot or periodical timer ? */
   timer->_period = timer->class->periodic ? interval : 0;
 
-  /* insert into tree */
-  avl_insert(&_timer_tree, &timer->_node);
+  /* insert into scheduler */
+  _add_timer(timer);
 
   OONF_DEBUG(LOG_TIMER, "TIMER: start timer '%s' firing in %s (%"PRIu64")\n",
       timer->class->name,
@@ -217,8 +235,8 @@ oonf_timer_stop(struct oonf_timer_instance *timer)
 
   OONF_DEBUG(LOG_TIMER, "TIMER: stop %s\n", timer->class->name);
 
-  /* remove timer from tree */
-  avl_remove(&_timer_tree, &timer->_node);
+  /* remove timer from scheduler */
+  _remove_timer(timer);
   timer->_clock = 0;
   timer->_random = 0;
   timer->class->usage--;
@@ -264,13 +282,7 @@ oonf_timer_walk(void)
 
   _scheduling_now = true;
 
-  while (!avl_is_empty(&_timer_tree)) {
-    timer = avl_first_element(&_timer_tree, timer, _node);
-
-    if (timer->_clock > oonf_clock_getNow()) {
-      break;
-    }
-
+  while ((timer = _get_expired_timer()) != NULL) {
     OONF_DEBUG(LOG_TIMER, "TIMER: fire '%s' at clocktick %" PRIu64 "\n",
                   timer->class->name, timer->_clock);
 
@@ -290,13 +302,15 @@ oonf_timer_walk(void)
     }
 
     /* This timer is expired, call into the provided callback function */
-    os_clock_gettime64(&start_time);
+    os_clock_gettime64_ns(&start_time);
     timer->class->callback(timer);
-    os_clock_gettime64(&end_time);
+    os_clock_gettime64_ns(&end_time);
 
-    if (end_time - start_time > OONF_TIMER_SLICE) {
+    /* the timer might have been freed by the callback, only use the class */
+    latency_histogram_add(&info->profile, end_time - start_time);
+    if (end_time - start_time > OONF_TIMER_SLICE * 1000000ull) {
       OONF_WARN(LOG_TIMER, "Timer %s scheduling took %"PRIu64" ms",
-          timer->class->name, end_time - start_time);
+          info->name, (end_time - start_time) / 1000000);
     }
 
     /*
@@ -326,11 +340,10 @@ uint64_t
 oonf_timer_getNextEvent(void) {
   struct oonf_timer_instance *first;
 
-  if (avl_is_empty(&_timer_tree)) {
+  first = _get_first_timer();
+  if (first == NULL) {
     return UINT64_MAX;
   }
-
-  first = avl_first_element(&_timer_tree, first, _node);
   return first->_clock;
 }
 
@@ -376,6 +389,91 @@ _calc_clock(struct oonf_timer_instance *timer, uint64_t rel_time)
   timer->_clock -= (timer->_clock % OONF_TIMER_SLICE);
 }
 
+#ifdef OONF_TIMER_WHEEL
+/**
+ * Hook timer into the timer wheel
+ * @param timer pointer to timer instance
+ */
+static void
+_add_timer(struct oonf_timer_instance *timer) {
+  timer_wheel_add(&_timer_wheel, &timer->_node, timer->_clock);
+}
+
+/**
+ * Remove timer from the timer wheel
+ * @param timer pointer to timer instance
+ */
+static void
+_remove_timer(struct oonf_timer_instance *timer) {
+  timer_wheel_remove(&_timer_wheel, &timer->_node);
+}
+
+/**
+ * @return timer that will fire next, NULL if no timer is active
+ */
+static struct oonf_timer_instance *
+_get_first_timer(void) {
+  struct oonf_timer_instance *timer;
+
+  return timer_wheel_next_element(&_timer_wheel, timer, _node);
+}
+
+/**
+ * @return next timer that should fire now, NULL if no timer is due
+ */
+static struct oonf_timer_instance *
+_get_expired_timer(void) {
+  struct oonf_timer_instance *timer;
+
+  return timer_wheel_expired_element(&_timer_wheel, oonf_clock_getNow(), timer, _node);
+}
+#else
+/**
+ * Hook timer into the timer tree
+ * @param timer pointer to timer instance
+ */
+static void
+_add_timer(struct oonf_timer_instance *timer) {
+  timer->_node.key = timer;
+  avl_insert(&_timer_tree, &timer->_node);
+}
+
+/**
+ * Remove timer from the timer tree
+ * @param timer pointer to timer instance
+ */
+static void
+_remove_timer(struct oonf_timer_instance *timer) {
+  avl_remove(&_timer_tree, &timer->_node);
+}
+
+/**
+ * @return timer that will fire next, NULL if no timer is active
+ */
+static struct oonf_timer_instance *
+_get_first_timer(void) {
+  struct oonf_timer_instance *timer;
+
+  if (avl_is_empty(&_timer_tree)) {
+    return NULL;
+  }
+  return avl_first_element(&_timer_tree, timer, _node);
+}
+
+/**
+ * @return next timer that should fire now, NULL if no timer is due
+ */
+static struct oonf_timer_instance *
+_get_expired_timer(void) {
+  struct oonf_timer_instance *timer;
+
+  timer = _get_first_timer();
+  if (timer == NULL || timer->_clock > oonf_clock_getNow()) {
+    return NULL;
+  }
+  return timer;
+}
+
 /**
  * Custom AVL comparator for two timer entries.
  * @param p1
@@ -397,3 +495,4 @@ _avlcomp_timer(const void *p1, const void *p2) {
   }
   return 0;
 }
+#endif
@@ -49,6 +49,8 @@
 #include "common/common_types.h"
 #include "common/list.h"
 #include "common/avl.h"
+#include "common/latency_histogram.h"
+#include "common/timer_wheel.h"
 
 #include "subsystems/oonf_clock.h"
 
@@ -86,6 +88,9 @@ struct oonf_timer_class {
   /*! Stats, resource churn */
   uint32_t changes;
 
+  /*! Stats, runtime of the callbacks */
+  struct latency_histogram profile;
+
   /*! pointer to timer currently in callback */
   struct oonf_timer_instance *_timer_in_callback;
 
@@ -97,8 +102,13 @@ struct oonf_timer_class {
  * A single timer instance of a timer class
  */
 struct oonf_timer_instance {
+#ifdef OONF_TIMER_WHEEL
+  /*! node of timer wheel */
+  struct timer_wheel_node _node;
+#else
   /*! node of timer class tree of instances */
   struct avl_node _node;
+#endif
 
   /*! backpointer to timer class */
   struct oonf_timer_class *class;
@@ -0,0 +1,492 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+
+#include "common/common_types.h"
+#include "common/latency_histogram.h"
+#include "common/list.h"
+
+#include "config/cfg_schema.h"
+
+#include "core/oonf_logging.h"
+#include "core/oonf_subsystem.h"
+#include "subsystems/oonf_socket.h"
+#include "subsystems/os_clock.h"
+#include "subsystems/os_fd.h"
+
+#include "subsystems/oonf_worker.h"
+
+/* definitions */
+#define LOG_WORKER _oonf_worker_subsystem.logging
+
+/**
+ * Configuration of worker subsystem
+ */
+struct _worker_config {
+  /*! number of worker threads */
+  int32_t threads;
+};
+
+/* prototypes */
+static int _init(void);
+static void _cleanup(void);
+
+static void *_cb_worker_thread(void *ptr);
+static void _process_job(struct oonf_worker_job *job);
+static void _cb_handle_completions(struct oonf_socket_entry *entry);
+static int _start_threads(int count);
+static void _stop_threads(void);
+static void _cb_config_changed(void);
+
+/* mutex protecting the job queues, job states and statistics */
+static pthread_mutex_t _mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* signals a new job in the wait queue (or the end of the threads) */
+static pthread_cond_t _job_available = PTHREAD_COND_INITIALIZER;
+
+/* signals the end of processing of a job */
+static pthread_cond_t _job_processed = PTHREAD_COND_INITIALIZER;
+
+/* jobs waiting for a worker thread */
+static struct list_entity _wait_queue;
+
+/* jobs waiting for their finished callback */
+static struct list_entity _done_queue;
+
+/* current number of jobs in wait queue */
+static uint32_t _wait_queue_length;
+
+/* worker threads */
+static pthread_t _threads[OONF_WORKER_MAX_THREADS];
+static int _thread_count;
+
+/* true if the worker threads should end */
+static bool _threads_stopping;
+
+/* statistics of the worker subsystem */
+static struct oonf_worker_statistics _stats;
+
+/* notification of the main loop for finished jobs */
+static struct oonf_socket_entry _completion_socket = {
+  .name = "worker completion",
+  .process = _cb_handle_completions,
+};
+
+/* configuration of worker subsystem */
+static struct cfg_schema_entry _worker_entries[] = {
+  CFG_MAP_INT32_MINMAX(_worker_config, threads, "threads", "2",
+      "Number of worker threads for offloaded jobs, 0 processes"
+      " jobs in the main loop", 0, false, 0, OONF_WORKER_MAX_THREADS),
+};
+
+static struct cfg_schema_section _worker_section = {
+  .type = OONF_WORKER_SUBSYSTEM,
+  .mode = CFG_SSMODE_UNNAMED,
+  .help = "Settings for the worker thread pool",
+  .cb_delta_handler = _cb_config_changed,
+  .entries = _worker_entries,
+  .entry_count = ARRAYSIZE(_worker_entries),
+};
+
+/* subsystem definition */
+static const char *_dependencies[] = {
+  OONF_SOCKET_SUBSYSTEM,
+  OONF_OS_CLOCK_SUBSYSTEM,
+  OONF_OS_FD_SUBSYSTEM,
+};
+
+static struct oonf_subsystem _oonf_worker_subsystem = {
+  .name = OONF_WORKER_SUBSYSTEM,
+  .dependencies = _dependencies,
+  .dependencies_count = ARRAYSIZE(_dependencies),
+  .init = _init,
+  .cleanup = _cleanup,
+  .cfg_section = &_worker_section,
+};
+DECLARE_OONF_PLUGIN(_oonf_worker_subsystem);
+
+/**
+ * Initialize worker subsystem
+ * @return -1 if an error happened, 0 otherwise
+ */
+static int
+_init(void) {
+  if (os_fd_open_notifier(&_completion_socket.fd)) {
+    OONF_WARN(LOG_WORKER, "Could not create notification descriptor: %s (%d)",
+        strerror(errno), errno);
+    return -1;
+  }
+
+  list_init_head(&_wait_queue);
+  list_init_head(&_done_queue);
+  _wait_queue_length = 0;
+
+  memset(&_stats, 0, sizeof(_stats));
+
+  oonf_socket_add(&_completion_socket);
+  oonf_socket_set_read(&_completion_socket, true);
+  return 0;
+}
+
+/**
+ * Cleanup worker subsystem, drop all jobs that have not been finished
+ */
+static void
+_cleanup(void) {
+  struct oonf_worker_job *job, *it;
+
+  _stop_threads();
+
+  list_for_each_element_safe(&_wait_queue, job, _node, it) {
+    OONF_WARN(LOG_WORKER, "Drop waiting job %s", job->name);
+    list_remove(&job->_node);
+    job->_state = OONF_WORKER_JOB_IDLE;
+  }
+  list_for_each_element_safe(&_done_queue, job, _node, it) {
+    OONF_WARN(LOG_WORKER, "Drop finished job %s", job->name);
+    list_remove(&job->_node);
+    job->_state = OONF_WORKER_JOB_IDLE;
+  }
+
+  oonf_socket_remove(&_completion_socket);
+  os_fd_close(&_completion_socket.fd);
+}
+
+/**
+ * Submit a job to the worker threads. The finished callback
+ * of the job will be called later from the main loop, never
+ * from within this function.
+ * @param job pointer to initialized worker job
+ * @return -1 if the job is already submitted, 0 otherwise
+ */
+int
+oonf_worker_submit(struct oonf_worker_job *job) {
+  pthread_mutex_lock(&_mutex);
+  if (job->_state != OONF_WORKER_JOB_IDLE) {
+    pthread_mutex_unlock(&_mutex);
+    OONF_WARN(LOG_WORKER, "Job %s is already submitted", job->name);
+    return -1;
+  }
+
+  _stats.submitted++;
+  os_clock_gettime64_ns(&job->_timestamp);
+
+  if (_thread_count == 0) {
+    /* no worker threads, process job in the main loop */
+    job->_state = OONF_WORKER_JOB_RUNNING;
+    pthread_mutex_unlock(&_mutex);
+    _process_job(job);
+    return 0;
+  }
+
+  job->_state = OONF_WORKER_JOB_QUEUED;
+  list_add_tail(&_wait_queue, &job->_node);
+
+  _wait_queue_length++;
+  if (_wait_queue_length > _stats.max_queue) {
+    _stats.max_queue = _wait_queue_length;
+  }
+
+  pthread_cond_signal(&_job_available);
+  pthread_mutex_unlock(&_mutex);
+
+  OONF_DEBUG(LOG_WORKER, "Submitted job %s", job->name);
+  return 0;
+}
+
+/**
+ * Cancel a submitted job. If the job is currently processed by
+ * a worker thread, this function blocks until the processing
+ * is done. The finished callback of a cancelled job is not called.
+ * @param job pointer to worker job
+ */
+void
+oonf_worker_cancel(struct oonf_worker_job *job) {
+  pthread_mutex_lock(&_mutex);
+  while (job->_state == OONF_WORKER_JOB_RUNNING) {
+    pthread_cond_wait(&_job_processed, &_mutex);
+  }
+
+  if (job->_state == OONF_WORKER_JOB_QUEUED) {
+    _wait_queue_length--;
+  }
+  if (job->_state != OONF_WORKER_JOB_IDLE) {
+    list_remove(&job->_node);
+    job->_state = OONF_WORKER_JOB_IDLE;
+    _stats.cancelled++;
+  }
+  pthread_mutex_unlock(&_mutex);
+}
+
+/**
+ * @param job pointer to worker job
+ * @return true if the job has been submitted and its finished
+ *   callback has not been called yet
+ */
+bool
+oonf_worker_is_busy(struct oonf_worker_job *job) {
+  bool busy;
+
+  pthread_mutex_lock(&_mutex);
+  busy = job->_state != OONF_WORKER_JOB_IDLE;
+  pthread_mutex_unlock(&_mutex);
+  return busy;
+}
+
+/**
+ * @return number of running worker threads
+ */
+int
+oonf_worker_get_thread_count(void) {
+  return _thread_count;
+}
+
+/**
+ * Copy the statistics of the worker subsystem
+ * @param stats pointer to target buffer
+ */
+void
+oonf_worker_get_statistics(struct oonf_worker_statistics *stats) {
+  pthread_mutex_lock(&_mutex);
+  memcpy(stats, &_stats, sizeof(*stats));
+  pthread_mutex_unlock(&_mutex);
+}
+
+/**
+ * Reset the statistics of the worker subsystem
+ */
+void
+oonf_worker_clear_statistics(void) {
+  pthread_mutex_lock(&_mutex);
+  memset(&_stats, 0, sizeof(_stats));
+  pthread_mutex_unlock(&_mutex);
+}
+
+/**
+ * Main function of a worker thread
+ * @param ptr unused
+ * @return always NULL
+ */
+static void *
+_cb_worker_thread(void *ptr __attribute__((unused))) {
+  struct oonf_worker_job *job;
+
+  pthread_mutex_lock(&_mutex);
+  while (true) {
+    while (!_threads_stopping && list_is_empty(&_wait_queue)) {
+      pthread_cond_wait(&_job_available, &_mutex);
+    }
+    if (_threads_stopping) {
+      break;
+    }
+
+    job = list_first_element(&_wait_queue, job, _node);
+    list_remove(&job->_node);
+    _wait_queue_length--;
+    job->_state = OONF_WORKER_JOB_RUNNING;
+    pthread_mutex_unlock(&_mutex);
+
+    _process_job(job);
+
+    pthread_mutex_lock(&_mutex);
+  }
+  pthread_mutex_unlock(&_mutex);
+  return NULL;
+}
+
+/**
+ * Process a job and move it into the queue for the main loop.
+ * The caller must set the job to running state before and must
+ * not hold the worker mutex.
+ * @param job pointer to worker job
+ */
+static void
+_process_job(struct oonf_worker_job *job) {
+  uint64_t start, end;
+
+  os_clock_gettime64_ns(&start);
+  job->process(job);
+  os_clock_gettime64_ns(&end);
+
+  pthread_mutex_lock(&_mutex);
+  latency_histogram_add(&_stats.queue_time, start - job->_timestamp);
+  latency_histogram_add(&_stats.run_time, end - start);
+
+  job->_state = OONF_WORKER_JOB_DONE;
+  job->_timestamp = end;
+
+  /* only wake up the main loop once for a group of finished jobs */
+  if (list_is_empty(&_done_queue)) {
+    os_fd_notify(&_completion_socket.fd);
+  }
+  list_add_tail(&_done_queue, &job->_node);
+
+  pthread_cond_broadcast(&_job_processed);
+  pthread_mutex_unlock(&_mutex);
+}
+
+/**
+ * Call the finished callbacks of all processed jobs
+ * @param entry socket entry of notification descriptor
+ */
+static void
+_cb_handle_completions(struct oonf_socket_entry *entry) {
+  struct oonf_worker_job *job;
+  uint64_t now;
+
+  os_fd_clear_notification(&entry->fd);
+
+  while (true) {
+    pthread_mutex_lock(&_mutex);
+    if (list_is_empty(&_done_queue)) {
+      pthread_mutex_unlock(&_mutex);
+      return;
+    }
+
+    job = list_first_element(&_done_queue, job, _node);
+    list_remove(&job->_node);
+    job->_state = OONF_WORKER_JOB_IDLE;
+
+    os_clock_gettime64_ns(&now);
+    latency_histogram_add(&_stats.completion_time, now - job->_timestamp);
+    _stats.completed++;
+    pthread_mutex_unlock(&_mutex);
+
+    OONF_DEBUG(LOG_WORKER, "Job %s finished", job->name);
+    if (job->finished) {
+      job->finished(job);
+    }
+  }
+}
+
+/**
+ * Start worker threads. All signals are blocked in the worker
+ * threads, so they are handled by the main loop.
+ * @param count number of worker threads
+ * @return -1 if an error happened, 0 otherwise
+ */
+static int
+_start_threads(int count) {
+  sigset_t all_signals, old_signals;
+  int result = 0;
+
+  sigfillset(&all_signals);
+  pthread_sigmask(SIG_SETMASK, &all_signals, &old_signals);
+
+  for (_thread_count = 0; _thread_count < count; _thread_count++) {
+    if (pthread_create(&_threads[_thread_count], NULL, _cb_worker_thread, NULL)) {
+      OONF_WARN(LOG_WORKER, "Could only start %d of %d worker threads",
+          _thread_count, count);
+      result = -1;
+      break;
+    }
+  }
+
+  pthread_sigmask(SIG_SETMASK, &old_signals, NULL);
+  return result;
+}
+
+/**
+ * Stop all worker threads. Jobs that are currently processed
+ * are finished first, waiting jobs stay in the queue.
+ */
+static void
+_stop_threads(void) {
+  int i;
+
+  pthread_mutex_lock(&_mutex);
+  _threads_stopping = true;
+  pthread_cond_broadcast(&_job_available);
+  pthread_mutex_unlock(&_mutex);
+
+  for (i=0; i<_thread_count; i++) {
+    pthread_join(_threads[i], NULL);
+  }
+  _thread_count = 0;
+  _threads_stopping = false;
+}
+
+/**
+ * Apply changed configuration of worker subsystem
+ */
+static void
+_cb_config_changed(void) {
+  struct _worker_config config;
+  struct oonf_worker_job *job;
+
+  if (cfg_schema_tobin(&config, _worker_section.post,
+      _worker_entries, ARRAYSIZE(_worker_entries))) {
+    OONF_WARN(LOG_WORKER, "Cannot convert worker configuration");
+    return;
+  }
+
+  if (config.threads == _thread_count) {
+    return;
+  }
+
+  _stop_threads();
+  _start_threads(config.threads);
+
+  if (_thread_count > 0) {
+    /* wake up the new threads for the waiting jobs */
+    pthread_mutex_lock(&_mutex);
+    pthread_cond_broadcast(&_job_available);
+    pthread_mutex_unlock(&_mutex);
+    return;
+  }
+
+  /* no worker threads left, process the waiting jobs in the main loop */
+  while (!list_is_empty(&_wait_queue)) {
+    job = list_first_element(&_wait_queue, job, _node);
+    list_remove(&job->_node);
+    _wait_queue_length--;
+    job->_state = OONF_WORKER_JOB_RUNNING;
+
+    _process_job(job);
+  }
+}
@@ -0,0 +1,144 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+
+#ifndef OONF_WORKER_H_
+#define OONF_WORKER_H_
+
+#include "common/common_types.h"
+#include "common/latency_histogram.h"
+#include "common/list.h"
+
+/*! subsystem identifier */
+#define OONF_WORKER_SUBSYSTEM "worker"
+
+/*! maximum number of worker threads */
+#define OONF_WORKER_MAX_THREADS 64
+
+/**
+ * State of a worker job
+ */
+enum oonf_worker_job_state {
+  /*! job is not handled by the worker subsystem */
+  OONF_WORKER_JOB_IDLE,
+
+  /*! job waits for a free worker thread */
+  OONF_WORKER_JOB_QUEUED,
+
+  /*! job is processed by a worker thread */
+  OONF_WORKER_JOB_RUNNING,
+
+  /*! job waits for its finished callback in the main loop */
+  OONF_WORKER_JOB_DONE,
+};
+
+/**
+ * A unit of work that can be offloaded to a worker thread.
+ * The memory of the job must stay valid until the finished
+ * callback has been called or the job has been cancelled.
+ */
+struct oonf_worker_job {
+  /*! name of the job, used for logging */
+  const char *name;
+
+  /**
+   * Callback to process the job, called from a worker thread.
+   * It must only access data owned by the job and must not call
+   * any other OONF API.
+   * @param job pointer to worker job
+   */
+  void (*process)(struct oonf_worker_job *job);
+
+  /**
+   * Callback when the job has been processed, called from the main
+   * loop. The job is idle again and can be resubmitted.
+   * @param job pointer to worker job
+   */
+  void (*finished)(struct oonf_worker_job *job);
+
+  /*! state of job, protected by the worker mutex */
+  enum oonf_worker_job_state _state;
+
+  /*! timestamp of the last state change in nanoseconds */
+  uint64_t _timestamp;
+
+  /*! node for queue of waiting or finished jobs */
+  struct list_entity _node;
+};
+
+/**
+ * statistics of the worker subsystem
+ */
+struct oonf_worker_statistics {
+  /*! number of submitted jobs */
+  uint32_t submitted;
+
+  /*! number of jobs that have reached their finished callback */
+  uint32_t completed;
+
+  /*! number of cancelled jobs */
+  uint32_t cancelled;
+
+  /*! highest number of jobs waiting for a worker thread */
+  uint32_t max_queue;
+
+  /*! time between submission and start of processing */
+  struct latency_histogram queue_time;
+
+  /*! time spent in the process callback */
+  struct latency_histogram run_time;
+
+  /*! time between end of processing and the finished callback */
+  struct latency_histogram completion_time;
+};
+
+EXPORT int oonf_worker_submit(struct oonf_worker_job *job);
+EXPORT void oonf_worker_cancel(struct oonf_worker_job *job);
+EXPORT bool oonf_worker_is_busy(struct oonf_worker_job *job);
+EXPORT int oonf_worker_get_thread_count(void);
+
+EXPORT void oonf_worker_get_statistics(struct oonf_worker_statistics *stats);
+EXPORT void oonf_worker_clear_statistics(void);
+
+#endif /* OONF_WORKER_H_ */
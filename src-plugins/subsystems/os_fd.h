@@ -48,6 +48,7 @@
 
 #include <unistd.h>
 #include <sys/select.h>
+#include <sys/uio.h>
 
 #include "common/avl.h"
 #include "common/common_types.h"
@@ -60,10 +61,39 @@
 /*! subsystem identifier */
 #define OONF_OS_FD_SUBSYSTEM "os_fd"
 
+/*! maximum number of datagrams handled by a single os_fd_recvmmsg()/os_fd_sendmmsg() call */
+#define OS_FD_MAX_DATAGRAMS 64
+
 /* pre-definition of structs */
 struct os_fd;
 struct os_fd_select;
 
+/**
+ * Buffer for one datagram of a batch receive or send operation
+ */
+struct os_fd_datagram {
+  /*! pointer to buffer for incoming or outgoing data */
+  void *buf;
+
+  /*! length of buffer (or outgoing data) */
+  size_t length;
+
+  /*! source of a received datagram or destination of an outgoing one */
+  union netaddr_socket remote;
+
+  /*! number of bytes received */
+  ssize_t received;
+
+  /*! true if the datagram was larger than the buffer */
+  bool truncated;
+
+  /**
+   * kernel receive timestamp of the datagram in nanoseconds
+   * (wall clock), 0 if not available
+   */
+  uint64_t timestamp;
+};
+
 /* pre-declare inlines */
 static INLINE int os_fd_init(struct os_fd *, int fd);
 static INLINE int os_fd_copy(struct os_fd *dst, struct os_fd *from);
@@ -84,8 +114,14 @@ static INLINE int os_fd_event_socket_write(struct os_fd_select *,
     struct os_fd *, bool want_write);
 static INLINE int os_fd_event_is_write(struct os_fd *);
 static INLINE int os_fd_event_socket_remove(struct os_fd_select *, struct os_fd *);
+static INLINE int os_fd_event_socket_edge_triggered(struct os_fd_select *,
+    struct os_fd *, bool edge_triggered);
+static INLINE bool os_fd_event_is_edge_triggered(struct os_fd *);
+static INLINE int os_fd_event_set_max_events(struct os_fd_select *, int max_events);
+static INLINE int os_fd_event_get_size(struct os_fd_select *);
 static INLINE int os_fd_event_set_deadline(struct os_fd_select *, uint64_t deadline);
 static INLINE uint64_t os_fd_event_get_deadline(struct os_fd_select *);
+static INLINE const char *os_fd_event_get_backend(struct os_fd_select *);
 static INLINE int os_fd_event_wait(struct os_fd_select *);
 static INLINE struct os_fd *os_fd_event_get(struct os_fd_select *, int idx);
 static INLINE int os_fd_event_remove(struct os_fd_select *);
@@ -96,11 +132,20 @@ static INLINE int os_fd_accept(struct os_fd *client,
 static INLINE int os_fd_get_socket_error(struct os_fd *, int *value);
 static INLINE ssize_t os_fd_sendto(struct os_fd *, const void *buf, size_t length,
     const union netaddr_socket *dst, bool dont_route);
+static INLINE ssize_t os_fd_sendmsg(struct os_fd *, const struct iovec *iov, int iovcnt,
+    const union netaddr_socket *dst, bool dont_route);
 static INLINE ssize_t os_fd_recvfrom(struct os_fd *, void *buf, size_t length,
     union netaddr_socket *source, const struct os_interface *);
+static INLINE int os_fd_recvmmsg(struct os_fd *, struct os_fd_datagram *dgrams,
+    int count, const struct os_interface *);
+static INLINE int os_fd_sendmmsg(struct os_fd *, struct os_fd_datagram *dgrams,
+    int count, bool dont_route);
 static INLINE const char *os_fd_get_loopback_name(void);
 static INLINE ssize_t os_fd_sendfile(struct os_fd *, struct os_fd *,
     size_t offset, size_t count);
+static INLINE int os_fd_open_notifier(struct os_fd *);
+static INLINE int os_fd_notify(struct os_fd *);
+static INLINE int os_fd_clear_notification(struct os_fd *);
 
 static INLINE int os_fd_getsocket(struct os_fd *, const union netaddr_socket *bindto, bool tcp,
     size_t recvbuf, const struct os_interface *, enum oonf_log_source log_src);
@@ -114,6 +159,7 @@ static INLINE int os_fd_join_mcast_recv(struct os_fd *, const struct netaddr *mu
 static INLINE int os_fd_join_mcast_send(struct os_fd *, const struct netaddr *multicast,
     const struct os_interface *, bool loop, enum oonf_log_source log_src);
 static INLINE int os_fd_set_dscp(struct os_fd *, int dscp, bool ipv6);
+static INLINE int os_fd_set_rx_timestamp(struct os_fd *, bool enable);
 static INLINE uint8_t *os_fd_skip_rawsocket_prefix(uint8_t *ptr, ssize_t *len, int af_type);
 
 /* include os-specific headers */
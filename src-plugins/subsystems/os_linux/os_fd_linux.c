@@ -43,10 +43,16 @@
  * @file
  */
 
+/*! activate GNU sources for recvmmsg() */
+#define _GNU_SOURCE
+
 #include <net/if.h>
 #include <netinet/in.h>
 #include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
 #include <errno.h>
+#include <stdlib.h>
 
 #include "common/common_types.h"
 #include "core/oonf_logging.h"
@@ -54,6 +60,7 @@
 #include "subsystems/oonf_clock.h"
 
 #include "subsystems/os_fd.h"
+#include "subsystems/os_linux/os_fd_linux_uring.h"
 
 /* Defintions */
 #define LOG_OS_SOCKET _oonf_os_fd_subsystem.logging
@@ -61,6 +68,7 @@
 /* prototypes */
 static int _init(void);
 static void _cleanup(void);
+static int _resize_event_array(struct os_fd_select *sel, int size);
 
 /* subsystem definition */
 static const char *_dependencies[] = {
@@ -92,6 +100,88 @@ static void
 _cleanup(void) {
 }
 
+/**
+ * Initialize a socket selector set with the default backend.
+ * The io_uring backend is used if it was enabled during the build
+ * and the kernel supports it, epoll otherwise.
+ * @param sel empty socket selector set
+ * @return -1 if an error happened, 0 otherwise
+ */
+int
+os_fd_linux_event_add(struct os_fd_select *sel) {
+#ifdef OONF_IO_URING
+  if (os_fd_linux_event_add_backend(sel, true) == 0) {
+    OONF_INFO(LOG_OS_SOCKET, "Using io_uring for socket events");
+    return 0;
+  }
+  OONF_INFO(LOG_OS_SOCKET, "io_uring not available (%s), fall back to epoll",
+      strerror(errno));
+#endif
+  return os_fd_linux_event_add_backend(sel, false);
+}
+
+/**
+ * Initialize a socket selector set with a specific backend
+ * @param sel empty socket selector set
+ * @param io_uring true to use io_uring, false to use epoll
+ * @return -1 if an error happened (or io_uring is not available),
+ *   0 otherwise
+ */
+int
+os_fd_linux_event_add_backend(struct os_fd_select *sel, bool io_uring) {
+  memset (sel, 0, sizeof(*sel));
+
+  sel->_events = calloc(OS_FD_EVENT_DEFAULT_SIZE, sizeof(*sel->_events));
+  if (!sel->_events) {
+    return -1;
+  }
+  sel->_event_size = OS_FD_EVENT_DEFAULT_SIZE;
+  sel->_event_max = OS_FD_EVENT_DEFAULT_SIZE;
+
+  if (io_uring) {
+#ifdef OONF_IO_URING
+    sel->_epoll_fd = -1;
+    if (os_fd_linux_uring_init(sel) == 0) {
+      return 0;
+    }
+#else
+    errno = ENOTSUP;
+#endif
+    free(sel->_events);
+    sel->_events = NULL;
+    return -1;
+  }
+
+  sel->_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  if (sel->_epoll_fd < 0) {
+    free(sel->_events);
+    sel->_events = NULL;
+    return -1;
+  }
+  return 0;
+}
+
+/**
+ * Cleanup a socket selector set
+ * @param sel socket selector set
+ * @return -1 if an error happened, 0 otherwise
+ */
+int
+os_fd_linux_event_remove(struct os_fd_select *sel) {
+  free(sel->_events);
+  sel->_events = NULL;
+  sel->_event_size = 0;
+  sel->_event_count = 0;
+
+#ifdef OONF_IO_URING
+  if (sel->_uring) {
+    os_fd_linux_uring_cleanup(sel);
+    return 0;
+  }
+#endif
+  return close(sel->_epoll_fd);
+}
+
 /**
  * wait for a network event on multiple sockets
  * @param sel socket selector set
@@ -101,15 +191,34 @@ int
 os_fd_linux_event_wait(struct os_fd_select *sel) {
   struct os_fd *sock;
   uint64_t maxdelay;
-  int i;
+  int i, size;
+
+  if (sel->_event_size > sel->_event_max) {
+    /* maximum has been lowered */
+    _resize_event_array(sel, sel->_event_max);
+  }
+  else if (sel->_event_count == sel->_event_size && sel->_event_size < sel->_event_max) {
+    /* last wait filled the event array, give it more room */
+    size = sel->_event_size * 2;
+    if (size > sel->_event_max) {
+      size = sel->_event_max;
+    }
+    _resize_event_array(sel, size);
+  }
 
   maxdelay = oonf_clock_get_relative(sel->deadline);
   if (maxdelay > INT32_MAX) {
     maxdelay = INT32_MAX;
   }
 
+#ifdef OONF_IO_URING
+  if (sel->_uring) {
+    sel->_event_count = os_fd_linux_uring_wait(sel, maxdelay);
+  }
+  else
+#endif
   sel->_event_count = epoll_wait(sel->_epoll_fd, sel->_events,
-      ARRAYSIZE(sel->_events), maxdelay);
+      sel->_event_size, maxdelay);
 
   OONF_DEBUG(LOG_OS_SOCKET, "epoll_wait(maxdelay = %"PRIu64"): %d",
       maxdelay, sel->_event_count);
@@ -123,6 +232,46 @@ os_fd_linux_event_wait(struct os_fd_select *sel) {
   return sel->_event_count;
 }
 
+/**
+ * Add a socket to a selector set
+ * @param sel socket selector set
+ * @param sock os socket
+ * @return -1 if an error happened, 0 otherwise
+ */
+int
+os_fd_linux_event_socket_add(struct os_fd_select *sel,
+    struct os_fd *sock) {
+  struct epoll_event event;
+
+#ifdef OONF_IO_URING
+  if (sel->_uring) {
+    return os_fd_linux_uring_socket_add(sel, sock);
+  }
+#endif
+
+  memset(&event,0,sizeof(event));
+
+  event.data.ptr = sock;
+  return epoll_ctl(sel->_epoll_fd, EPOLL_CTL_ADD, sock->fd, &event);
+}
+
+/**
+ * Remove a socket from a selector set
+ * @param sel socket selector set
+ * @param sock os socket
+ * @return -1 if an error happened, 0 otherwise
+ */
+int
+os_fd_linux_event_socket_remove(struct os_fd_select *sel,
+    struct os_fd *sock) {
+#ifdef OONF_IO_URING
+  if (sel->_uring) {
+    return os_fd_linux_uring_socket_remove(sel, sock);
+  }
+#endif
+  return epoll_ctl(sel->_epoll_fd, EPOLL_CTL_DEL, sock->fd, NULL);
+}
+
 /**
  * Move the wanted events of a socket into a selector set
  * @param sel socket selector set
@@ -134,9 +283,18 @@ os_fd_linux_event_socket_modify(struct os_fd_select *sel,
     struct os_fd *sock) {
   struct epoll_event event;
 
+#ifdef OONF_IO_URING
+  if (sel->_uring) {
+    return os_fd_linux_uring_socket_modify(sel, sock);
+  }
+#endif
+
   memset(&event,0,sizeof(event));
 
   event.events = sock->wanted_events;
+  if (sock->_flags & OS_FD_EDGE_TRIGGERED) {
+    event.events |= EPOLLET;
+  }
   event.data.ptr = sock;
 
   OONF_DEBUG(LOG_OS_SOCKET, "Modify socket %d to events 0x%x",
@@ -167,3 +325,117 @@ os_fd_linux_skip_rawsocket_prefix(uint8_t *ptr, ssize_t *len, int af_type) {
   *len -= header_size;
   return ptr + header_size;
 }
+
+/**
+ * Receive multiple datagrams from a socket with a single recvmmsg() call.
+ * @param sock socket representation
+ * @param dgrams array of datagram buffers
+ * @param count number of datagram buffers
+ * @return number of received datagrams, -1 if an error happened
+ */
+int
+os_fd_linux_recvmmsg(struct os_fd *sock,
+    struct os_fd_datagram *dgrams, int count) {
+  struct mmsghdr msgs[OS_FD_MAX_DATAGRAMS];
+  struct iovec iov[OS_FD_MAX_DATAGRAMS];
+  uint8_t control[OS_FD_MAX_DATAGRAMS][CMSG_SPACE(sizeof(struct timespec))];
+  struct cmsghdr *cmsg;
+  struct timespec ts;
+  int i, result;
+
+  if (count > OS_FD_MAX_DATAGRAMS) {
+    count = OS_FD_MAX_DATAGRAMS;
+  }
+
+  memset(msgs, 0, sizeof(*msgs) * count);
+  for (i=0; i<count; i++) {
+    iov[i].iov_base = dgrams[i].buf;
+    iov[i].iov_len = dgrams[i].length;
+
+    msgs[i].msg_hdr.msg_name = &dgrams[i].remote.std;
+    msgs[i].msg_hdr.msg_namelen = sizeof(dgrams[i].remote);
+    msgs[i].msg_hdr.msg_iov = &iov[i];
+    msgs[i].msg_hdr.msg_iovlen = 1;
+    msgs[i].msg_hdr.msg_control = control[i];
+    msgs[i].msg_hdr.msg_controllen = sizeof(control[i]);
+  }
+
+  result = recvmmsg(sock->fd, msgs, count, 0, NULL);
+  for (i=0; i<result; i++) {
+    dgrams[i].received = msgs[i].msg_len;
+    dgrams[i].truncated = (msgs[i].msg_hdr.msg_flags & MSG_TRUNC) != 0;
+    dgrams[i].timestamp = 0;
+
+    /* look for the receive timestamp (if activated for socket) */
+    for (cmsg = CMSG_FIRSTHDR(&msgs[i].msg_hdr); cmsg != NULL;
+        cmsg = CMSG_NXTHDR(&msgs[i].msg_hdr, cmsg)) {
+      if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+        memcpy(&ts, CMSG_DATA(cmsg), sizeof(ts));
+        dgrams[i].timestamp = (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+      }
+    }
+  }
+
+  OONF_DEBUG(LOG_OS_SOCKET, "recvmmsg(%d): %d", count, result);
+  return result;
+}
+
+/**
+ * Send multiple datagrams through a socket with a single sendmmsg() call.
+ * @param sock socket representation
+ * @param dgrams array of outgoing datagrams
+ * @param count number of outgoing datagrams
+ * @param dont_route suppress routing of datagrams
+ * @return number of sent datagrams, -1 if an error happened
+ *   before the first datagram was sent
+ */
+int
+os_fd_linux_sendmmsg(struct os_fd *sock,
+    struct os_fd_datagram *dgrams, int count, bool dont_route) {
+  struct mmsghdr msgs[OS_FD_MAX_DATAGRAMS];
+  struct iovec iov[OS_FD_MAX_DATAGRAMS];
+  int i, result;
+
+  if (count > OS_FD_MAX_DATAGRAMS) {
+    count = OS_FD_MAX_DATAGRAMS;
+  }
+
+  memset(msgs, 0, sizeof(*msgs) * count);
+  for (i=0; i<count; i++) {
+    iov[i].iov_base = dgrams[i].buf;
+    iov[i].iov_len = dgrams[i].length;
+
+    msgs[i].msg_hdr.msg_name = &dgrams[i].remote.std;
+    msgs[i].msg_hdr.msg_namelen = sizeof(dgrams[i].remote);
+    msgs[i].msg_hdr.msg_iov = &iov[i];
+    msgs[i].msg_hdr.msg_iovlen = 1;
+  }
+
+  result = sendmmsg(sock->fd, msgs, count, dont_route ? MSG_DONTROUTE : 0);
+  OONF_DEBUG(LOG_OS_SOCKET, "sendmmsg(%d): %d", count, result);
+  return result;
+}
+
+/**
+ * Change the size of the event array of a socket selector set.
+ * The old array is kept if the allocation fails.
+ * @param sel socket selector set
+ * @param size new number of elements
+ * @return -1 if an error happened, 0 otherwise
+ */
+static int
+_resize_event_array(struct os_fd_select *sel, int size) {
+  struct epoll_event *events;
+
+  events = realloc(sel->_events, sizeof(*events) * size);
+  if (!events) {
+    OONF_WARN(LOG_OS_SOCKET, "Could not resize epoll event array to %d", size);
+    return -1;
+  }
+
+  OONF_DEBUG(LOG_OS_SOCKET, "Resized epoll event array from %d to %d",
+      sel->_event_size, size);
+  sel->_events = events;
+  sel->_event_size = size;
+  return 0;
+}
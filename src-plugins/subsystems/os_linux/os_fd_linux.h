@@ -47,6 +47,7 @@
 #define OS_FD_LINUX_H_
 
 #include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/sendfile.h>
@@ -63,8 +64,14 @@
 /*! name of the loopback interface */
 #define IF_LOOPBACK_NAME "lo"
 
+/*! initial number of events handled by a single epoll_wait() call */
+#define OS_FD_EVENT_DEFAULT_SIZE 16
+
 enum os_fd_flags {
   OS_FD_ACTIVE = 1,
+
+  /*! socket is registered with EPOLLET */
+  OS_FD_EDGE_TRIGGERED = 2,
 };
 
 /*! linux specific socket definition */
@@ -80,23 +87,54 @@ struct os_fd {
 
   /*! flags for socket */
   enum os_fd_flags _flags;
+
+#ifdef OONF_IO_URING
+  /*! slot of socket in io_uring backend (index plus one), 0 if not registered */
+  uint32_t _uring_slot;
+#endif
 };
 
+/* io_uring backend, internal to os_fd_linux_uring.c */
+struct os_fd_linux_uring;
+
 /*! linux specific socket select definition */
 struct os_fd_select {
-  struct epoll_event _events[16];
+  /*! array of events filled by epoll_wait() */
+  struct epoll_event *_events;
+
+  /*! number of elements in event array */
+  int _event_size;
+
+  /*! maximum number of elements the event array can grow to */
+  int _event_max;
+
+  /*! number of events of the last epoll_wait() */
   int _event_count;
 
   int _epoll_fd;
 
   uint64_t deadline;
+
+  /*! io_uring backend, NULL if epoll is used */
+  struct os_fd_linux_uring *_uring;
 };
 
 /** declare non-inline linux-specific functions */
+EXPORT int os_fd_linux_event_add(struct os_fd_select *);
+EXPORT int os_fd_linux_event_add_backend(struct os_fd_select *, bool io_uring);
+EXPORT int os_fd_linux_event_remove(struct os_fd_select *);
 EXPORT int os_fd_linux_event_wait(struct os_fd_select *);
+EXPORT int os_fd_linux_event_socket_add(struct os_fd_select *sel,
+    struct os_fd *sock);
 EXPORT int os_fd_linux_event_socket_modify(struct os_fd_select *sel,
     struct os_fd *sock);
+EXPORT int os_fd_linux_event_socket_remove(struct os_fd_select *sel,
+    struct os_fd *sock);
 EXPORT uint8_t *os_fd_linux_skip_rawsocket_prefix(uint8_t *ptr, ssize_t *len, int af_type);
+EXPORT int os_fd_linux_recvmmsg(struct os_fd *sock,
+    struct os_fd_datagram *dgrams, int count);
+EXPORT int os_fd_linux_sendmmsg(struct os_fd *sock,
+    struct os_fd_datagram *dgrams, int count, bool dont_route);
 
 /**
  * Redirect to linux specific event wait call
@@ -212,6 +250,19 @@ os_fd_set_dscp(struct os_fd *sock, int dscp, bool ipv6) {
   return os_fd_generic_set_dscp(sock, dscp, ipv6);
 }
 
+/**
+ * Activate kernel receive timestamps for a socket, they are reported
+ * by os_fd_recvmmsg()
+ * @param sock socket representation
+ * @param enable true to enable timestamps, false to disable them
+ * @return -1 if an error happened, 0 otherwise
+ */
+static INLINE int
+os_fd_set_rx_timestamp(struct os_fd *sock, bool enable) {
+  int value = enable ? 1 : 0;
+  return setsockopt(sock->fd, SOL_SOCKET, SO_TIMESTAMPNS, &value, sizeof(value));
+}
+
 /**
  * Redirect to linux specific rawsocket prefix call
  * @param ptr pointer to the beginning of the buffer
@@ -313,9 +364,7 @@ os_fd_listen(struct os_fd *sock, int n) {
  */
 static INLINE int
 os_fd_event_add(struct os_fd_select *sel) {
-  memset (sel, 0, sizeof(*sel));
-  sel->_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
-  return sel->_epoll_fd < 0 ? -1 : 0;
+  return os_fd_linux_event_add(sel);
 }
 
 /**
@@ -337,12 +386,7 @@ os_fd_event_get(struct os_fd_select *sel, int idx) {
  */
 static INLINE int
 os_fd_event_socket_add(struct os_fd_select *sel, struct os_fd *sock) {
-  struct epoll_event event;
-
-  memset(&event,0,sizeof(event));
-
-  event.data.ptr = sock;
-  return epoll_ctl(sel->_epoll_fd, EPOLL_CTL_ADD, sock->fd, &event);
+  return os_fd_linux_event_socket_add(sel, sock);
 }
 
 /**
@@ -413,7 +457,64 @@ os_fd_event_is_write(struct os_fd *sock) {
  */
 static INLINE int
 os_fd_event_socket_remove(struct os_fd_select *sel, struct os_fd *sock) {
-  return epoll_ctl(sel->_epoll_fd, EPOLL_CTL_DEL, sock->fd, NULL);
+  return os_fd_linux_event_socket_remove(sel, sock);
+}
+
+/**
+ * Switch a socket between level and edge triggered events. The user
+ * of an edge triggered socket must read/write it until it would block.
+ * @param sel socket event handler
+ * @param sock socket representation
+ * @param edge_triggered true to use edge triggered events,
+ *   false for level triggered events
+ * @return -1 if an error happened, 0 otherwise
+ */
+static INLINE int
+os_fd_event_socket_edge_triggered(struct os_fd_select *sel,
+    struct os_fd *sock, bool edge_triggered) {
+  if (edge_triggered) {
+    sock->_flags |= OS_FD_EDGE_TRIGGERED;
+  }
+  else {
+    sock->_flags &= ~OS_FD_EDGE_TRIGGERED;
+  }
+  return os_fd_linux_event_socket_modify(sel, sock);
+}
+
+/**
+ * @param sock socket representation
+ * @return true if socket uses edge triggered events
+ */
+static INLINE bool
+os_fd_event_is_edge_triggered(struct os_fd *sock) {
+  return (sock->_flags & OS_FD_EDGE_TRIGGERED) != 0;
+}
+
+/**
+ * Set the maximum number of events a single wait call can return.
+ * The event array starts small and grows up to this limit if it
+ * was filled completely, the new limit is applied during the next
+ * wait call.
+ * @param sel socket event handler
+ * @param max_events maximum number of events
+ * @return -1 if an error happened, 0 otherwise
+ */
+static INLINE int
+os_fd_event_set_max_events(struct os_fd_select *sel, int max_events) {
+  if (max_events < 1) {
+    return -1;
+  }
+  sel->_event_max = max_events;
+  return 0;
+}
+
+/**
+ * @param sel socket event handler
+ * @return current number of events a single wait call can return
+ */
+static INLINE int
+os_fd_event_get_size(struct os_fd_select *sel) {
+  return sel->_event_size;
 }
 
 /**
@@ -437,6 +538,15 @@ os_fd_event_get_deadline(struct os_fd_select *sel) {
   return sel->deadline;
 }
 
+/**
+ * @param sel socket event handler
+ * @return name of the kernel interface used by the socket event handler
+ */
+static INLINE const char *
+os_fd_event_get_backend(struct os_fd_select *sel) {
+  return sel->_uring != NULL ? "io_uring" : "epoll";
+}
+
 /**
  * Cleans up a socket event handler
  * @param sel socket event handler
@@ -444,7 +554,7 @@ os_fd_event_get_deadline(struct os_fd_select *sel) {
  */
 static INLINE int
 os_fd_event_remove(struct os_fd_select *sel) {
-  return close(sel->_epoll_fd);
+  return os_fd_linux_event_remove(sel);
 }
 
 /**
@@ -504,6 +614,29 @@ os_fd_sendto(struct os_fd *sock, const void *buf, size_t length, const union net
       dst ? &dst->std : NULL, sizeof(*dst));
 }
 
+/**
+ * Sends a datagram assembled from several buffers to an UDP socket.
+ * @param sock socket representation
+ * @param iov array of buffers
+ * @param iovcnt number of buffers
+ * @param dst pointer to netaddr socket to send packet to
+ * @param dont_route true to suppress routing of data
+ * @return same as sendmsg()
+ */
+static INLINE ssize_t
+os_fd_sendmsg(struct os_fd *sock, const struct iovec *iov, int iovcnt,
+    const union netaddr_socket *dst, bool dont_route) {
+  struct msghdr msg;
+
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_name = dst ? (void *)&dst->std : NULL;
+  msg.msg_namelen = dst ? sizeof(*dst) : 0;
+  msg.msg_iov = (struct iovec *)iov;
+  msg.msg_iovlen = iovcnt;
+
+  return sendmsg(sock->fd, &msg, dont_route ? MSG_DONTROUTE : 0);
+}
+
 /**
  * Receive data from a socket.
  * @param fd filedescriptor
@@ -521,6 +654,36 @@ os_fd_recvfrom(struct os_fd *sock, void *buf, size_t length, union netaddr_socke
   return recvfrom(sock->fd, buf, length, 0, &source->std, &len);
 }
 
+/**
+ * Receive multiple datagrams from a socket with a single call.
+ * @param sock socket representation
+ * @param dgrams array of datagram buffers
+ * @param count number of datagram buffers
+ * @param interf limit received data to certain interface
+ *   (only used if socket cannot be bound to interface)
+ * @return number of received datagrams, -1 if an error happened
+ */
+static INLINE int
+os_fd_recvmmsg(struct os_fd *sock, struct os_fd_datagram *dgrams, int count,
+    const struct os_interface *interf __attribute__((unused))) {
+  return os_fd_linux_recvmmsg(sock, dgrams, count);
+}
+
+/**
+ * Send multiple datagrams through a socket with a single call.
+ * @param sock socket representation
+ * @param dgrams array of outgoing datagrams
+ * @param count number of outgoing datagrams
+ * @param dont_route suppress routing of datagrams
+ * @return number of sent datagrams, -1 if an error happened
+ *   before the first datagram was sent
+ */
+static INLINE int
+os_fd_sendmmsg(struct os_fd *sock, struct os_fd_datagram *dgrams, int count,
+    bool dont_route) {
+  return os_fd_linux_sendmmsg(sock, dgrams, count, dont_route);
+}
+
 /**
  * Binds a socket to a certain interface
  * @param sock filedescriptor of socket
@@ -556,4 +719,43 @@ os_fd_sendfile(struct os_fd *out, struct os_fd *in, size_t offset, size_t count)
   return sendfile(out->fd, in->fd, &int_offset, count);
 }
 
+/**
+ * Create a non-blocking file descriptor that can be used to wake up
+ * the socket scheduler from another thread (an eventfd on Linux)
+ * @param sock empty socket representation
+ * @return -1 if an error happened, 0 otherwise
+ */
+static INLINE int
+os_fd_open_notifier(struct os_fd *sock) {
+  int fd;
+
+  fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (fd == -1) {
+    return -1;
+  }
+  return os_fd_init(sock, fd);
+}
+
+/**
+ * Trigger a read event on a notifier file descriptor.
+ * This function can be called from any thread.
+ * @param sock notifier socket representation
+ * @return -1 if an error happened, 0 otherwise
+ */
+static INLINE int
+os_fd_notify(struct os_fd *sock) {
+  return eventfd_write(sock->fd, 1);
+}
+
+/**
+ * Reset the read event of a notifier file descriptor
+ * @param sock notifier socket representation
+ * @return -1 if no notification was pending, 0 otherwise
+ */
+static INLINE int
+os_fd_clear_notification(struct os_fd *sock) {
+  eventfd_t value;
+  return eventfd_read(sock->fd, &value);
+}
+
 #endif /* OS_FD_LINUX_H_ */
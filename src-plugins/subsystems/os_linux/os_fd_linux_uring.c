@@ -0,0 +1,642 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/io_uring.h>
+
+#include "common/common_types.h"
+#include "subsystems/os_fd.h"
+
+#include "subsystems/os_linux/os_fd_linux_uring.h"
+
+/*
+ * The io_uring backend emulates level triggered epoll semantics with
+ * oneshot poll requests. A poll request that delivered an event is
+ * armed again at the start of the next wait call, so all new and
+ * rearmed poll requests are submitted by the same io_uring_enter()
+ * call that waits for the completions.
+ *
+ * Edge triggered sockets use a multishot poll request instead, which
+ * stays armed in the kernel and creates a completion for each wakeup
+ * of the socket. Multiple completions of the same socket during one
+ * wait call are merged into a single event.
+ *
+ * Each socket owns a slot of the backend. The user_data of a poll
+ * request contains the slot index and a generation counter, so
+ * completions of poll requests that belonged to a removed (and maybe
+ * freed) socket or an outdated event mask are dropped.
+ */
+
+/*! number of entries in the submission queue */
+#define URING_SQ_ENTRIES 256
+
+/*! initial number of socket slots */
+#define URING_DEFAULT_SLOTS 16
+
+/**
+ * io_uring state of a socket
+ */
+struct _uring_slot {
+  /*! socket of slot, NULL if slot is unused */
+  struct os_fd *sock;
+
+  /*! generation of the current poll request */
+  uint32_t generation;
+
+  /*! true if a poll request is active in the kernel */
+  bool armed;
+
+  /*! true if slot is in the list of slots to be armed */
+  bool pending;
+
+  /*! wait call that reported the last event of this slot */
+  uint32_t event_wait;
+
+  /*! index of the last event of this slot in the event array */
+  int event_idx;
+
+  /*! next unused slot (index plus one), 0 for end of list */
+  uint32_t next_free;
+};
+
+/**
+ * io_uring backend of a socket selector set
+ */
+struct os_fd_linux_uring {
+  /*! file descriptor of io_uring */
+  int ring_fd;
+
+  /*! mapping of submission and completion ring */
+  void *ring;
+  size_t ring_size;
+
+  /*! mapping of submission queue entries */
+  struct io_uring_sqe *sqes;
+  size_t sqes_size;
+
+  /*! pointers into submission ring */
+  uint32_t *sq_head, *sq_tail, *sq_array;
+  uint32_t sq_mask, sq_entries;
+
+  /*! pointers into completion ring */
+  uint32_t *cq_head, *cq_tail;
+  struct io_uring_cqe *cqes;
+  uint32_t cq_mask;
+
+  /*! socket slots */
+  struct _uring_slot *slots;
+  uint32_t slot_count;
+
+  /*! first unused slot (index plus one), 0 if all slots are used */
+  uint32_t free_slot;
+
+  /*! slots that need a new poll request */
+  uint32_t *pending;
+  uint32_t pending_count;
+
+  /*! number of wait calls, used to merge multishot completions */
+  uint32_t wait_count;
+};
+
+static int _enter(struct os_fd_linux_uring *uring, uint32_t to_submit,
+    uint32_t min_complete, uint32_t flags, struct io_uring_getevents_arg *arg);
+static int _submit(struct os_fd_linux_uring *uring);
+static struct io_uring_sqe *_get_sqe(struct os_fd_linux_uring *uring);
+static void _commit_sqe(struct os_fd_linux_uring *uring);
+static int _queue_poll_add(struct os_fd_linux_uring *uring, uint32_t idx);
+static int _queue_poll_remove(struct os_fd_linux_uring *uring, uint32_t idx);
+static void _set_pending(struct os_fd_linux_uring *uring, uint32_t idx);
+static int _grow_slots(struct os_fd_linux_uring *uring);
+
+/**
+ * Create the io_uring backend for a socket selector set
+ * @param sel socket selector set
+ * @return -1 if io_uring is not available, 0 otherwise
+ */
+int
+os_fd_linux_uring_init(struct os_fd_select *sel) {
+  struct os_fd_linux_uring *uring;
+  struct io_uring_params params;
+  size_t sq_size, cq_size;
+  uint8_t *ring;
+
+  uring = calloc(1, sizeof(*uring));
+  if (!uring) {
+    return -1;
+  }
+
+  memset(&params, 0, sizeof(params));
+  uring->ring_fd = syscall(__NR_io_uring_setup, URING_SQ_ENTRIES, &params);
+  if (uring->ring_fd < 0) {
+    free(uring);
+    return -1;
+  }
+
+  if ((params.features & IORING_FEAT_SINGLE_MMAP) == 0
+      || (params.features & IORING_FEAT_NODROP) == 0
+      || (params.features & IORING_FEAT_EXT_ARG) == 0
+      || (params.features & IORING_FEAT_RSRC_TAGS) == 0) {
+    /* kernel too old, multishot poll needs the same version (5.13) as resource tags */
+    close(uring->ring_fd);
+    free(uring);
+    errno = ENOTSUP;
+    return -1;
+  }
+
+  sq_size = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+  cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+  uring->ring_size = sq_size > cq_size ? sq_size : cq_size;
+  uring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+
+  uring->ring = mmap(NULL, uring->ring_size, PROT_READ | PROT_WRITE,
+      MAP_SHARED | MAP_POPULATE, uring->ring_fd, IORING_OFF_SQ_RING);
+  if (uring->ring == MAP_FAILED) {
+    close(uring->ring_fd);
+    free(uring);
+    return -1;
+  }
+
+  uring->sqes = mmap(NULL, uring->sqes_size, PROT_READ | PROT_WRITE,
+      MAP_SHARED | MAP_POPULATE, uring->ring_fd, IORING_OFF_SQES);
+  if (uring->sqes == MAP_FAILED) {
+    munmap(uring->ring, uring->ring_size);
+    close(uring->ring_fd);
+    free(uring);
+    return -1;
+  }
+
+  ring = uring->ring;
+  uring->sq_head = (uint32_t *)(ring + params.sq_off.head);
+  uring->sq_tail = (uint32_t *)(ring + params.sq_off.tail);
+  uring->sq_array = (uint32_t *)(ring + params.sq_off.array);
+  uring->sq_mask = *(uint32_t *)(ring + params.sq_off.ring_mask);
+  uring->sq_entries = params.sq_entries;
+
+  uring->cq_head = (uint32_t *)(ring + params.cq_off.head);
+  uring->cq_tail = (uint32_t *)(ring + params.cq_off.tail);
+  uring->cqes = (struct io_uring_cqe *)(ring + params.cq_off.cqes);
+  uring->cq_mask = *(uint32_t *)(ring + params.cq_off.ring_mask);
+
+  if (_grow_slots(uring)) {
+    sel->_uring = uring;
+    os_fd_linux_uring_cleanup(sel);
+    return -1;
+  }
+
+  sel->_uring = uring;
+  return 0;
+}
+
+/**
+ * Free the io_uring backend of a socket selector set
+ * @param sel socket selector set
+ */
+void
+os_fd_linux_uring_cleanup(struct os_fd_select *sel) {
+  struct os_fd_linux_uring *uring = sel->_uring;
+
+  munmap(uring->sqes, uring->sqes_size);
+  munmap(uring->ring, uring->ring_size);
+  close(uring->ring_fd);
+
+  free(uring->slots);
+  free(uring->pending);
+  free(uring);
+
+  sel->_uring = NULL;
+}
+
+/**
+ * Add a socket to the io_uring backend
+ * @param sel socket selector set
+ * @param sock socket representation
+ * @return -1 if an error happened, 0 otherwise
+ */
+int
+os_fd_linux_uring_socket_add(struct os_fd_select *sel, struct os_fd *sock) {
+  struct os_fd_linux_uring *uring = sel->_uring;
+  struct _uring_slot *slot;
+  uint32_t idx;
+
+  if (uring->free_slot == 0 && _grow_slots(uring)) {
+    return -1;
+  }
+
+  idx = uring->free_slot - 1;
+  slot = &uring->slots[idx];
+  uring->free_slot = slot->next_free;
+
+  slot->sock = sock;
+  slot->generation++;
+  slot->armed = false;
+  slot->next_free = 0;
+
+  sock->_uring_slot = idx + 1;
+
+  if (sock->wanted_events) {
+    _set_pending(uring, idx);
+  }
+  return 0;
+}
+
+/**
+ * Apply a changed event mask of a socket to the io_uring backend
+ * @param sel socket selector set
+ * @param sock socket representation
+ * @return -1 if an error happened, 0 otherwise
+ */
+int
+os_fd_linux_uring_socket_modify(struct os_fd_select *sel, struct os_fd *sock) {
+  struct os_fd_linux_uring *uring = sel->_uring;
+  uint32_t idx;
+
+  if (sock->_uring_slot == 0) {
+    errno = ENOENT;
+    return -1;
+  }
+  idx = sock->_uring_slot - 1;
+
+  if (uring->slots[idx].armed && _queue_poll_remove(uring, idx)) {
+    return -1;
+  }
+
+  if (sock->wanted_events) {
+    _set_pending(uring, idx);
+  }
+  return 0;
+}
+
+/**
+ * Remove a socket from the io_uring backend. The kernel releases
+ * the socket immediately, so it can be closed afterwards.
+ * @param sel socket selector set
+ * @param sock socket representation
+ * @return -1 if an error happened, 0 otherwise
+ */
+int
+os_fd_linux_uring_socket_remove(struct os_fd_select *sel, struct os_fd *sock) {
+  struct os_fd_linux_uring *uring = sel->_uring;
+  struct _uring_slot *slot;
+  uint32_t idx;
+
+  if (sock->_uring_slot == 0) {
+    errno = ENOENT;
+    return -1;
+  }
+  idx = sock->_uring_slot - 1;
+  slot = &uring->slots[idx];
+
+  if (slot->armed) {
+    _queue_poll_remove(uring, idx);
+  }
+
+  /* pending list is cleaned up during the next wait call */
+  slot->sock = NULL;
+  slot->generation++;
+  slot->next_free = uring->free_slot;
+  uring->free_slot = idx + 1;
+
+  sock->_uring_slot = 0;
+
+  /* make sure the kernel drops its reference to the socket */
+  return _submit(uring);
+}
+
+/**
+ * Arm all pending poll requests and wait for socket events.
+ * The events are stored in the event array of the selector set.
+ * @param sel socket selector set
+ * @param timeout maximum time to wait in milliseconds
+ * @return number of events, -1 if an error happened
+ */
+int
+os_fd_linux_uring_wait(struct os_fd_select *sel, int timeout) {
+  struct os_fd_linux_uring *uring = sel->_uring;
+  struct io_uring_getevents_arg arg;
+  struct __kernel_timespec ts;
+  struct io_uring_cqe *cqe;
+  struct _uring_slot *slot;
+  uint32_t i, idx, head, tail, generation, to_submit, events;
+  int count, result;
+
+  /* arm poll requests of new, changed and triggered sockets */
+  for (i=0; i<uring->pending_count; i++) {
+    idx = uring->pending[i];
+    slot = &uring->slots[idx];
+    slot->pending = false;
+
+    if (slot->sock != NULL && !slot->armed && slot->sock->wanted_events != 0) {
+      if (_queue_poll_add(uring, idx)) {
+        return -1;
+      }
+    }
+  }
+  uring->pending_count = 0;
+
+  to_submit = *uring->sq_tail - __atomic_load_n(uring->sq_head, __ATOMIC_ACQUIRE);
+  head = *uring->cq_head;
+  tail = __atomic_load_n(uring->cq_tail, __ATOMIC_ACQUIRE);
+
+  if (head == tail) {
+    /* no completion available, submit and wait */
+    memset(&ts, 0, sizeof(ts));
+    ts.tv_sec = timeout / 1000;
+    ts.tv_nsec = (timeout % 1000) * 1000000ll;
+
+    memset(&arg, 0, sizeof(arg));
+    arg.ts = (uint64_t)(uintptr_t)&ts;
+
+    result = _enter(uring, to_submit, 1, IORING_ENTER_GETEVENTS, &arg);
+    if (result < 0 && errno != ETIME) {
+      return -1;
+    }
+    tail = __atomic_load_n(uring->cq_tail, __ATOMIC_ACQUIRE);
+  }
+  else if (to_submit > 0) {
+    /* collect the completions of sockets that are already readable */
+    if (_enter(uring, to_submit, 0, IORING_ENTER_GETEVENTS, NULL) < 0) {
+      return -1;
+    }
+    tail = __atomic_load_n(uring->cq_tail, __ATOMIC_ACQUIRE);
+  }
+
+  uring->wait_count++;
+  count = 0;
+  while (head != tail && count < sel->_event_size) {
+    cqe = &uring->cqes[head & uring->cq_mask];
+    head++;
+
+    idx = (uint32_t)(cqe->user_data & 0xffffffff);
+    generation = (uint32_t)(cqe->user_data >> 32);
+    if (idx == 0) {
+      /* completion of a poll remove request */
+      continue;
+    }
+
+    slot = &uring->slots[idx - 1];
+    if (slot->sock == NULL || slot->generation != generation) {
+      /* outdated poll request */
+      continue;
+    }
+
+    if ((cqe->flags & IORING_CQE_F_MORE) == 0) {
+      /* oneshot request or terminated multishot request */
+      slot->armed = false;
+      _set_pending(uring, idx - 1);
+    }
+
+    if (cqe->res < 0) {
+      /* report error to socket handler like epoll */
+      events = EPOLLERR;
+    }
+    else {
+      events = cqe->res & (slot->sock->wanted_events | EPOLLERR | EPOLLHUP);
+      if (events == 0) {
+        continue;
+      }
+    }
+
+    if (slot->event_wait == uring->wait_count) {
+      /* multishot request triggered again during this wait call */
+      sel->_events[slot->event_idx].events |= events;
+      continue;
+    }
+
+    slot->event_wait = uring->wait_count;
+    slot->event_idx = count;
+
+    sel->_events[count].events = events;
+    sel->_events[count].data.ptr = slot->sock;
+    count++;
+  }
+  __atomic_store_n(uring->cq_head, head, __ATOMIC_RELEASE);
+
+  return count;
+}
+
+/**
+ * Call io_uring_enter()
+ * @param uring io_uring backend
+ * @param to_submit number of new submission queue entries
+ * @param min_complete number of completions to wait for
+ * @param flags io_uring_enter flags
+ * @param arg extended arguments with timeout, NULL if not used
+ * @return number of submitted entries, -1 if an error happened
+ */
+static int
+_enter(struct os_fd_linux_uring *uring, uint32_t to_submit,
+    uint32_t min_complete, uint32_t flags, struct io_uring_getevents_arg *arg) {
+  if (arg) {
+    return syscall(__NR_io_uring_enter, uring->ring_fd, to_submit, min_complete,
+        flags | IORING_ENTER_EXT_ARG, arg, sizeof(*arg));
+  }
+  return syscall(__NR_io_uring_enter, uring->ring_fd, to_submit, min_complete,
+      flags, NULL, 0);
+}
+
+/**
+ * Submit all queued submission queue entries without waiting
+ * @param uring io_uring backend
+ * @return -1 if an error happened, 0 otherwise
+ */
+static int
+_submit(struct os_fd_linux_uring *uring) {
+  uint32_t to_submit;
+
+  to_submit = *uring->sq_tail - __atomic_load_n(uring->sq_head, __ATOMIC_ACQUIRE);
+  if (to_submit == 0) {
+    return 0;
+  }
+  return _enter(uring, to_submit, 0, 0, NULL) < 0 ? -1 : 0;
+}
+
+/**
+ * Get the next free submission queue entry, submits the queue
+ * if it is full.
+ * @param uring io_uring backend
+ * @return pointer to cleared entry, NULL if an error happened
+ */
+static struct io_uring_sqe *
+_get_sqe(struct os_fd_linux_uring *uring) {
+  struct io_uring_sqe *sqe;
+  uint32_t tail;
+
+  tail = *uring->sq_tail;
+  if (tail - __atomic_load_n(uring->sq_head, __ATOMIC_ACQUIRE) == uring->sq_entries) {
+    if (_submit(uring)) {
+      return NULL;
+    }
+  }
+
+  sqe = &uring->sqes[tail & uring->sq_mask];
+  memset(sqe, 0, sizeof(*sqe));
+
+  uring->sq_array[tail & uring->sq_mask] = tail & uring->sq_mask;
+  return sqe;
+}
+
+/**
+ * Commit the submission queue entry fetched with _get_sqe()
+ * @param uring io_uring backend
+ */
+static void
+_commit_sqe(struct os_fd_linux_uring *uring) {
+  __atomic_store_n(uring->sq_tail, *uring->sq_tail + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * Queue a poll request for a socket slot, oneshot for level triggered
+ * and multishot for edge triggered sockets
+ * @param uring io_uring backend
+ * @param idx slot index
+ * @return -1 if an error happened, 0 otherwise
+ */
+static int
+_queue_poll_add(struct os_fd_linux_uring *uring, uint32_t idx) {
+  struct _uring_slot *slot = &uring->slots[idx];
+  struct io_uring_sqe *sqe;
+
+  sqe = _get_sqe(uring);
+  if (!sqe) {
+    return -1;
+  }
+
+  sqe->opcode = IORING_OP_POLL_ADD;
+  sqe->fd = slot->sock->fd;
+  sqe->poll32_events = slot->sock->wanted_events;
+  if (slot->sock->_flags & OS_FD_EDGE_TRIGGERED) {
+    sqe->len = IORING_POLL_ADD_MULTI;
+  }
+  sqe->user_data = ((uint64_t)slot->generation << 32) | (idx + 1);
+  _commit_sqe(uring);
+
+  slot->armed = true;
+  return 0;
+}
+
+/**
+ * Queue the removal of the poll request of a socket slot and
+ * invalidate all of its completions.
+ * @param uring io_uring backend
+ * @param idx slot index
+ * @return -1 if an error happened, 0 otherwise
+ */
+static int
+_queue_poll_remove(struct os_fd_linux_uring *uring, uint32_t idx) {
+  struct _uring_slot *slot = &uring->slots[idx];
+  struct io_uring_sqe *sqe;
+
+  sqe = _get_sqe(uring);
+  if (!sqe) {
+    return -1;
+  }
+
+  sqe->opcode = IORING_OP_POLL_REMOVE;
+  sqe->fd = -1;
+  sqe->addr = ((uint64_t)slot->generation << 32) | (idx + 1);
+  sqe->user_data = 0;
+  _commit_sqe(uring);
+
+  slot->armed = false;
+  slot->generation++;
+  return 0;
+}
+
+/**
+ * Remember that a socket slot needs a new poll request
+ * @param uring io_uring backend
+ * @param idx slot index
+ */
+static void
+_set_pending(struct os_fd_linux_uring *uring, uint32_t idx) {
+  if (!uring->slots[idx].pending) {
+    uring->slots[idx].pending = true;
+    uring->pending[uring->pending_count++] = idx;
+  }
+}
+
+/**
+ * Double the number of socket slots
+ * @param uring io_uring backend
+ * @return -1 if an error happened, 0 otherwise
+ */
+static int
+_grow_slots(struct os_fd_linux_uring *uring) {
+  struct _uring_slot *slots;
+  uint32_t *pending;
+  uint32_t i, count;
+
+  count = uring->slot_count ? uring->slot_count * 2 : URING_DEFAULT_SLOTS;
+
+  slots = realloc(uring->slots, sizeof(*slots) * count);
+  if (!slots) {
+    return -1;
+  }
+  uring->slots = slots;
+
+  pending = realloc(uring->pending, sizeof(*pending) * count);
+  if (!pending) {
+    return -1;
+  }
+  uring->pending = pending;
+
+  memset(&slots[uring->slot_count], 0,
+      sizeof(*slots) * (count - uring->slot_count));
+
+  /* add new slots to the front of the free list */
+  for (i = count; i > uring->slot_count; i--) {
+    slots[i-1].next_free = uring->free_slot;
+    uring->free_slot = i;
+  }
+  uring->slot_count = count;
+  return 0;
+}
@@ -0,0 +1,123 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "common/common_types.h"
+#include "rfc5444_arena.h"
+
+/**
+ * Free all memory chunks of an arena and clear it.
+ * This function should not be called by the user of the rfc5444 API!
+ * @param arena pointer to arena
+ */
+void
+_rfc5444_arena_free(struct rfc5444_arena *arena) {
+  struct rfc5444_arena_chunk *chunk, *next;
+
+  for (chunk = arena->first; chunk != NULL; chunk = next) {
+    next = chunk->next;
+    free(chunk);
+  }
+  memset(arena, 0, sizeof(*arena));
+}
+
+/**
+ * Allocate cleared memory from an arena.
+ * This function should not be called by the user of the rfc5444 API!
+ * @param arena pointer to arena
+ * @param size number of bytes
+ * @param chunk_size size of newly allocated chunks,
+ *   0 for RFC5444_ARENA_CHUNK
+ * @return pointer to memory, NULL if out of memory
+ */
+void *
+_rfc5444_arena_alloc(struct rfc5444_arena *arena, size_t size, size_t chunk_size) {
+  struct rfc5444_arena_chunk *chunk, *next;
+  void *ptr;
+
+  /* keep all objects aligned */
+  size = (size + RFC5444_ARENA_ALIGN - 1) & ~((size_t)RFC5444_ARENA_ALIGN - 1);
+
+  chunk = arena->current;
+  while (chunk == NULL || arena->used + size > chunk->size) {
+    next = chunk == NULL ? arena->first : chunk->next;
+    if (next == NULL) {
+      /* no chunk left, get a new one from the heap */
+      if (chunk_size == 0) {
+        chunk_size = RFC5444_ARENA_CHUNK;
+      }
+      if (chunk_size < size) {
+        chunk_size = size;
+      }
+
+      next = malloc(sizeof(*next) + chunk_size);
+      if (next == NULL) {
+        return NULL;
+      }
+      next->next = NULL;
+      next->size = chunk_size;
+
+      if (chunk == NULL) {
+        arena->first = next;
+      }
+      else {
+        chunk->next = next;
+      }
+      arena->chunk_count++;
+    }
+
+    chunk = next;
+    arena->used = 0;
+  }
+
+  arena->current = chunk;
+  ptr = &chunk->data[arena->used];
+  arena->used += size;
+
+  memset(ptr, 0, size);
+  return ptr;
+}
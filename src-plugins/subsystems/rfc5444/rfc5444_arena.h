@@ -0,0 +1,140 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+
+#ifndef RFC5444_ARENA_H_
+#define RFC5444_ARENA_H_
+
+#include "common/common_types.h"
+
+enum {
+  /*! default size of a memory chunk of an arena */
+  RFC5444_ARENA_CHUNK = 16384,
+
+  /*! alignment of objects allocated from an arena */
+  RFC5444_ARENA_ALIGN = 16,
+};
+
+/**
+ * Memory chunk of an arena
+ */
+struct rfc5444_arena_chunk {
+  /*! next chunk of the arena, NULL if this is the last one */
+  struct rfc5444_arena_chunk *next;
+
+  /*! number of usable bytes in this chunk */
+  size_t size;
+
+  /*! usable memory of chunk */
+  uint8_t data[] __attribute__((aligned(RFC5444_ARENA_ALIGN)));
+};
+
+/**
+ * Bump allocator for the transient objects of the reader and writer.
+ * The objects are never freed one by one, they are all released
+ * at once and the memory chunks are kept for the next use.
+ */
+struct rfc5444_arena {
+  /*! first memory chunk, NULL if none has been allocated yet */
+  struct rfc5444_arena_chunk *first;
+
+  /*! chunk used for the next allocation */
+  struct rfc5444_arena_chunk *current;
+
+  /*! number of bytes used in the current chunk */
+  size_t used;
+
+  /*! number of chunks allocated from the heap */
+  uint32_t chunk_count;
+};
+
+/**
+ * Allocation state of an arena to release all
+ * later allocations at once
+ */
+struct rfc5444_arena_mark {
+  /*! current chunk of the arena */
+  struct rfc5444_arena_chunk *chunk;
+
+  /*! number of used bytes in the current chunk */
+  size_t used;
+};
+
+void _rfc5444_arena_free(struct rfc5444_arena *arena);
+void *_rfc5444_arena_alloc(struct rfc5444_arena *arena, size_t size, size_t chunk_size);
+
+/**
+ * Remember the allocation state of an arena
+ * @param arena pointer to arena
+ * @param mark pointer to buffer for allocation state
+ */
+static INLINE void
+_rfc5444_arena_get_mark(struct rfc5444_arena *arena, struct rfc5444_arena_mark *mark) {
+  mark->chunk = arena->current;
+  mark->used = arena->used;
+}
+
+/**
+ * Release all objects allocated from an arena since
+ * a mark has been set
+ * @param arena pointer to arena
+ * @param mark allocation state of arena
+ */
+static INLINE void
+_rfc5444_arena_release(struct rfc5444_arena *arena, struct rfc5444_arena_mark *mark) {
+  arena->current = mark->chunk;
+  arena->used = mark->used;
+}
+
+/**
+ * Release all objects allocated from an arena
+ * @param arena pointer to arena
+ */
+static INLINE void
+_rfc5444_arena_reset(struct rfc5444_arena *arena) {
+  arena->current = arena->first;
+  arena->used = 0;
+}
+
+#endif /* RFC5444_ARENA_H_ */
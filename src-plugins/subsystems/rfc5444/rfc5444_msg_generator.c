@@ -90,6 +90,12 @@ static int _compress_address(struct _rfc5444_internal_addr_compress_session *acs
 static void _write_addresses(struct rfc5444_writer *writer, struct rfc5444_writer_message *msg,
     struct list_entity *fragment_addrs);
 static void _write_msgheader(struct rfc5444_writer *writer, struct rfc5444_writer_message *msg);
+static void _plan_addresses(struct rfc5444_writer *writer, struct rfc5444_writer_message *msg);
+static int _estimate_addresses(struct rfc5444_writer *writer,
+    struct rfc5444_writer_address **addrs, size_t count);
+static int _cmp_planned_address(const void *p1, const void *p2);
+static bool _use_fanout(struct rfc5444_writer *writer,
+    struct rfc5444_writer_message *msg, size_t target_count);
 static uint8_t *_write_addresstlvs(struct rfc5444_writer *writer, struct rfc5444_writer_message *msg,
     struct rfc5444_writer_address *first, struct rfc5444_writer_address *last, uint8_t *ptr);
 
@@ -253,6 +259,10 @@ rfc5444_writer_create_message(struct rfc5444_writer *writer, uint8_t msgid,
   /* join mandatory and normal address list */
   list_merge(&msg->_addr_head, &msg->_non_mandatory_addr_head);
 
+  if (writer->plan_addresses) {
+    _plan_addresses(writer, msg);
+  }
+
   /* initialize list of current addresses */
   list_init_head(&current_list);
   not_fragmented = true;
@@ -428,6 +438,91 @@ bool rfc5444_writer_alltargets_selector(struct rfc5444_writer *writer __attribut
   return true;
 }
 
+/**
+ * Write a complete binary rfc5444 message into the buffers of
+ * all selected targets without modifying it, e.g. to resend a message
+ * reported by the messageGenerated callback with a new sequence number.
+ * This function must NOT be called from the rfc5444 writer callbacks.
+ * @param writer pointer to writer context
+ * @param msg pointer to binary message
+ * @param len number of bytes of message
+ * @param useIf pointer to interface selector
+ * @param param last parameter of interface selector
+ * @return RFC5444_OKAY if the message was put into the writer buffer,
+ *   RFC5444_... if an error happened
+ */
+enum rfc5444_result
+rfc5444_writer_add_binary_msg(struct rfc5444_writer *writer,
+    const uint8_t *msg, size_t len,
+    rfc5444_writer_targetselector useIf, void *param) {
+  struct rfc5444_writer_target *target;
+  struct rfc5444_writer_shared_msg *shared;
+  size_t max, target_count;
+
+#if WRITER_STATE_MACHINE == true
+  assert(writer->_state == RFC5444_WRITER_NONE);
+#endif
+
+  /* check if message fits into all selected targets */
+  target_count = 0;
+  list_for_each_element(&writer->_targets, target, _target_node) {
+    if (!useIf(writer, target, param)) {
+      continue;
+    }
+    target_count++;
+
+    if (target->_is_flushed) {
+      /* begin a new packet */
+      _rfc5444_writer_begin_packet(writer,target);
+    }
+
+    max = target->_pkt.max - (target->_pkt.header + target->_pkt.added + target->_pkt.allocated);
+    if (len > max) {
+      /* message too long for this target */
+      return RFC5444_FW_MESSAGE_TOO_LONG;
+    }
+  }
+
+  shared = NULL;
+  if (writer->fanout && target_count > 1) {
+    shared = _rfc5444_writer_get_shared_msg(writer, len);
+  }
+  if (shared != NULL) {
+    memcpy(shared->data, msg, len);
+    shared->length = len;
+    writer->fanout_stats.messages++;
+  }
+
+  list_for_each_element(&writer->_targets, target, _target_node) {
+    if (!useIf(writer, target, param)) {
+      continue;
+    }
+
+    /* check if we have to flush the message buffer */
+    if (target->_pkt.header + target->_pkt.added + target->_pkt.set + target->_bin_msgs_size + len
+        > target->_pkt.max) {
+      /* flush the old packet */
+      rfc5444_writer_flush(writer, target, false);
+
+      /* begin a new one */
+      _rfc5444_writer_begin_packet(writer,target);
+    }
+
+    if (shared != NULL && _rfc5444_writer_attach_shared_msg(target, shared)) {
+      writer->fanout_stats.references++;
+      continue;
+    }
+
+    memcpy(_rfc5444_writer_get_msg_end(target), msg, len);
+    target->_bin_msgs_size += len;
+  }
+
+  if (shared != NULL) {
+    _rfc5444_writer_release_shared_msg(writer, shared);
+  }
+  return RFC5444_OKAY;
+}
+
 /**
  * Write a binary rfc5444 message into the writers buffer to
  * forward it. This function handles the modification of hopcount
@@ -449,11 +544,12 @@ rfc5444_writer_forward_msg(struct rfc5444_writer *writer,
     struct rfc5444_reader_tlvblock_context *context, uint8_t *msg, size_t len) {
   struct rfc5444_writer_target *target;
   struct rfc5444_writer_message *rfc5444_msg;
+  struct rfc5444_writer_shared_msg *shared;
   int cnt, hopcount = -1, hoplimit = -1;
   uint16_t size;
   uint8_t flags, addr_len;
   uint8_t *ptr;
-  size_t max_msg_size;
+  size_t max_msg_size, target_count;
 
 #if WRITER_STATE_MACHINE == true
   assert(writer->_state == RFC5444_WRITER_NONE);
@@ -473,12 +569,14 @@ rfc5444_writer_forward_msg(struct rfc5444_writer *writer,
 
   /* check if message is small enough to be forwarded */
   max_msg_size = 0;
+  target_count = 0;
   list_for_each_element(&writer->_targets, target, _target_node) {
     size_t max;
 
     if (!rfc5444_msg->forward_target_selector(target, context, msg, len)) {
       continue;
     }
+    target_count++;
 
     if (target->_is_flushed) {
       /* begin a new packet */
@@ -529,6 +627,24 @@ rfc5444_writer_forward_msg(struct rfc5444_writer *writer,
     return RFC5444_OKAY;
   }
 
+  /* modify hoplimit and hopcount only once for all targets */
+  shared = NULL;
+  if (writer->fanout && target_count > 1) {
+    shared = _rfc5444_writer_get_shared_msg(writer, len);
+  }
+  if (shared != NULL) {
+    memcpy(shared->data, msg, len);
+    shared->length = len;
+    writer->fanout_stats.messages++;
+
+    if (hoplimit != -1) {
+      shared->data[hoplimit]--;
+    }
+    if (hopcount != -1) {
+      shared->data[hopcount]++;
+    }
+  }
+
   /* forward message */
   list_for_each_element(&writer->_targets, target, _target_node) {
     if (!rfc5444_msg->forward_target_selector(target, context, msg, len)) {
@@ -545,25 +661,38 @@ rfc5444_writer_forward_msg(struct rfc5444_writer *writer,
       _rfc5444_writer_begin_packet(writer,target);
     }
 
-    ptr = &target->_pkt.buffer[target->_pkt.header + target->_pkt.added
-                            + target->_pkt.allocated + target->_bin_msgs_size];
-    memcpy(ptr, msg, len);
-    target->_bin_msgs_size += len;
-
-    /* correct hoplimit if necesssary */
-    if (hoplimit != -1) {
-      ptr[hoplimit]--;
+    if (shared != NULL && _rfc5444_writer_attach_shared_msg(target, shared)) {
+      writer->fanout_stats.references++;
+    }
+    else if (shared != NULL) {
+      /* no free reference in packet, copy modified message */
+      memcpy(_rfc5444_writer_get_msg_end(target), shared->data, len);
+      target->_bin_msgs_size += len;
     }
+    else {
+      ptr = _rfc5444_writer_get_msg_end(target);
+      memcpy(ptr, msg, len);
+      target->_bin_msgs_size += len;
 
-    /* correct hopcount if necessary */
-    if (hopcount != -1) {
-      ptr[hopcount]++;
+      /* correct hoplimit if necesssary */
+      if (hoplimit != -1) {
+        ptr[hoplimit]--;
+      }
+
+      /* correct hopcount if necessary */
+      if (hopcount != -1) {
+        ptr[hopcount]++;
+      }
     }
 
     if (writer->forwarding_notifier) {
       writer->forwarding_notifier(target);
     }
   }
+
+  if (shared != NULL) {
+    _rfc5444_writer_release_shared_msg(writer, shared);
+  }
   return RFC5444_OKAY;
 }
 
@@ -739,6 +868,155 @@ rfc5444_writer_set_msg_seqno(struct rfc5444_writer *writer __attribute__ ((unuse
   msg->seqno = seqno;
 }
 
+/**
+ * Reorder the addresses of a message before compression. Addresses are
+ * grouped by prefix length and sorted by their binary representation,
+ * which puts addresses with the longest common head next to each
+ * other. Mandatory addresses stay in front of all others.
+ * The new order is only used if it is estimated to be smaller than
+ * the order of the content providers.
+ * @param writer pointer to rfc5444 writer
+ * @param msg pointer to message
+ */
+static void
+_plan_addresses(struct rfc5444_writer *writer, struct rfc5444_writer_message *msg) {
+  struct rfc5444_writer_address *addr, **plan;
+  size_t count, i;
+  int old_size, new_size;
+
+  writer->planner_stats.messages++;
+  writer->planner_stats.last_bytes_saved = 0;
+
+  count = msg->_addr_tree.count;
+  if (count < 2) {
+    return;
+  }
+
+  if (count > writer->_plan_size) {
+    plan = realloc(writer->_plan, count * sizeof(*plan));
+    if (plan == NULL) {
+      /* keep original order */
+      return;
+    }
+    writer->_plan = plan;
+    writer->_plan_size = count;
+  }
+
+  i = 0;
+  list_for_each_element(&msg->_addr_head, addr, _addr_list_node) {
+    writer->_plan[i++] = addr;
+  }
+
+  old_size = _estimate_addresses(writer, writer->_plan, count);
+  qsort(writer->_plan, count, sizeof(*writer->_plan), _cmp_planned_address);
+  new_size = _estimate_addresses(writer, writer->_plan, count);
+
+  if (new_size >= old_size) {
+    /* content providers did a better job */
+    return;
+  }
+
+  /* rebuild address list in planned order */
+  list_init_head(&msg->_addr_head);
+  for (i = 0; i < count; i++) {
+    list_add_tail(&msg->_addr_head, &writer->_plan[i]->_addr_list_node);
+  }
+
+  writer->planner_stats.reordered++;
+  writer->planner_stats.bytes_saved += (old_size - new_size);
+  writer->planner_stats.last_bytes_saved = old_size - new_size;
+}
+
+/**
+ * Estimate the size of address blocks and address TLVs for a
+ * sequence of addresses. Each address either continues the block
+ * of its predecessor (sharing their common head) or starts a new block,
+ * whatever is cheaper. Each TLV either continues the TLV of the
+ * predecessor (as single or multivalue TLV) or starts a new one.
+ * @param writer pointer to rfc5444 writer
+ * @param addrs array of addresses
+ * @param count number of addresses in array
+ * @return estimated number of bytes
+ */
+static int
+_estimate_addresses(struct rfc5444_writer *writer,
+    struct rfc5444_writer_address **addrs, size_t count) {
+  struct rfc5444_writer_addrtlv *tlv, *last_tlv;
+  const uint8_t *addrptr, *last_addrptr;
+  size_t i;
+  int size, head, new_cost, continue_cost;
+
+  size = 0;
+  for (i = 0; i < count; i++) {
+    /* new address block: header, flags, head, address, prefix and tlvblock length */
+    new_cost = 2 + 1 + writer->msg_addr_len + 1 + 2;
+    for (tlv = addrs[i]->_addrtlvs; tlv < addrs[i]->_addrtlvs + addrs[i]->_addrtlv_count; tlv++) {
+      /* type, flags, indices, length and value */
+      new_cost += 5 + tlv->length;
+    }
+
+    if (i == 0) {
+      size += new_cost;
+      continue;
+    }
+
+    /* continue address block with mid part */
+    addrptr = netaddr_get_binptr(&addrs[i]->address);
+    last_addrptr = netaddr_get_binptr(&addrs[i-1]->address);
+    for (head = 0; head < writer->msg_addr_len; head++) {
+      if (addrptr[head] != last_addrptr[head]) {
+        break;
+      }
+    }
+    continue_cost = writer->msg_addr_len - head;
+
+    if (netaddr_get_prefix_length(&addrs[i]->address)
+        != netaddr_get_prefix_length(&addrs[i-1]->address)) {
+      /* block with multiple prefix lengths */
+      continue_cost++;
+    }
+
+    for (tlv = addrs[i]->_addrtlvs; tlv < addrs[i]->_addrtlvs + addrs[i]->_addrtlv_count; tlv++) {
+      last_tlv = _rfc5444_writer_find_addrtlv(addrs[i-1], tlv->tlvtype->_full_type);
+      if (last_tlv == NULL || last_tlv->length != tlv->length) {
+        /* new TLV */
+        continue_cost += 5 + tlv->length;
+      }
+      else if (memcmp(last_tlv->value, tlv->value, tlv->length) != 0) {
+        /* additional value in multivalue TLV */
+        continue_cost += tlv->length;
+      }
+    }
+
+    size += continue_cost < new_cost ? continue_cost : new_cost;
+  }
+  return size;
+}
+
+/**
+ * Comparator for the address compression planner
+ * @param p1 pointer to pointer of first address
+ * @param p2 pointer to pointer of second address
+ * @return <0, 0 or >0 like memcmp
+ */
+static int
+_cmp_planned_address(const void *p1, const void *p2) {
+  const struct rfc5444_writer_address *a1, *a2;
+
+  a1 = *(struct rfc5444_writer_address * const *)p1;
+  a2 = *(struct rfc5444_writer_address * const *)p2;
+
+  if (a1->_mandatory_addr != a2->_mandatory_addr) {
+    return a1->_mandatory_addr ? -1 : 1;
+  }
+  if (netaddr_get_prefix_length(&a1->address) != netaddr_get_prefix_length(&a2->address)) {
+    return (int)netaddr_get_prefix_length(&a2->address)
+        - (int)netaddr_get_prefix_length(&a1->address);
+  }
+  return memcmp(netaddr_get_binptr(&a1->address), netaddr_get_binptr(&a2->address),
+      netaddr_get_binlength(&a1->address));
+}
+
 /**
  * Update address compression session when a potential address block
  * is finished.
@@ -858,15 +1136,14 @@ _compress_address(struct _rfc5444_internal_addr_compress_session *acs,
   }
 
   /* calculate tlv flags */
-  avl_for_each_element(&addr->_addrtlv_tree, tlv, addrtlv_node) {
+  for (tlv = addr->_addrtlvs; tlv < addr->_addrtlvs + addr->_addrtlv_count; tlv++) {
     tlvtype = tlv->tlvtype;
 
     tlv->_same_length = false;
     tlv->_same_value = false;
 
     if (last_addr) {
-      last_tlv = avl_find_element(&last_addr->_addrtlv_tree,
-          &tlvtype->_full_type, last_tlv, addrtlv_node);
+      last_tlv = _rfc5444_writer_find_addrtlv(last_addr, tlvtype->_full_type);
       if (last_tlv && last_tlv->length == tlv->length) {
         tlv->_same_length = true;
         tlv->_same_value = memcmp(tlv->value, last_tlv->value, tlv->length) == 0;
@@ -908,7 +1185,7 @@ _compress_address(struct _rfc5444_internal_addr_compress_session *acs,
     new_cost += 2;
 
     /* calculate costs for breaking/continuing tlv sequences */
-    avl_for_each_element(&addr->_addrtlv_tree, tlv, addrtlv_node) {
+    for (tlv = addr->_addrtlvs; tlv < addr->_addrtlvs + addr->_addrtlv_count; tlv++) {
       tlvtype = tlv->tlvtype;
 
       /* type + flags */
@@ -984,7 +1261,7 @@ _compress_address(struct _rfc5444_internal_addr_compress_session *acs,
     }
 
     /* update internal tlv calculation */
-    avl_for_each_element(&addr->_addrtlv_tree, tlv, addrtlv_node) {
+    for (tlv = addr->_addrtlvs; tlv < addr->_addrtlvs + addr->_addrtlv_count; tlv++) {
       tlvtype = tlv->tlvtype;
 
       if (closed || !tlv->_same_length) {
@@ -1103,7 +1380,7 @@ _write_addresstlvs(struct rfc5444_writer *writer, struct rfc5444_writer_message
   /* loop over all addresses */
   prev_addr = NULL;
   list_for_element_range(first, last, addr, _addr_fragment_node) {
-    avl_for_each_element(&addr->_addrtlv_tree, tlv, addrtlv_node) {
+    for (tlv = addr->_addrtlvs; tlv < addr->_addrtlvs + addr->_addrtlv_count; tlv++) {
       tlvtype = tlv->tlvtype;
 
       if (!list_is_empty(&tlvtype->_current_tlv_list)) {
@@ -1350,6 +1627,32 @@ _write_msgheader(struct rfc5444_writer *writer, struct rfc5444_writer_message *m
   *ptr++ = total_size & 255;
 }
 
+/**
+ * @param writer pointer to writer context
+ * @param msg message that is finalized
+ * @param target_count number of targets selected for the message
+ * @return true if the message should be written only once and
+ *   be referenced by all target packets
+ */
+static bool
+_use_fanout(struct rfc5444_writer *writer,
+    struct rfc5444_writer_message *msg, size_t target_count) {
+  struct rfc5444_writer_postprocessor *processor;
+
+  if (!writer->fanout || target_count < 2) {
+    return false;
+  }
+
+  /* target specific processors need a copy of the message per target */
+  avl_for_each_element(&writer->_processors, processor, _node) {
+    if (processor->target_specific
+        && processor->is_matching_signature(processor, msg->type)) {
+      return false;
+    }
+  }
+  return true;
+}
+
 /**
  * Finalize a message fragment, copy it into the packet buffer and
  * cleanup message internal data.
@@ -1368,9 +1671,10 @@ _finalize_message_fragment(struct rfc5444_writer *writer, struct rfc5444_writer_
   struct rfc5444_writer_content_provider *prv;
   struct rfc5444_writer_target *target;
   struct rfc5444_writer_address *addr, *first, *last;
+  struct rfc5444_writer_shared_msg *shared;
   uint8_t *ptr, *firstcopy;
-  size_t msg_minsize, firstcopy_size, msg_size;
-  bool error;
+  size_t msg_minsize, firstcopy_size, msg_size, target_count;
+  bool error, processed;
 
   /* reset optional tlv length */
   writer->_msg.set = 0;
@@ -1436,13 +1740,16 @@ _finalize_message_fragment(struct rfc5444_writer *writer, struct rfc5444_writer_
   firstcopy = NULL;
   firstcopy_size = 0;
   ptr = NULL;
+  processed = false;
 
   /* 1.) first flush all interfaces that have full buffers */
+  target_count = 0;
   list_for_each_element(&writer->_targets, target, _target_node) {
     /* do we need to handle this interface ? */
     if (!useIf(writer, target, param)) {
       continue;
     }
+    target_count++;
 
     /* calculate total size of packet and message, see if it fits into the current packet */
     if (target->_pkt.header + target->_pkt.added + target->_pkt.set + target->_bin_msgs_size
@@ -1458,6 +1765,12 @@ _finalize_message_fragment(struct rfc5444_writer *writer, struct rfc5444_writer_
   }
 
   /* 2.) copy a interface-unspecific (but post-processed) message into all buffers */
+  shared = NULL;
+  if (_use_fanout(writer, msg, target_count)) {
+    shared = _rfc5444_writer_get_shared_msg(writer,
+        msg_minsize + writer->_msg.allocated + msg->_bin_addr_size);
+  }
+
   list_for_each_element(&writer->_targets, target, _target_node) {
     /* do we need to handle this interface ? */
     if (!useIf(writer, target, param)) {
@@ -1465,18 +1778,17 @@ _finalize_message_fragment(struct rfc5444_writer *writer, struct rfc5444_writer_
     }
 
     /* get pointer to end of _pkt buffer */
-    ptr = &target->_pkt.buffer[target->_pkt.header + target->_pkt.added
-                                 + target->_pkt.allocated + target->_bin_msgs_size];
+    ptr = _rfc5444_writer_get_msg_end(target);
     if (!firstcopy) {
       /* first target. Assemble message and run interface-unspecific transformers */
-      firstcopy = ptr;
+      firstcopy = shared != NULL ? shared->data : ptr;
 
       /* copy message header and message tlvs into packet buffer */
-      memcpy(ptr, writer->_msg.buffer, msg_minsize + writer->_msg.set);
+      memcpy(firstcopy, writer->_msg.buffer, msg_minsize + writer->_msg.set);
 
       /* copy address blocks and address tlvs into packet buffer */
-      ptr += msg_minsize + writer->_msg.set;
-      memcpy(ptr, &writer->_msg.buffer[msg_minsize + writer->_msg.allocated], msg->_bin_addr_size);
+      memcpy(firstcopy + msg_minsize + writer->_msg.set,
+          &writer->_msg.buffer[msg_minsize + writer->_msg.allocated], msg->_bin_addr_size);
 
       /* remember position of first copy */
       firstcopy_size = msg_minsize + writer->_msg.set + msg->_bin_addr_size;
@@ -1487,39 +1799,77 @@ _finalize_message_fragment(struct rfc5444_writer *writer, struct rfc5444_writer_
             && !processor->target_specific) {
           if (processor->process(processor, target, msg, firstcopy, &firstcopy_size)) {
             /* error, we have not modified the _bin_msgs_size, so we can just return */
+            if (shared != NULL) {
+              _rfc5444_writer_release_shared_msg(writer, shared);
+            }
             return;
           }
         }
       }
+
+      if (shared != NULL) {
+        shared->length = firstcopy_size;
+        writer->fanout_stats.messages++;
+      }
     }
-    else {
+
+    if (shared != NULL) {
+      /* reference the message, copy it only if the packet has no free slot */
+      if (_rfc5444_writer_attach_shared_msg(target, shared)) {
+        writer->fanout_stats.references++;
+      }
+      else {
+        memcpy(ptr, shared->data, shared->length);
+        target->_bin_msgs_size += shared->length;
+      }
+    }
+    else if (ptr != firstcopy) {
       /* we already have a copy of the message in the first targets buffer */
       memcpy(ptr, firstcopy, firstcopy_size);
     }
   }
 
-  /* run target-specific processors */
-  list_for_each_element(&writer->_targets, target, _target_node) {
-    error = false;
-
-    /* do we need to handle this interface ? */
-    if (!useIf(writer, target, param)) {
-      continue;
+  /* report unprocessed message to creator */
+  if (firstcopy != NULL && msg->messageGenerated) {
+    avl_for_each_element(&writer->_processors, processor, _node) {
+      if (processor->is_matching_signature(processor, msg->type)) {
+        processed = true;
+        break;
+      }
+    }
+    if (!processed) {
+      msg->messageGenerated(writer, msg, firstcopy, firstcopy_size, not_fragmented);
     }
+  }
 
-    msg_size = firstcopy_size;
-    avl_for_each_element(&writer->_processors, processor, _node) {
-      if (processor->is_matching_signature(processor, msg->type)
-          && processor->target_specific) {
-        if (processor->process(processor, target, msg, ptr, &msg_size)) {
-          error = true;
+  if (shared != NULL) {
+    /* all targets have the message now, drop the reference of the writer */
+    _rfc5444_writer_release_shared_msg(writer, shared);
+  }
+  else {
+    /* run target-specific processors */
+    list_for_each_element(&writer->_targets, target, _target_node) {
+      error = false;
+
+      /* do we need to handle this interface ? */
+      if (!useIf(writer, target, param)) {
+        continue;
+      }
+
+      msg_size = firstcopy_size;
+      avl_for_each_element(&writer->_processors, processor, _node) {
+        if (processor->is_matching_signature(processor, msg->type)
+            && processor->target_specific) {
+          if (processor->process(processor, target, msg, ptr, &msg_size)) {
+            error = true;
+          }
         }
       }
-    }
 
-    if (!error) {
-      /* increase byte count of packet */
-      target->_bin_msgs_size += msg_size;
+      if (!error) {
+        /* increase byte count of packet */
+        target->_bin_msgs_size += msg_size;
+      }
     }
   }
 
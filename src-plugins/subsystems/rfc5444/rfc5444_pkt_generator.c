@@ -51,6 +51,11 @@
 #include "rfc5444_api_config.h"
 
 static void _write_pktheader(struct rfc5444_writer_target *target);
+static bool _has_pkt_postprocessor(struct rfc5444_writer *writer);
+static void _copy_shared_msgs(struct rfc5444_writer *writer,
+    struct rfc5444_writer_target *target);
+static void _send_fragments(struct rfc5444_writer *writer,
+    struct rfc5444_writer_target *target, size_t hdr_len);
 
 /**
  * Internal function to start generation of a packet
@@ -164,11 +169,17 @@ rfc5444_writer_flush(struct rfc5444_writer *writer,
     len += 2;
   }
 
+  /* packet post-processors and sendPacket need a contiguous packet */
+  if (target->_shared_count > 0
+      && (target->sendPacketv == NULL || _has_pkt_postprocessor(writer))) {
+    _copy_shared_msgs(writer, target);
+  }
+
   /* compress packet buffer */
-  if (target->_bin_msgs_size) {
+  if (target->_bin_msgs_size > target->_shared_size) {
     memmove(&target->_pkt.buffer[len + target->_pkt.added + target->_pkt.set],
         &target->_pkt.buffer[target->_pkt.header + target->_pkt.added + target->_pkt.allocated],
-        target->_bin_msgs_size);
+        target->_bin_msgs_size - target->_shared_size);
   }
 
   /* run post-processors */
@@ -185,12 +196,17 @@ rfc5444_writer_flush(struct rfc5444_writer *writer,
     }
   }
 
-  if (!error) {
+  if (!error && target->_shared_count > 0) {
+    /* send packet header and local messages together with the shared ones */
+    _send_fragments(writer, target, len + target->_pkt.added + target->_pkt.set);
+  }
+  else if (!error) {
     /* send packet */
     target->sendPacket(writer, target, target->_pkt.buffer,total);
   }
 
   /* cleanup length information */
+  _rfc5444_writer_release_shared_refs(writer, target);
   target->_pkt.set  = 0;
   target->_bin_msgs_size = 0;
 
@@ -206,6 +222,52 @@ rfc5444_writer_flush(struct rfc5444_writer *writer,
 #endif
 }
 
+/**
+ * Internal function to let the current packet of a target reference
+ * a shared message instead of copying it into the packet buffer.
+ * The caller has to make sure the message fits into the packet.
+ * @param target pointer to writer target
+ * @param shared shared message
+ * @return true if the message was added, false if the packet cannot
+ *   reference more shared messages
+ */
+bool
+_rfc5444_writer_attach_shared_msg(struct rfc5444_writer_target *target,
+    struct rfc5444_writer_shared_msg *shared) {
+  struct rfc5444_writer_shared_ref *ref;
+
+  if (target->_shared_count >= RFC5444_WRITER_SHARED_REFS) {
+    return false;
+  }
+
+  ref = &target->_shared[target->_shared_count++];
+  ref->msg = shared;
+  ref->offset = target->_bin_msgs_size - target->_shared_size;
+
+  shared->_refcount++;
+  target->_bin_msgs_size += shared->length;
+  target->_shared_size += shared->length;
+  return true;
+}
+
+/**
+ * Internal function to drop all shared message references
+ * of the current packet of a target
+ * @param writer pointer to writer context
+ * @param target pointer to writer target
+ */
+void
+_rfc5444_writer_release_shared_refs(struct rfc5444_writer *writer,
+    struct rfc5444_writer_target *target) {
+  uint32_t i;
+
+  for (i=0; i<target->_shared_count; i++) {
+    _rfc5444_writer_release_shared_msg(writer, target->_shared[i].msg);
+  }
+  target->_shared_count = 0;
+  target->_shared_size = 0;
+}
+
 /**
  * Adds a tlv to a packet.
  * This function must not be called outside the packet add_tlv callback.
@@ -338,3 +400,105 @@ _write_pktheader(struct rfc5444_writer_target *target) {
     *ptr++ = (len & 255);
   }
 }
+
+/**
+ * @param writer pointer to writer context
+ * @return true if a packet post-processor is registered
+ */
+static bool
+_has_pkt_postprocessor(struct rfc5444_writer *writer) {
+  struct rfc5444_writer_postprocessor *processor;
+
+  avl_for_each_element(&writer->_processors, processor, _node) {
+    if (processor->is_matching_signature(
+        processor, RFC5444_WRITER_PKT_POSTPROCESSOR)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * Copy the shared messages of the current packet into the packet
+ * buffer of a target, between the local messages they were added
+ * after. The local messages are moved back to front, so no byte
+ * is overwritten before it was moved.
+ * @param writer pointer to writer context
+ * @param target pointer to writer target
+ */
+static void
+_copy_shared_msgs(struct rfc5444_writer *writer,
+    struct rfc5444_writer_target *target) {
+  struct rfc5444_writer_shared_ref *ref;
+  uint8_t *msgs;
+  size_t local_end, shift;
+  uint32_t i;
+
+  msgs = &target->_pkt.buffer[target->_pkt.header + target->_pkt.added + target->_pkt.allocated];
+  local_end = target->_bin_msgs_size - target->_shared_size;
+  shift = target->_shared_size;
+
+  for (i = target->_shared_count; i > 0; i--) {
+    ref = &target->_shared[i-1];
+
+    /* move local messages behind the shared message to their final position */
+    memmove(&msgs[ref->offset + shift], &msgs[ref->offset], local_end - ref->offset);
+
+    shift -= ref->msg->length;
+    memcpy(&msgs[ref->offset + shift], ref->msg->data, ref->msg->length);
+
+    local_end = ref->offset;
+  }
+
+  writer->fanout_stats.copied += target->_shared_count;
+
+  /* all messages are now part of the packet buffer */
+  _rfc5444_writer_release_shared_refs(writer, target);
+}
+
+/**
+ * Send the current packet of a target as an array of fragments,
+ * consisting of the compressed packet buffer and the shared messages
+ * @param writer pointer to writer context
+ * @param target pointer to writer target
+ * @param hdr_len length of packet header including packet TLVs
+ */
+static void
+_send_fragments(struct rfc5444_writer *writer,
+    struct rfc5444_writer_target *target, size_t hdr_len) {
+  struct iovec iov[RFC5444_WRITER_SHARED_REFS * 2 + 1];
+  struct rfc5444_writer_shared_ref *ref;
+  size_t start, end;
+  uint32_t i;
+  int count;
+
+  count = 0;
+  start = 0;
+  for (i=0; i<target->_shared_count; i++) {
+    ref = &target->_shared[i];
+
+    /* packet header and local messages in front of the shared message */
+    end = hdr_len + ref->offset;
+    if (end > start) {
+      iov[count].iov_base = &target->_pkt.buffer[start];
+      iov[count].iov_len = end - start;
+      count++;
+      start = end;
+    }
+
+    iov[count].iov_base = ref->msg->data;
+    iov[count].iov_len = ref->msg->length;
+    count++;
+  }
+
+  /* local messages behind the last shared message */
+  end = hdr_len + target->_bin_msgs_size - target->_shared_size;
+  if (end > start) {
+    iov[count].iov_base = &target->_pkt.buffer[start];
+    iov[count].iov_len = end - start;
+    count++;
+  }
+
+  writer->fanout_stats.packets++;
+  target->sendPacketv(writer, target, iov, count);
+}
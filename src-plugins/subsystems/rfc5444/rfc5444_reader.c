@@ -48,7 +48,6 @@
 
 #include "common/common_types.h"
 #include "common/avl.h"
-#include "common/avl_comp.h"
 #include "common/bitmap256.h"
 #include "rfc5444_reader.h"
 #include "rfc5444_api_config.h"
@@ -67,30 +66,37 @@
 static int _consumer_avl_comp(const void *k1, const void *k2);
 static uint16_t _calc_tlvconsumer_intorder(struct rfc5444_reader_tlvblock_consumer_entry *entry);
 static uint16_t _calc_tlvblock_intorder(struct rfc5444_reader_tlvblock_entry *entry);
-static int _compare_tlvtypes(struct rfc5444_reader_tlvblock_entry *tlv,
-    struct rfc5444_reader_tlvblock_consumer_entry *entry);
+static bool _match_tlv_index(struct rfc5444_reader_tlvblock_entry *tlv, uint8_t idx);
 static uint8_t _rfc5444_get_u8(uint8_t **ptr, uint8_t *end, enum rfc5444_result *result);
 static uint16_t _rfc5444_get_u16(uint8_t **ptr, uint8_t *end, enum rfc5444_result *result);
-static void _free_tlvblock(struct rfc5444_reader *parser, struct avl_tree *entries);
+static void _free_tlvblock(struct rfc5444_reader *parser, struct rfc5444_reader_tlvblock *block);
+static void _free_tlvlist(struct rfc5444_reader *parser, struct rfc5444_reader_tlvblock_entry *tlv);
 static int _parse_tlv(struct rfc5444_reader_tlvblock_entry *entry, uint8_t **ptr,
     uint8_t *eob, uint8_t addr_count);
 static int _parse_tlvblock(struct rfc5444_reader *parser,
-    struct avl_tree *tlvblock, uint8_t **ptr, uint8_t *eob, uint8_t addr_count);
+    struct rfc5444_reader_tlvblock *block, uint8_t **ptr, uint8_t *eob, uint8_t addr_count);
+static void _index_tlvblock(struct rfc5444_reader_tlvblock *block,
+    struct rfc5444_reader_tlvblock_entry *first);
 static int _schedule_tlvblock(struct rfc5444_reader_tlvblock_consumer *consumer,
-    struct rfc5444_reader_tlvblock_context *context, struct avl_tree *entries, uint8_t idx);
+    struct rfc5444_reader_tlvblock_context *context, struct rfc5444_reader_tlvblock *block, uint8_t idx);
 static int _parse_addrblock(struct rfc5444_reader_addrblock_entry *addr_entry,
     struct rfc5444_reader_tlvblock_context *tlv_context, uint8_t **ptr, uint8_t *eob);
+static int _expand_addrblock(struct rfc5444_reader *parser,
+    struct rfc5444_reader_addrblock_entry *addr_entry, uint8_t addr_len);
 static int _handle_message(struct rfc5444_reader *parser,
     struct rfc5444_reader_tlvblock_context *tlv_context, uint8_t **ptr, uint8_t *eob);
+static INLINE bool _overlap_consumer_entries(struct rfc5444_reader_tlvblock_consumer_entry *e1,
+    struct rfc5444_reader_tlvblock_consumer_entry *e2);
 static struct rfc5444_reader_tlvblock_consumer *_add_consumer(
     struct rfc5444_reader_tlvblock_consumer *, struct avl_tree *consumer_tree,
     struct rfc5444_reader_tlvblock_consumer_entry *entries, int entrycount);
 static void _free_consumer(struct avl_tree *consumer_tree,
     struct rfc5444_reader_tlvblock_consumer *consumer);
-static struct rfc5444_reader_addrblock_entry *_malloc_addrblock_entry(void);
-static struct rfc5444_reader_tlvblock_entry *_malloc_tlvblock_entry(void);
-static void _free_addrblock_entry(struct rfc5444_reader_addrblock_entry *entry);
-static void _free_tlvblock_entry(struct rfc5444_reader_tlvblock_entry *entry);
+static int _compile_dispatch_table(struct rfc5444_reader *parser);
+static struct rfc5444_reader_addrblock_entry *_malloc_addrblock_entry(struct rfc5444_reader *parser);
+static struct rfc5444_reader_tlvblock_entry *_malloc_tlvblock_entry(struct rfc5444_reader *parser);
+static void _free_addrblock_entry(struct rfc5444_reader *parser,
+    struct rfc5444_reader_addrblock_entry *entry);
 
 static uint8_t rfc5444_get_pktversion(uint8_t v);
 
@@ -103,15 +109,10 @@ rfc5444_reader_init(struct rfc5444_reader *context) {
   avl_init(&context->packet_consumer, _consumer_avl_comp, true);
   avl_init(&context->message_consumer, _consumer_avl_comp, true);
 
-  if (context->malloc_addrblock_entry == NULL)
-    context->malloc_addrblock_entry = _malloc_addrblock_entry;
-  if (context->malloc_tlvblock_entry == NULL)
-    context->malloc_tlvblock_entry = _malloc_tlvblock_entry;
+  memset(&context->_arena, 0, sizeof(context->_arena));
 
-  if (context->free_addrblock_entry == NULL)
-    context->free_addrblock_entry = _free_addrblock_entry;
-  if (context->free_tlvblock_entry == NULL)
-    context->free_tlvblock_entry = _free_tlvblock_entry;
+  context->_dispatch = NULL;
+  context->_dispatch_dirty = true;
 }
 
 /**
@@ -121,6 +122,12 @@ rfc5444_reader_init(struct rfc5444_reader *context) {
  */
 void
 rfc5444_reader_cleanup(struct rfc5444_reader *context) {
+  _rfc5444_arena_free(&context->_arena);
+
+  free(context->_dispatch);
+  context->_dispatch = NULL;
+  context->_dispatch_dirty = true;
+
   memset(&context->packet_consumer, 0, sizeof(context->packet_consumer));
   memset(&context->message_consumer, 0, sizeof(context->message_consumer));
 }
@@ -135,8 +142,9 @@ rfc5444_reader_cleanup(struct rfc5444_reader *context) {
 enum rfc5444_result
 rfc5444_reader_handle_packet(struct rfc5444_reader *parser, uint8_t *buffer, size_t length) {
   struct rfc5444_reader_tlvblock_context context;
-  struct avl_tree entries;
+  struct rfc5444_reader_tlvblock entries;
   struct rfc5444_reader_tlvblock_consumer *consumer, *last_started;
+  struct rfc5444_arena_mark mark;
   uint8_t *ptr, *eob;
   bool has_tlv;
   uint8_t first_byte;
@@ -155,6 +163,10 @@ rfc5444_reader_handle_packet(struct rfc5444_reader *parser, uint8_t *buffer, siz
   context.type = RFC5444_CONTEXT_PACKET;
   context.reader = parser;
 
+  /* the timestamp only belongs to this packet */
+  context.pkt_timestamp = parser->rx_timestamp;
+  parser->rx_timestamp = 0;
+
   /* read header of packet */
   first_byte = _rfc5444_get_u8(&ptr, eob, &result);
   context.pkt_version = rfc5444_get_pktversion(first_byte);
@@ -182,10 +194,14 @@ rfc5444_reader_handle_packet(struct rfc5444_reader *parser, uint8_t *buffer, siz
     return result;
   }
 
-  /* initialize avl_tree */
-  avl_init(&entries, avl_comp_uint32, true);
+  /* initialize packet tlv block */
+  entries.tlvs = NULL;
+  entries.count = 0;
   last_started = NULL;
 
+  /* all transient objects of this packet are released together */
+  _rfc5444_arena_get_mark(&parser->_arena, &mark);
+
   /* check for packet tlv */
   has_tlv = (context.pkt_flags & RFC5444_PKT_FLAG_TLV) != 0;
   if (has_tlv) {
@@ -193,8 +209,9 @@ rfc5444_reader_handle_packet(struct rfc5444_reader *parser, uint8_t *buffer, siz
     if (result != RFC5444_OKAY) {
       /*
        * error while parsing TLV block, do not jump to cleanup_parse packet because
-       * we have not allocated any resources at this point
+       * we have not called any consumer at this point
        */
+      _rfc5444_arena_release(&parser->_arena, &mark);
       return result;
     }
   }
@@ -253,6 +270,7 @@ cleanup_parse_packet:
     }
   }
   _free_tlvblock(parser, &entries);
+  _rfc5444_arena_release(&parser->_arena, &mark);
 
   /* do not tell caller about packet drop */
 #if DISALLOW_CONSUMER_CONTEXT_DROP == false
@@ -290,6 +308,7 @@ rfc5444_reader_add_message_consumer(struct rfc5444_reader *parser,
     struct rfc5444_reader_tlvblock_consumer *consumer,
     struct rfc5444_reader_tlvblock_consumer_entry *entries, size_t entrycount) {
   _add_consumer(consumer, &parser->message_consumer, entries, entrycount);
+  parser->_dispatch_dirty = true;
 }
 
 /**
@@ -305,7 +324,10 @@ rfc5444_reader_remove_packet_consumer(struct rfc5444_reader *parser,
 }
 
 /**
- * Remove a message/address consumer from the parser
+ * Remove a message/address consumer from the parser.
+ * This can be called from a consumer callback. The consumer will not
+ * be called again for the current message, but its memory must stay
+ * valid until the message has been processed.
  * @param parser pointer to parser context
  * @param consumer pointer to tlvblock consumer
  */
@@ -313,6 +335,7 @@ void
 rfc5444_reader_remove_message_consumer(struct rfc5444_reader *parser,
     struct rfc5444_reader_tlvblock_consumer *consumer) {
   _free_consumer(&parser->message_consumer, consumer);
+  parser->_dispatch_dirty = true;
 }
 
 /**
@@ -360,28 +383,24 @@ _calc_tlvblock_intorder(struct rfc5444_reader_tlvblock_entry *entry) {
 }
 
 /**
- * Checks if two internal types have the same tlv type
- * @param int_type1 first internal type
- * @param int_type2 second internal type
- * @param match_ext true if extension type is relevant
- * @return <0 if type1<type2, ==0 if type1==type2, >0 if type1>type2
+ * Checks if a TLV applies to an address index and calculates its
+ * value pointer for this index if the TLV is a multivalue TLV.
+ * @param tlv pointer to tlvblock entry
+ * @param idx index of current address, 0 for packet/message tlv block
+ * @return true if TLV applies to the index and has not been dropped
  */
-static int
-_compare_tlvtypes(struct rfc5444_reader_tlvblock_entry *tlv, struct rfc5444_reader_tlvblock_consumer_entry *entry) {
-  if (entry == NULL) {
-    if (tlv == NULL) {
-      return 0;
-    }
-    return -1;
-  }
-  if (tlv == NULL) {
-    return 1;
+static bool
+_match_tlv_index(struct rfc5444_reader_tlvblock_entry *tlv, uint8_t idx) {
+  if (!RFC5444_CONSUMER_DROP_ONLY(!bitmap256_get(&tlv->int_drop_tlv, idx), true)
+      || idx < tlv->index1 || idx > tlv->index2) {
+    return false;
   }
 
-  if (entry->match_type_ext) {
-    return (int)tlv->_order - _calc_tlvconsumer_intorder(entry);
+  if (tlv->_multivalue_tlv) {
+    /* calculate value pointer for multivalue tlv */
+    tlv->single_value = &tlv->_value[(size_t)(idx - tlv->index1) * tlv->length];
   }
-  return (int)tlv->type - (int)entry->type;
+  return true;
 }
 
 /**
@@ -425,15 +444,43 @@ _rfc5444_get_u16(uint8_t **ptr, uint8_t *end, enum rfc5444_result *error) {
 }
 
 /**
- * free a list of linked tlv_block entries
- * @param entries avl_tree of tlv_block entries
+ * free all entries of a parsed tlv block
+ * @param parser pointer to reader
+ * @param block pointer to tlv block
  */
 static void
-_free_tlvblock(struct rfc5444_reader *parser, struct avl_tree *entries) {
-  struct rfc5444_reader_tlvblock_entry *tlv, *ptr;
+_free_tlvblock(struct rfc5444_reader *parser, struct rfc5444_reader_tlvblock *block) {
+  uint16_t i;
 
-  avl_remove_all_elements(entries, tlv, node, ptr) {
+  if (parser->free_tlvblock_entry != NULL) {
+    for (i=0; i<block->count; i++) {
+      parser->free_tlvblock_entry(block->tlvs[i]);
+    }
+  }
+
+  /* the array itself is part of the arena */
+  block->tlvs = NULL;
+  block->count = 0;
+}
+
+/**
+ * free a list of tlv_block entries linked by their next_entry pointer
+ * @param parser pointer to reader
+ * @param tlv first entry of list, might be NULL
+ */
+static void
+_free_tlvlist(struct rfc5444_reader *parser, struct rfc5444_reader_tlvblock_entry *tlv) {
+  struct rfc5444_reader_tlvblock_entry *next;
+
+  if (parser->free_tlvblock_entry == NULL) {
+    /* entries are part of the arena */
+    return;
+  }
+
+  while (tlv != NULL) {
+    next = tlv->next_entry;
     parser->free_tlvblock_entry(tlv);
+    tlv = next;
   }
 }
 
@@ -542,8 +589,9 @@ _parse_tlv(struct rfc5444_reader_tlvblock_entry *entry, uint8_t **ptr, uint8_t *
 }
 
 /**
- * parse a TLV block into a list of linked tlvblock_entries.
- * @param tlvblock pointer to avl_tree to store generates tlvblock entries
+ * parse a TLV block into an indexed array of tlvblock_entries.
+ * @param parser pointer to reader
+ * @param block pointer to tlv block to store generated tlvblock entries
  * @param ptr pointer to pointer to begin of datastream, will be
  *   incremented to the first byte after the block if no error happened.
  *   Will be set to eob if an error happened.
@@ -553,12 +601,20 @@ _parse_tlv(struct rfc5444_reader_tlvblock_entry *entry, uint8_t **ptr, uint8_t *
  */
 static enum rfc5444_result
 _parse_tlvblock(struct rfc5444_reader *parser,
-    struct avl_tree *tlvblock, uint8_t **ptr, uint8_t *eob, uint8_t addr_count) {
+    struct rfc5444_reader_tlvblock *block, uint8_t **ptr, uint8_t *eob, uint8_t addr_count) {
   enum rfc5444_result result = RFC5444_OKAY;
-  struct rfc5444_reader_tlvblock_entry *tlv1 = NULL;
+  struct rfc5444_reader_tlvblock_entry *tlv1 = NULL, *first = NULL, **last;
   struct rfc5444_reader_tlvblock_entry entry;
+  uint16_t count;
   uint8_t *end;
 
+  block->tlvs = NULL;
+  block->count = 0;
+
+  /* temporary list of parsed TLVs */
+  last = &first;
+  count = 0;
+
   /* get length of TLV block */
   end = (*ptr) + 2;
   end = end + _rfc5444_get_u16(ptr, eob, &result);
@@ -582,7 +638,7 @@ _parse_tlvblock(struct rfc5444_reader *parser,
     }
 
     /* get memory to store TLV block entry */
-    tlv1 = parser->malloc_tlvblock_entry();
+    tlv1 = _malloc_tlvblock_entry(parser);
     if (tlv1 == NULL) {
       /* not enough memory left ! */
       result = RFC5444_OUT_OF_MEMORY;
@@ -592,23 +648,88 @@ _parse_tlvblock(struct rfc5444_reader *parser,
     /* copy TLV block entry into allocated memory */
     memcpy (tlv1, &entry, sizeof(entry));
 
-    /* put into sorted list */
-    tlv1->node.key = &tlv1->_order;
-    avl_insert(tlvblock, &tlv1->node);
+    /* append to temporary list */
+    tlv1->next_entry = NULL;
+    *last = tlv1;
+    last = &tlv1->next_entry;
+    count++;
+  }
+
+  if (count > 0) {
+    /* move TLVs into a flat array */
+    block->tlvs = _rfc5444_arena_alloc(&parser->_arena,
+        sizeof(*block->tlvs) * count, parser->arena_chunk_size);
+    if (block->tlvs == NULL) {
+      result = RFC5444_OUT_OF_MEMORY;
+      goto cleanup_parse_tlvblock;
+    }
+    block->count = count;
+
+    _index_tlvblock(block, first);
   }
 cleanup_parse_tlvblock:
   if (result != RFC5444_OKAY) {
-    _free_tlvblock(parser, tlvblock);
+    _free_tlvlist(parser, first);
+    block->tlvs = NULL;
+    block->count = 0;
     *ptr = eob;
   }
   return result;
 }
 
+/**
+ * Sort a list of TLVs into the array of a tlv block and build
+ * the type index. The TLVs are distributed by type with a counting
+ * sort, so TLVs with the same type and extension keep their order
+ * from the packet.
+ * @param block pointer to tlv block with allocated array and count
+ * @param first first element of list of TLVs, linked by next_entry
+ */
+static void
+_index_tlvblock(struct rfc5444_reader_tlvblock *block,
+    struct rfc5444_reader_tlvblock_entry *first) {
+  struct rfc5444_reader_tlvblock_entry *tlv;
+  uint16_t *index;
+  uint16_t i, j;
+  int type;
+
+  index = block->_type_index;
+  memset(index, 0, sizeof(block->_type_index));
+
+  /* count TLVs of each type */
+  for (tlv = first; tlv != NULL; tlv = tlv->next_entry) {
+    index[tlv->type + 1]++;
+  }
+
+  /* calculate first position of each type */
+  for (type=1; type<=256; type++) {
+    index[type] += index[type-1];
+  }
+
+  /* distribute TLVs, this moves the position of each type to its end */
+  for (tlv = first; tlv != NULL; tlv = tlv->next_entry) {
+    block->tlvs[index[tlv->type]++] = tlv;
+  }
+  for (type=255; type>0; type--) {
+    index[type] = index[type-1];
+  }
+  index[0] = 0;
+
+  /* sort by extension type, TLVs of one type rarely use more than one */
+  for (i=1; i<block->count; i++) {
+    tlv = block->tlvs[i];
+    for (j=i; j>0 && block->tlvs[j-1]->_order > tlv->_order; j--) {
+      block->tlvs[j] = block->tlvs[j-1];
+    }
+    block->tlvs[j] = tlv;
+  }
+}
+
 /**
  * Call callbacks for parsed TLV blocks
  * @param consumer pointer to first consumer for this message type
  * @param context pointer to context for tlv block
- * @param entries pointer avl_tree of tlv block entries
+ * @param block pointer to indexed tlv block
  * @param index of current address inside the addressblock, 0 for message tlv block
  * @return RFC5444_TLV_DROP_ADDRESS if the current address should
  *   be dropped for later consumers, RFC5444_TLV_DROP_CONTEXT if
@@ -617,57 +738,23 @@ cleanup_parse_tlvblock:
  */
 static enum rfc5444_result
 _schedule_tlvblock(struct rfc5444_reader_tlvblock_consumer *consumer, struct rfc5444_reader_tlvblock_context *context,
-    struct avl_tree *entries, uint8_t idx) {
-  struct rfc5444_reader_tlvblock_entry *tlv = NULL, *nexttlv = NULL;
+    struct rfc5444_reader_tlvblock *block, uint8_t idx) {
+  struct rfc5444_reader_tlvblock_entry *tlv, *lasttlv;
   struct rfc5444_reader_tlvblock_consumer_entry *cons_entry;
   bool constraints_failed;
   enum rfc5444_result result = RFC5444_OKAY;
+  uint16_t i, end;
 
   constraints_failed = false;
 
-  /* initialize tlv pointers, there must be TLVs */
-  if (avl_is_empty(entries)) {
-    tlv = NULL;
-  }
-  else {
-    tlv = avl_first_element(entries, tlv, node);
-  }
-
-  /* initialize consumer pointer */
-  if (list_is_empty(&consumer->_consumer_list)) {
-    cons_entry = NULL;
-  }
-  else {
-    cons_entry = list_first_element(&consumer->_consumer_list, cons_entry, _node);
-    cons_entry->tlv = NULL;
-  }
-
-  /* we are running in parallel through two sorted lists */
-  while (cons_entry != NULL || tlv != NULL) {
-    bool match = false;
-    bool index_match = false;
-
-    if (tlv) {
-      index_match = RFC5444_CONSUMER_DROP_ONLY(!bitmap256_get(&tlv->int_drop_tlv, idx), true)
-          && idx >= tlv->index1 && idx <= tlv->index2;
-    }
-
-    /* check index for address blocks */
-    if (tlv != NULL && cons_entry != NULL && index_match) {
-      /* calculate match between tlv and consumer */
-      match = _compare_tlvtypes(tlv, cons_entry) == 0;
-    }
-
-    if (index_match && tlv->_multivalue_tlv) {
-      size_t offset;
-
-      /* calculate value pointer for multivalue tlv */
-      offset = (size_t)(idx - tlv->index1) * tlv->length;
-      tlv->single_value = &tlv->_value[offset];
-    }
+  /* handle tlv_callback first, it sees all TLVs of the index */
+  if (consumer->tlv_callback != NULL) {
+    for (i=0; i<block->count; i++) {
+      tlv = block->tlvs[i];
+      if (!_match_tlv_index(tlv, idx)) {
+        continue;
+      }
 
-    /* handle tlv_callback first */
-    if (index_match && consumer->tlv_callback != NULL) {
       /* call consumer for TLV, can skip tlv, address, message and packet */
       context->consumer = consumer;
 #if DISALLOW_CONSUMER_CONTEXT_DROP == false
@@ -676,9 +763,8 @@ _schedule_tlvblock(struct rfc5444_reader_tlvblock_consumer *consumer, struct rfc
           consumer->tlv_callback(tlv, context);
 #if DISALLOW_CONSUMER_CONTEXT_DROP == false
       if (result == RFC5444_DROP_TLV) {
-        /* mark dropped tlv */
+        /* mark dropped tlv, it will not match any consumer entry */
         bitmap256_set(&tlv->int_drop_tlv, idx);
-        match = false;
         /* do not propagate result */
         result = RFC5444_OKAY;
       }
@@ -688,12 +774,29 @@ _schedule_tlvblock(struct rfc5444_reader_tlvblock_consumer *consumer, struct rfc
       }
 #endif
     }
+  }
+
+  /* look up the TLVs of each consumer entry in the type index */
+  list_for_each_element(&consumer->_consumer_list, cons_entry, _node) {
+    cons_entry->tlv = NULL;
+    lasttlv = NULL;
+
+    if (block->count > 0) {
+      end = block->_type_index[cons_entry->type + 1];
+      for (i = block->_type_index[cons_entry->type]; i < end; i++) {
+        tlv = block->tlvs[i];
 
-    /* run through both sorted lists until finding a match */
-    if (_compare_tlvtypes(tlv, cons_entry) >= 0) {
-      constraints_failed |= cons_entry->mandatory && !match;
+        if (cons_entry->match_type_ext && tlv->type_ext != cons_entry->type_ext) {
+          if (tlv->type_ext > cons_entry->type_ext) {
+            /* array is sorted by extension type */
+            break;
+          }
+          continue;
+        }
+        if (!_match_tlv_index(tlv, idx)) {
+          continue;
+        }
 
-      if (match) {
         if (cons_entry->match_length &&
             (tlv->length < cons_entry->min_length
                 || tlv->length > cons_entry->max_length)) {
@@ -703,7 +806,7 @@ _schedule_tlvblock(struct rfc5444_reader_tlvblock_consumer *consumer, struct rfc
         /* this is the last TLV that fits the description... for now */
         tlv->next_entry = NULL;
 
-        if (cons_entry->tlv == NULL) {
+        if (lasttlv == NULL) {
           /* it is also the first one we find */
           cons_entry->tlv = tlv;
 
@@ -719,35 +822,13 @@ _schedule_tlvblock(struct rfc5444_reader_tlvblock_consumer *consumer, struct rfc
         }
         else {
           /* its one of many, put it at the end of the list */
-          nexttlv = cons_entry->tlv;
-          while (nexttlv->next_entry) {
-            nexttlv = nexttlv->next_entry;
-          }
-          nexttlv->next_entry = tlv;
+          lasttlv->next_entry = tlv;
         }
+        lasttlv = tlv;
       }
     }
-    if (tlv != NULL && _compare_tlvtypes(tlv, cons_entry) <= 0) {
-      /* advance tlv pointer */
-      if (avl_is_last(entries, &tlv->node)) {
-        tlv = NULL;
-      }
-      else {
-        tlv = avl_next_element(tlv, node);
-      }
-    }
-    if (_compare_tlvtypes(tlv, cons_entry) > 0) {
-      constraints_failed |= cons_entry->mandatory && !match;
 
-      /* advance consumer pointer */
-      if (list_is_last(&consumer->_consumer_list, &cons_entry->_node)) {
-        cons_entry = NULL;
-      }
-      else {
-        cons_entry = list_next_element(cons_entry, _node);
-        cons_entry->tlv = NULL;
-      }
-    }
+    constraints_failed |= cons_entry->mandatory && cons_entry->tlv == NULL;
   }
 
   /* call consumer for tlvblock */
@@ -894,17 +975,63 @@ _parse_addrblock(struct rfc5444_reader_addrblock_entry *addr_entry,
   return result;
 }
 
+/**
+ * Expand all addresses of a parsed address block into an array of
+ * netaddr objects. Head and tail are written into a template once,
+ * each address only needs a fixed size copy of the template and the
+ * copy of its middle part.
+ * @param parser pointer to reader
+ * @param addr_entry pointer to parsed address block
+ * @param addr_len address length of message
+ * @return RFC5444_OKAY or RFC5444_OUT_OF_MEMORY
+ */
+static enum rfc5444_result
+_expand_addrblock(struct rfc5444_reader *parser,
+    struct rfc5444_reader_addrblock_entry *addr_entry, uint8_t addr_len) {
+  struct netaddr template, *dst;
+  const uint8_t *src;
+  uint8_t i, mid_start, mid_len;
+
+  addr_entry->addrs = _rfc5444_arena_alloc(&parser->_arena,
+      sizeof(struct netaddr) * addr_entry->num_addr, parser->arena_chunk_size);
+  if (addr_entry->addrs == NULL) {
+    return RFC5444_OUT_OF_MEMORY;
+  }
+
+  netaddr_from_binary_prefix(&template, addr_entry->addr, addr_len, 0, addr_entry->prefixlen);
+
+  mid_start = addr_entry->mid_start;
+  mid_len = addr_entry->mid_len;
+  src = addr_entry->mid_src;
+
+  for (i=0; i<addr_entry->num_addr; i++, src += mid_len) {
+    dst = &addr_entry->addrs[i];
+
+    memcpy(dst, &template, sizeof(*dst));
+    memcpy(&dst->_addr[mid_start], src, mid_len);
+  }
+
+  if (addr_entry->prefixes) {
+    for (i=0; i<addr_entry->num_addr; i++) {
+      /* same special case as netaddr_from_binary_prefix() */
+      addr_entry->addrs[i]._prefix_len =
+          addr_entry->prefixes[i] == 255 ? addr_len * 8 : addr_entry->prefixes[i];
+    }
+  }
+  return RFC5444_OKAY;
+}
+
 /**
  * Call start and tlvblock callbacks for message tlv consumer
  * @param consumer pointer to tlvblock consumer object
  * @param tlv_context current tlv context
- * @param tlv_entries pointer to tlventry avltree
+ * @param tlv_entries pointer to message tlv block
  * @return RFC5444_OKAY if no error happend, RFC5444_DROP_ if a
  *   context (message or packet) should be dropped
  */
 static enum rfc5444_result
 schedule_msgtlv_consumer(struct rfc5444_reader_tlvblock_consumer *consumer,
-    struct rfc5444_reader_tlvblock_context *tlv_context, struct avl_tree *tlv_entries) {
+    struct rfc5444_reader_tlvblock_context *tlv_context, struct rfc5444_reader_tlvblock *tlv_entries) {
   enum rfc5444_result result = RFC5444_OKAY;
   tlv_context->type = RFC5444_CONTEXT_MESSAGE;
 
@@ -945,7 +1072,7 @@ schedule_msgaddr_consumer(struct rfc5444_reader_tlvblock_consumer *consumer,
   /* consume address tlv block(s) */
   /* iterate over all address blocks */
   list_for_each_element(addr_head, addr, list_node) {
-    uint8_t i, plen;
+    uint8_t i;
 
     /* initialize byte context */
     tlv_context->addr_block_buffer = addr->addr_block_ptr;
@@ -961,18 +1088,8 @@ schedule_msgaddr_consumer(struct rfc5444_reader_tlvblock_consumer *consumer,
       }
 #endif
 
-      /* assemble address for context */
-      memcpy(&addr->addr[addr->mid_start], &addr->mid_src[addr->mid_len * i], addr->mid_len);
-
-      /* create netaddr */
-      if (addr->prefixes) {
-        plen = addr->prefixes[i];
-      }
-      else {
-        plen = addr->prefixlen;
-      }
-      netaddr_from_binary_prefix(&tlv_context->addr, addr->addr,
-          tlv_context->addr_len, 0, plen);
+      /* copy expanded address into context */
+      memcpy(&tlv_context->addr, &addr->addrs[i], sizeof(tlv_context->addr));
 
       /* remember index of address */
       tlv_context->addr_index = i;
@@ -1024,23 +1141,27 @@ schedule_msgaddr_consumer(struct rfc5444_reader_tlvblock_consumer *consumer,
 /**
  * Call end callbacks for message tlvblock consumer.
  * @param tlv_context context of current tlvblock
- * @param first begin of range of consumers which should be called
- * @param last end of range of consumers which should be called
+ * @param first begin of range of consumers in dispatch table which should be called
+ * @param last end of range of consumers in dispatch table which should be called
  * @param result current 'drop context' level
  * @return new 'drop context level'
  */
 static enum rfc5444_result
 schedule_end_message_cbs(struct rfc5444_reader_tlvblock_context *tlv_context,
-    struct rfc5444_reader_tlvblock_consumer *first, struct rfc5444_reader_tlvblock_consumer *last,
+    struct rfc5444_reader_tlvblock_consumer **first, struct rfc5444_reader_tlvblock_consumer **last,
     enum rfc5444_result result) {
-  struct rfc5444_reader_tlvblock_consumer *consumer;
+  struct rfc5444_reader_tlvblock_consumer **ptr, *consumer;
   enum rfc5444_result r;
 
   tlv_context->type = RFC5444_CONTEXT_MESSAGE;
 
-  avl_for_element_range_reverse(first, last, consumer, _node) {
-    if (consumer->end_callback && !consumer->addrblock_consumer
-        && (consumer->default_msg_consumer || consumer->msg_id == tlv_context->msg_type)) {
+  for (ptr = last; ptr >= first; ptr--) {
+    consumer = *ptr;
+    if (!avl_is_node_added(&consumer->_node)) {
+      /* consumer was removed during this message */
+      continue;
+    }
+    if (consumer->end_callback && !consumer->addrblock_consumer) {
       tlv_context->consumer = consumer;
       r = consumer->end_callback(tlv_context, result != RFC5444_OKAY);
       if (r > result) {
@@ -1064,10 +1185,12 @@ schedule_end_message_cbs(struct rfc5444_reader_tlvblock_context *tlv_context,
 static enum rfc5444_result
 _handle_message(struct rfc5444_reader *parser,
     struct rfc5444_reader_tlvblock_context *tlv_context, uint8_t **ptr, uint8_t *eob) {
-  struct avl_tree tlv_entries;
-  struct rfc5444_reader_tlvblock_consumer *consumer, *same_order[2];
+  struct rfc5444_reader_tlvblock tlv_entries;
+  struct rfc5444_reader_tlvblock_consumer **dispatch, **dispatch_end, **same_order[2];
+  struct rfc5444_reader_tlvblock_consumer *consumer;
   struct list_entity addr_head;
   struct rfc5444_reader_addrblock_entry *addr, *safe;
+  struct rfc5444_arena_mark mark;
   uint8_t *start, *end = NULL;
   uint8_t flags;
   uint16_t size;
@@ -1077,9 +1200,11 @@ _handle_message(struct rfc5444_reader *parser,
   /* initialize variables */
   result = RFC5444_OKAY;
   same_order[0] = same_order[1] = NULL;
-  avl_init(&tlv_entries, avl_comp_uint16, true);
+  tlv_entries.tlvs = NULL;
+  tlv_entries.count = 0;
   list_init_head(&addr_head);
   tlv_context->_do_not_forward = false;
+  _rfc5444_arena_get_mark(&parser->_arena, &mark);
 
   /* remember start of message */
   start = *ptr;
@@ -1132,6 +1257,18 @@ _handle_message(struct rfc5444_reader *parser,
     goto cleanup_parse_message;
   }
 
+  /* let the user skip the message before decoding its blocks */
+  if (parser->prefilter_message != NULL) {
+    tlv_context->type = RFC5444_CONTEXT_MESSAGE;
+    tlv_context->msg_buffer = start;
+    tlv_context->msg_size = size;
+
+    if (!parser->prefilter_message(tlv_context)) {
+      tlv_context->_do_not_forward = true;
+      goto cleanup_parse_message;
+    }
+  }
+
   /* parse message TLV block */
   result = _parse_tlvblock(parser, &tlv_entries, ptr, end, 0);
   if (result != RFC5444_OKAY) {
@@ -1142,25 +1279,32 @@ _handle_message(struct rfc5444_reader *parser,
   /* parse rest of message */
   while (*ptr < end) {
     /* get memory for storing the address block entry */
-    addr = parser->malloc_addrblock_entry();
+    addr = _malloc_addrblock_entry(parser);
     if (addr == NULL) {
       result = RFC5444_OUT_OF_MEMORY;
       goto cleanup_parse_message;
     }
 
-    /* initialize avl_tree */
-    avl_init(&addr->tlvblock, avl_comp_uint16, true);
+    /* initialize tlv block */
+    addr->tlvblock.tlvs = NULL;
+    addr->tlvblock.count = 0;
 
     /* parse address block... */
     if ((result = _parse_addrblock(addr, tlv_context, ptr, end)) != RFC5444_OKAY) {
-      parser->free_addrblock_entry(addr);
+      _free_addrblock_entry(parser, addr);
       goto cleanup_parse_message;
     }
 
-    /* ... and corresponding tlvblock */
+    /* expand all addresses of the block... */
+    if ((result = _expand_addrblock(parser, addr, tlv_context->addr_len)) != RFC5444_OKAY) {
+      _free_addrblock_entry(parser, addr);
+      goto cleanup_parse_message;
+    }
+
+    /* ... and parse corresponding tlvblock */
     result = _parse_tlvblock(parser, &addr->tlvblock, ptr, end, addr->num_addr);
     if (result != RFC5444_OKAY) {
-      parser->free_addrblock_entry(addr);
+      _free_addrblock_entry(parser, addr);
       goto cleanup_parse_message;
     }
 
@@ -1174,15 +1318,25 @@ _handle_message(struct rfc5444_reader *parser,
   tlv_context->msg_buffer = start;
   tlv_context->msg_size = size;
 
+  /* get the precompiled list of consumers for this message type */
+  if (parser->_dispatch_dirty && _compile_dispatch_table(parser)) {
+    result = RFC5444_OUT_OF_MEMORY;
+    goto cleanup_parse_message;
+  }
+  dispatch = &parser->_dispatch[parser->_dispatch_index[tlv_context->msg_type]];
+  dispatch_end = &parser->_dispatch[parser->_dispatch_index[tlv_context->msg_type + 1]];
+
   /* loop through list of message/address consumers */
-  avl_for_each_element(&parser->message_consumer, consumer, _node) {
-    if (!consumer->default_msg_consumer && consumer->msg_id != tlv_context->msg_type) {
-      /* wrong type of message, continue... */
+  for (; dispatch < dispatch_end; dispatch++) {
+    consumer = *dispatch;
+
+    if (!avl_is_node_added(&consumer->_node)) {
+      /* consumer was removed by an earlier callback of this message */
       continue;
     }
 
     /* remember range of consumers with same order to call end_message() callbacks */
-    if (same_order[0] != NULL && consumer->order > same_order[1]->order) {
+    if (same_order[0] != NULL && consumer->order > (*same_order[1])->order) {
 #if DISALLOW_CONSUMER_CONTEXT_DROP == false
       result =
 #endif
@@ -1208,9 +1362,9 @@ _handle_message(struct rfc5444_reader *parser,
 #endif
       schedule_msgtlv_consumer(consumer, tlv_context, &tlv_entries);
       if (same_order[0] == NULL) {
-        same_order[0] = consumer;
+        same_order[0] = dispatch;
       }
-      same_order[1] = consumer;
+      same_order[1] = dispatch;
     }
 
 #if DISALLOW_CONSUMER_CONTEXT_DROP == false
@@ -1256,11 +1410,12 @@ cleanup_parse_message:
   /* free address tlvblocks */
   list_for_each_element_safe(&addr_head, addr, list_node, safe) {
     _free_tlvblock(parser, &addr->tlvblock);
-    parser->free_addrblock_entry(addr);
+    _free_addrblock_entry(parser, addr);
   }
 
   /* free message tlvblock */
   _free_tlvblock(parser, &tlv_entries);
+  _rfc5444_arena_release(&parser->_arena, &mark);
   *ptr = end;
 #if DISALLOW_CONSUMER_CONTEXT_DROP == false
   if (result > RFC5444_OKAY && result != RFC5444_DROP_PACKET) {
@@ -1271,6 +1426,22 @@ cleanup_parse_message:
   return result;
 }
 
+/**
+ * Checks if two consumer entries can match the same TLV. Both entries
+ * would link the TLV into their own next_entry chain.
+ * @param e1 first consumer entry
+ * @param e2 second consumer entry
+ * @return true if a TLV could match both entries
+ */
+static INLINE bool
+_overlap_consumer_entries(struct rfc5444_reader_tlvblock_consumer_entry *e1,
+    struct rfc5444_reader_tlvblock_consumer_entry *e2) {
+  if (e1->type != e2->type) {
+    return false;
+  }
+  return !e1->match_type_ext || !e2->match_type_ext || e1->type_ext == e2->type_ext;
+}
+
 /**
  * Add a tlvblock consumer to a linked list of consumers.
  * The list is kept sorted by the order of the consumers.
@@ -1286,9 +1457,16 @@ static struct rfc5444_reader_tlvblock_consumer *
 _add_consumer(struct rfc5444_reader_tlvblock_consumer *consumer, struct avl_tree *consumer_tree,
     struct rfc5444_reader_tlvblock_consumer_entry *entries, int entrycount) {
   struct rfc5444_reader_tlvblock_consumer_entry *e;
-  int i, o;
+  int i, j, o;
   bool set;
 
+  /* entries share the next_entry pointer of their TLVs */
+  for (i=1; i<entrycount; i++) {
+    for (j=0; j<i; j++) {
+      assert(!_overlap_consumer_entries(&entries[i], &entries[j]));
+    }
+  }
+
   list_init_head(&consumer->_consumer_list);
 
   /* generate sorted list of entries */
@@ -1339,39 +1517,87 @@ _free_consumer(struct avl_tree *consumer_tree,
 }
 
 /**
- * Internal memory allocation function for addrblock
- * @return pointer to cleared addrblock
+ * Compile the dispatch table of the message consumers. The table
+ * contains the sorted list of consumers of each message type, so the
+ * parser does not need to filter the consumer tree for each message.
+ * @param parser pointer to reader
+ * @return -1 if an out of memory error happened, 0 otherwise
  */
-static struct rfc5444_reader_addrblock_entry *
-_malloc_addrblock_entry(void) {
-  return calloc(1, sizeof(struct rfc5444_reader_addrblock_entry));
+static int
+_compile_dispatch_table(struct rfc5444_reader *parser) {
+  struct rfc5444_reader_tlvblock_consumer **table, *consumer;
+  uint32_t count;
+  int type;
+
+  /* calculate size of table */
+  count = 0;
+  avl_for_each_element(&parser->message_consumer, consumer, _node) {
+    count += consumer->default_msg_consumer ? 256 : 1;
+  }
+
+  table = realloc(parser->_dispatch, sizeof(*table) * (count > 0 ? count : 1));
+  if (table == NULL) {
+    return -1;
+  }
+  parser->_dispatch = table;
+
+  /* fill table, keeping the consumer order for each message type */
+  count = 0;
+  for (type=0; type<256; type++) {
+    parser->_dispatch_index[type] = count;
+
+    avl_for_each_element(&parser->message_consumer, consumer, _node) {
+      if (consumer->default_msg_consumer || consumer->msg_id == type) {
+        table[count++] = consumer;
+      }
+    }
+  }
+  parser->_dispatch_index[256] = count;
+  parser->_dispatch_dirty = false;
+  return 0;
 }
 
 /**
- * Internal memory allocation function for rfc5444_reader_tlvblock_entry
- * @return pointer to cleared rfc5444_reader_tlvblock_entry
+ * Allocate an addrblock entry for a parser
+ * @param parser pointer to parser context
+ * @return pointer to cleared addrblock, NULL if out of memory
  */
-static struct rfc5444_reader_tlvblock_entry *
-_malloc_tlvblock_entry(void) {
-  return calloc(1, sizeof(struct rfc5444_reader_tlvblock_entry));
+static struct rfc5444_reader_addrblock_entry *
+_malloc_addrblock_entry(struct rfc5444_reader *parser) {
+  if (parser->malloc_addrblock_entry) {
+    return parser->malloc_addrblock_entry();
+  }
+  return _rfc5444_arena_alloc(&parser->_arena,
+      sizeof(struct rfc5444_reader_addrblock_entry), parser->arena_chunk_size);
 }
 
 /**
- * Free an addressblock entry
- * @param entry addressblock entry
+ * Allocate a rfc5444_reader_tlvblock_entry for a parser
+ * @param parser pointer to parser context
+ * @return pointer to cleared rfc5444_reader_tlvblock_entry,
+ *   NULL if out of memory
  */
-static void
-_free_addrblock_entry(struct rfc5444_reader_addrblock_entry *entry) {
-  free(entry);
+static struct rfc5444_reader_tlvblock_entry *
+_malloc_tlvblock_entry(struct rfc5444_reader *parser) {
+  if (parser->malloc_tlvblock_entry) {
+    return parser->malloc_tlvblock_entry();
+  }
+  return _rfc5444_arena_alloc(&parser->_arena,
+      sizeof(struct rfc5444_reader_tlvblock_entry), parser->arena_chunk_size);
 }
 
 /**
- * Free an tlvblock entry
- * @param entry tlvblock entry
+ * Free an addressblock entry of a parser. Entries from the arena
+ * are released together with the rest of the packet.
+ * @param parser pointer to parser context
+ * @param entry addressblock entry
  */
 static void
-_free_tlvblock_entry(struct rfc5444_reader_tlvblock_entry *entry) {
-  free(entry);
+_free_addrblock_entry(struct rfc5444_reader *parser,
+    struct rfc5444_reader_addrblock_entry *entry) {
+  if (parser->free_addrblock_entry) {
+    parser->free_addrblock_entry(entry);
+  }
 }
 
 /**
@@ -50,6 +50,7 @@
 #include "common/avl.h"
 #include "common/bitmap256.h"
 #include "common/netaddr.h"
+#include "rfc5444_arena.h"
 #include "rfc5444_context.h"
 
 /**
@@ -65,9 +66,6 @@ enum rfc5444_reader_tlvblock_context_type {
  * This struct temporary holds the content of a decoded TLV.
  */
 struct rfc5444_reader_tlvblock_entry {
-  /*! tree of TLVs */
-  struct avl_node node;
-
   /*! tlv type */
   uint8_t type;
 
@@ -114,6 +112,27 @@ struct rfc5444_reader_tlvblock_entry {
   struct bitmap256 int_drop_tlv;
 };
 
+/**
+ * Indexed representation of a parsed TLV block. All TLVs of the block
+ * are stored in a flat array, sorted once by type and type extension.
+ * The type index allows to find all TLVs of a single type without
+ * walking through the whole block.
+ */
+struct rfc5444_reader_tlvblock {
+  /*! array of TLVs, sorted by type and type extension */
+  struct rfc5444_reader_tlvblock_entry **tlvs;
+
+  /*! number of TLVs in the array */
+  uint16_t count;
+
+  /**
+   * position of the first TLV with a type larger or equal to the
+   * array index, the last element is always the number of TLVs.
+   * Only valid if count is not zero.
+   */
+  uint16_t _type_index[257];
+};
+
 /**
  * common context for packet, message and address TLV block
  */
@@ -145,6 +164,9 @@ struct rfc5444_reader_tlvblock_context {
   /*! size of binary packet */
   size_t pkt_size;
 
+  /*! receive timestamp of packet in nanoseconds, 0 if not available */
+  uint64_t pkt_timestamp;
+
   /* only for message and address TLV blocks */
 
   /*! message type */
@@ -215,7 +237,7 @@ struct rfc5444_reader_addrblock_entry {
   struct list_entity list_node;
 
   /*! corresponding tlv block */
-  struct avl_tree tlvblock;
+  struct rfc5444_reader_tlvblock tlvblock;
 
   /*! number of addresses */
   uint8_t num_addr;
@@ -241,6 +263,12 @@ struct rfc5444_reader_addrblock_entry {
   /*! storage for fixed prefix length */
   uint8_t prefixlen;
 
+  /**
+   * array of all addresses of the block including their prefix length,
+   * expanded once after the block has been parsed
+   */
+  struct netaddr *addrs;
+
   /*! pointer to binary address block data */
   const uint8_t *addr_block_ptr;
 
@@ -270,7 +298,13 @@ struct rfc5444_reader_tlvblock_consumer_entry {
   /*! set by the consumer to define the required type extension */
   uint8_t type_ext;
 
-  /*! set by the consumer to require a certain type extension */
+  /**
+   * set by the consumer to require a certain type extension.
+   * All TLVs matching an entry are linked by their next_entry pointer,
+   * so two entries of the same consumer must never match the same TLV.
+   * Entries with the same type need match_type_ext and different
+   * type extensions, adding the consumer asserts this.
+   */
   bool match_type_ext;
 
   /*! set by the consumer to define the minimum length of the TLVs value */
@@ -389,28 +423,67 @@ struct rfc5444_reader {
       uint8_t *buffer, size_t length);
 
   /**
-   * Callback to allocate a tlvblock entry
+   * Callback triggered after the header of a message has been read,
+   * before any TLV or address block of the message is decoded.
+   * Only the packet and message header fields of the context are valid.
+   * @param context message context
+   * @return true if message should be parsed, false to skip the
+   *   message completely (it will not be forwarded either)
+   */
+  bool (*prefilter_message)(struct rfc5444_reader_tlvblock_context *context);
+
+  /**
+   * Callback to allocate a tlvblock entry, NULL to allocate
+   * all tlvblock entries from the reader arena
    * @return tlvblock entry, NULL if out of memory
    */
   struct rfc5444_reader_tlvblock_entry* (*malloc_tlvblock_entry)(void);
 
   /**
-   * Callback to allocate an addressblock entry
+   * Callback to allocate an addressblock entry, NULL to allocate
+   * all addressblock entries from the reader arena
    * @return addressblock entry, NULL if out of memory
    */
   struct rfc5444_reader_addrblock_entry* (*malloc_addrblock_entry)(void);
 
   /**
-   * Free a tlvblock entry
+   * Free a tlvblock entry, must be set together with
+   * malloc_tlvblock_entry
    * @param entry tlvblock entry to free
    */
   void (*free_tlvblock_entry)(struct rfc5444_reader_tlvblock_entry *entry);
 
   /**
-   * Free an addressblock entry
+   * Free an addressblock entry, must be set together with
+   * malloc_addrblock_entry
    * @param entry addressblock entry to free
    */
   void (*free_addrblock_entry)(struct rfc5444_reader_addrblock_entry *entry);
+
+  /*! size of the memory chunks of the arena, 0 for RFC5444_ARENA_CHUNK */
+  size_t arena_chunk_size;
+
+  /**
+   * receive timestamp of the next packet in nanoseconds, 0 if not
+   * available. It is copied into the tlvblock context of the packet
+   * and reset to 0 by rfc5444_reader_handle_packet().
+   */
+  uint64_t rx_timestamp;
+
+  /*! arena for the transient parser objects of the current packet */
+  struct rfc5444_arena _arena;
+
+  /**
+   * precompiled dispatch table, contains the message/addr consumers
+   * of each message type sorted by order
+   */
+  struct rfc5444_reader_tlvblock_consumer **_dispatch;
+
+  /*! position of the first consumer of each message type in dispatch table */
+  uint32_t _dispatch_index[257];
+
+  /*! true if the dispatch table must be compiled again */
+  bool _dispatch_dirty;
 };
 
 EXPORT void rfc5444_reader_init(struct rfc5444_reader *);
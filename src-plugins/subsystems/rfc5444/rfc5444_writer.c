@@ -61,10 +61,9 @@ static void _register_addrtlvtype(struct rfc5444_writer *writer,
 static void *_copy_addrtlv_value(struct rfc5444_writer *writer, const void *value, size_t length);
 static void _lazy_free_message(struct rfc5444_writer *writer, struct rfc5444_writer_message *msg);
 static struct rfc5444_writer_message *_get_message(struct rfc5444_writer *writer, uint8_t msgid);
-static struct rfc5444_writer_address *_malloc_address_entry(void);
-static struct rfc5444_writer_addrtlv *_malloc_addrtlv_entry(void);
-static void _free_address_entry(struct rfc5444_writer_address *addr);
-static void _free_addrtlv_entry(struct rfc5444_writer_addrtlv *addrtlv);
+static struct rfc5444_writer_address *_malloc_address_entry(struct rfc5444_writer *writer);
+static struct rfc5444_writer_addrtlv *_get_addrtlv_slot(struct rfc5444_writer *writer,
+    struct rfc5444_writer_address *addr, int full_type);
 
 /**
  * @param type TLV type
@@ -85,17 +84,10 @@ rfc5444_writer_init(struct rfc5444_writer *writer) {
   assert (writer->msg_buffer != NULL && writer->msg_size > 0);
   assert (writer->addrtlv_buffer != NULL && writer->addrtlv_size > 0);
 
-  /* set default memory handler functions */
-  if (!writer->malloc_address_entry)
-    writer->malloc_address_entry = _malloc_address_entry;
-  if (!writer->malloc_addrtlv_entry)
-    writer->malloc_addrtlv_entry = _malloc_addrtlv_entry;
-  if (!writer->free_address_entry)
-    writer->free_address_entry = _free_address_entry;
-  if (!writer->free_addrtlv_entry)
-    writer->free_addrtlv_entry = _free_addrtlv_entry;
+  memset(&writer->_arena, 0, sizeof(writer->_arena));
 
   list_init_head(&writer->_targets);
+  list_init_head(&writer->_shared_free);
 
   /* initialize packet buffer */
   writer->_msg.buffer = writer->msg_buffer;
@@ -127,6 +119,7 @@ rfc5444_writer_cleanup(struct rfc5444_writer *writer) {
   struct rfc5444_writer_tlvtype *tlvtype, *safe_tt;
   struct rfc5444_writer_target *interf, *safe_interf;
   struct rfc5444_writer_postprocessor *processor, *safe_proc;
+  struct rfc5444_writer_shared_msg *shared, *safe_shared;
 
   assert(writer);
 #if WRITER_STATE_MACHINE == true
@@ -171,6 +164,20 @@ rfc5444_writer_cleanup(struct rfc5444_writer *writer) {
     /* remove message and addresses */
     rfc5444_writer_unregister_message(writer, msg);
   }
+
+  /* free address planner array */
+  free(writer->_plan);
+  writer->_plan = NULL;
+  writer->_plan_size = 0;
+
+  /* free arena */
+  _rfc5444_arena_free(&writer->_arena);
+
+  /* free unused shared messages, the targets released all references */
+  list_for_each_element_safe(&writer->_shared_free, shared, _node, safe_shared) {
+    list_remove(&shared->_node);
+    free(shared);
+  }
 }
 
 /**
@@ -190,17 +197,24 @@ enum rfc5444_result
 rfc5444_writer_add_addrtlv(struct rfc5444_writer *writer, struct rfc5444_writer_address *addr,
     struct rfc5444_writer_tlvtype *tlvtype, const void *value, size_t length, bool allow_dup) {
   struct rfc5444_writer_addrtlv *addrtlv;
+  void *valuecopy;
 
 #if WRITER_STATE_MACHINE == true
   assert(writer->_state == RFC5444_WRITER_ADD_ADDRESSES);
 #endif
 
   /* check for collision if necessary */
-  if (!allow_dup && avl_find(&addr->_addrtlv_tree, &tlvtype->_full_type) != NULL) {
+  if (!allow_dup && _rfc5444_writer_find_addrtlv(addr, tlvtype->_full_type) != NULL) {
     return RFC5444_DUPLICATE_TLV;
   }
 
-  if ((addrtlv = writer->malloc_addrtlv_entry()) == NULL) {
+  /* copy value(length) */
+  valuecopy = NULL;
+  if (length > 0 && (valuecopy = _copy_addrtlv_value(writer, value, length)) == NULL) {
+    return RFC5444_OUT_OF_ADDRTLV_MEM;
+  }
+
+  if ((addrtlv = _get_addrtlv_slot(writer, addr, tlvtype->_full_type)) == NULL) {
     /* out of memory error */
     return RFC5444_OUT_OF_MEMORY;
   }
@@ -208,19 +222,84 @@ rfc5444_writer_add_addrtlv(struct rfc5444_writer *writer, struct rfc5444_writer_
   /* set back pointer */
   addrtlv->address = addr;
   addrtlv->tlvtype = tlvtype;
-
-  /* copy value(length) */
   addrtlv->length = length;
-  if (length > 0 && (addrtlv->value = _copy_addrtlv_value(writer, value, length)) == NULL) {
-    writer->free_addrtlv_entry(addrtlv);
-    return RFC5444_OUT_OF_ADDRTLV_MEM;
+  addrtlv->value = valuecopy;
+
+  return RFC5444_OKAY;
+}
+
+/**
+ * Find the first TLV of a type in the TLV array of an address
+ * @param addr pointer to address object
+ * @param full_type type*256 + extension type of TLV
+ * @return pointer to address TLV, NULL if not found
+ */
+struct rfc5444_writer_addrtlv *
+_rfc5444_writer_find_addrtlv(struct rfc5444_writer_address *addr, int full_type) {
+  struct rfc5444_writer_addrtlv *tlv;
+
+  /* arrays are short, a linear search is fastest */
+  for (tlv = addr->_addrtlvs; tlv < addr->_addrtlvs + addr->_addrtlv_count; tlv++) {
+    if (tlv->tlvtype->_full_type >= full_type) {
+      return tlv->tlvtype->_full_type == full_type ? tlv : NULL;
+    }
   }
+  return NULL;
+}
 
-  /* add to address tree */
-  addrtlv->addrtlv_node.key = &tlvtype->_full_type;
-  avl_insert(&addr->_addrtlv_tree, &addrtlv->addrtlv_node);
+/**
+ * Get a buffer for a shared message. The caller holds the
+ * only reference to it.
+ * @param writer pointer to writer context
+ * @param size minimal number of bytes of the message
+ * @return shared message, NULL if out of memory
+ */
+struct rfc5444_writer_shared_msg *
+_rfc5444_writer_get_shared_msg(struct rfc5444_writer *writer, size_t size) {
+  struct rfc5444_writer_shared_msg *shared, *safe;
+
+  list_for_each_element_safe(&writer->_shared_free, shared, _node, safe) {
+    list_remove(&shared->_node);
+    if (shared->_capacity >= size) {
+      shared->length = 0;
+      shared->_refcount = 1;
+      return shared;
+    }
 
-  return RFC5444_OKAY;
+    /* too small for this message */
+    free(shared);
+  }
+
+  if (size < writer->msg_size) {
+    size = writer->msg_size;
+  }
+
+  shared = malloc(sizeof(*shared) + size);
+  if (shared == NULL) {
+    return NULL;
+  }
+
+  shared->length = 0;
+  shared->_capacity = size;
+  shared->_refcount = 1;
+  return shared;
+}
+
+/**
+ * Drop a reference to a shared message and keep it for reuse
+ * if it is not used anymore
+ * @param writer pointer to writer context
+ * @param shared shared message
+ */
+void
+_rfc5444_writer_release_shared_msg(struct rfc5444_writer *writer,
+    struct rfc5444_writer_shared_msg *shared) {
+  assert(shared->_refcount > 0);
+
+  shared->_refcount--;
+  if (shared->_refcount == 0) {
+    list_add_head(&writer->_shared_free, &shared->_node);
+  }
 }
 
 /**
@@ -244,7 +323,7 @@ rfc5444_writer_add_address(struct rfc5444_writer *writer __attribute__ ((unused)
 
   address = avl_find_element(&msg->_addr_tree, naddr, address, _addr_tree_node);
   if (address == NULL) {
-    if ((address = writer->malloc_address_entry()) == NULL) {
+    if ((address = _malloc_address_entry(writer)) == NULL) {
       return NULL;
     }
 
@@ -261,8 +340,6 @@ rfc5444_writer_add_address(struct rfc5444_writer *writer __attribute__ ((unused)
     /* add address into message address tree */
     address->_addr_tree_node.key = &address->address;
     avl_insert(&msg->_addr_tree, &address->_addr_tree_node);
-
-    avl_init(&address->_addrtlv_tree, avl_comp_uint32, true);
   }
 
   address->_mandatory_addr |= mandatory;
@@ -532,6 +609,8 @@ rfc5444_writer_register_target(struct rfc5444_writer *writer,
   _rfc5444_tlv_writer_init(&interf->_pkt, interf->packet_size, interf->packet_size);
 
   interf->_is_flushed = true;
+  interf->_shared_count = 0;
+  interf->_shared_size = 0;
 
   list_add_tail(&writer->_targets, &interf->_target_node);
 }
@@ -544,7 +623,7 @@ rfc5444_writer_register_target(struct rfc5444_writer *writer,
  */
 void
 rfc5444_writer_unregister_target(
-    struct rfc5444_writer *writer  __attribute__ ((unused)),
+    struct rfc5444_writer *writer,
     struct rfc5444_writer_target *interf) {
 #if WRITER_STATE_MACHINE == true
   assert(writer->_state == RFC5444_WRITER_NONE);
@@ -554,6 +633,9 @@ rfc5444_writer_unregister_target(
   if (list_is_node_added(&interf->_target_node)) {
     list_remove(&interf->_target_node);
   }
+
+  /* drop shared messages of an unsent packet */
+  _rfc5444_writer_release_shared_refs(writer, interf);
 }
 
 /**
@@ -652,18 +734,24 @@ _copy_addrtlv_value(struct rfc5444_writer *writer, const void *value, size_t len
 void
 _rfc5444_writer_free_addresses(struct rfc5444_writer *writer, struct rfc5444_writer_message *msg) {
   struct rfc5444_writer_address *addr, *safe_addr;
-  struct rfc5444_writer_addrtlv *addrtlv, *safe_addrtlv;
-
-  avl_remove_all_elements(&msg->_addr_tree, addr, _addr_tree_node, safe_addr) {
-    /* remove from list too */
-    list_remove(&addr->_addr_list_node);
 
-    avl_remove_all_elements(&addr->_addrtlv_tree, addrtlv, addrtlv_node, safe_addrtlv) {
-      writer->free_addrtlv_entry(addrtlv);
+  if (writer->free_address_entry) {
+    avl_remove_all_elements(&msg->_addr_tree, addr, _addr_tree_node, safe_addr) {
+      /* remove from list too */
+      list_remove(&addr->_addr_list_node);
+      writer->free_address_entry(addr);
     }
-    writer->free_address_entry(addr);
+  }
+  else {
+    /* all addresses are in the arena, just forget them */
+    avl_init(&msg->_addr_tree, avl_comp_netaddr, false);
+    list_init_head(&msg->_addr_head);
+    list_init_head(&msg->_non_mandatory_addr_head);
   }
 
+  /* release addresses and address TLVs */
+  _rfc5444_arena_reset(&writer->_arena);
+
   /* allow overwriting of addrtlv-value buffer */
   writer->_addrtlv_used = 0;
 }
@@ -685,37 +773,62 @@ _lazy_free_message(struct rfc5444_writer *writer, struct rfc5444_writer_message
 }
 
 /**
- * Default allocater for address objects
- * @return pointer to cleaned address object, NULL if an error happened
+ * Allocate an address object for a writer
+ * @param writer pointer to writer context
+ * @return pointer to cleared address object, NULL if an error happened
  */
 static struct rfc5444_writer_address*
-_malloc_address_entry(void) {
-  return calloc(1, sizeof(struct rfc5444_writer_address));
-}
-
-/**
- * Default allocator for address tlv object.
- * @return pointer to cleaned address tlv object, NULL if an error happened
- */
-static struct rfc5444_writer_addrtlv*
-_malloc_addrtlv_entry(void) {
-  return calloc(1, sizeof(struct rfc5444_writer_addrtlv));
+_malloc_address_entry(struct rfc5444_writer *writer) {
+  if (writer->malloc_address_entry) {
+    return writer->malloc_address_entry();
+  }
+  return _rfc5444_arena_alloc(&writer->_arena,
+      sizeof(struct rfc5444_writer_address), writer->arena_chunk_size);
 }
 
 /**
- * Default deallocater for address objects
+ * Get a new slot for an address TLV in the TLV array of an address.
+ * The slot is placed behind all TLVs with the same or a lower type.
+ * @param writer pointer to writer context
  * @param addr pointer to address object
+ * @param full_type type*256 + extension type of new TLV
+ * @return pointer to cleared address TLV, NULL if out of memory
  */
-static void
-_free_address_entry(struct rfc5444_writer_address *addr) {
-  free(addr);
-}
+static struct rfc5444_writer_addrtlv *
+_get_addrtlv_slot(struct rfc5444_writer *writer,
+    struct rfc5444_writer_address *addr, int full_type) {
+  struct rfc5444_writer_addrtlv *array;
+  size_t idx, size;
+
+  if (addr->_addrtlv_count == addr->_addrtlv_size) {
+    if (addr->_addrtlv_size > UINT16_MAX / 2) {
+      return NULL;
+    }
 
-/**
- * Default deallocator for address tlv object.
- * @param addrtlv pointer to address tlv object
- */
-static void
-_free_addrtlv_entry(struct rfc5444_writer_addrtlv *addrtlv) {
-  free (addrtlv);
+    /* array is full, move it to a larger one in the arena */
+    size = addr->_addrtlv_size == 0 ? RFC5444_WRITER_ADDRTLV_ARRAY : addr->_addrtlv_size * 2u;
+    array = _rfc5444_arena_alloc(&writer->_arena, size * sizeof(*array), writer->arena_chunk_size);
+    if (array == NULL) {
+      return NULL;
+    }
+    if (addr->_addrtlv_count > 0) {
+      memcpy(array, addr->_addrtlvs, addr->_addrtlv_count * sizeof(*array));
+    }
+    addr->_addrtlvs = array;
+    addr->_addrtlv_size = (uint16_t)size;
+  }
+
+  /* keep array sorted, TLVs are mostly added in order of their type */
+  idx = addr->_addrtlv_count;
+  while (idx > 0 && addr->_addrtlvs[idx-1].tlvtype->_full_type > full_type) {
+    idx--;
+  }
+  if (idx < addr->_addrtlv_count) {
+    memmove(&addr->_addrtlvs[idx+1], &addr->_addrtlvs[idx],
+        (addr->_addrtlv_count - idx) * sizeof(*addr->_addrtlvs));
+  }
+  addr->_addrtlv_count++;
+
+  memset(&addr->_addrtlvs[idx], 0, sizeof(*addr->_addrtlvs));
+  return &addr->_addrtlvs[idx];
 }
@@ -49,10 +49,13 @@
 struct rfc5444_writer;
 struct rfc5444_writer_message;
 
+#include <sys/uio.h>
+
 #include "common/avl.h"
 #include "common/common_types.h"
 #include "common/list.h"
 #include "common/netaddr.h"
+#include "rfc5444_arena.h"
 #include "rfc5444_context.h"
 #include "rfc5444_reader.h"
 #include "rfc5444_tlv_writer.h"
@@ -80,6 +83,46 @@ enum {
   RFC5444_WRITER_PKT_POSTPROCESSOR = -1,
 };
 
+enum {
+  /*! initial number of address TLVs allocated for an address */
+  RFC5444_WRITER_ADDRTLV_ARRAY = 4,
+
+  /*! maximum number of shared messages referenced by a single packet */
+  RFC5444_WRITER_SHARED_REFS = 16,
+};
+
+/**
+ * A serialized message in fan-out mode. It is written only once
+ * and referenced by the packets of all targets it is sent to.
+ */
+struct rfc5444_writer_shared_msg {
+  /*! number of bytes of the message */
+  size_t length;
+
+  /*! number of bytes allocated for data */
+  size_t _capacity;
+
+  /*! number of packets (and the writer) referencing the message */
+  uint32_t _refcount;
+
+  /*! node for list of unused shared messages */
+  struct list_entity _node;
+
+  /*! binary message */
+  uint8_t data[];
+};
+
+/**
+ * Reference of a target packet to a shared message
+ */
+struct rfc5444_writer_shared_ref {
+  /*! shared message */
+  struct rfc5444_writer_shared_msg *msg;
+
+  /*! number of local message bytes of the packet in front of the shared message */
+  size_t offset;
+};
+
 /**
  * This INTERNAL struct represents a single address tlv
  * of an address during message serialization.
@@ -88,9 +131,6 @@ struct rfc5444_writer_addrtlv {
   /*! backpointer to tlvtype */
   struct rfc5444_writer_tlvtype *tlvtype;
 
-  /*! tree _target_node of tlvs used by a single address */
-  struct avl_node addrtlv_node;
-
   /*! backpointer to address */
   struct rfc5444_writer_address *address;
 
@@ -137,8 +177,14 @@ struct rfc5444_writer_address {
   /*! node for quick access ( O(log n)) to addresses */
   struct avl_node _addr_tree_node;
 
-  /*! tree to connect all TLVs of this address */
-  struct avl_tree _addrtlv_tree;
+  /*! array of all TLVs of this address, sorted by type and extension */
+  struct rfc5444_writer_addrtlv *_addrtlvs;
+
+  /*! number of TLVs of this address */
+  uint16_t _addrtlv_count;
+
+  /*! number of TLVs allocated in array */
+  uint16_t _addrtlv_size;
 
   /*! address block head length */
   uint8_t _block_headlen;
@@ -277,6 +323,18 @@ struct rfc5444_writer_target {
   void (*sendPacket)(struct rfc5444_writer *writer,
       struct rfc5444_writer_target *target, void *ptr, size_t len);
 
+  /**
+   * Callback to send a RFC5444 packet assembled from its own buffer
+   * and shared messages, NULL if the target can only send a
+   * contiguous packet through sendPacket.
+   * @param writer rfc5444 writer
+   * @param target rfc5444 target
+   * @param iov array of packet fragments
+   * @param iovcnt number of packet fragments
+   */
+  void (*sendPacketv)(struct rfc5444_writer *writer,
+      struct rfc5444_writer_target *target, const struct iovec *iov, int iovcnt);
+
   /*! true if packet should have a sequence number */
   bool _has_seqno;
 
@@ -292,8 +350,17 @@ struct rfc5444_writer_target {
   /*! buffer for constructing the current packet */
   struct rfc5444_tlv_writer_data _pkt;
 
-  /*! number of bytes used by messages */
+  /*! number of bytes used by messages (including shared ones) */
   size_t _bin_msgs_size;
+
+  /*! shared messages referenced by the current packet */
+  struct rfc5444_writer_shared_ref _shared[RFC5444_WRITER_SHARED_REFS];
+
+  /*! number of shared messages referenced by the current packet */
+  uint32_t _shared_count;
+
+  /*! number of bytes of shared messages in the current packet */
+  size_t _shared_size;
 };
 
 /**
@@ -381,6 +448,22 @@ struct rfc5444_writer_message {
       struct rfc5444_writer_address *first,
       struct rfc5444_writer_address *last, bool complete);
 
+  /**
+   * Callback to notify the message creator about the binary
+   * representation of a generated message fragment, e.g. to
+   * cache it for later use with rfc5444_writer_add_binary_msg().
+   * Not called if a post-processor applies to the message type.
+   * @param writer rfc5444 writer
+   * @param msg rfc5444 message
+   * @param buffer pointer to binary message
+   * @param len length of binary message
+   * @param complete false if message has been fragmented,
+   *    true if message fit into MTU
+   */
+  void (*messageGenerated)(struct rfc5444_writer *writer,
+      struct rfc5444_writer_message *msg,
+      const uint8_t *buffer, size_t len, bool complete);
+
   /**
    * callback to determine if a message shall be forwarded
    * @param target rfc5444 target
@@ -468,6 +551,40 @@ struct rfc5444_writer_postprocessor {
       uint8_t *data, size_t *length);
 };
 
+/**
+ * Statistics of the address compression planner
+ */
+struct rfc5444_writer_planner_stats {
+  /*! number of messages the planner looked at */
+  uint64_t messages;
+
+  /*! number of messages with reordered addresses */
+  uint64_t reordered;
+
+  /*! estimated number of bytes saved over all messages */
+  uint64_t bytes_saved;
+
+  /*! estimated number of bytes saved in the last message */
+  uint32_t last_bytes_saved;
+};
+
+/**
+ * Statistics of the message fan-out of a rfc5444 writer
+ */
+struct rfc5444_writer_fanout_stats {
+  /*! number of messages serialized into a shared buffer */
+  uint64_t messages;
+
+  /*! number of packets that referenced a shared message instead of copying it */
+  uint64_t references;
+
+  /*! number of packets sent as multiple fragments */
+  uint64_t packets;
+
+  /*! number of shared messages copied into a packet buffer before sending */
+  uint64_t copied;
+};
+
 /**
  * This struct represents the internal state of a
  * rfc5444 writer.
@@ -488,6 +605,24 @@ struct rfc5444_writer {
   /*! length of addrtlv buffer */
   size_t addrtlv_size;
 
+  /**
+   * true to group the addresses of a message by prefix length
+   * and common head before compressing them
+   */
+  bool plan_addresses;
+
+  /*! statistics of the address compression planner */
+  struct rfc5444_writer_planner_stats planner_stats;
+
+  /**
+   * true to serialize an interface independent message for multiple
+   * targets only once and let all their packets reference it
+   */
+  bool fanout;
+
+  /*! statistics of the message fan-out */
+  struct rfc5444_writer_fanout_stats fanout_stats;
+
   /**
    * Callback to notify an instance that a message was forwarded
    * @param target pointer to rfc5444 target where
@@ -496,28 +631,21 @@ struct rfc5444_writer {
   void (*forwarding_notifier)(struct rfc5444_writer_target *target);
 
   /**
-   * Callback to allocate a writer_address, NULL for use calloc()
+   * Callback to allocate a writer_address, NULL to allocate
+   * all addresses from the writer arena
    * @return writer address, NULL if out of memory
    */
   struct rfc5444_writer_address * (*malloc_address_entry)(void);
 
   /**
-   * Callback to allocate an address tlv, NULL for use calloc()
-   * @return address tlv, NULL if out of memory
-   */
-  struct rfc5444_writer_addrtlv * (*malloc_addrtlv_entry)(void);
-
-  /**
-   * Callback to free a writer_address, NULL for use free()
+   * Free a writer_address, must be set together with
+   * malloc_address_entry
    * @param addr writer address
    */
   void (*free_address_entry)(struct rfc5444_writer_address *addr);
 
-  /**
-   * Callback to free a address tlv, NULL for use free()
-   * @param addrtlv address tlv
-   */
-  void (*free_addrtlv_entry)(struct rfc5444_writer_addrtlv *addrtlv);
+  /*! size of the memory chunks of the arena, 0 for RFC5444_ARENA_CHUNK */
+  size_t arena_chunk_size;
 
   /**
    * target of current generated message
@@ -546,6 +674,18 @@ struct rfc5444_writer {
   /*! number of bytes of addrtlv buffer currently used */
   size_t _addrtlv_used;
 
+  /*! arena for the addresses and address TLVs of the current message */
+  struct rfc5444_arena _arena;
+
+  /*! list of unused shared messages */
+  struct list_entity _shared_free;
+
+  /*! array of addresses used by the address compression planner */
+  struct rfc5444_writer_address **_plan;
+
+  /*! number of entries allocated in planner array */
+  size_t _plan_size;
+
   /*! internal state of writer */
   enum rfc5444_internal_state _state;
 };
@@ -646,6 +786,10 @@ EXPORT enum rfc5444_result rfc5444_writer_create_message(
     struct rfc5444_writer *writer, uint8_t msgid, uint8_t addr_len,
     rfc5444_writer_targetselector useIf, void *param);
 
+EXPORT enum rfc5444_result rfc5444_writer_add_binary_msg(
+    struct rfc5444_writer *writer, const uint8_t *msg, size_t len,
+    rfc5444_writer_targetselector useIf, void *param);
+
 EXPORT enum rfc5444_result rfc5444_writer_forward_msg(struct rfc5444_writer *writer,
     struct rfc5444_reader_tlvblock_context *context, uint8_t *msg, size_t len);
 
@@ -657,6 +801,28 @@ EXPORT void rfc5444_writer_cleanup(struct rfc5444_writer *writer);
 /* internal functions that are not exported to the user */
 void _rfc5444_writer_free_addresses(struct rfc5444_writer *writer, struct rfc5444_writer_message *msg);
 void _rfc5444_writer_begin_packet(struct rfc5444_writer *writer, struct rfc5444_writer_target *target);
+struct rfc5444_writer_addrtlv *_rfc5444_writer_find_addrtlv(
+    struct rfc5444_writer_address *addr, int full_type);
+struct rfc5444_writer_shared_msg *_rfc5444_writer_get_shared_msg(
+    struct rfc5444_writer *writer, size_t size);
+void _rfc5444_writer_release_shared_msg(
+    struct rfc5444_writer *writer, struct rfc5444_writer_shared_msg *shared);
+bool _rfc5444_writer_attach_shared_msg(struct rfc5444_writer_target *target,
+    struct rfc5444_writer_shared_msg *shared);
+void _rfc5444_writer_release_shared_refs(
+    struct rfc5444_writer *writer, struct rfc5444_writer_target *target);
+
+/**
+ * Internal function to get the end of the messages in the packet
+ * buffer of a target. Shared messages are not part of the buffer.
+ * @param target rfc5444 target
+ * @return pointer to first unused byte behind the messages
+ */
+static INLINE uint8_t *
+_rfc5444_writer_get_msg_end(struct rfc5444_writer_target *target) {
+  return &target->_pkt.buffer[target->_pkt.header + target->_pkt.added
+      + target->_pkt.allocated + target->_bin_msgs_size - target->_shared_size];
+}
 
 /**
  * creates a message of a certain ID for a single target
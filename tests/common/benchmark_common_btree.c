@@ -0,0 +1,267 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "common/avl.h"
+#include "common/avl_comp.h"
+#include "common/btree.h"
+#include "common/netaddr.h"
+
+/*
+ * Microbenchmark comparing the AVL tree and the btree as ordered
+ * containers for originator addresses. Each element is allocated
+ * separately with the size of an olsrv2 tc node, like the objects
+ * of an oonf_class.
+ */
+
+#define ROUNDS 1000000
+
+struct bench_element {
+  struct netaddr addr;
+  struct avl_node avl;
+  struct btree_node btree;
+  uint8_t payload[256];
+};
+
+static struct avl_tree _avl;
+static struct btree_tree _btree;
+
+static struct bench_element **_elements;
+static struct netaddr *_queries;
+
+static uint64_t
+_get_ns(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void
+_create_elements(uint32_t count, bool ipv6) {
+  uint8_t addr[16];
+  uint32_t i, j, r;
+
+  memset(addr, 0, sizeof(addr));
+  for (i=0; i<count; i++) {
+    _elements[i] = calloc(1, sizeof(struct bench_element));
+
+    if (ipv6) {
+      /* mesh prefix, random interface identifier */
+      addr[0] = 0xfd;
+      for (j=8; j<14; j++) {
+        addr[j] = rand();
+      }
+      addr[14] = i >> 8;
+      addr[15] = i;
+      netaddr_from_binary(&_elements[i]->addr, addr, 16, AF_INET6);
+    }
+    else {
+      r = ((uint32_t)rand() << 17) ^ i;
+      addr[0] = 10;
+      addr[1] = r >> 16;
+      addr[2] = r >> 8;
+      addr[3] = r;
+      netaddr_from_binary(&_elements[i]->addr, addr, 4, AF_INET);
+    }
+    _elements[i]->avl.key = &_elements[i]->addr;
+    _elements[i]->btree.key = &_elements[i]->addr;
+  }
+
+  for (i=0; i<ROUNDS; i++) {
+    memcpy(&_queries[i], &_elements[rand() % count]->addr, sizeof(_queries[i]));
+  }
+}
+
+static void
+_free_elements(uint32_t count) {
+  uint32_t i;
+
+  for (i=0; i<count; i++) {
+    free(_elements[i]);
+  }
+}
+
+static void
+_run_avl(uint32_t count, uint64_t *result) {
+  struct bench_element *e;
+  uint64_t start, sum;
+  uint32_t i;
+
+  avl_init(&_avl, avl_comp_netaddr, false);
+
+  start = _get_ns();
+  for (i=0; i<count; i++) {
+    avl_insert(&_avl, &_elements[i]->avl);
+  }
+  result[0] = (_get_ns() - start) / count;
+
+  sum = 0;
+  start = _get_ns();
+  for (i=0; i<ROUNDS; i++) {
+    e = avl_find_element(&_avl, &_queries[i], e, avl);
+    sum += e->payload[0];
+  }
+  result[1] = (_get_ns() - start) * 1000 / ROUNDS;
+
+  start = _get_ns();
+  for (i=0; i<ROUNDS; i++) {
+    e = avl_find_ge_element(&_avl, &_queries[i], e, avl);
+    sum += e->payload[1];
+  }
+  result[2] = (_get_ns() - start) * 1000 / ROUNDS;
+
+  start = _get_ns();
+  for (i=0; i<ROUNDS / count + 1; i++) {
+    avl_for_each_element(&_avl, e, avl) {
+      sum += e->payload[2];
+    }
+  }
+  result[3] = (_get_ns() - start) * 1000 / ((ROUNDS / count + 1) * count);
+
+  start = _get_ns();
+  for (i=0; i<count; i++) {
+    avl_remove(&_avl, &_elements[i]->avl);
+  }
+  result[4] = (_get_ns() - start) / count;
+
+  if (sum != 0) {
+    printf("unexpected checksum\n");
+  }
+}
+
+static void
+_run_btree(uint32_t count, bool prefix, uint64_t *result) {
+  struct bench_element *e;
+  uint64_t start, sum;
+  uint32_t i;
+
+  btree_init(&_btree, avl_comp_netaddr, false);
+  if (prefix) {
+    _btree.prefix = btree_prefix_memcmp;
+  }
+
+  start = _get_ns();
+  for (i=0; i<count; i++) {
+    btree_insert(&_btree, &_elements[i]->btree);
+  }
+  result[0] = (_get_ns() - start) / count;
+
+  sum = 0;
+  start = _get_ns();
+  for (i=0; i<ROUNDS; i++) {
+    e = btree_find_element(&_btree, &_queries[i], e, btree);
+    sum += e->payload[0];
+  }
+  result[1] = (_get_ns() - start) * 1000 / ROUNDS;
+
+  start = _get_ns();
+  for (i=0; i<ROUNDS; i++) {
+    e = btree_find_ge_element(&_btree, &_queries[i], e, btree);
+    sum += e->payload[1];
+  }
+  result[2] = (_get_ns() - start) * 1000 / ROUNDS;
+
+  start = _get_ns();
+  for (i=0; i<ROUNDS / count + 1; i++) {
+    btree_for_each_element(&_btree, e, btree) {
+      sum += e->payload[2];
+    }
+  }
+  result[3] = (_get_ns() - start) * 1000 / ((ROUNDS / count + 1) * count);
+
+  start = _get_ns();
+  for (i=0; i<count; i++) {
+    btree_remove(&_btree, &_elements[i]->btree);
+  }
+  result[4] = (_get_ns() - start) / count;
+
+  if (sum != 0) {
+    printf("unexpected checksum\n");
+  }
+}
+
+static void
+_print(const char *name, uint64_t *result) {
+  printf("  %-14s insert %5"PRIu64" ns  find %7.1f ns  find_ge %7.1f ns"
+      "  iterate %5.1f ns  remove %5"PRIu64" ns\n", name,
+      result[0], result[1] / 1000.0, result[2] / 1000.0, result[3] / 1000.0, result[4]);
+}
+
+int
+main(int argc __attribute__ ((unused)), char **argv __attribute__ ((unused))) {
+  static const uint32_t counts[] = { 1000, 10000, 100000 };
+  uint64_t result[5];
+  size_t c;
+  int v6;
+
+  _elements = calloc(100000, sizeof(*_elements));
+  _queries = calloc(ROUNDS, sizeof(*_queries));
+
+  srand(42);
+  for (v6 = 0; v6 < 2; v6++) {
+    for (c=0; c<ARRAYSIZE(counts); c++) {
+      _create_elements(counts[c], v6);
+
+      printf("%u %s originators:\n", counts[c], v6 ? "IPv6" : "IPv4");
+      _run_avl(counts[c], result);
+      _print("avl", result);
+      _run_btree(counts[c], false, result);
+      _print("btree", result);
+      _run_btree(counts[c], true, result);
+      _print("btree+prefix", result);
+
+      _free_elements(counts[c]);
+    }
+  }
+
+  free(_elements);
+  free(_queries);
+  return 0;
+}
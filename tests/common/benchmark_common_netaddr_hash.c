@@ -0,0 +1,309 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "common/avl.h"
+#include "common/avl_comp.h"
+#include "common/btree.h"
+#include "common/netaddr.h"
+#include "common/netaddr_hash.h"
+
+/*
+ * Microbenchmark comparing exact-match lookups of originator addresses
+ * in an AVL tree, a btree with key prefix and a netaddr hash. Each
+ * element is allocated separately with the size of an olsrv2 tc node,
+ * like the objects of an oonf_class.
+ */
+
+#define ROUNDS 1000000
+
+enum bench_container {
+  BENCH_AVL,
+  BENCH_BTREE,
+  BENCH_HASH,
+};
+
+struct bench_element {
+  struct netaddr addr;
+  struct avl_node avl;
+  struct btree_node btree;
+  struct netaddr_hash_node hash;
+  uint8_t payload[256];
+};
+
+static struct avl_tree _avl;
+static struct btree_tree _btree;
+static struct netaddr_hash _hash;
+
+static struct bench_element **_elements;
+static struct netaddr *_queries;
+static struct netaddr *_misses;
+
+static uint64_t
+_get_ns(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void
+_random_addr(struct netaddr *dst, uint32_t i, bool ipv6) {
+  uint8_t addr[16];
+  uint32_t j, r;
+
+  memset(addr, 0, sizeof(addr));
+  if (ipv6) {
+    /* mesh prefix, random interface identifier */
+    addr[0] = 0xfd;
+    for (j=8; j<14; j++) {
+      addr[j] = rand();
+    }
+    addr[14] = i >> 8;
+    addr[15] = i;
+    netaddr_from_binary(dst, addr, 16, AF_INET6);
+  }
+  else {
+    r = ((uint32_t)rand() << 17) ^ i;
+    addr[0] = 10;
+    addr[1] = r >> 16;
+    addr[2] = r >> 8;
+    addr[3] = r;
+    netaddr_from_binary(dst, addr, 4, AF_INET);
+  }
+}
+
+static void
+_create_elements(uint32_t count, bool ipv6) {
+  uint32_t i;
+
+  for (i=0; i<count; i++) {
+    _elements[i] = calloc(1, sizeof(struct bench_element));
+    _random_addr(&_elements[i]->addr, i, ipv6);
+
+    _elements[i]->avl.key = &_elements[i]->addr;
+    _elements[i]->btree.key = &_elements[i]->addr;
+    _elements[i]->hash.key = &_elements[i]->addr;
+  }
+
+  /* use the avl tree to make sure that the misses are not in the set */
+  avl_init(&_avl, avl_comp_netaddr, false);
+  for (i=0; i<count; i++) {
+    avl_insert(&_avl, &_elements[i]->avl);
+  }
+
+  for (i=0; i<ROUNDS; i++) {
+    memcpy(&_queries[i], &_elements[rand() % count]->addr, sizeof(_queries[i]));
+
+    do {
+      _random_addr(&_misses[i], rand(), ipv6);
+    } while (avl_find(&_avl, &_misses[i]) != NULL);
+  }
+
+  for (i=0; i<count; i++) {
+    avl_remove(&_avl, &_elements[i]->avl);
+  }
+}
+
+static void
+_free_elements(uint32_t count) {
+  uint32_t i;
+
+  for (i=0; i<count; i++) {
+    free(_elements[i]);
+  }
+}
+
+static void
+_insert(enum bench_container type, struct bench_element *e) {
+  switch (type) {
+    case BENCH_AVL:
+      avl_insert(&_avl, &e->avl);
+      break;
+    case BENCH_BTREE:
+      btree_insert(&_btree, &e->btree);
+      break;
+    case BENCH_HASH:
+      netaddr_hash_insert(&_hash, &e->hash);
+      break;
+    default:
+      break;
+  }
+}
+
+static struct bench_element *
+_find(enum bench_container type, const struct netaddr *addr) {
+  struct bench_element *e = NULL;
+
+  switch (type) {
+    case BENCH_AVL:
+      e = avl_find_element(&_avl, addr, e, avl);
+      break;
+    case BENCH_BTREE:
+      e = btree_find_element(&_btree, addr, e, btree);
+      break;
+    case BENCH_HASH:
+      e = netaddr_hash_find_element(&_hash, addr, e, hash);
+      break;
+    default:
+      break;
+  }
+  return e;
+}
+
+static void
+_remove(enum bench_container type, struct bench_element *e) {
+  switch (type) {
+    case BENCH_AVL:
+      avl_remove(&_avl, &e->avl);
+      break;
+    case BENCH_BTREE:
+      btree_remove(&_btree, &e->btree);
+      break;
+    case BENCH_HASH:
+      netaddr_hash_remove(&_hash, &e->hash);
+      break;
+    default:
+      break;
+  }
+}
+
+static void
+_run(enum bench_container type, uint32_t count, uint64_t *result) {
+  struct bench_element *e;
+  uint64_t start, now, last, max, sum;
+  uint32_t i;
+
+  avl_init(&_avl, avl_comp_netaddr, false);
+  btree_init(&_btree, avl_comp_netaddr, false);
+  _btree.prefix = btree_prefix_memcmp;
+  netaddr_hash_init(&_hash);
+
+  /* time each insert to catch the cost of resizing */
+  max = 0;
+  start = _get_ns();
+  last = start;
+  for (i=0; i<count; i++) {
+    _insert(type, _elements[i]);
+
+    now = _get_ns();
+    if (now - last > max) {
+      max = now - last;
+    }
+    last = now;
+  }
+  result[0] = (last - start) / count;
+  result[1] = max;
+
+  sum = 0;
+  start = _get_ns();
+  for (i=0; i<ROUNDS; i++) {
+    e = _find(type, &_queries[i]);
+    sum += e->payload[0];
+  }
+  result[2] = (_get_ns() - start) * 1000 / ROUNDS;
+
+  start = _get_ns();
+  for (i=0; i<ROUNDS; i++) {
+    e = _find(type, &_misses[i]);
+    sum += e != NULL;
+  }
+  result[3] = (_get_ns() - start) * 1000 / ROUNDS;
+
+  start = _get_ns();
+  for (i=0; i<count; i++) {
+    _remove(type, _elements[i]);
+  }
+  result[4] = (_get_ns() - start) / count;
+
+  if (sum != 0) {
+    printf("unexpected checksum\n");
+  }
+}
+
+static void
+_print(const char *name, uint64_t *result) {
+  printf("  %-14s insert %5"PRIu64" ns (max %7"PRIu64" ns)  find %7.1f ns"
+      "  miss %7.1f ns  remove %5"PRIu64" ns\n", name,
+      result[0], result[1], result[2] / 1000.0, result[3] / 1000.0, result[4]);
+}
+
+int
+main(int argc __attribute__ ((unused)), char **argv __attribute__ ((unused))) {
+  static const uint32_t counts[] = { 1000, 10000, 100000 };
+  uint64_t result[5];
+  size_t c;
+  int v6;
+
+  _elements = calloc(100000, sizeof(*_elements));
+  _queries = calloc(ROUNDS, sizeof(*_queries));
+  _misses = calloc(ROUNDS, sizeof(*_misses));
+
+  srand(42);
+  for (v6 = 0; v6 < 2; v6++) {
+    for (c=0; c<ARRAYSIZE(counts); c++) {
+      _create_elements(counts[c], v6);
+
+      printf("%u %s originators:\n", counts[c], v6 ? "IPv6" : "IPv4");
+      _run(BENCH_AVL, counts[c], result);
+      _print("avl", result);
+      _run(BENCH_BTREE, counts[c], result);
+      _print("btree+prefix", result);
+      _run(BENCH_HASH, counts[c], result);
+      _print("netaddr_hash", result);
+
+      _free_elements(counts[c]);
+    }
+  }
+
+  free(_elements);
+  free(_queries);
+  free(_misses);
+  return 0;
+}
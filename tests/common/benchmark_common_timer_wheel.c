@@ -0,0 +1,226 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "common/avl.h"
+#include "common/timer_wheel.h"
+
+/*
+ * Microbenchmark comparing the AVL tree and the hierarchical
+ * timer wheel as backends for the timer scheduler. All keys are
+ * rounded to a 100 ms timeslice like in oonf_timer.
+ */
+
+#define SLICE     100ull
+#define MAX_DELAY 60000ull
+#define START     1000000ull
+
+struct bench_timer {
+  uint64_t clock;
+  struct avl_node avl;
+  struct timer_wheel_node wheel;
+};
+
+static struct avl_tree _tree;
+static struct timer_wheel _wheel;
+
+static struct bench_timer *_timers;
+static uint64_t *_delays;
+static uint32_t *_indices;
+
+static int
+_avlcomp_timer(const void *p1, const void *p2) {
+  const struct bench_timer *t1 = p1, *t2 = p2;
+
+  if (t1->clock > t2->clock) {
+    return 1;
+  }
+  if (t1->clock < t2->clock) {
+    return -1;
+  }
+  return 0;
+}
+
+static uint64_t
+_get_ns(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t
+_calc_clock(uint64_t now, uint64_t delay) {
+  uint64_t clock = now + delay + SLICE;
+  return clock - clock % SLICE;
+}
+
+static void
+_avl_start(struct bench_timer *t, uint64_t clock) {
+  if (avl_is_node_added(&t->avl)) {
+    avl_remove(&_tree, &t->avl);
+  }
+  t->clock = clock;
+  t->avl.key = t;
+  avl_insert(&_tree, &t->avl);
+}
+
+static void
+_wheel_start(struct bench_timer *t, uint64_t clock) {
+  if (timer_wheel_is_node_added(&t->wheel)) {
+    timer_wheel_remove(&_wheel, &t->wheel);
+  }
+  t->clock = clock;
+  timer_wheel_add(&_wheel, &t->wheel, clock);
+}
+
+static void
+_run(uint32_t count, bool wheel) {
+  struct bench_timer *t;
+  uint64_t start, t_start, t_restart, t_walk, now, fired;
+  uint32_t i;
+
+  memset(_timers, 0, sizeof(*_timers) * count);
+  avl_init(&_tree, _avlcomp_timer, true);
+  timer_wheel_init(&_wheel, SLICE, START);
+
+  /* start all timers */
+  start = _get_ns();
+  for (i=0; i<count; i++) {
+    if (wheel) {
+      _wheel_start(&_timers[i], _calc_clock(START, _delays[i]));
+    }
+    else {
+      _avl_start(&_timers[i], _calc_clock(START, _delays[i]));
+    }
+  }
+  t_start = _get_ns() - start;
+
+  /* restart all timers in random order (e.g. validity time refresh) */
+  start = _get_ns();
+  for (i=0; i<count; i++) {
+    t = &_timers[_indices[i]];
+    if (wheel) {
+      _wheel_start(t, _calc_clock(START, _delays[count - 1 - i]));
+    }
+    else {
+      _avl_start(t, _calc_clock(START, _delays[count - 1 - i]));
+    }
+  }
+  t_restart = _get_ns() - start;
+
+  /* advance time for one maximum delay, fire and restart periodic timers */
+  fired = 0;
+  start = _get_ns();
+  for (now = START; now <= START + MAX_DELAY; now += SLICE) {
+    while (true) {
+      if (wheel) {
+        t = timer_wheel_expired_element(&_wheel, now, t, wheel);
+        if (t == NULL) {
+          break;
+        }
+        _wheel_start(t, _calc_clock(now, _delays[fired % count]));
+      }
+      else {
+        if (avl_is_empty(&_tree)) {
+          break;
+        }
+        t = avl_first_element(&_tree, t, avl);
+        if (t->clock > now) {
+          break;
+        }
+        _avl_start(t, _calc_clock(now, _delays[fired % count]));
+      }
+      fired++;
+    }
+  }
+  t_walk = _get_ns() - start;
+
+  printf("%-6s %7u timers: start %6.1f ns, restart %6.1f ns, fire+restart %6.1f ns (%"PRIu64" events)\n",
+      wheel ? "wheel" : "avl", count,
+      (double)t_start / count, (double)t_restart / count,
+      fired ? (double)t_walk / fired : 0.0, fired);
+}
+
+int
+main(int argc __attribute__ ((unused)), char **argv __attribute__ ((unused))) {
+  static const uint32_t counts[] = { 10000, 100000 };
+  uint32_t i, j, max, tmp, swap;
+
+  max = counts[ARRAYSIZE(counts)-1];
+  _timers = calloc(max, sizeof(*_timers));
+  _delays = calloc(max, sizeof(*_delays));
+  _indices = calloc(max, sizeof(*_indices));
+  if (!_timers || !_delays || !_indices) {
+    fprintf(stderr, "Out of memory\n");
+    return 1;
+  }
+
+  srand(42);
+  for (i=0; i<ARRAYSIZE(counts); i++) {
+    for (j=0; j<counts[i]; j++) {
+      _delays[j] = (uint64_t)(rand() % (int)MAX_DELAY) + 1;
+      _indices[j] = j;
+    }
+    for (j=counts[i]-1; j>0; j--) {
+      tmp = (uint32_t)rand() % (j+1);
+      swap = _indices[j];
+      _indices[j] = _indices[tmp];
+      _indices[tmp] = swap;
+    }
+
+    _run(counts[i], false);
+    _run(counts[i], true);
+  }
+
+  free(_timers);
+  free(_delays);
+  free(_indices);
+  return 0;
+}
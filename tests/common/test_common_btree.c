@@ -0,0 +1,332 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "common/avl.h"
+#include "common/avl_comp.h"
+#include "common/btree.h"
+#include "common/netaddr.h"
+#include "cunit/cunit.h"
+
+struct tree_element {
+  uint32_t value;
+  struct netaddr addr;
+  struct btree_node node;
+  struct avl_node avl;
+};
+
+#define LARGE_COUNT 5000
+
+static struct btree_tree head;
+static struct avl_tree reference;
+static struct tree_element elements[LARGE_COUNT];
+
+static void clear_elements(void) {
+  memset(&head, 0, sizeof(head));
+  memset(&reference, 0, sizeof(reference));
+  memset(elements, 0, sizeof(elements));
+}
+
+static void add_element(struct tree_element *e, uint32_t value) {
+  e->value = value;
+  e->node.key = &e->value;
+  e->avl.key = &e->value;
+  btree_insert(&head, &e->node);
+  avl_insert(&reference, &e->avl);
+}
+
+static void remove_element(struct tree_element *e) {
+  btree_remove(&head, &e->node);
+  avl_remove(&reference, &e->avl);
+}
+
+static void remove_all(void) {
+  struct tree_element *e, *ptr;
+
+  btree_for_each_element_safe(&head, e, node, ptr) {
+    btree_remove(&head, &e->node);
+  }
+}
+
+/* compare order of btree keys with avl tree (duplicates are in different order) */
+static void check_tree(const char *name, uint32_t line) {
+  struct tree_element *e;
+  struct list_entity *ref;
+  uint32_t count;
+
+  CHECK_NAMED_TRUE(head.count == reference.count, name, line,
+      "wrong count: %u != %u", head.count, reference.count);
+  CHECK_NAMED_TRUE((head._root == NULL) == (head.count == 0), name, line,
+      "root pointer does not match count");
+
+  count = 0;
+  ref = reference.list_head.next;
+  btree_for_each_element(&head, e, node) {
+    CHECK_NAMED_TRUE(container_of(ref, struct tree_element, avl.list)->value == e->value,
+        name, line, "wrong element %u at position %u", e->value, count);
+    if (container_of(ref, struct tree_element, avl.list)->value != e->value) {
+      return;
+    }
+    ref = ref->next;
+    count++;
+
+    CHECK_NAMED_TRUE(btree_find_element(&head, &e->value, e, node) != NULL,
+        name, line, "element %u not found", e->value);
+  }
+  CHECK_NAMED_TRUE(count == head.count, name, line, "iterated %u of %u elements", count, head.count);
+}
+
+static void test_insert_find(void) {
+  struct tree_element additional;
+  uint32_t i, value;
+
+  START_TEST();
+  btree_init(&head, avl_comp_uint32, false);
+  avl_init(&reference, avl_comp_uint32, false);
+
+  srand(1);
+  for (i=0; i<LARGE_COUNT; i++) {
+    do {
+      value = (uint32_t)rand();
+    } while (avl_find(&reference, &value) != NULL);
+    add_element(&elements[i], value);
+  }
+  check_tree(__func__, __LINE__);
+
+  for (i=0; i<LARGE_COUNT; i++) {
+    CHECK_TRUE(btree_find(&head, &elements[i].value) == &elements[i].node,
+        "element %u not found", i);
+  }
+
+  memset(&additional, 0, sizeof(additional));
+  additional.value = elements[17].value;
+  additional.node.key = &additional.value;
+  CHECK_TRUE(btree_insert(&head, &additional.node) != 0, "insert duplicate (in non-dup tree) was successful");
+  CHECK_TRUE(!btree_is_node_added(&additional.node), "rejected node is marked as added");
+  CHECK_TRUE(head.count == LARGE_COUNT, "wrong count after rejected insert");
+
+  remove_all();
+  END_TEST();
+}
+
+static void test_duplicates(void) {
+  struct tree_element *e;
+  uint32_t i, last, key;
+
+  START_TEST();
+  btree_init(&head, avl_comp_uint32, true);
+  avl_init(&reference, avl_comp_uint32, true);
+
+  /* three keys with many duplicates each, spanning several pages */
+  for (i=0; i<300; i++) {
+    add_element(&elements[i], (i * 7) % 3);
+  }
+  check_tree(__func__, __LINE__);
+
+  /* duplicates must be returned in insertion order */
+  last = 0;
+  key = 1;
+  btree_for_each_elements_with_key(&head, e, node, &key) {
+    CHECK_TRUE(e->value == 1, "wrong key %u", e->value);
+    CHECK_TRUE(e == elements || e > &elements[last], "duplicates out of order");
+    last = e - elements;
+  }
+  CHECK_TRUE(btree_find(&head, &key) == &elements[1].node, "first duplicate not found");
+
+  /* remove every second duplicate */
+  for (i=0; i<300; i+=2) {
+    remove_element(&elements[i]);
+  }
+  check_tree(__func__, __LINE__);
+
+  for (i=1; i<300; i+=2) {
+    remove_element(&elements[i]);
+  }
+  check_tree(__func__, __LINE__);
+  CHECK_TRUE(head._root == NULL, "root not freed");
+
+  END_TEST();
+}
+
+static void test_greater_less(void) {
+  struct btree_node *node;
+  struct avl_node *ref;
+  uint32_t i, key;
+
+  START_TEST();
+  btree_init(&head, avl_comp_uint32, true);
+  avl_init(&reference, avl_comp_uint32, true);
+
+  for (i=0; i<1000; i++) {
+    add_element(&elements[i], (i % 500) * 10 + 10);
+  }
+
+  for (key=0; key<=5020; key++) {
+    node = btree_find_greaterequal(&head, &key);
+    ref = avl_find_greaterequal(&reference, &key);
+    CHECK_TRUE((node == NULL) == (ref == NULL), "greaterequal %u: NULL mismatch", key);
+    if (node && ref) {
+      CHECK_TRUE(container_of(node, struct tree_element, node)
+          == container_of(ref, struct tree_element, avl),
+          "greaterequal %u: wrong element", key);
+    }
+
+    node = btree_find_lessequal(&head, &key);
+    ref = avl_find_lessequal(&reference, &key);
+    CHECK_TRUE((node == NULL) == (ref == NULL), "lessequal %u: NULL mismatch", key);
+    if (node && ref) {
+      CHECK_TRUE(container_of(node, struct tree_element, node)
+          == container_of(ref, struct tree_element, avl),
+          "lessequal %u: wrong element", key);
+    }
+  }
+
+  remove_all();
+  END_TEST();
+}
+
+static void test_random_insert_remove(void) {
+  struct tree_element *e, *ptr;
+  uint32_t i, j;
+
+  START_TEST();
+  btree_init(&head, avl_comp_uint32, true);
+  avl_init(&reference, avl_comp_uint32, true);
+
+  srand(2);
+  for (i=0; i<20; i++) {
+    /* fill up randomly, then remove random elements */
+    for (j=0; j<LARGE_COUNT; j++) {
+      if (!btree_is_node_added(&elements[j].node) && (rand() & 1)) {
+        add_element(&elements[j], (uint32_t)rand() % 2000);
+      }
+    }
+    check_tree(__func__, __LINE__);
+
+    for (j=0; j<LARGE_COUNT; j++) {
+      if (btree_is_node_added(&elements[j].node) && (rand() % 3) != 0) {
+        remove_element(&elements[j]);
+      }
+    }
+    check_tree(__func__, __LINE__);
+  }
+
+  btree_for_each_element_safe(&head, e, node, ptr) {
+    remove_element(e);
+  }
+  check_tree(__func__, __LINE__);
+  CHECK_TRUE(head._root == NULL, "root not freed");
+
+  END_TEST();
+}
+
+static void test_prefix(void) {
+  struct tree_element *e;
+  struct netaddr *prev;
+  uint8_t addr[16];
+  uint32_t i;
+
+  START_TEST();
+  btree_init(&head, avl_comp_netaddr, false);
+  head.prefix = btree_prefix_memcmp;
+
+  memset(addr, 0, sizeof(addr));
+  srand(3);
+  for (i=0; i<LARGE_COUNT; i++) {
+    if (i & 1) {
+      /* IPv4 */
+      addr[0] = 10;
+      addr[1] = rand();
+      addr[2] = rand();
+      addr[3] = i;
+      netaddr_from_binary(&elements[i].addr, addr, 4, AF_INET);
+    }
+    else {
+      /* IPv6 with identical first 8 bytes */
+      addr[0] = 0xfd;
+      addr[1] = addr[2] = addr[3] = 0;
+      addr[14] = i >> 8;
+      addr[15] = i;
+      netaddr_from_binary(&elements[i].addr, addr, 16, AF_INET6);
+    }
+    elements[i].node.key = &elements[i].addr;
+    if (btree_insert(&head, &elements[i].node)) {
+      /* random IPv4 address collision */
+      elements[i].node.key = NULL;
+    }
+  }
+
+  prev = NULL;
+  btree_for_each_element(&head, e, node) {
+    CHECK_TRUE(prev == NULL || netaddr_cmp(prev, &e->addr) < 0, "wrong order");
+    prev = &e->addr;
+  }
+
+  for (i=0; i<LARGE_COUNT; i++) {
+    if (elements[i].node.key) {
+      CHECK_TRUE(btree_find(&head, &elements[i].addr) == &elements[i].node,
+          "address %u not found", i);
+    }
+  }
+
+  remove_all();
+  CHECK_TRUE(head._root == NULL, "root not freed");
+  END_TEST();
+}
+
+int main(int argc __attribute__ ((unused)), char **argv __attribute__ ((unused))) {
+  BEGIN_TESTING(clear_elements);
+
+  test_insert_find();
+  test_duplicates();
+  test_greater_less();
+  test_random_insert_remove();
+  test_prefix();
+
+  return FINISH_TESTING();
+}
@@ -0,0 +1,110 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+
+#include <string.h>
+#include <stdio.h>
+
+#include "common/latency_histogram.h"
+#include "cunit/cunit.h"
+
+static struct latency_histogram hist;
+
+static void clear_elements(void) {
+  latency_histogram_clear(&hist);
+}
+
+static void test_buckets(void) {
+  int i;
+
+  START_TEST();
+
+  latency_histogram_add(&hist, 999);
+  CHECK_TRUE(hist.bucket[0] == 1, "999 ns not in bucket 0");
+
+  latency_histogram_add(&hist, 1000);
+  latency_histogram_add(&hist, 1999);
+  CHECK_TRUE(hist.bucket[1] == 2, "1-2 us not in bucket 1 (%u)", hist.bucket[1]);
+
+  latency_histogram_add(&hist, 2000);
+  latency_histogram_add(&hist, 3999);
+  CHECK_TRUE(hist.bucket[2] == 2, "2-4 us not in bucket 2 (%u)", hist.bucket[2]);
+
+  latency_histogram_add(&hist, 10000000000ull);
+  CHECK_TRUE(hist.bucket[LATENCY_HISTOGRAM_BUCKETS-1] == 1, "10 s not in last bucket");
+
+  for (i=1; i<LATENCY_HISTOGRAM_BUCKETS-1; i++) {
+    CHECK_TRUE(latency_histogram_get_lower_bound(i) == 1ull << (i-1),
+        "wrong lower bound for bucket %d", i);
+  }
+  CHECK_TRUE(latency_histogram_get_lower_bound(0) == 0, "lower bound of bucket 0 not zero");
+
+  END_TEST();
+}
+
+static void test_totals(void) {
+  START_TEST();
+
+  CHECK_TRUE(latency_histogram_get_average(&hist) == 0, "average of empty histogram not zero");
+
+  latency_histogram_add(&hist, 100);
+  latency_histogram_add(&hist, 300);
+  latency_histogram_add(&hist, 500);
+
+  CHECK_TRUE(hist.count == 3, "count is %"PRIu64" instead of 3", hist.count);
+  CHECK_TRUE(hist.total == 900, "total is %"PRIu64" instead of 900", hist.total);
+  CHECK_TRUE(hist.max == 500, "max is %"PRIu64" instead of 500", hist.max);
+  CHECK_TRUE(latency_histogram_get_average(&hist) == 300, "average is not 300");
+
+  END_TEST();
+}
+
+int main(int argc __attribute__ ((unused)), char **argv __attribute__ ((unused))) {
+  BEGIN_TESTING(clear_elements);
+
+  test_buckets();
+  test_totals();
+
+  return FINISH_TESTING();
+}
@@ -0,0 +1,244 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "common/netaddr.h"
+#include "common/netaddr_hash.h"
+#include "cunit/cunit.h"
+
+struct hash_element {
+  struct netaddr addr;
+  bool added;
+  struct netaddr_hash_node node;
+};
+
+#define LARGE_COUNT 5000
+
+static struct netaddr_hash head;
+static struct hash_element elements[LARGE_COUNT];
+
+static void clear_elements(void) {
+  memset(&head, 0, sizeof(head));
+  memset(elements, 0, sizeof(elements));
+}
+
+static void init_element(struct hash_element *e, uint32_t i) {
+  uint8_t addr[16];
+
+  memset(addr, 0, sizeof(addr));
+  if (i & 1) {
+    /* IPv6 addresses that only differ in the last bytes */
+    addr[0] = 0xfd;
+    addr[14] = i >> 8;
+    addr[15] = i;
+    netaddr_from_binary(&e->addr, addr, 16, AF_INET6);
+  }
+  else {
+    addr[0] = 10;
+    addr[2] = i >> 8;
+    addr[3] = i;
+    netaddr_from_binary(&e->addr, addr, 4, AF_INET);
+  }
+  e->node.key = &e->addr;
+}
+
+static void remove_all(void) {
+  struct hash_element *e, *ptr;
+
+  netaddr_hash_for_each_element_safe(&head, e, node, ptr) {
+    netaddr_hash_remove(&head, &e->node);
+    e->added = false;
+  }
+}
+
+/* check that exactly the added elements can be found */
+static void check_hash(const char *name, uint32_t line) {
+  struct hash_element *e;
+  uint32_t i, count;
+
+  count = 0;
+  for (i=0; i<LARGE_COUNT; i++) {
+    e = netaddr_hash_find_element(&head, &elements[i].addr, e, node);
+    if (elements[i].added) {
+      CHECK_NAMED_TRUE(e == &elements[i], name, line, "element %u not found", i);
+      count++;
+    }
+    else {
+      CHECK_NAMED_TRUE(e == NULL, name, line, "removed element %u found", i);
+    }
+  }
+  CHECK_NAMED_TRUE(head.count == count, name, line,
+      "wrong count: %u != %u", head.count, count);
+
+  count = 0;
+  netaddr_hash_for_each_element(&head, e, node) {
+    count++;
+  }
+  CHECK_NAMED_TRUE(head.count == count, name, line,
+      "iterated %u of %u elements", count, head.count);
+}
+
+static void test_insert_find(void) {
+  struct hash_element *e, duplicate;
+  uint32_t i;
+
+  START_TEST();
+  netaddr_hash_init(&head);
+
+  for (i=0; i<LARGE_COUNT; i++) {
+    init_element(&elements[i], i);
+    CHECK_TRUE(netaddr_hash_insert(&head, &elements[i].node) == 0,
+        "insert of element %u failed", i);
+    elements[i].added = true;
+  }
+  check_hash(__func__, __LINE__);
+
+  /* iteration keeps insertion order */
+  i = 0;
+  netaddr_hash_for_each_element(&head, e, node) {
+    CHECK_TRUE(e == &elements[i], "wrong element at position %u", i);
+    i++;
+  }
+
+  /* keys must be unique */
+  memset(&duplicate, 0, sizeof(duplicate));
+  init_element(&duplicate, 42);
+  CHECK_TRUE(netaddr_hash_insert(&head, &duplicate.node) != 0, "duplicate was inserted");
+  CHECK_TRUE(!netaddr_hash_is_node_added(&duplicate.node), "duplicate is marked as added");
+  CHECK_TRUE(head.count == LARGE_COUNT, "count changed by duplicate");
+
+  remove_all();
+  check_hash(__func__, __LINE__);
+  CHECK_TRUE(head._buckets == NULL && head._old_buckets == NULL, "buckets not freed");
+  END_TEST();
+}
+
+static void test_type_prefix(void) {
+  struct hash_element e1, e2, e3;
+  struct netaddr_hash_node *node;
+
+  START_TEST();
+  netaddr_hash_init(&head);
+
+  memset(&e1, 0, sizeof(e1));
+  memset(&e2, 0, sizeof(e2));
+  memset(&e3, 0, sizeof(e3));
+
+  CHECK_TRUE(netaddr_from_string(&e1.addr, "10.0.0.0/8") == 0, "cannot parse e1");
+  CHECK_TRUE(netaddr_from_string(&e2.addr, "10.0.0.0/16") == 0, "cannot parse e2");
+  CHECK_TRUE(netaddr_from_string(&e3.addr, "0a:00:00:00:00:00") == 0, "cannot parse e3");
+  e1.node.key = &e1.addr;
+  e2.node.key = &e2.addr;
+  e3.node.key = &e3.addr;
+
+  CHECK_TRUE(netaddr_hash_insert(&head, &e1.node) == 0, "insert of e1 failed");
+  CHECK_TRUE(netaddr_hash_insert(&head, &e2.node) == 0, "insert of e2 failed");
+  CHECK_TRUE(netaddr_hash_insert(&head, &e3.node) == 0, "insert of e3 failed");
+
+  node = netaddr_hash_find(&head, &e1.addr);
+  CHECK_TRUE(node == &e1.node, "e1 not found");
+  node = netaddr_hash_find(&head, &e2.addr);
+  CHECK_TRUE(node == &e2.node, "e2 not found");
+  node = netaddr_hash_find(&head, &e3.addr);
+  CHECK_TRUE(node == &e3.node, "e3 not found");
+
+  netaddr_hash_remove(&head, &e2.node);
+  CHECK_TRUE(netaddr_hash_find(&head, &e2.addr) == NULL, "e2 found after remove");
+  CHECK_TRUE(netaddr_hash_find(&head, &e1.addr) == &e1.node, "e1 lost");
+
+  /* removing a node twice does nothing */
+  netaddr_hash_remove(&head, &e2.node);
+  CHECK_TRUE(head.count == 2, "wrong count %u", head.count);
+
+  netaddr_hash_remove(&head, &e1.node);
+  netaddr_hash_remove(&head, &e3.node);
+  CHECK_TRUE(netaddr_hash_is_empty(&head), "hash not empty");
+  END_TEST();
+}
+
+static void test_random_insert_remove(void) {
+  uint32_t i, j, idx;
+
+  START_TEST();
+  netaddr_hash_init(&head);
+
+  for (i=0; i<LARGE_COUNT; i++) {
+    init_element(&elements[i], i);
+  }
+
+  /* mix inserts and removals so they happen during resizing */
+  srand(1);
+  for (i=0; i<20; i++) {
+    for (j=0; j<LARGE_COUNT/2; j++) {
+      idx = (uint32_t)rand() % LARGE_COUNT;
+      if (elements[idx].added) {
+        netaddr_hash_remove(&head, &elements[idx].node);
+      }
+      else {
+        CHECK_TRUE(netaddr_hash_insert(&head, &elements[idx].node) == 0,
+            "insert of element %u failed", idx);
+      }
+      elements[idx].added = !elements[idx].added;
+    }
+    check_hash(__func__, __LINE__);
+  }
+
+  remove_all();
+  check_hash(__func__, __LINE__);
+  END_TEST();
+}
+
+int main(int argc __attribute__ ((unused)), char **argv __attribute__ ((unused))) {
+  BEGIN_TESTING(clear_elements);
+
+  test_insert_find();
+  test_type_prefix();
+  test_random_insert_remove();
+
+  return FINISH_TESTING();
+}
@@ -0,0 +1,229 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "common/timer_wheel.h"
+#include "cunit/cunit.h"
+
+struct wheel_element {
+  uint32_t id;
+  struct timer_wheel_node node;
+};
+
+#define COUNT      2000
+#define GRANULARITY 100
+#define START      123456700ull
+
+static struct timer_wheel wheel;
+static struct wheel_element elements[COUNT];
+
+static void clear_elements(void) {
+  uint32_t i;
+
+  timer_wheel_init(&wheel, GRANULARITY, START);
+  memset(elements, 0, sizeof(elements));
+
+  for (i=0; i<COUNT; i++) {
+    elements[i].id = i;
+  }
+}
+
+static uint64_t
+get_min_key(void) {
+  uint64_t min = UINT64_MAX;
+  uint32_t i;
+
+  for (i=0; i<COUNT; i++) {
+    if (timer_wheel_is_node_added(&elements[i].node) && elements[i].node.key < min) {
+      min = elements[i].node.key;
+    }
+  }
+  return min;
+}
+
+static void test_add_remove(void) {
+  struct wheel_element *e;
+  uint32_t i;
+
+  START_TEST();
+
+  CHECK_TRUE(timer_wheel_is_empty(&wheel), "wheel not empty after init");
+  CHECK_TRUE(timer_wheel_next_element(&wheel, e, node) == NULL, "empty wheel has a next element");
+
+  for (i=0; i<COUNT; i++) {
+    /* spread keys from 100 ms up to more than a day */
+    timer_wheel_add(&wheel, &elements[i].node, START + GRANULARITY + (uint64_t)(rand() % 100000) * 1000ull);
+  }
+  CHECK_TRUE(wheel.count == COUNT, "wheel has %u elements instead of %d", wheel.count, COUNT);
+
+  e = timer_wheel_next_element(&wheel, e, node);
+  CHECK_TRUE(e != NULL && e->node.key / GRANULARITY == get_min_key() / GRANULARITY,
+      "next element has wrong key");
+
+  for (i=0; i<COUNT; i+=2) {
+    timer_wheel_remove(&wheel, &elements[i].node);
+  }
+  CHECK_TRUE(wheel.count == COUNT/2, "wheel has %u elements instead of %d", wheel.count, COUNT/2);
+
+  e = timer_wheel_next_element(&wheel, e, node);
+  CHECK_TRUE(e != NULL && e->node.key / GRANULARITY == get_min_key() / GRANULARITY,
+      "next element has wrong key after remove");
+
+  END_TEST();
+}
+
+static void test_expire_order(void) {
+  struct wheel_element *e;
+  uint64_t now, last_tick;
+  uint32_t i, fired;
+  bool order_ok, time_ok;
+
+  START_TEST();
+
+  for (i=0; i<COUNT; i++) {
+    timer_wheel_add(&wheel, &elements[i].node,
+        START + GRANULARITY + (uint64_t)(rand() % 20000) * 50ull);
+  }
+
+  fired = 0;
+  last_tick = 0;
+  order_ok = true;
+  time_ok = true;
+
+  for (now = START; now < START + 20000ull * 50ull + 2 * GRANULARITY; now += 37) {
+    while ((e = timer_wheel_expired_element(&wheel, now, e, node)) != NULL) {
+      if (e->node.key / GRANULARITY < last_tick) {
+        order_ok = false;
+      }
+      if (e->node.key / GRANULARITY > now / GRANULARITY) {
+        time_ok = false;
+      }
+      last_tick = e->node.key / GRANULARITY;
+
+      timer_wheel_remove(&wheel, &e->node);
+      fired++;
+    }
+
+    e = timer_wheel_next_element(&wheel, e, node);
+    if (e != NULL && e->node.key / GRANULARITY <= now / GRANULARITY) {
+      time_ok = false;
+    }
+  }
+
+  CHECK_TRUE(order_ok, "elements expired out of order");
+  CHECK_TRUE(time_ok, "elements expired at the wrong time");
+  CHECK_TRUE(fired == COUNT, "only %u of %d elements expired", fired, COUNT);
+  CHECK_TRUE(timer_wheel_is_empty(&wheel), "wheel not empty after expiring all elements");
+
+  END_TEST();
+}
+
+static void test_restart(void) {
+  struct wheel_element *e;
+  uint64_t now;
+  uint32_t i, fired;
+
+  START_TEST();
+
+  for (i=0; i<COUNT; i++) {
+    timer_wheel_add(&wheel, &elements[i].node, START + 1000ull * (i+1));
+  }
+
+  /* restart every second element a minute later while time advances */
+  fired = 0;
+  for (now = START; now < START + 1000ull * COUNT; now += 500) {
+    while ((e = timer_wheel_expired_element(&wheel, now, e, node)) != NULL) {
+      timer_wheel_remove(&wheel, &e->node);
+      if ((e->id & 1) == 0 && e->node.key < START + 1000ull * (COUNT + 1)) {
+        timer_wheel_add(&wheel, &e->node, e->node.key + 1000ull * COUNT);
+      }
+      else {
+        fired++;
+      }
+    }
+  }
+  CHECK_TRUE(fired == COUNT/2 - 1, "%u elements fired instead of %d", fired, COUNT/2 - 1);
+  CHECK_TRUE(wheel.count == COUNT/2 + 1, "wheel has %u elements instead of %d", wheel.count, COUNT/2 + 1);
+
+  e = timer_wheel_next_element(&wheel, e, node);
+  CHECK_TRUE(e != NULL && e->node.key == get_min_key(), "next element has wrong key after restart");
+
+  END_TEST();
+}
+
+static void test_for_each_save_macro(void) {
+  struct wheel_element *e, *ptr;
+  uint32_t i;
+
+  START_TEST();
+
+  for (i=0; i<COUNT; i++) {
+    timer_wheel_add(&wheel, &elements[i].node, START + (uint64_t)(rand() % 1000000) * 100ull);
+  }
+
+  i = 0;
+  timer_wheel_for_each_element_safe(&wheel, e, node, ptr) {
+    timer_wheel_remove(&wheel, &e->node);
+    i++;
+  }
+  CHECK_TRUE(i == COUNT, "for_each_save only had %u of %d iterations", i, COUNT);
+  CHECK_TRUE(timer_wheel_is_empty(&wheel), "for_each_save wheel not empty after loop with remove");
+
+  END_TEST();
+}
+
+int main(int argc __attribute__ ((unused)), char **argv __attribute__ ((unused))) {
+  BEGIN_TESTING(clear_elements);
+
+  test_add_remove();
+  test_expire_order();
+  test_restart();
+  test_for_each_save_macro();
+
+  return FINISH_TESTING();
+}
@@ -0,0 +1,231 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "common/common_types.h"
+#include "rfc5444/rfc5444_reader.h"
+
+/*
+ * Microbenchmark comparing the heap allocation of the transient
+ * RFC5444 reader objects (one calloc/free per TLV and address block)
+ * with the per-packet reader arena. The test packet is a single
+ * HELLO-like message with ADDR_COUNT addresses and TLVS_PER_ADDR
+ * single-index address TLVs per address. Each variant is measured
+ * without consumer (pure parsing) and with an address consumer.
+ */
+
+#define ADDR_COUNT    250
+#define ADDR_BLOCKS   2
+#define TLVS_PER_ADDR 2
+#define ROUNDS        2000
+
+static uint8_t _packet[65536];
+static size_t _packet_size;
+
+static uint32_t _addr_counter;
+
+static struct rfc5444_reader_tlvblock_consumer_entry _addr_entries[] = {
+  { .type = 1 },
+  { .type = 2 },
+};
+
+static struct rfc5444_reader_tlvblock_consumer _addr_consumer = {
+  .msg_id = 0,
+  .addrblock_consumer = true,
+};
+
+static uint64_t
+_get_ns(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static enum rfc5444_result
+_cb_addr(struct rfc5444_reader_tlvblock_context *context __attribute__((unused))) {
+  _addr_counter++;
+  return RFC5444_OKAY;
+}
+
+static struct rfc5444_reader_tlvblock_entry *
+_heap_malloc_tlvblock_entry(void) {
+  return calloc(1, sizeof(struct rfc5444_reader_tlvblock_entry));
+}
+
+static struct rfc5444_reader_addrblock_entry *
+_heap_malloc_addrblock_entry(void) {
+  return calloc(1, sizeof(struct rfc5444_reader_addrblock_entry));
+}
+
+static void
+_heap_free_tlvblock_entry(struct rfc5444_reader_tlvblock_entry *entry) {
+  free(entry);
+}
+
+static void
+_heap_free_addrblock_entry(struct rfc5444_reader_addrblock_entry *entry) {
+  free(entry);
+}
+
+static void
+_create_packet(void) {
+  uint8_t *ptr, *msg, *tlvblock;
+  size_t len;
+  int b, i, t, index;
+
+  ptr = _packet;
+
+  /* packet header: version 0, no seqno, no tlvs */
+  *ptr++ = 0;
+
+  /* message header: HELLO, 4 byte addresses */
+  msg = ptr;
+  *ptr++ = 0;
+  *ptr++ = 3;
+  ptr += 2;
+
+  /* empty message tlv block */
+  *ptr++ = 0;
+  *ptr++ = 0;
+
+  for (b=0; b<ADDR_BLOCKS; b++) {
+    /* address block without head/tail compression */
+    *ptr++ = ADDR_COUNT / ADDR_BLOCKS;
+    *ptr++ = 0;
+    for (i=0; i<ADDR_COUNT / ADDR_BLOCKS; i++) {
+      index = b * (ADDR_COUNT / ADDR_BLOCKS) + i;
+      *ptr++ = 10;
+      *ptr++ = b;
+      *ptr++ = index >> 8;
+      *ptr++ = index & 255;
+    }
+
+    /* address tlv block, one single index tlv per type and address */
+    tlvblock = ptr;
+    ptr += 2;
+    for (i=0; i<ADDR_COUNT / ADDR_BLOCKS; i++) {
+      for (t=0; t<TLVS_PER_ADDR; t++) {
+        *ptr++ = t+1;
+        *ptr++ = RFC5444_TLV_FLAG_SINGLE_IDX | RFC5444_TLV_FLAG_VALUE;
+        *ptr++ = i;
+        *ptr++ = 1;
+        *ptr++ = i;
+      }
+    }
+    len = ptr - tlvblock - 2;
+    tlvblock[0] = len >> 8;
+    tlvblock[1] = len & 255;
+  }
+
+  len = ptr - msg;
+  msg[2] = len >> 8;
+  msg[3] = len & 255;
+
+  _packet_size = ptr - _packet;
+}
+
+static void
+_run(bool arena, bool consumer) {
+  struct rfc5444_reader reader;
+  uint64_t start, duration;
+  uint32_t chunks;
+  int i;
+
+  memset(&reader, 0, sizeof(reader));
+  if (!arena) {
+    reader.malloc_tlvblock_entry = _heap_malloc_tlvblock_entry;
+    reader.malloc_addrblock_entry = _heap_malloc_addrblock_entry;
+    reader.free_tlvblock_entry = _heap_free_tlvblock_entry;
+    reader.free_addrblock_entry = _heap_free_addrblock_entry;
+  }
+  rfc5444_reader_init(&reader);
+
+  if (consumer) {
+    _addr_consumer.block_callback = _cb_addr;
+    rfc5444_reader_add_message_consumer(&reader, &_addr_consumer,
+        _addr_entries, ARRAYSIZE(_addr_entries));
+  }
+
+  /* warm up */
+  rfc5444_reader_handle_packet(&reader, _packet, _packet_size);
+  chunks = reader._arena.chunk_count;
+
+  _addr_counter = 0;
+  start = _get_ns();
+  for (i=0; i<ROUNDS; i++) {
+    rfc5444_reader_handle_packet(&reader, _packet, _packet_size);
+  }
+  duration = _get_ns() - start;
+
+  printf("%-5s %-11s %zu bytes, %u addresses: %9.1f ns/packet,"
+      " arena chunks allocated during run: %u\n",
+      arena ? "arena" : "heap", consumer ? "consumer" : "no consumer",
+      _packet_size, ADDR_COUNT, (double)duration / ROUNDS,
+      reader._arena.chunk_count - chunks);
+
+  if (consumer) {
+    rfc5444_reader_remove_message_consumer(&reader, &_addr_consumer);
+  }
+  rfc5444_reader_cleanup(&reader);
+}
+
+int
+main(int argc __attribute__ ((unused)), char **argv __attribute__ ((unused))) {
+  _create_packet();
+
+  _run(false, false);
+  _run(true, false);
+  _run(false, false);
+  _run(true, false);
+
+  _run(false, true);
+  _run(true, true);
+  return 0;
+}
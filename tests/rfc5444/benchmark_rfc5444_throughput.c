@@ -0,0 +1,603 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "common/common_types.h"
+#include "common/netaddr.h"
+#include "rfc5444/rfc5444_iana.h"
+#include "rfc5444/rfc5444_reader.h"
+#include "rfc5444/rfc5444_writer.h"
+
+#include "interop2010/test_rfc5444_interop.h"
+
+/*
+ * Throughput benchmark for the RFC5444 reader and writer.
+ *
+ * The corpus consists of the interop2010 test vectors and of synthetic
+ * NHDP HELLO and OLSRv2 TC messages with 1 to 500 addresses and link
+ * metric TLVs for two domains. Everything in the corpus is generated
+ * deterministically, so two runs of the same build parse and generate
+ * exactly the same packets.
+ *
+ * The size and a checksum of each corpus entry are printed, so a
+ * change of the writer output shows up next to the numbers.
+ *
+ * For each corpus entry the benchmark reports packets per second,
+ * nanoseconds per address and heap allocations per packet, both for
+ * parsing (reader arena chunks) and for generating the packets
+ * (writer arena chunks).
+ */
+
+/* same limits as used by oonf_rfc5444 */
+#define BENCH_PACKET_SIZE   1472
+#define BENCH_MESSAGE_SIZE  1225
+#define BENCH_ADDRTLV_SIZE  65536
+
+/* total number of addresses processed per corpus entry and operation */
+#define ROUND_ADDRESSES     400000
+#define MIN_ROUNDS          200
+
+#define MAX_PACKETS         512
+#define CORPUS_BUFFER       (MAX_PACKETS * BENCH_PACKET_SIZE)
+
+/* number of NHDP domains with their own link metric TLV */
+#define DOMAIN_COUNT        2
+
+struct _corpus_entry {
+  /* name of corpus entry */
+  const char *name;
+
+  /* message type for generation, 0 for interop vectors */
+  uint8_t msg_type;
+
+  /* address length for generation */
+  uint8_t addr_len;
+
+  /* number of addresses for generation */
+  int addr_count;
+
+  /* true if entry cannot be generated by the writer */
+  bool parse_only;
+
+  /* range of corpus packets of this entry */
+  int first_packet, packet_count;
+
+  /* number of addresses in the packets of this entry */
+  uint32_t parsed_addresses;
+};
+
+static struct _corpus_entry _corpus[] = {
+  { .name = "interop2010", .parse_only = true },
+  { .name = "HELLO ipv4", .msg_type = RFC6130_MSGTYPE_HELLO, .addr_len = 4, .addr_count = 1 },
+  { .name = "HELLO ipv4", .msg_type = RFC6130_MSGTYPE_HELLO, .addr_len = 4, .addr_count = 10 },
+  { .name = "HELLO ipv4", .msg_type = RFC6130_MSGTYPE_HELLO, .addr_len = 4, .addr_count = 50 },
+  { .name = "HELLO ipv4", .msg_type = RFC6130_MSGTYPE_HELLO, .addr_len = 4, .addr_count = 100 },
+  { .name = "HELLO ipv4", .msg_type = RFC6130_MSGTYPE_HELLO, .addr_len = 4, .addr_count = 250 },
+  { .name = "HELLO ipv4", .msg_type = RFC6130_MSGTYPE_HELLO, .addr_len = 4, .addr_count = 500 },
+  { .name = "HELLO ipv6", .msg_type = RFC6130_MSGTYPE_HELLO, .addr_len = 16, .addr_count = 10 },
+  { .name = "HELLO ipv6", .msg_type = RFC6130_MSGTYPE_HELLO, .addr_len = 16, .addr_count = 100 },
+  { .name = "HELLO ipv6", .msg_type = RFC6130_MSGTYPE_HELLO, .addr_len = 16, .addr_count = 500 },
+  { .name = "TC ipv4", .msg_type = RFC7181_MSGTYPE_TC, .addr_len = 4, .addr_count = 1 },
+  { .name = "TC ipv4", .msg_type = RFC7181_MSGTYPE_TC, .addr_len = 4, .addr_count = 10 },
+  { .name = "TC ipv4", .msg_type = RFC7181_MSGTYPE_TC, .addr_len = 4, .addr_count = 50 },
+  { .name = "TC ipv4", .msg_type = RFC7181_MSGTYPE_TC, .addr_len = 4, .addr_count = 100 },
+  { .name = "TC ipv4", .msg_type = RFC7181_MSGTYPE_TC, .addr_len = 4, .addr_count = 250 },
+  { .name = "TC ipv4", .msg_type = RFC7181_MSGTYPE_TC, .addr_len = 4, .addr_count = 500 },
+  { .name = "TC ipv6", .msg_type = RFC7181_MSGTYPE_TC, .addr_len = 16, .addr_count = 10 },
+  { .name = "TC ipv6", .msg_type = RFC7181_MSGTYPE_TC, .addr_len = 16, .addr_count = 100 },
+  { .name = "TC ipv6", .msg_type = RFC7181_MSGTYPE_TC, .addr_len = 16, .addr_count = 500 },
+};
+
+/* storage for corpus packets */
+static uint8_t _corpus_buffer[CORPUS_BUFFER];
+static size_t _corpus_used;
+static uint8_t *_packets[MAX_PACKETS];
+static size_t _packet_size[MAX_PACKETS];
+static int _packet_count;
+
+/* true while the writer output is stored into the corpus */
+static bool _capture;
+
+/* corpus entry the writer is generating */
+static struct _corpus_entry *_current;
+
+/* statistics */
+static uint32_t _written_packets;
+static uint32_t _parsed_addresses;
+
+/* writer */
+static uint8_t _msg_buffer[BENCH_MESSAGE_SIZE];
+static uint8_t _addrtlv_buffer[BENCH_ADDRTLV_SIZE];
+static uint8_t _packet_buffer[BENCH_PACKET_SIZE];
+
+static int _cb_add_message_header(struct rfc5444_writer *, struct rfc5444_writer_message *);
+static void _cb_add_message_tlvs(struct rfc5444_writer *);
+static void _cb_add_addresses(struct rfc5444_writer *);
+static void _cb_send_packet(struct rfc5444_writer *,
+    struct rfc5444_writer_target *, void *, size_t);
+
+static struct rfc5444_writer _writer = {
+  .msg_buffer = _msg_buffer,
+  .msg_size = sizeof(_msg_buffer),
+  .addrtlv_buffer = _addrtlv_buffer,
+  .addrtlv_size = sizeof(_addrtlv_buffer),
+};
+
+static struct rfc5444_writer_target _target = {
+  .packet_buffer = _packet_buffer,
+  .packet_size = sizeof(_packet_buffer),
+  .sendPacket = _cb_send_packet,
+};
+
+enum {
+  IDX_HELLO_LOCAL_IF,
+  IDX_HELLO_LINK_STATUS,
+  IDX_HELLO_MPR,
+  IDX_HELLO_METRIC,
+};
+
+static struct rfc5444_writer_tlvtype _hello_addrtlvs[] = {
+  [IDX_HELLO_LOCAL_IF] = { .type = RFC6130_ADDRTLV_LOCAL_IF },
+  [IDX_HELLO_LINK_STATUS] = { .type = RFC6130_ADDRTLV_LINK_STATUS },
+  [IDX_HELLO_MPR] = { .type = RFC7181_ADDRTLV_MPR },
+  [IDX_HELLO_METRIC + 0] = { .type = RFC7181_ADDRTLV_LINK_METRIC, .exttype = 0 },
+  [IDX_HELLO_METRIC + 1] = { .type = RFC7181_ADDRTLV_LINK_METRIC, .exttype = 1 },
+};
+
+enum {
+  IDX_TC_NBR_ADDR_TYPE,
+  IDX_TC_METRIC,
+};
+
+static struct rfc5444_writer_tlvtype _tc_addrtlvs[] = {
+  [IDX_TC_NBR_ADDR_TYPE] = { .type = RFC7181_ADDRTLV_NBR_ADDR_TYPE },
+  [IDX_TC_METRIC + 0] = { .type = RFC7181_ADDRTLV_LINK_METRIC, .exttype = 0 },
+  [IDX_TC_METRIC + 1] = { .type = RFC7181_ADDRTLV_LINK_METRIC, .exttype = 1 },
+};
+
+static struct rfc5444_writer_content_provider _hello_provider = {
+  .msg_type = RFC6130_MSGTYPE_HELLO,
+  .addMessageTLVs = _cb_add_message_tlvs,
+  .addAddresses = _cb_add_addresses,
+};
+
+static struct rfc5444_writer_content_provider _tc_provider = {
+  .msg_type = RFC7181_MSGTYPE_TC,
+  .addMessageTLVs = _cb_add_message_tlvs,
+  .addAddresses = _cb_add_addresses,
+};
+
+/* reader */
+static enum rfc5444_result _cb_address_block(struct rfc5444_reader_tlvblock_context *);
+
+static struct rfc5444_reader _reader;
+
+static struct rfc5444_reader_tlvblock_consumer_entry _msg_entries[] = {
+  { .type = RFC5497_MSGTLV_VALIDITY_TIME, .match_type_ext = true },
+  { .type = RFC5497_MSGTLV_INTERVAL_TIME, .match_type_ext = true },
+  { .type = RFC7181_MSGTLV_CONT_SEQ_NUM },
+};
+
+static struct rfc5444_reader_tlvblock_consumer _msg_consumer = {
+  .default_msg_consumer = true,
+};
+
+static struct rfc5444_reader_tlvblock_consumer_entry _addr_entries[] = {
+  { .type = RFC6130_ADDRTLV_LOCAL_IF, .match_type_ext = true },
+  { .type = RFC6130_ADDRTLV_LINK_STATUS, .match_type_ext = true },
+  { .type = RFC7181_ADDRTLV_LINK_METRIC, .min_length = 2, .match_length = true },
+  { .type = RFC7181_ADDRTLV_MPR, .match_type_ext = true },
+  { .type = RFC7181_ADDRTLV_NBR_ADDR_TYPE, .match_type_ext = true },
+};
+
+static struct rfc5444_reader_tlvblock_consumer _addr_consumer = {
+  .default_msg_consumer = true,
+  .addrblock_consumer = true,
+  .block_callback = _cb_address_block,
+};
+
+/**
+ * @return monotonic time in nanoseconds
+ */
+static uint64_t
+_get_ns(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * Deterministic pseudo random numbers for TLV values
+ * @param value input value
+ * @return scrambled value
+ */
+static uint32_t
+_scramble(uint32_t value) {
+  value ^= value >> 16;
+  value *= 0x7feb352d;
+  value ^= value >> 15;
+  value *= 0x846ca68b;
+  value ^= value >> 16;
+  return value;
+}
+
+/**
+ * Calculate FNV-1a checksum over the packets of a corpus entry
+ * @param entry corpus entry
+ * @param size pointer to variable for total size of packets
+ * @return checksum
+ */
+static uint32_t
+_get_checksum(struct _corpus_entry *entry, size_t *size) {
+  uint32_t hash = 2166136261u;
+  size_t i;
+  int p;
+
+  *size = 0;
+  for (p=entry->first_packet; p<entry->first_packet + entry->packet_count; p++) {
+    for (i=0; i<_packet_size[p]; i++) {
+      hash ^= _packets[p][i];
+      hash *= 16777619u;
+    }
+    *size += _packet_size[p];
+  }
+  return hash;
+}
+
+/**
+ * Store a packet in the corpus
+ * @param ptr pointer to packet
+ * @param len length of packet
+ */
+static void
+_add_packet(const void *ptr, size_t len) {
+  if (_packet_count == MAX_PACKETS || _corpus_used + len > sizeof(_corpus_buffer)) {
+    fprintf(stderr, "Corpus buffer is too small\n");
+    exit(1);
+  }
+
+  _packets[_packet_count] = &_corpus_buffer[_corpus_used];
+  _packet_size[_packet_count] = len;
+  memcpy(_packets[_packet_count], ptr, len);
+
+  _corpus_used += len;
+  _packet_count++;
+}
+
+/**
+ * Called by the interop2010 vectors to register themselves
+ * @param p interop test packet
+ */
+void
+add_test(struct test_packet *p) {
+  _add_packet(p->binary, p->binlen);
+}
+
+static int
+_cb_add_message_header(struct rfc5444_writer *wr, struct rfc5444_writer_message *msg) {
+  static const uint8_t orig[16] = { 10, 0, 0, 1 };
+  static uint16_t seqno = 0;
+
+  if (msg->type == RFC6130_MSGTYPE_HELLO) {
+    rfc5444_writer_set_msg_header(wr, msg, false, false, false, false);
+    return RFC5444_OKAY;
+  }
+
+  rfc5444_writer_set_msg_header(wr, msg, true, true, true, true);
+  rfc5444_writer_set_msg_originator(wr, msg, orig);
+  rfc5444_writer_set_msg_hopcount(wr, msg, 0);
+  rfc5444_writer_set_msg_hoplimit(wr, msg, 255);
+  rfc5444_writer_set_msg_seqno(wr, msg, seqno++);
+  return RFC5444_OKAY;
+}
+
+static void
+_cb_add_message_tlvs(struct rfc5444_writer *wr) {
+  uint8_t vtime = 0x6b, itime = 0x4b, willingness = 7;
+  uint16_t ansn = htons(0x1234);
+
+  rfc5444_writer_add_messagetlv(wr, RFC5497_MSGTLV_VALIDITY_TIME, 0, &vtime, sizeof(vtime));
+  rfc5444_writer_add_messagetlv(wr, RFC5497_MSGTLV_INTERVAL_TIME, 0, &itime, sizeof(itime));
+
+  if (_current->msg_type == RFC6130_MSGTYPE_HELLO) {
+    rfc5444_writer_add_messagetlv(wr, RFC7181_MSGTLV_MPR_WILLING, 0,
+        &willingness, sizeof(willingness));
+  }
+  else {
+    rfc5444_writer_add_messagetlv(wr, RFC7181_MSGTLV_CONT_SEQ_NUM,
+        RFC7181_CONT_SEQ_NUM_COMPLETE, &ansn, sizeof(ansn));
+  }
+}
+
+static void
+_cb_add_addresses(struct rfc5444_writer *wr) {
+  struct rfc5444_writer_content_provider *provider;
+  struct rfc5444_writer_tlvtype *metric;
+  struct rfc5444_writer_address *addr;
+  struct netaddr naddr;
+  uint8_t binary[16];
+  uint8_t value;
+  uint16_t linkmetric;
+  uint32_t rnd;
+  int i, d;
+
+  if (_current->msg_type == RFC6130_MSGTYPE_HELLO) {
+    provider = &_hello_provider;
+    metric = &_hello_addrtlvs[IDX_HELLO_METRIC];
+  }
+  else {
+    provider = &_tc_provider;
+    metric = &_tc_addrtlvs[IDX_TC_METRIC];
+  }
+
+  memset(binary, 0, sizeof(binary));
+  if (_current->addr_len == 4) {
+    binary[0] = 10;
+  }
+  else {
+    binary[0] = 0xfd;
+  }
+
+  for (i=0; i<_current->addr_count; i++) {
+    rnd = _scramble(i);
+
+    /* neighbors share the prefix and differ in the last two bytes */
+    binary[_current->addr_len - 2] = (uint8_t)(i / 250 + 1);
+    binary[_current->addr_len - 1] = (uint8_t)(i % 250 + 1);
+    netaddr_from_binary(&naddr, binary, _current->addr_len, 0);
+
+    addr = rfc5444_writer_add_address(wr, provider->creator, &naddr, false);
+    if (addr == NULL) {
+      continue;
+    }
+
+    if (_current->msg_type == RFC6130_MSGTYPE_HELLO) {
+      if (i == 0) {
+        /* first address is the local interface */
+        value = RFC6130_LOCALIF_THIS_IF;
+        rfc5444_writer_add_addrtlv(wr, addr, &_hello_addrtlvs[IDX_HELLO_LOCAL_IF],
+            &value, sizeof(value), false);
+        continue;
+      }
+
+      value = (rnd & 7) == 0 ? RFC6130_LINKSTATUS_HEARD : RFC6130_LINKSTATUS_SYMMETRIC;
+      rfc5444_writer_add_addrtlv(wr, addr, &_hello_addrtlvs[IDX_HELLO_LINK_STATUS],
+          &value, sizeof(value), false);
+
+      if (i % 5 == 0) {
+        value = RFC7181_MPR_FLOODING;
+        rfc5444_writer_add_addrtlv(wr, addr, &_hello_addrtlvs[IDX_HELLO_MPR],
+            &value, sizeof(value), false);
+      }
+    }
+    else {
+      value = RFC7181_NBR_ADDR_TYPE_ORIGINATOR | RFC7181_NBR_ADDR_TYPE_ROUTABLE;
+      rfc5444_writer_add_addrtlv(wr, addr, &_tc_addrtlvs[IDX_TC_NBR_ADDR_TYPE],
+          &value, sizeof(value), false);
+    }
+
+    /* one link metric per domain */
+    for (d=0; d<DOMAIN_COUNT; d++) {
+      linkmetric = htons((RFC7181_LINKMETRIC_OUTGOING_NEIGH << 8)
+          | (uint16_t)((rnd >> (d * 12)) & 0x0fff));
+      rfc5444_writer_add_addrtlv(wr, addr, &metric[d],
+          &linkmetric, sizeof(linkmetric), false);
+    }
+  }
+}
+
+static void
+_cb_send_packet(struct rfc5444_writer *wr __attribute__((unused)),
+    struct rfc5444_writer_target *target __attribute__((unused)),
+    void *ptr, size_t len) {
+  if (_capture) {
+    _add_packet(ptr, len);
+  }
+  _written_packets++;
+}
+
+static enum rfc5444_result
+_cb_address_block(struct rfc5444_reader_tlvblock_context *context __attribute__((unused))) {
+  _parsed_addresses++;
+  return RFC5444_OKAY;
+}
+
+/**
+ * Generate all packets of a corpus entry once
+ * @param entry corpus entry
+ */
+static void
+_generate(struct _corpus_entry *entry) {
+  _current = entry;
+  rfc5444_writer_create_message_alltarget(&_writer, entry->msg_type, entry->addr_len);
+  rfc5444_writer_flush(&_writer, &_target, true);
+}
+
+/**
+ * Calculate number of rounds for a corpus entry
+ * @param addresses number of addresses in the corpus entry
+ * @return number of rounds
+ */
+static int
+_get_rounds(uint32_t addresses) {
+  int rounds;
+
+  rounds = ROUND_ADDRESSES / (addresses > 0 ? addresses : 1);
+  return rounds < MIN_ROUNDS ? MIN_ROUNDS : rounds;
+}
+
+/**
+ * Measure parsing of the packets of a corpus entry
+ * @param entry corpus entry
+ */
+static void
+_measure_parse(struct _corpus_entry *entry) {
+  uint64_t start, duration;
+  uint32_t chunks, packets, addresses;
+  int i, p, rounds;
+
+  rounds = _get_rounds(entry->parsed_addresses);
+  packets = (uint32_t)rounds * entry->packet_count;
+  addresses = (uint32_t)rounds * entry->parsed_addresses;
+
+  chunks = _reader._arena.chunk_count;
+  start = _get_ns();
+  for (i=0; i<rounds; i++) {
+    for (p=entry->first_packet; p<entry->first_packet + entry->packet_count; p++) {
+      rfc5444_reader_handle_packet(&_reader, _packets[p], _packet_size[p]);
+    }
+  }
+  duration = _get_ns() - start;
+
+  printf("  parse    %10.0f pkt/s %8.1f ns/addr %6.2f allocs/pkt\n",
+      (double)packets * 1e9 / (double)duration,
+      addresses > 0 ? (double)duration / addresses : 0.0,
+      (double)(_reader._arena.chunk_count - chunks) / packets);
+}
+
+/**
+ * Measure generation of the packets of a corpus entry
+ * @param entry corpus entry
+ */
+static void
+_measure_generate(struct _corpus_entry *entry) {
+  uint64_t start, duration;
+  uint32_t addresses, chunks;
+  int i, rounds;
+
+  rounds = _get_rounds(entry->addr_count);
+  addresses = (uint32_t)rounds * entry->addr_count;
+
+  _written_packets = 0;
+  chunks = _writer._arena.chunk_count;
+
+  start = _get_ns();
+  for (i=0; i<rounds; i++) {
+    _generate(entry);
+  }
+  duration = _get_ns() - start;
+
+  printf("  generate %10.0f pkt/s %8.1f ns/addr %6.2f allocs/pkt\n",
+      (double)_written_packets * 1e9 / (double)duration,
+      (double)duration / addresses,
+      (double)(_writer._arena.chunk_count - chunks) / _written_packets);
+}
+
+int
+main(int argc __attribute__ ((unused)), char **argv __attribute__ ((unused))) {
+  struct rfc5444_writer_message *msg;
+  struct _corpus_entry *entry;
+  size_t i, size;
+  uint32_t checksum;
+  int p;
+
+  rfc5444_reader_init(&_reader);
+  rfc5444_reader_add_message_consumer(&_reader, &_msg_consumer,
+      _msg_entries, ARRAYSIZE(_msg_entries));
+  rfc5444_reader_add_message_consumer(&_reader, &_addr_consumer,
+      _addr_entries, ARRAYSIZE(_addr_entries));
+
+  rfc5444_writer_init(&_writer);
+  rfc5444_writer_register_target(&_writer, &_target);
+
+  msg = rfc5444_writer_register_message(&_writer, RFC6130_MSGTYPE_HELLO, false);
+  msg->addMessageHeader = _cb_add_message_header;
+  msg = rfc5444_writer_register_message(&_writer, RFC7181_MSGTYPE_TC, false);
+  msg->addMessageHeader = _cb_add_message_header;
+
+  rfc5444_writer_register_msgcontentprovider(&_writer, &_hello_provider,
+      _hello_addrtlvs, ARRAYSIZE(_hello_addrtlvs));
+  rfc5444_writer_register_msgcontentprovider(&_writer, &_tc_provider,
+      _tc_addrtlvs, ARRAYSIZE(_tc_addrtlvs));
+
+  /* interop vectors have been added to the corpus by their constructors */
+  _corpus[0].first_packet = 0;
+  _corpus[0].packet_count = _packet_count;
+
+  /* generate synthetic part of corpus */
+  _capture = true;
+  for (i=1; i<ARRAYSIZE(_corpus); i++) {
+    _corpus[i].first_packet = _packet_count;
+    _generate(&_corpus[i]);
+    _corpus[i].packet_count = _packet_count - _corpus[i].first_packet;
+  }
+  _capture = false;
+
+  /* count addresses in corpus and warm up reader arena */
+  for (i=0; i<ARRAYSIZE(_corpus); i++) {
+    entry = &_corpus[i];
+
+    _parsed_addresses = 0;
+    for (p=entry->first_packet; p<entry->first_packet + entry->packet_count; p++) {
+      rfc5444_reader_handle_packet(&_reader, _packets[p], _packet_size[p]);
+    }
+    entry->parsed_addresses = _parsed_addresses;
+  }
+
+  for (i=0; i<ARRAYSIZE(_corpus); i++) {
+    entry = &_corpus[i];
+
+    checksum = _get_checksum(entry, &size);
+    printf("%-12s %3d addresses: %3d packets, %6zu bytes, checksum %08x\n",
+        entry->name, (int)entry->parsed_addresses, entry->packet_count,
+        size, checksum);
+
+    _measure_parse(entry);
+    if (!entry->parse_only) {
+      _measure_generate(entry);
+    }
+  }
+
+  rfc5444_writer_cleanup(&_writer);
+  rfc5444_reader_remove_message_consumer(&_reader, &_addr_consumer);
+  rfc5444_reader_remove_message_consumer(&_reader, &_msg_consumer);
+  rfc5444_reader_cleanup(&_reader);
+  return 0;
+}
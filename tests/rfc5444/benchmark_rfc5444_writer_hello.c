@@ -0,0 +1,261 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "common/common_types.h"
+#include "common/netaddr.h"
+#include "rfc5444/rfc5444_iana.h"
+#include "rfc5444/rfc5444_writer.h"
+
+/*
+ * Microbenchmark for the generation of a NHDP HELLO with NEIGHBOR_COUNT
+ * neighbors. Each neighbor has a link status TLV, an incoming and an
+ * outgoing link metric TLV for DOMAIN_COUNT domains and every fifth
+ * neighbor has a MPR TLV.
+ *
+ * The HELLO is generated once with writer addresses allocated from the
+ * heap (malloc_address_entry callback) and once with all addresses and
+ * address TLVs in the writer arena. For both variants the time per
+ * HELLO and the number of heap allocations per HELLO are reported.
+ */
+
+#define NEIGHBOR_COUNT 300
+#define DOMAIN_COUNT   2
+#define ROUNDS         2000
+
+/* same limits as used by oonf_rfc5444 */
+#define BENCH_PACKET_SIZE   1472
+#define BENCH_MESSAGE_SIZE  1225
+#define BENCH_ADDRTLV_SIZE  65536
+
+enum {
+  IDX_LOCAL_IF,
+  IDX_LINK_STATUS,
+  IDX_MPR,
+  IDX_METRIC,
+};
+
+static struct rfc5444_writer_address *_cb_heap_malloc_address_entry(void);
+static void _cb_heap_free_address_entry(struct rfc5444_writer_address *);
+static int _cb_add_message_header(struct rfc5444_writer *, struct rfc5444_writer_message *);
+static void _cb_add_addresses(struct rfc5444_writer *);
+static void _cb_send_packet(struct rfc5444_writer *,
+    struct rfc5444_writer_target *, void *, size_t);
+
+static uint8_t _msg_buffer[BENCH_MESSAGE_SIZE];
+static uint8_t _addrtlv_buffer[BENCH_ADDRTLV_SIZE];
+static uint8_t _packet_buffer[BENCH_PACKET_SIZE];
+
+static struct rfc5444_writer _writer = {
+  .msg_buffer = _msg_buffer,
+  .msg_size = sizeof(_msg_buffer),
+  .addrtlv_buffer = _addrtlv_buffer,
+  .addrtlv_size = sizeof(_addrtlv_buffer),
+};
+
+static struct rfc5444_writer_target _target = {
+  .packet_buffer = _packet_buffer,
+  .packet_size = sizeof(_packet_buffer),
+  .sendPacket = _cb_send_packet,
+};
+
+static struct rfc5444_writer_tlvtype _addrtlvs[] = {
+  [IDX_LOCAL_IF] = { .type = RFC6130_ADDRTLV_LOCAL_IF },
+  [IDX_LINK_STATUS] = { .type = RFC6130_ADDRTLV_LINK_STATUS },
+  [IDX_MPR] = { .type = RFC7181_ADDRTLV_MPR },
+  [IDX_METRIC + 0] = { .type = RFC7181_ADDRTLV_LINK_METRIC, .exttype = 0 },
+  [IDX_METRIC + 1] = { .type = RFC7181_ADDRTLV_LINK_METRIC, .exttype = 1 },
+};
+
+static struct rfc5444_writer_content_provider _provider = {
+  .msg_type = RFC6130_MSGTYPE_HELLO,
+  .addAddresses = _cb_add_addresses,
+};
+
+static uint32_t _heap_allocations;
+static uint32_t _packets;
+static size_t _bytes;
+
+static uint64_t
+_get_ns(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static struct rfc5444_writer_address *
+_cb_heap_malloc_address_entry(void) {
+  _heap_allocations++;
+  return calloc(1, sizeof(struct rfc5444_writer_address));
+}
+
+static void
+_cb_heap_free_address_entry(struct rfc5444_writer_address *addr) {
+  free(addr);
+}
+
+static int
+_cb_add_message_header(struct rfc5444_writer *wr, struct rfc5444_writer_message *msg) {
+  rfc5444_writer_set_msg_header(wr, msg, false, false, false, false);
+  return RFC5444_OKAY;
+}
+
+static void
+_cb_add_addresses(struct rfc5444_writer *wr) {
+  struct rfc5444_writer_address *addr;
+  struct netaddr naddr;
+  uint8_t binary[4] = { 10, 0, 0, 0 };
+  uint16_t linkmetric;
+  uint8_t value;
+  int i, d;
+
+  /* local interface */
+  binary[3] = 1;
+  netaddr_from_binary(&naddr, binary, sizeof(binary), 0);
+  addr = rfc5444_writer_add_address(wr, _provider.creator, &naddr, true);
+  value = RFC6130_LOCALIF_THIS_IF;
+  rfc5444_writer_add_addrtlv(wr, addr, &_addrtlvs[IDX_LOCAL_IF],
+      &value, sizeof(value), false);
+
+  for (i=0; i<NEIGHBOR_COUNT; i++) {
+    binary[2] = (uint8_t)(i / 250 + 1);
+    binary[3] = (uint8_t)(i % 250 + 2);
+    netaddr_from_binary(&naddr, binary, sizeof(binary), 0);
+
+    addr = rfc5444_writer_add_address(wr, _provider.creator, &naddr, false);
+    if (addr == NULL) {
+      continue;
+    }
+
+    value = RFC6130_LINKSTATUS_SYMMETRIC;
+    rfc5444_writer_add_addrtlv(wr, addr, &_addrtlvs[IDX_LINK_STATUS],
+        &value, sizeof(value), false);
+
+    if (i % 5 == 0) {
+      value = RFC7181_MPR_FLOODING;
+      rfc5444_writer_add_addrtlv(wr, addr, &_addrtlvs[IDX_MPR],
+          &value, sizeof(value), false);
+    }
+
+    /* incoming and outgoing link metric per domain */
+    for (d=0; d<DOMAIN_COUNT; d++) {
+      linkmetric = htons((RFC7181_LINKMETRIC_INCOMING_LINK << 8) | (uint16_t)(i & 0x0fff));
+      rfc5444_writer_add_addrtlv(wr, addr, &_addrtlvs[IDX_METRIC + d],
+          &linkmetric, sizeof(linkmetric), true);
+      linkmetric = htons((RFC7181_LINKMETRIC_OUTGOING_LINK << 8) | (uint16_t)((i + d) & 0x0fff));
+      rfc5444_writer_add_addrtlv(wr, addr, &_addrtlvs[IDX_METRIC + d],
+          &linkmetric, sizeof(linkmetric), true);
+    }
+  }
+}
+
+static void
+_cb_send_packet(struct rfc5444_writer *wr __attribute__((unused)),
+    struct rfc5444_writer_target *target __attribute__((unused)),
+    void *ptr __attribute__((unused)), size_t len) {
+  _packets++;
+  _bytes += len;
+}
+
+static void
+_measure(const char *name) {
+  uint64_t start, duration;
+  uint32_t chunks;
+  int i;
+
+  /* warm up the allocators */
+  rfc5444_writer_create_message_alltarget(&_writer, RFC6130_MSGTYPE_HELLO, 4);
+  rfc5444_writer_flush(&_writer, &_target, true);
+
+  _heap_allocations = 0;
+  _packets = 0;
+  _bytes = 0;
+  chunks = _writer._arena.chunk_count;
+
+  start = _get_ns();
+  for (i=0; i<ROUNDS; i++) {
+    rfc5444_writer_create_message_alltarget(&_writer, RFC6130_MSGTYPE_HELLO, 4);
+    rfc5444_writer_flush(&_writer, &_target, true);
+  }
+  duration = _get_ns() - start;
+
+  printf("%-6s %8.1f us/HELLO %8.1f ns/neighbor %7.2f allocs/HELLO %3u packets %5zu bytes\n",
+      name, (double)duration / ROUNDS / 1000.0,
+      (double)duration / ROUNDS / NEIGHBOR_COUNT,
+      (double)(_heap_allocations + _writer._arena.chunk_count - chunks) / ROUNDS,
+      _packets / ROUNDS, _bytes / ROUNDS);
+}
+
+int
+main(int argc __attribute__ ((unused)), char **argv __attribute__ ((unused))) {
+  struct rfc5444_writer_message *msg;
+
+  rfc5444_writer_init(&_writer);
+  rfc5444_writer_register_target(&_writer, &_target);
+
+  msg = rfc5444_writer_register_message(&_writer, RFC6130_MSGTYPE_HELLO, false);
+  msg->addMessageHeader = _cb_add_message_header;
+
+  rfc5444_writer_register_msgcontentprovider(&_writer, &_provider,
+      _addrtlvs, ARRAYSIZE(_addrtlvs));
+
+  printf("HELLO with %d neighbors, %d link metric domains\n", NEIGHBOR_COUNT, DOMAIN_COUNT);
+
+  _writer.malloc_address_entry = _cb_heap_malloc_address_entry;
+  _writer.free_address_entry = _cb_heap_free_address_entry;
+  _measure("heap");
+
+  _writer.malloc_address_entry = NULL;
+  _writer.free_address_entry = NULL;
+  _measure("arena");
+
+  rfc5444_writer_cleanup(&_writer);
+  return 0;
+}
@@ -0,0 +1,124 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+#include <string.h>
+#include <stdio.h>
+
+#include "common/common_types.h"
+#include "rfc5444/rfc5444_reader.h"
+#include "cunit/cunit.h"
+
+/* rfc5444 test messages */
+static uint8_t testpacket[] = {
+/* packet without tlvblock and sequence number */
+    0x00,
+/* message type 1, address length 4, size 17 */
+    1, 0x03, 0, 17,
+/* message tlvblock, 3 TLVs type 1:0, 1 TLV type 1:1 */
+    0, 11,
+    1, 0x80, 0,
+    1, 0x80, 0,
+    1, 0x80, 1,
+    1, 0x00,
+};
+
+static struct rfc5444_reader reader;
+static struct rfc5444_reader_tlvblock_consumer consumer = {
+  .order = 1,
+  .msg_id = 1,
+};
+
+static struct rfc5444_reader_tlvblock_consumer_entry entries[] = {
+  { .type = 1, .type_ext = 0, .match_type_ext = true },
+  { .type = 1, .type_ext = 1, .match_type_ext = true },
+};
+
+static int chain_length[ARRAYSIZE(entries)];
+static int msg_count;
+
+static enum rfc5444_result
+cb_message(struct rfc5444_reader_tlvblock_context *cont __attribute__ ((unused))) {
+  struct rfc5444_reader_tlvblock_entry *tlv;
+  size_t i;
+
+  for (i=0; i<ARRAYSIZE(entries); i++) {
+    for (tlv = entries[i].tlv; tlv != NULL; tlv = tlv->next_entry) {
+      chain_length[i]++;
+    }
+  }
+  msg_count++;
+  return RFC5444_OKAY;
+}
+
+static void clear_elements(void) {
+  memset(chain_length, 0, sizeof(chain_length));
+  msg_count = 0;
+}
+
+static void test_separate_chains(void) {
+  START_TEST();
+
+  rfc5444_reader_handle_packet(&reader, testpacket, sizeof(testpacket));
+
+  CHECK_TRUE(msg_count == 1, "message consumer called %d times", msg_count);
+  CHECK_TRUE(chain_length[0] == 3, "%d TLVs of type 1:0 instead of 3", chain_length[0]);
+  CHECK_TRUE(chain_length[1] == 1, "%d TLVs of type 1:1 instead of 1", chain_length[1]);
+  END_TEST();
+}
+
+int main(int argc __attribute__ ((unused)), char **argv __attribute__ ((unused))) {
+  rfc5444_reader_init(&reader);
+
+  rfc5444_reader_add_message_consumer(&reader, &consumer,
+      entries, ARRAYSIZE(entries));
+  consumer.block_callback = cb_message;
+
+  BEGIN_TESTING(clear_elements);
+
+  test_separate_chains();
+
+  rfc5444_reader_cleanup(&reader);
+
+  return FINISH_TESTING();
+}
@@ -0,0 +1,139 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+#include <string.h>
+#include <stdio.h>
+
+#include "common/common_types.h"
+#include "rfc5444/rfc5444_reader.h"
+#include "cunit/cunit.h"
+
+/* rfc5444 test messages */
+static uint8_t testpacket[] = {
+/* packet without tlvblock and sequence number */
+    0x00,
+/* message type 1, address length 4, size 6, empty tlvblock */
+    1, 0x03, 0, 6, 0, 0,
+};
+
+static struct rfc5444_reader reader;
+static struct rfc5444_reader_tlvblock_consumer first_consumer = {
+  .order = 1,
+  .msg_id = 1,
+};
+static struct rfc5444_reader_tlvblock_consumer second_consumer = {
+  .order = 2,
+  .msg_id = 1,
+};
+
+static int first_count, second_start_count, second_end_count;
+
+static enum rfc5444_result
+cb_first_start(struct rfc5444_reader_tlvblock_context *cont __attribute__ ((unused))) {
+  /* unregister the next consumer in the middle of the message */
+  rfc5444_reader_remove_message_consumer(&reader, &second_consumer);
+  first_count++;
+  return RFC5444_OKAY;
+}
+
+static enum rfc5444_result
+cb_second_start(struct rfc5444_reader_tlvblock_context *cont __attribute__ ((unused))) {
+  second_start_count++;
+  return RFC5444_OKAY;
+}
+
+static enum rfc5444_result
+cb_second_end(struct rfc5444_reader_tlvblock_context *cont __attribute__ ((unused)),
+    bool dropped __attribute__ ((unused))) {
+  second_end_count++;
+  return RFC5444_OKAY;
+}
+
+static void clear_elements(void) {
+  first_count = 0;
+  second_start_count = 0;
+  second_end_count = 0;
+}
+
+static void test_remove_in_callback(void) {
+  START_TEST();
+
+  rfc5444_reader_handle_packet(&reader, testpacket, sizeof(testpacket));
+
+  CHECK_TRUE(first_count == 1, "first consumer called %d times", first_count);
+  CHECK_TRUE(second_start_count == 0,
+      "removed consumer start callback called %d times", second_start_count);
+  CHECK_TRUE(second_end_count == 0,
+      "removed consumer end callback called %d times", second_end_count);
+  END_TEST();
+}
+
+static void test_next_message(void) {
+  START_TEST();
+
+  rfc5444_reader_handle_packet(&reader, testpacket, sizeof(testpacket));
+
+  CHECK_TRUE(first_count == 1, "first consumer called %d times", first_count);
+  CHECK_TRUE(second_start_count == 0,
+      "removed consumer called %d times", second_start_count);
+  END_TEST();
+}
+
+int main(int argc __attribute__ ((unused)), char **argv __attribute__ ((unused))) {
+  rfc5444_reader_init(&reader);
+  first_consumer.start_callback = cb_first_start;
+  second_consumer.start_callback = cb_second_start;
+  second_consumer.end_callback = cb_second_end;
+  rfc5444_reader_add_message_consumer(&reader, &first_consumer, NULL, 0);
+  rfc5444_reader_add_message_consumer(&reader, &second_consumer, NULL, 0);
+
+  BEGIN_TESTING(clear_elements);
+
+  test_remove_in_callback();
+  test_next_message();
+
+  rfc5444_reader_cleanup(&reader);
+
+  return FINISH_TESTING();
+}
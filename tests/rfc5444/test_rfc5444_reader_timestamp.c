@@ -0,0 +1,165 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+#include <string.h>
+#include <stdio.h>
+
+#include "common/common_types.h"
+#include "rfc5444/rfc5444_reader.h"
+#include "cunit/cunit.h"
+
+#define TIMESTAMP UINT64_C(1234567890123)
+
+/* rfc5444 test messages */
+static uint8_t testpacket[] = {
+/* packet without tlvblock and sequence number */
+    0x00,
+/* message type 1, address length 4, size 6, empty tlvblock */
+    1, 0x03, 0, 6, 0, 0,
+};
+
+static uint8_t badpacket[] = {
+/* packet with unsupported version */
+    0x10,
+};
+
+static struct rfc5444_reader reader;
+static struct rfc5444_reader_tlvblock_consumer pkt_consumer = {
+  .order = 1,
+};
+static struct rfc5444_reader_tlvblock_consumer msg_consumer = {
+  .order = 1,
+  .msg_id = 1,
+};
+
+static uint64_t pkt_timestamp;
+static uint64_t msg_timestamp;
+static int pkt_count, msg_count;
+
+static enum rfc5444_result
+cb_packet(struct rfc5444_reader_tlvblock_context *cont) {
+  pkt_timestamp = cont->pkt_timestamp;
+  pkt_count++;
+  return RFC5444_OKAY;
+}
+
+static enum rfc5444_result
+cb_message(struct rfc5444_reader_tlvblock_context *cont) {
+  msg_timestamp = cont->pkt_timestamp;
+  msg_count++;
+  return RFC5444_OKAY;
+}
+
+static void clear_elements(void) {
+  pkt_timestamp = 0;
+  msg_timestamp = 0;
+  pkt_count = 0;
+  msg_count = 0;
+}
+
+static void test_timestamp(void) {
+  START_TEST();
+
+  reader.rx_timestamp = TIMESTAMP;
+  rfc5444_reader_handle_packet(&reader, testpacket, sizeof(testpacket));
+
+  CHECK_TRUE(pkt_count == 1, "packet consumer called %d times", pkt_count);
+  CHECK_TRUE(msg_count == 1, "message consumer called %d times", msg_count);
+  CHECK_TRUE(pkt_timestamp == TIMESTAMP,
+      "packet timestamp %"PRIu64" instead of %"PRIu64, pkt_timestamp, TIMESTAMP);
+  CHECK_TRUE(msg_timestamp == TIMESTAMP,
+      "message timestamp %"PRIu64" instead of %"PRIu64, msg_timestamp, TIMESTAMP);
+  CHECK_TRUE(reader.rx_timestamp == 0,
+      "reader timestamp not reset: %"PRIu64, reader.rx_timestamp);
+  END_TEST();
+}
+
+static void test_no_timestamp(void) {
+  START_TEST();
+
+  /* the timestamp of the last packet must not leak into this one */
+  reader.rx_timestamp = TIMESTAMP;
+  rfc5444_reader_handle_packet(&reader, testpacket, sizeof(testpacket));
+  clear_elements();
+
+  rfc5444_reader_handle_packet(&reader, testpacket, sizeof(testpacket));
+
+  CHECK_TRUE(pkt_count == 1, "packet consumer called %d times", pkt_count);
+  CHECK_TRUE(msg_count == 1, "message consumer called %d times", msg_count);
+  CHECK_TRUE(pkt_timestamp == 0, "stale packet timestamp %"PRIu64, pkt_timestamp);
+  CHECK_TRUE(msg_timestamp == 0, "stale message timestamp %"PRIu64, msg_timestamp);
+  END_TEST();
+}
+
+static void test_bad_packet(void) {
+  START_TEST();
+
+  reader.rx_timestamp = TIMESTAMP;
+  CHECK_TRUE(rfc5444_reader_handle_packet(&reader, badpacket, sizeof(badpacket))
+      == RFC5444_UNSUPPORTED_VERSION, "bad packet was not rejected");
+  CHECK_TRUE(reader.rx_timestamp == 0,
+      "reader timestamp not reset after error: %"PRIu64, reader.rx_timestamp);
+
+  rfc5444_reader_handle_packet(&reader, testpacket, sizeof(testpacket));
+  CHECK_TRUE(pkt_timestamp == 0, "stale packet timestamp %"PRIu64, pkt_timestamp);
+  END_TEST();
+}
+
+int main(int argc __attribute__ ((unused)), char **argv __attribute__ ((unused))) {
+  rfc5444_reader_init(&reader);
+  rfc5444_reader_add_packet_consumer(&reader, &pkt_consumer, NULL, 0);
+  rfc5444_reader_add_message_consumer(&reader, &msg_consumer, NULL, 0);
+  pkt_consumer.start_callback = cb_packet;
+  msg_consumer.block_callback = cb_message;
+
+  BEGIN_TESTING(clear_elements);
+
+  test_timestamp();
+  test_no_timestamp();
+  test_bad_packet();
+
+  rfc5444_reader_cleanup(&reader);
+
+  return FINISH_TESTING();
+}
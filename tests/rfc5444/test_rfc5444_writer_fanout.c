@@ -0,0 +1,312 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "rfc5444/rfc5444_context.h"
+#include "rfc5444/rfc5444_writer.h"
+#include "cunit/cunit.h"
+
+#define MSG_SHARED 1
+#define MSG_IFSPECIFIC 2
+#define ADDR_COUNT 10
+#define TARGET_COUNT 3
+#define PACKET_COUNT 8
+
+static void addMessageTLVs(struct rfc5444_writer *wr);
+static void addAddresses(struct rfc5444_writer *wr);
+static void write_packet(struct rfc5444_writer *,
+    struct rfc5444_writer_target *, void *, size_t);
+static void write_packetv(struct rfc5444_writer *,
+    struct rfc5444_writer_target *, const struct iovec *, int);
+
+static uint8_t msg_buffer[1000];
+static uint8_t msg_addrtlvs[5000];
+
+static struct rfc5444_writer writer = {
+  .msg_buffer = msg_buffer,
+  .msg_size = sizeof(msg_buffer),
+  .addrtlv_buffer = msg_addrtlvs,
+  .addrtlv_size = sizeof(msg_addrtlvs),
+};
+
+static struct rfc5444_writer_content_provider cpr_shared = {
+  .msg_type = MSG_SHARED,
+  .addAddresses = addAddresses,
+};
+
+static struct rfc5444_writer_content_provider cpr_ifspecific = {
+  .msg_type = MSG_IFSPECIFIC,
+  .addMessageTLVs = addMessageTLVs,
+};
+
+static struct rfc5444_writer_tlvtype addrtlvs[] = {
+  { .type = 3 },
+};
+
+/* the last target can only send contiguous packets */
+static uint8_t packet_buffer[TARGET_COUNT][1000];
+static struct rfc5444_writer_target targets[TARGET_COUNT] = {
+  {
+    .packet_buffer = packet_buffer[0],
+    .packet_size = sizeof(packet_buffer[0]),
+    .sendPacket = write_packet,
+    .sendPacketv = write_packetv,
+  },
+  {
+    .packet_buffer = packet_buffer[1],
+    .packet_size = sizeof(packet_buffer[1]),
+    .sendPacket = write_packet,
+    .sendPacketv = write_packetv,
+  },
+  {
+    .packet_buffer = packet_buffer[2],
+    .packet_size = sizeof(packet_buffer[2]),
+    .sendPacket = write_packet,
+  },
+};
+
+struct packet {
+  uint8_t data[1000];
+  size_t length;
+};
+
+static struct packet packets[TARGET_COUNT][PACKET_COUNT];
+static int packet_count[TARGET_COUNT];
+static int fragmented_packets;
+static uint8_t seqno;
+
+static int addMessageHeader(struct rfc5444_writer *wr, struct rfc5444_writer_message *msg) {
+  rfc5444_writer_set_msg_header(wr, msg, false, false, false, true);
+  rfc5444_writer_set_msg_seqno(wr, msg, seqno++);
+  return RFC5444_OKAY;
+}
+
+static void addMessageTLVs(struct rfc5444_writer *wr) {
+  uint8_t value;
+
+  value = wr->msg_target - &targets[0];
+  rfc5444_writer_add_messagetlv(wr, 7, 0, &value, sizeof(value));
+}
+
+static void addAddresses(struct rfc5444_writer *wr) {
+  struct netaddr addr = { { 10,0,0,0 }, AF_INET, 32 };
+  struct rfc5444_writer_address *a;
+  uint8_t value;
+  int i;
+
+  for (i=0; i<ADDR_COUNT; i++) {
+    addr._addr[3] = i+1;
+    value = i;
+
+    a = rfc5444_writer_add_address(wr, cpr_shared.creator, &addr, false);
+    rfc5444_writer_add_addrtlv(wr, a, &addrtlvs[0], &value, sizeof(value), false);
+  }
+}
+
+static struct packet *get_packet(struct rfc5444_writer_target *target) {
+  int idx = target - &targets[0];
+
+  CHECK_TRUE(packet_count[idx] < PACKET_COUNT, "too many packets for target %d", idx);
+  if (packet_count[idx] >= PACKET_COUNT) {
+    return NULL;
+  }
+  return &packets[idx][packet_count[idx]++];
+}
+
+static void write_packet(struct rfc5444_writer *w __attribute__ ((unused)),
+    struct rfc5444_writer_target *target, void *buffer, size_t length) {
+  struct packet *pkt;
+
+  if ((pkt = get_packet(target)) != NULL) {
+    memcpy(pkt->data, buffer, length);
+    pkt->length = length;
+  }
+}
+
+static void write_packetv(struct rfc5444_writer *w __attribute__ ((unused)),
+    struct rfc5444_writer_target *target, const struct iovec *iov, int iovcnt) {
+  struct packet *pkt;
+  int i;
+
+  fragmented_packets++;
+  if ((pkt = get_packet(target)) != NULL) {
+    pkt->length = 0;
+    for (i=0; i<iovcnt; i++) {
+      memcpy(&pkt->data[pkt->length], iov[i].iov_base, iov[i].iov_len);
+      pkt->length += iov[i].iov_len;
+    }
+  }
+}
+
+static void clear_elements(void) {
+  memset(packets, 0, sizeof(packets));
+  memset(packet_count, 0, sizeof(packet_count));
+  memset(&writer.fanout_stats, 0, sizeof(writer.fanout_stats));
+  fragmented_packets = 0;
+  seqno = 0;
+}
+
+static void flush_all(void) {
+  int i;
+
+  for (i=0; i<TARGET_COUNT; i++) {
+    rfc5444_writer_flush(&writer, &targets[i], false);
+  }
+}
+
+/* shared messages interleaved with interface specific ones */
+static void generate_mixed(void) {
+  int i;
+
+  CHECK_TRUE(rfc5444_writer_create_message_alltarget(&writer, MSG_SHARED, 4) == RFC5444_OKAY,
+      "Could not create shared message");
+  for (i=0; i<TARGET_COUNT; i++) {
+    CHECK_TRUE(rfc5444_writer_create_message_singletarget(
+        &writer, MSG_IFSPECIFIC, 4, &targets[i]) == RFC5444_OKAY,
+        "Could not create interface specific message");
+  }
+  CHECK_TRUE(rfc5444_writer_create_message_alltarget(&writer, MSG_SHARED, 4) == RFC5444_OKAY,
+      "Could not create shared message");
+  flush_all();
+}
+
+/* more binary messages than a packet can reference */
+static void generate_binary(void) {
+  uint8_t msg[] = { 5, 0x03, 0, 6, 0, 0 };
+  int i;
+
+  for (i=0; i<RFC5444_WRITER_SHARED_REFS + 4; i++) {
+    msg[5] = i;
+    CHECK_TRUE(rfc5444_writer_add_binary_msg(&writer, msg, sizeof(msg),
+        rfc5444_writer_alltargets_selector, NULL) == RFC5444_OKAY,
+        "Could not add binary message");
+  }
+  flush_all();
+}
+
+static void compare(struct packet reference[TARGET_COUNT][PACKET_COUNT],
+    int reference_count[TARGET_COUNT]) {
+  int i, j;
+
+  for (i=0; i<TARGET_COUNT; i++) {
+    CHECK_TRUE(packet_count[i] == reference_count[i],
+        "target %d: %d packets instead of %d", i, packet_count[i], reference_count[i]);
+
+    for (j=0; j<packet_count[i] && j<reference_count[i]; j++) {
+      CHECK_TRUE(packets[i][j].length == reference[i][j].length
+          && memcmp(packets[i][j].data, reference[i][j].data, packets[i][j].length) == 0,
+          "target %d: packet %d differs from copied packet", i, j);
+    }
+  }
+}
+
+static void test_fanout(void (*generate)(void), uint64_t messages) {
+  static struct packet reference[TARGET_COUNT][PACKET_COUNT];
+  static int reference_count[TARGET_COUNT];
+
+  writer.fanout = false;
+  generate();
+  CHECK_TRUE(fragmented_packets == 0, "packet was sent as fragments without fan-out");
+  CHECK_TRUE(writer.fanout_stats.messages == 0, "fan-out used although switched off");
+
+  memcpy(reference, packets, sizeof(reference));
+  memcpy(reference_count, packet_count, sizeof(reference_count));
+  clear_elements();
+
+  writer.fanout = true;
+  generate();
+  compare(reference, reference_count);
+
+  CHECK_TRUE(writer.fanout_stats.messages == messages,
+      "%"PRIu64" shared messages instead of %"PRIu64, writer.fanout_stats.messages, messages);
+  CHECK_TRUE(writer.fanout_stats.references > 0, "no shared message was referenced");
+  CHECK_TRUE(writer.fanout_stats.copied > 0, "target without sendPacketv got no copy");
+  CHECK_TRUE(fragmented_packets == 2, "%d fragmented packets instead of 2", fragmented_packets);
+}
+
+static void test_fanout_mixed(void) {
+  START_TEST();
+  test_fanout(generate_mixed, 2);
+  END_TEST();
+}
+
+static void test_fanout_binary(void) {
+  START_TEST();
+  test_fanout(generate_binary, RFC5444_WRITER_SHARED_REFS + 4);
+  CHECK_TRUE(writer.fanout_stats.references == TARGET_COUNT * RFC5444_WRITER_SHARED_REFS,
+      "%"PRIu64" references instead of %d", writer.fanout_stats.references,
+      TARGET_COUNT * RFC5444_WRITER_SHARED_REFS);
+  END_TEST();
+}
+
+int main(int argc __attribute__ ((unused)), char **argv __attribute__ ((unused))) {
+  struct rfc5444_writer_message *msg;
+  int i;
+
+  rfc5444_writer_init(&writer);
+  for (i=0; i<TARGET_COUNT; i++) {
+    rfc5444_writer_register_target(&writer, &targets[i]);
+  }
+
+  msg = rfc5444_writer_register_message(&writer, MSG_SHARED, false);
+  msg->addMessageHeader = addMessageHeader;
+  msg = rfc5444_writer_register_message(&writer, MSG_IFSPECIFIC, true);
+  msg->addMessageHeader = addMessageHeader;
+
+  rfc5444_writer_register_msgcontentprovider(&writer, &cpr_shared, addrtlvs, ARRAYSIZE(addrtlvs));
+  rfc5444_writer_register_msgcontentprovider(&writer, &cpr_ifspecific, NULL, 0);
+
+  BEGIN_TESTING(clear_elements);
+
+  test_fanout_mixed();
+  test_fanout_binary();
+
+  rfc5444_writer_cleanup(&writer);
+
+  return FINISH_TESTING();
+}
@@ -0,0 +1,236 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "rfc5444/rfc5444_context.h"
+#include "rfc5444/rfc5444_reader.h"
+#include "rfc5444/rfc5444_writer.h"
+#include "cunit/cunit.h"
+
+#define MSG_TYPE 1
+#define ADDR_COUNT 20
+
+static void write_packet(struct rfc5444_writer *,
+    struct rfc5444_writer_target *, void *, size_t);
+static void addAddresses(struct rfc5444_writer *wr);
+
+static uint8_t msg_buffer[1500];
+static uint8_t msg_addrtlvs[5000];
+
+static struct rfc5444_writer writer = {
+  .msg_buffer = msg_buffer,
+  .msg_size = sizeof(msg_buffer),
+  .addrtlv_buffer = msg_addrtlvs,
+  .addrtlv_size = sizeof(msg_addrtlvs),
+};
+
+static struct rfc5444_writer_content_provider cpr = {
+  .msg_type = MSG_TYPE,
+  .addAddresses = addAddresses,
+};
+
+static struct rfc5444_writer_tlvtype addrtlvs[] = {
+  { .type = 3 },
+};
+
+static uint8_t packet_buffer[1500];
+static struct rfc5444_writer_target out_if = {
+  .packet_buffer = packet_buffer,
+  .packet_size = sizeof(packet_buffer),
+  .sendPacket = write_packet,
+};
+
+static struct rfc5444_reader reader;
+
+static struct rfc5444_reader_tlvblock_consumer_entry consumer_entries[] = {
+  { .type = 3, .mandatory = true, .min_length = 1, .max_length = 1 },
+};
+
+static struct rfc5444_reader_tlvblock_consumer consumer = {
+  .msg_id = MSG_TYPE,
+  .addrblock_consumer = true,
+};
+
+static uint8_t packet[1500];
+static size_t packet_len;
+static int addr_count, bad_addr_count;
+
+static int addMessageHeader(struct rfc5444_writer *wr, struct rfc5444_writer_message *msg) {
+  rfc5444_writer_set_msg_header(wr, msg, false, false, false, false);
+  return RFC5444_OKAY;
+}
+
+/* interleave routers, hosts and attached networks */
+static void addAddresses(struct rfc5444_writer *wr) {
+  struct netaddr router = { { 10,0,0,0 }, AF_INET, 32 };
+  struct netaddr host = { { 192,168,1,0 }, AF_INET, 32 };
+  struct netaddr lan = { { 172,16,0,0 }, AF_INET, 24 };
+  struct rfc5444_writer_address *addr;
+  uint8_t value;
+  int i;
+
+  for (i=0; i<ADDR_COUNT; i++) {
+    router._addr[3] = i+1;
+    host._addr[3] = i+1;
+    lan._addr[2] = i+1;
+
+    value = 1;
+    addr = rfc5444_writer_add_address(wr, cpr.creator, &router, false);
+    rfc5444_writer_add_addrtlv(wr, addr, &addrtlvs[0], &value, sizeof(value), false);
+
+    value = 2;
+    addr = rfc5444_writer_add_address(wr, cpr.creator, &host, false);
+    rfc5444_writer_add_addrtlv(wr, addr, &addrtlvs[0], &value, sizeof(value), false);
+
+    value = 3;
+    addr = rfc5444_writer_add_address(wr, cpr.creator, &lan, false);
+    rfc5444_writer_add_addrtlv(wr, addr, &addrtlvs[0], &value, sizeof(value), false);
+  }
+}
+
+static void write_packet(struct rfc5444_writer *w __attribute__ ((unused)),
+    struct rfc5444_writer_target *iface __attribute__ ((unused)),
+    void *buffer, size_t length) {
+  memcpy(packet, buffer, length);
+  packet_len = length;
+}
+
+static enum rfc5444_result
+cb_addr(struct rfc5444_reader_tlvblock_context *context) {
+  const uint8_t *addr;
+  uint8_t value;
+
+  addr = netaddr_get_binptr(&context->addr);
+  if (addr[0] == 10 && netaddr_get_prefix_length(&context->addr) == 32) {
+    value = 1;
+  }
+  else if (addr[0] == 192 && netaddr_get_prefix_length(&context->addr) == 32) {
+    value = 2;
+  }
+  else if (addr[0] == 172 && netaddr_get_prefix_length(&context->addr) == 24) {
+    value = 3;
+  }
+  else {
+    value = 0;
+  }
+
+  addr_count++;
+  if (value == 0 || *consumer_entries[0].tlv->single_value != value) {
+    bad_addr_count++;
+  }
+  return RFC5444_OKAY;
+}
+
+static void clear_elements(void) {
+  packet_len = 0;
+  addr_count = 0;
+  bad_addr_count = 0;
+  memset(&writer.planner_stats, 0, sizeof(writer.planner_stats));
+}
+
+static size_t generate(bool planner) {
+  enum rfc5444_result result;
+
+  writer.plan_addresses = planner;
+  result = rfc5444_writer_create_message_alltarget(&writer, MSG_TYPE, 4);
+  CHECK_TRUE(result == RFC5444_OKAY, "create_message failed: %s (%d)",
+      rfc5444_strerror(result), result);
+  rfc5444_writer_flush(&writer, &out_if, false);
+
+  rfc5444_reader_handle_packet(&reader, packet, packet_len);
+  CHECK_TRUE(addr_count == 3*ADDR_COUNT, "bad number of addresses: %d", addr_count);
+  CHECK_TRUE(bad_addr_count == 0, "addresses with wrong TLV: %d", bad_addr_count);
+  return packet_len;
+}
+
+static void test_planner(void) {
+  size_t unplanned, planned;
+  START_TEST();
+
+  unplanned = generate(false);
+  CHECK_TRUE(writer.planner_stats.messages == 0, "planner should not be used");
+
+  addr_count = 0;
+  planned = generate(true);
+  CHECK_TRUE(writer.planner_stats.messages == 1, "planner should be used once");
+  CHECK_TRUE(writer.planner_stats.reordered == 1, "planner should reorder addresses");
+  CHECK_TRUE(writer.planner_stats.last_bytes_saved > 0, "planner should save bytes");
+
+  printf("Packet size without planner: %zu, with planner: %zu (estimated saving %u)\n",
+      unplanned, planned, writer.planner_stats.last_bytes_saved);
+  CHECK_TRUE(planned < unplanned, "planned message should be smaller: %zu >= %zu",
+      planned, unplanned);
+
+  END_TEST();
+}
+
+int main(int argc __attribute__ ((unused)), char **argv __attribute__ ((unused))) {
+  struct rfc5444_writer_message *msg;
+
+  rfc5444_reader_init(&reader);
+  rfc5444_reader_add_message_consumer(&reader, &consumer,
+      consumer_entries, ARRAYSIZE(consumer_entries));
+  consumer.block_callback = cb_addr;
+
+  rfc5444_writer_init(&writer);
+  rfc5444_writer_register_target(&writer, &out_if);
+
+  msg = rfc5444_writer_register_message(&writer, MSG_TYPE, false);
+  msg->addMessageHeader = addMessageHeader;
+
+  rfc5444_writer_register_msgcontentprovider(&writer, &cpr, addrtlvs, ARRAYSIZE(addrtlvs));
+
+  BEGIN_TESTING(clear_elements);
+
+  test_planner();
+
+  rfc5444_writer_cleanup(&writer);
+  rfc5444_reader_cleanup(&reader);
+
+  return FINISH_TESTING();
+}
@@ -0,0 +1,264 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "common/common_types.h"
+#include "core/oonf_appdata.h"
+#include "core/oonf_cfg.h"
+#include "core/oonf_main.h"
+#include "core/oonf_subsystem.h"
+#include "subsystems/oonf_class.h"
+#include "subsystems/oonf_timer.h"
+
+/*
+ * Benchmark for the memory class allocator. Three classes with the
+ * sizes of NHDP links, l2hops and TC edges are filled interleaved,
+ * then objects are replaced randomly and finally most of them are
+ * removed. Build once with and once without OONF_CLASS_SLAB to
+ * compare the backends.
+ */
+
+#define LINKS            10000
+#define L2HOPS_PER_LINK      8
+#define EDGES_PER_LINK       4
+#define CHURN_ROUNDS        20
+
+static int _init(void);
+static void _cleanup(void);
+static void _cb_run(struct oonf_timer_instance *);
+
+static struct oonf_appdata _appdata = {
+  .app_name = "benchmark_class_allocator",
+  .versionstring_trailer = "",
+  .help_prefix = "",
+  .help_suffix = "",
+  .default_lockfile = "",
+  .default_cfg_handler = "",
+  .need_root = false,
+  .need_lock = false,
+};
+
+static const char *_dependencies[] = {
+  OONF_CLASS_SUBSYSTEM,
+  OONF_TIMER_SUBSYSTEM,
+};
+
+static struct oonf_subsystem _benchmark_subsystem = {
+  .name = "benchmark_class_allocator",
+  .dependencies = _dependencies,
+  .dependencies_count = ARRAYSIZE(_dependencies),
+  .init = _init,
+  .cleanup = _cleanup,
+};
+DECLARE_OONF_PLUGIN(_benchmark_subsystem);
+
+static struct oonf_timer_class _run_timer_class = {
+  .name = "benchmark run",
+  .callback = _cb_run,
+};
+
+static struct oonf_timer_instance _run_timer = {
+  .class = &_run_timer_class,
+};
+
+static struct oonf_class _link_class = {
+  .name = "benchmark link",
+  .size = 600,
+};
+
+static struct oonf_class _l2hop_class = {
+  .name = "benchmark l2hop",
+  .size = 96,
+};
+
+static struct oonf_class _edge_class = {
+  .name = "benchmark edge",
+  .size = 160,
+};
+
+static void *_links[LINKS];
+static void *_l2hops[LINKS * L2HOPS_PER_LINK];
+static void *_edges[LINKS * EDGES_PER_LINK];
+
+static uint64_t
+_get_ns(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static long
+_get_rss_kb(void) {
+  FILE *f;
+  long pages = 0, rss = 0;
+
+  f = fopen("/proc/self/statm", "r");
+  if (f) {
+    if (fscanf(f, "%ld %ld", &pages, &rss) != 2) {
+      rss = 0;
+    }
+    fclose(f);
+  }
+  return rss * 4;
+}
+
+static void
+_print_class(struct oonf_class *c) {
+  printf("  %-16s usage %6u memory %9" PRINTF_SIZE_T_SPECIFIER
+      " slabs %5u fragmentation %3u%%\n",
+      c->name, oonf_class_get_usage(c), oonf_class_get_memory(c),
+      oonf_class_get_slabs(c), oonf_class_get_fragmentation(c));
+}
+
+static void
+_print_state(const char *phase) {
+  printf("%s (rss %ld kB)\n", phase, _get_rss_kb());
+  _print_class(&_link_class);
+  _print_class(&_l2hop_class);
+  _print_class(&_edge_class);
+}
+
+static int
+_init(void) {
+  oonf_class_add(&_link_class);
+  oonf_class_add(&_l2hop_class);
+  oonf_class_add(&_edge_class);
+
+  oonf_timer_add(&_run_timer_class);
+  oonf_timer_set(&_run_timer, 1);
+  return 0;
+}
+
+static void
+_cleanup(void) {
+  oonf_timer_stop(&_run_timer);
+  oonf_timer_remove(&_run_timer_class);
+
+  oonf_class_remove(&_edge_class);
+  oonf_class_remove(&_l2hop_class);
+  oonf_class_remove(&_link_class);
+}
+
+static void
+_cb_run(struct oonf_timer_instance *ptr __attribute__((unused))) {
+  uint64_t start, fill_time, churn_time, drain_time;
+  uint32_t ops;
+  int i, j, r;
+
+  srandom(42);
+
+  /* fill all three classes interleaved */
+  start = _get_ns();
+  for (i=0; i<LINKS; i++) {
+    _links[i] = oonf_class_malloc(&_link_class);
+    for (j=0; j<L2HOPS_PER_LINK; j++) {
+      _l2hops[i * L2HOPS_PER_LINK + j] = oonf_class_malloc(&_l2hop_class);
+    }
+    for (j=0; j<EDGES_PER_LINK; j++) {
+      _edges[i * EDGES_PER_LINK + j] = oonf_class_malloc(&_edge_class);
+    }
+  }
+  fill_time = _get_ns() - start;
+  _print_state("filled");
+
+  /* replace random objects */
+  ops = 0;
+  start = _get_ns();
+  for (r=0; r<CHURN_ROUNDS; r++) {
+    for (i=0; i<LINKS; i++) {
+      j = random() % (LINKS * L2HOPS_PER_LINK);
+      oonf_class_free(&_l2hop_class, _l2hops[j]);
+      _l2hops[j] = oonf_class_malloc(&_l2hop_class);
+
+      j = random() % (LINKS * EDGES_PER_LINK);
+      oonf_class_free(&_edge_class, _edges[j]);
+      _edges[j] = oonf_class_malloc(&_edge_class);
+
+      if ((i & 7) == 0) {
+        j = random() % LINKS;
+        oonf_class_free(&_link_class, _links[j]);
+        _links[j] = oonf_class_malloc(&_link_class);
+        ops++;
+      }
+      ops += 2;
+    }
+  }
+  churn_time = _get_ns() - start;
+
+  /* remove all objects except every tenth link with its l2hops and edges */
+  start = _get_ns();
+  for (i=0; i<LINKS; i++) {
+    if (i % 10 == 0) {
+      continue;
+    }
+    oonf_class_free(&_link_class, _links[i]);
+    for (j=0; j<L2HOPS_PER_LINK; j++) {
+      oonf_class_free(&_l2hop_class, _l2hops[i * L2HOPS_PER_LINK + j]);
+    }
+    for (j=0; j<EDGES_PER_LINK; j++) {
+      oonf_class_free(&_edge_class, _edges[i * EDGES_PER_LINK + j]);
+    }
+  }
+  drain_time = _get_ns() - start;
+  _print_state("drained to 10%");
+
+  printf("fill   %6.1f ns/malloc\n",
+      (double)fill_time / (LINKS * (1 + L2HOPS_PER_LINK + EDGES_PER_LINK)));
+  printf("churn  %6.1f ns/free+malloc\n", (double)churn_time / ops);
+  printf("drain  %6.1f ns/free\n",
+      (double)drain_time / (LINKS / 10 * 9 * (1 + L2HOPS_PER_LINK + EDGES_PER_LINK)));
+
+  oonf_cfg_exit();
+}
+
+int
+main(int argc, char **argv) {
+  return oonf_main(argc, argv, &_appdata);
+}
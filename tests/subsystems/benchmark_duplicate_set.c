@@ -0,0 +1,222 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "common/common_types.h"
+#include "common/netaddr.h"
+#include "core/oonf_appdata.h"
+#include "core/oonf_cfg.h"
+#include "core/oonf_main.h"
+#include "core/oonf_subsystem.h"
+#include "subsystems/oonf_clock.h"
+#include "subsystems/oonf_duplicate_set.h"
+#include "subsystems/oonf_timer.h"
+
+/*
+ * Benchmark for the duplicate set with many originators. Every round
+ * each originator sends a new message which is received three times
+ * (like in a dense mesh): the first copy is tested and added, the
+ * other two are tested again and must be duplicates. From time to
+ * time an old sequence number arrives late.
+ */
+
+#define ORIGINATORS  10000
+#define ROUNDS         100
+#define MSG_TYPE         1
+#define VTIME       300000
+
+static int _init(void);
+static void _cleanup(void);
+static void _cb_run(struct oonf_timer_instance *);
+
+static struct oonf_appdata _appdata = {
+  .app_name = "benchmark_duplicate_set",
+  .versionstring_trailer = "",
+  .help_prefix = "",
+  .help_suffix = "",
+  .default_lockfile = "",
+  .default_cfg_handler = "",
+  .need_root = false,
+  .need_lock = false,
+};
+
+static const char *_dependencies[] = {
+  OONF_CLOCK_SUBSYSTEM,
+  OONF_DUPSET_SUBSYSTEM,
+  OONF_TIMER_SUBSYSTEM,
+};
+
+static struct oonf_subsystem _benchmark_subsystem = {
+  .name = "benchmark_duplicate_set",
+  .dependencies = _dependencies,
+  .dependencies_count = ARRAYSIZE(_dependencies),
+  .init = _init,
+  .cleanup = _cleanup,
+};
+DECLARE_OONF_PLUGIN(_benchmark_subsystem);
+
+static struct oonf_timer_class _run_timer_class = {
+  .name = "benchmark run",
+  .callback = _cb_run,
+};
+
+static struct oonf_timer_instance _run_timer = {
+  .class = &_run_timer_class,
+};
+
+static struct oonf_duplicate_set _set;
+static struct netaddr _originators[ORIGINATORS];
+static uint32_t _results[OONF_DUPSET_FIRST + 1];
+
+static uint64_t
+_get_ns(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static int
+_init(void) {
+  uint8_t addr[16];
+  int i;
+
+  /* half IPv4, half IPv6 originators */
+  memset(addr, 0, sizeof(addr));
+  for (i=0; i<ORIGINATORS; i++) {
+    if (i & 1) {
+      addr[0] = 10;
+      addr[1] = i >> 16;
+      addr[2] = i >> 8;
+      addr[3] = i;
+      netaddr_from_binary(&_originators[i], addr, 4, AF_INET);
+    }
+    else {
+      addr[0] = 0xfd;
+      addr[13] = i >> 16;
+      addr[14] = i >> 8;
+      addr[15] = i;
+      netaddr_from_binary(&_originators[i], addr, 16, AF_INET6);
+    }
+  }
+
+  oonf_duplicate_set_add(&_set, OONF_DUPSET_16BIT);
+  oonf_timer_add(&_run_timer_class);
+  oonf_timer_set(&_run_timer, 1);
+  return 0;
+}
+
+static void
+_cleanup(void) {
+  oonf_timer_stop(&_run_timer);
+  oonf_timer_remove(&_run_timer_class);
+  oonf_duplicate_set_remove(&_set);
+}
+
+static void
+_cb_run(struct oonf_timer_instance *ptr __attribute__((unused))) {
+  uint64_t start, first_time, add_time, test_time;
+  uint32_t checksum;
+  int i, r;
+
+  /* first message of every originator */
+  start = _get_ns();
+  for (i=0; i<ORIGINATORS; i++) {
+    _results[oonf_duplicate_entry_add(&_set, MSG_TYPE, &_originators[i], i & 0xff, VTIME)]++;
+  }
+  first_time = _get_ns() - start;
+
+  add_time = 0;
+  test_time = 0;
+  for (r=1; r<=ROUNDS; r++) {
+    start = _get_ns();
+    for (i=0; i<ORIGINATORS; i++) {
+      if (oonf_duplicate_is_new(oonf_duplicate_test(&_set, MSG_TYPE,
+          &_originators[i], (i + r) & 0xff))) {
+        _results[oonf_duplicate_entry_add(
+            &_set, MSG_TYPE, &_originators[i], (i + r) & 0xff, VTIME)]++;
+      }
+    }
+    add_time += _get_ns() - start;
+
+    start = _get_ns();
+    for (i=0; i<ORIGINATORS; i++) {
+      _results[oonf_duplicate_test(&_set, MSG_TYPE, &_originators[i], (i + r) & 0xff)]++;
+      _results[oonf_duplicate_test(&_set, MSG_TYPE, &_originators[i], (i + r) & 0xff)]++;
+
+      /* late message */
+      if (i % 16 == 0) {
+        _results[oonf_duplicate_test(&_set, MSG_TYPE, &_originators[i], (i + r - 3) & 0xff)]++;
+      }
+    }
+    test_time += _get_ns() - start;
+  }
+
+  checksum = 0;
+  for (i=0; i<=OONF_DUPSET_FIRST; i++) {
+    checksum = checksum * 31 + _results[i];
+  }
+
+  printf("%d originators, %d rounds\n", ORIGINATORS, ROUNDS);
+  printf("first      %7.1f ns/originator\n", (double)first_time / ORIGINATORS);
+  printf("test+add   %7.1f ns/message\n", (double)add_time / (ORIGINATORS * ROUNDS));
+  printf("duplicate  %7.1f ns/test\n",
+      (double)test_time / (ROUNDS * (ORIGINATORS * 2 + (ORIGINATORS + 15) / 16)));
+  printf("results: first %u, newest %u, current %u, new %u, duplicate %u, too old %u"
+      " (checksum %08x)\n",
+      _results[OONF_DUPSET_FIRST], _results[OONF_DUPSET_NEWEST],
+      _results[OONF_DUPSET_CURRENT], _results[OONF_DUPSET_NEW],
+      _results[OONF_DUPSET_DUPLICATE], _results[OONF_DUPSET_TOO_OLD], checksum);
+
+  oonf_cfg_exit();
+}
+
+int
+main(int argc, char **argv) {
+  return oonf_main(argc, argv, &_appdata);
+}
@@ -0,0 +1,191 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+
+#include "common/common_types.h"
+#include "subsystems/os_fd.h"
+
+/*
+ * Benchmark for the receive path of packet sockets. A local stand-in
+ * flooder sends bursts of UDP packets over loopback, the receiver waits
+ * for read events with epoll (like the socket scheduler) and reads either
+ * one datagram per event (recvfrom) or a batch per event (recvmmsg).
+ */
+
+#define PACKET_SIZE  200
+#define BURST        64
+#define ROUNDS       2000
+
+static uint8_t _ring_buffer[OS_FD_MAX_DATAGRAMS][1500];
+static struct os_fd_datagram _ring[OS_FD_MAX_DATAGRAMS];
+
+static uint64_t
+_get_ns(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void
+_run(int epoll_fd, struct os_fd *rx, int tx, struct sockaddr_in *dst, int batch) {
+  union netaddr_socket source;
+  struct epoll_event event;
+  uint8_t packet[PACKET_SIZE];
+  uint64_t start, time, syscalls, events, received;
+  int round, i, pending, result;
+
+  memset(packet, 0xaa, sizeof(packet));
+  syscalls = 0;
+  events = 0;
+  received = 0;
+  time = 0;
+
+  for (round = 0; round < ROUNDS; round++) {
+    /* flood a burst of packets */
+    for (i=0; i<BURST; i++) {
+      if (sendto(tx, packet, sizeof(packet), 0, (struct sockaddr *)dst, sizeof(*dst)) < 0) {
+        fprintf(stderr, "sendto failed: %s\n", strerror(errno));
+        return;
+      }
+    }
+
+    /* drain it like the scheduler would */
+    start = _get_ns();
+    pending = BURST;
+    while (pending > 0) {
+      syscalls++;
+      if (epoll_wait(epoll_fd, &event, 1, 100) <= 0) {
+        /* packets lost */
+        break;
+      }
+      events++;
+
+      syscalls++;
+      if (batch <= 1) {
+        result = os_fd_recvfrom(rx, _ring_buffer[0], sizeof(_ring_buffer[0]), &source, NULL) > 0 ? 1 : 0;
+      }
+      else {
+        result = os_fd_recvmmsg(rx, _ring, batch, NULL);
+      }
+      if (result > 0) {
+        pending -= result;
+        received += result;
+      }
+    }
+    time += _get_ns() - start;
+  }
+
+  printf("%-9s batch %2d: %7"PRIu64" packets, %7"PRIu64" events, %5.2f syscalls/packet, %6.1f ns/packet\n",
+      batch <= 1 ? "recvfrom" : "recvmmsg", batch <= 1 ? 1 : batch,
+      received, events,
+      received ? (double)syscalls / received : 0.0,
+      received ? (double)time / received : 0.0);
+}
+
+int
+main(int argc __attribute__ ((unused)), char **argv __attribute__ ((unused))) {
+  static const int batches[] = { 1, 4, 16, 64 };
+  struct sockaddr_in addr;
+  struct epoll_event event;
+  struct os_fd rx;
+  socklen_t len;
+  int rx_fd, tx_fd, epoll_fd, rcvbuf;
+  size_t i;
+
+  for (i=0; i<OS_FD_MAX_DATAGRAMS; i++) {
+    _ring[i].buf = _ring_buffer[i];
+    _ring[i].length = sizeof(_ring_buffer[i]);
+  }
+
+  rx_fd = socket(AF_INET, SOCK_DGRAM, 0);
+  tx_fd = socket(AF_INET, SOCK_DGRAM, 0);
+  epoll_fd = epoll_create1(0);
+  if (rx_fd < 0 || tx_fd < 0 || epoll_fd < 0) {
+    fprintf(stderr, "Could not create sockets: %s\n", strerror(errno));
+    return 1;
+  }
+
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+  rcvbuf = 1 << 20;
+  setsockopt(rx_fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+  len = sizeof(addr);
+  if (bind(rx_fd, (struct sockaddr *)&addr, sizeof(addr))
+      || getsockname(rx_fd, (struct sockaddr *)&addr, &len)
+      || fcntl(rx_fd, F_SETFL, fcntl(rx_fd, F_GETFL) | O_NONBLOCK)) {
+    fprintf(stderr, "Could not bind receiver socket: %s\n", strerror(errno));
+    return 1;
+  }
+  os_fd_init(&rx, rx_fd);
+
+  memset(&event, 0, sizeof(event));
+  event.events = EPOLLIN;
+  if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, rx_fd, &event)) {
+    fprintf(stderr, "Could not add socket to epoll: %s\n", strerror(errno));
+    return 1;
+  }
+
+  printf("%d bursts of %d packets (%d bytes) over loopback\n", ROUNDS, BURST, PACKET_SIZE);
+  for (i=0; i<ARRAYSIZE(batches); i++) {
+    _run(epoll_fd, &rx, tx_fd, &addr, batches[i]);
+  }
+
+  close(epoll_fd);
+  close(tx_fd);
+  close(rx_fd);
+  return 0;
+}
@@ -0,0 +1,211 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include "common/common_types.h"
+#include "common/autobuf.h"
+#include "subsystems/os_fd.h"
+
+/*
+ * Benchmark for the transmit queue of packet sockets. A burst of queued
+ * datagrams (e.g. a TC flood to many targets) is flushed either like the
+ * old serialized queue (one sendto() per datagram, followed by a memmove
+ * of the rest of the buffer) or from a descriptor queue with sendmmsg().
+ */
+
+#define PACKET_SIZE  500
+#define ROUNDS       200
+
+static uint8_t _drain_buffer[OS_FD_MAX_DATAGRAMS][1500];
+static struct os_fd_datagram _drain[OS_FD_MAX_DATAGRAMS];
+static struct os_fd_datagram _queue[1024];
+
+static uint64_t
+_get_ns(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void
+_drain_receiver(struct os_fd *rx) {
+  while (os_fd_recvmmsg(rx, _drain, OS_FD_MAX_DATAGRAMS, NULL) > 0);
+}
+
+static void
+_run_serialized(struct os_fd *rx, struct os_fd *tx,
+    union netaddr_socket *dst, uint8_t *packet, int burst) {
+  struct autobuf out;
+  union netaddr_socket sock;
+  uint64_t start, time, syscalls;
+  uint16_t length;
+  char *pkt;
+  int round, i;
+
+  abuf_init(&out);
+  time = 0;
+  syscalls = 0;
+
+  for (round = 0; round < ROUNDS; round++) {
+    for (i=0; i<burst; i++) {
+      abuf_memcpy(&out, dst, sizeof(*dst));
+      abuf_append_uint16(&out, PACKET_SIZE);
+      abuf_memcpy(&out, packet, PACKET_SIZE);
+    }
+
+    start = _get_ns();
+    while (abuf_getlen(&out) > 0) {
+      pkt = abuf_getptr(&out);
+      memcpy(&sock, pkt, sizeof(sock));
+      memcpy(&length, pkt + sizeof(sock), 2);
+
+      os_fd_sendto(tx, pkt + sizeof(sock) + 2, length, &sock, false);
+      syscalls++;
+
+      abuf_pull(&out, sizeof(sock) + 2 + length);
+    }
+    time += _get_ns() - start;
+
+    _drain_receiver(rx);
+  }
+  abuf_free(&out);
+
+  printf("sendto   burst %4d: %5.2f syscalls/packet, %7.1f ns/packet\n",
+      burst, (double)syscalls / (ROUNDS * burst), (double)time / (ROUNDS * burst));
+}
+
+static void
+_run_queue(struct os_fd *rx, struct os_fd *tx,
+    union netaddr_socket *dst, uint8_t *packet, int burst) {
+  uint64_t start, time, syscalls;
+  int round, i, sent, result;
+
+  time = 0;
+  syscalls = 0;
+
+  for (round = 0; round < ROUNDS; round++) {
+    for (i=0; i<burst; i++) {
+      _queue[i].buf = packet;
+      _queue[i].length = PACKET_SIZE;
+      memcpy(&_queue[i].remote, dst, sizeof(*dst));
+    }
+
+    start = _get_ns();
+    for (sent = 0; sent < burst; sent += result) {
+      result = os_fd_sendmmsg(tx, &_queue[sent], burst - sent, false);
+      syscalls++;
+      if (result <= 0) {
+        fprintf(stderr, "sendmmsg failed: %s\n", strerror(errno));
+        return;
+      }
+    }
+    time += _get_ns() - start;
+
+    _drain_receiver(rx);
+  }
+
+  printf("sendmmsg burst %4d: %5.2f syscalls/packet, %7.1f ns/packet\n",
+      burst, (double)syscalls / (ROUNDS * burst), (double)time / (ROUNDS * burst));
+}
+
+int
+main(int argc __attribute__ ((unused)), char **argv __attribute__ ((unused))) {
+  static const int bursts[] = { 16, 128, 1024 };
+  static uint8_t packet[PACKET_SIZE];
+  union netaddr_socket dst;
+  struct os_fd rx, tx;
+  socklen_t len;
+  int rx_fd, tx_fd, bufsize;
+  size_t i;
+
+  for (i=0; i<OS_FD_MAX_DATAGRAMS; i++) {
+    _drain[i].buf = _drain_buffer[i];
+    _drain[i].length = sizeof(_drain_buffer[i]);
+  }
+  memset(packet, 0xaa, sizeof(packet));
+
+  rx_fd = socket(AF_INET, SOCK_DGRAM, 0);
+  tx_fd = socket(AF_INET, SOCK_DGRAM, 0);
+  if (rx_fd < 0 || tx_fd < 0) {
+    fprintf(stderr, "Could not create sockets: %s\n", strerror(errno));
+    return 1;
+  }
+
+  memset(&dst, 0, sizeof(dst));
+  dst.v4.sin_family = AF_INET;
+  dst.v4.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+  bufsize = 4 << 20;
+  setsockopt(rx_fd, SOL_SOCKET, SO_RCVBUF, &bufsize, sizeof(bufsize));
+  setsockopt(tx_fd, SOL_SOCKET, SO_SNDBUF, &bufsize, sizeof(bufsize));
+  len = sizeof(dst);
+  if (bind(rx_fd, &dst.std, sizeof(dst.v4))
+      || getsockname(rx_fd, &dst.std, &len)
+      || fcntl(rx_fd, F_SETFL, fcntl(rx_fd, F_GETFL) | O_NONBLOCK)) {
+    fprintf(stderr, "Could not bind receiver socket: %s\n", strerror(errno));
+    return 1;
+  }
+  os_fd_init(&rx, rx_fd);
+  os_fd_init(&tx, tx_fd);
+
+  printf("%d bursts of %d byte packets over loopback\n", ROUNDS, PACKET_SIZE);
+  for (i=0; i<ARRAYSIZE(bursts); i++) {
+    _run_serialized(&rx, &tx, &dst, packet, bursts[i]);
+    _run_queue(&rx, &tx, &dst, packet, bursts[i]);
+  }
+
+  close(tx_fd);
+  close(rx_fd);
+  return 0;
+}
@@ -0,0 +1,224 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include "common/common_types.h"
+#include "subsystems/os_fd.h"
+
+/*
+ * Benchmark for the socket event backends. A number of UDP sockets on
+ * the loopback interface receive a few datagrams each, the receiver
+ * waits for events and drains the triggered sockets until all datagrams
+ * have been received. The same run is done with the epoll and the
+ * io_uring backend (if it was enabled during the build).
+ */
+
+#define PACKET_SIZE      200
+#define PACKETS_PER_FD     4
+#define ROUNDS          2000
+#define MAX_SOCKETS      256
+
+static uint8_t _drain_buffer[OS_FD_MAX_DATAGRAMS][1500];
+static struct os_fd_datagram _drain[OS_FD_MAX_DATAGRAMS];
+static struct os_fd_datagram _queue[MAX_SOCKETS * PACKETS_PER_FD];
+
+static struct os_fd _rx[MAX_SOCKETS];
+static union netaddr_socket _rx_addr[MAX_SOCKETS];
+static struct os_fd _tx;
+
+static uint64_t
+_get_ns(clockid_t clock) {
+  struct timespec ts;
+
+  clock_gettime(clock, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static int
+_send_burst(int sockets) {
+  int i, count, sent, result;
+
+  count = sockets * PACKETS_PER_FD;
+  for (i=0; i<count; i++) {
+    memcpy(&_queue[i].remote, &_rx_addr[i % sockets], sizeof(_queue[i].remote));
+  }
+
+  for (sent = 0; sent < count; sent += result) {
+    result = os_fd_sendmmsg(&_tx, &_queue[sent], count - sent, false);
+    if (result <= 0) {
+      fprintf(stderr, "sendmmsg failed: %s\n", strerror(errno));
+      return -1;
+    }
+  }
+  return 0;
+}
+
+static void
+_run(bool io_uring, int sockets) {
+  struct os_fd_select sel;
+  struct os_fd *sock;
+  uint64_t wall, cpu, start_wall, start_cpu, waits, packets;
+  int round, received, i, n, result;
+
+  if (os_fd_linux_event_add_backend(&sel, io_uring)) {
+    printf("%-8s %4d sockets: backend not available (%s)\n",
+        io_uring ? "io_uring" : "epoll", sockets, strerror(errno));
+    return;
+  }
+  os_fd_event_set_max_events(&sel, MAX_SOCKETS);
+
+  for (i=0; i<sockets; i++) {
+    os_fd_event_socket_add(&sel, &_rx[i]);
+    os_fd_event_socket_read(&sel, &_rx[i], true);
+  }
+
+  wall = 0;
+  cpu = 0;
+  waits = 0;
+  packets = 0;
+  for (round = 0; round < ROUNDS; round++) {
+    if (_send_burst(sockets)) {
+      break;
+    }
+
+    start_wall = _get_ns(CLOCK_MONOTONIC);
+    start_cpu = _get_ns(CLOCK_PROCESS_CPUTIME_ID);
+
+    for (received = 0; received < sockets * PACKETS_PER_FD; ) {
+      os_fd_event_set_deadline(&sel, oonf_clock_getNow() + 1000);
+      n = os_fd_event_wait(&sel);
+      waits++;
+      if (n <= 0) {
+        fprintf(stderr, "wait failed: %d\n", n);
+        break;
+      }
+
+      for (i=0; i<n; i++) {
+        sock = os_fd_event_get(&sel, i);
+        while ((result = os_fd_recvmmsg(sock, _drain, OS_FD_MAX_DATAGRAMS, NULL)) > 0) {
+          received += result;
+        }
+      }
+    }
+
+    wall += _get_ns(CLOCK_MONOTONIC) - start_wall;
+    cpu += _get_ns(CLOCK_PROCESS_CPUTIME_ID) - start_cpu;
+    packets += received;
+  }
+
+  for (i=0; i<sockets; i++) {
+    os_fd_event_socket_remove(&sel, &_rx[i]);
+  }
+  os_fd_event_remove(&sel);
+
+  printf("%-8s %4d sockets: %5.2f waits/round, %9.0f packets/s, %7.1f ns cpu/packet\n",
+      io_uring ? "io_uring" : "epoll", sockets, (double)waits / ROUNDS,
+      (double)packets * 1000000000.0 / wall, (double)cpu / packets);
+}
+
+int
+main(int argc __attribute__ ((unused)), char **argv __attribute__ ((unused))) {
+  static const int socket_counts[] = { 1, 16, MAX_SOCKETS };
+  static uint8_t packet[PACKET_SIZE];
+  socklen_t len;
+  int fd, bufsize;
+  size_t i;
+
+  for (i=0; i<OS_FD_MAX_DATAGRAMS; i++) {
+    _drain[i].buf = _drain_buffer[i];
+    _drain[i].length = sizeof(_drain_buffer[i]);
+  }
+  memset(packet, 0xaa, sizeof(packet));
+  for (i=0; i<ARRAYSIZE(_queue); i++) {
+    _queue[i].buf = packet;
+    _queue[i].length = PACKET_SIZE;
+  }
+
+  bufsize = 1 << 20;
+  for (i=0; i<MAX_SOCKETS; i++) {
+    fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) {
+      fprintf(stderr, "Could not create socket: %s\n", strerror(errno));
+      return 1;
+    }
+
+    memset(&_rx_addr[i], 0, sizeof(_rx_addr[i]));
+    _rx_addr[i].v4.sin_family = AF_INET;
+    _rx_addr[i].v4.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    len = sizeof(_rx_addr[i]);
+    if (bind(fd, &_rx_addr[i].std, sizeof(_rx_addr[i].v4))
+        || getsockname(fd, &_rx_addr[i].std, &len)
+        || fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK)) {
+      fprintf(stderr, "Could not bind receiver socket: %s\n", strerror(errno));
+      return 1;
+    }
+    os_fd_init(&_rx[i], fd);
+  }
+
+  fd = socket(AF_INET, SOCK_DGRAM, 0);
+  setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &bufsize, sizeof(bufsize));
+  os_fd_init(&_tx, fd);
+
+  printf("%d rounds of %d datagrams per socket over loopback\n", ROUNDS, PACKETS_PER_FD);
+  for (i=0; i<ARRAYSIZE(socket_counts); i++) {
+    _run(false, socket_counts[i]);
+    _run(true, socket_counts[i]);
+  }
+
+  for (i=0; i<MAX_SOCKETS; i++) {
+    os_fd_close(&_rx[i]);
+  }
+  os_fd_close(&_tx);
+  return 0;
+}
@@ -0,0 +1,325 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+
+/*! activate GNU sources for pipe2() */
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "common/common_types.h"
+#include "core/oonf_appdata.h"
+#include "core/oonf_cfg.h"
+#include "core/oonf_main.h"
+#include "core/oonf_subsystem.h"
+#include "subsystems/oonf_clock.h"
+#include "subsystems/oonf_socket.h"
+#include "subsystems/oonf_timer.h"
+#include "subsystems/oonf_worker.h"
+#include "subsystems/os_clock.h"
+#include "subsystems/os_fd.h"
+
+/*
+ * Benchmark for the main loop latency with and without the worker
+ * subsystem. A probe thread writes a timestamp into a pipe every
+ * millisecond (like an incoming HELLO), the main loop records how
+ * long it took to read it. A periodic timer triggers a compute heavy
+ * job (like a routing update), which runs either directly in the main
+ * loop or in a worker thread.
+ */
+
+#define PROBE_INTERVAL_NS   1000000ull
+#define COMPUTE_INTERVAL        100
+#define COMPUTE_ROUNDS     2000000
+#define PHASE_DURATION        3000
+#define MAX_SAMPLES           8192
+
+enum _phase {
+  PHASE_INLINE,
+  PHASE_OFFLOAD,
+  PHASE_END,
+};
+
+static int _init(void);
+static void _cleanup(void);
+
+static void *_cb_probe_thread(void *ptr);
+static void _cb_read_probe(struct oonf_socket_entry *entry);
+static void _cb_compute_timer(struct oonf_timer_instance *);
+static void _cb_phase_timer(struct oonf_timer_instance *);
+static void _cb_process_job(struct oonf_worker_job *job);
+static void _print_phase(const char *name);
+
+static struct oonf_appdata _appdata = {
+  .app_name = "benchmark_worker_offload",
+  .versionstring_trailer = "",
+  .help_prefix = "",
+  .help_suffix = "",
+  .default_lockfile = "",
+  .default_cfg_handler = "",
+  .need_root = false,
+  .need_lock = false,
+};
+
+static const char *_dependencies[] = {
+  OONF_CLOCK_SUBSYSTEM,
+  OONF_SOCKET_SUBSYSTEM,
+  OONF_TIMER_SUBSYSTEM,
+  OONF_WORKER_SUBSYSTEM,
+};
+
+static struct oonf_subsystem _benchmark_subsystem = {
+  .name = "benchmark_worker_offload",
+  .dependencies = _dependencies,
+  .dependencies_count = ARRAYSIZE(_dependencies),
+  .init = _init,
+  .cleanup = _cleanup,
+};
+DECLARE_OONF_PLUGIN(_benchmark_subsystem);
+
+static struct oonf_socket_entry _probe_socket = {
+  .name = "benchmark probe",
+  .process = _cb_read_probe,
+};
+
+static struct oonf_timer_class _compute_timer_class = {
+  .name = "benchmark compute",
+  .callback = _cb_compute_timer,
+  .periodic = true,
+};
+
+static struct oonf_timer_instance _compute_timer = {
+  .class = &_compute_timer_class,
+};
+
+static struct oonf_timer_class _phase_timer_class = {
+  .name = "benchmark phase",
+  .callback = _cb_phase_timer,
+  .periodic = true,
+};
+
+static struct oonf_timer_instance _phase_timer = {
+  .class = &_phase_timer_class,
+};
+
+static struct oonf_worker_job _job = {
+  .name = "benchmark compute",
+  .process = _cb_process_job,
+};
+
+static enum _phase _phase;
+static volatile bool _probe_running;
+static pthread_t _probe_thread;
+static int _probe_pipe[2];
+
+static uint64_t _samples[MAX_SAMPLES];
+static int _sample_count;
+static uint32_t _jobs, _skipped;
+static uint64_t _checksum;
+
+static uint64_t
+_get_ns(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static int
+_init(void) {
+  if (pipe2(_probe_pipe, O_NONBLOCK | O_CLOEXEC)) {
+    fprintf(stderr, "Could not create pipe: %s\n", strerror(errno));
+    return -1;
+  }
+  os_fd_init(&_probe_socket.fd, _probe_pipe[0]);
+  oonf_socket_add(&_probe_socket);
+  oonf_socket_set_read(&_probe_socket, true);
+
+  oonf_timer_add(&_compute_timer_class);
+  oonf_timer_add(&_phase_timer_class);
+  oonf_timer_set(&_compute_timer, COMPUTE_INTERVAL);
+  oonf_timer_set(&_phase_timer, PHASE_DURATION);
+
+  _phase = PHASE_INLINE;
+  _probe_running = true;
+  if (pthread_create(&_probe_thread, NULL, _cb_probe_thread, NULL)) {
+    fprintf(stderr, "Could not start probe thread\n");
+    return -1;
+  }
+  return 0;
+}
+
+static void
+_cleanup(void) {
+  _probe_running = false;
+  pthread_join(_probe_thread, NULL);
+
+  oonf_worker_cancel(&_job);
+  oonf_timer_stop(&_compute_timer);
+  oonf_timer_stop(&_phase_timer);
+  oonf_timer_remove(&_compute_timer_class);
+  oonf_timer_remove(&_phase_timer_class);
+
+  oonf_socket_remove(&_probe_socket);
+  close(_probe_pipe[0]);
+  close(_probe_pipe[1]);
+}
+
+static void *
+_cb_probe_thread(void *ptr __attribute__((unused))) {
+  struct timespec delay = { 0, PROBE_INTERVAL_NS };
+  uint64_t now;
+
+  while (_probe_running) {
+    now = _get_ns();
+    if (write(_probe_pipe[1], &now, sizeof(now)) != sizeof(now)) {
+      /* main loop is stalled and the pipe is full */
+    }
+    nanosleep(&delay, NULL);
+  }
+  return NULL;
+}
+
+static void
+_cb_read_probe(struct oonf_socket_entry *entry) {
+  uint64_t sent, now;
+
+  now = _get_ns();
+  while (read(os_fd_get_fd(&entry->fd), &sent, sizeof(sent)) == sizeof(sent)) {
+    if (_sample_count < MAX_SAMPLES) {
+      _samples[_sample_count++] = now - sent;
+    }
+  }
+}
+
+static void
+_cb_process_job(struct oonf_worker_job *job __attribute__((unused))) {
+  uint64_t x = 88172645463325252ull;
+  int i;
+
+  /* xorshift as a stand-in for a routing update */
+  for (i=0; i<COMPUTE_ROUNDS; i++) {
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+  }
+  _checksum += x;
+}
+
+static void
+_cb_compute_timer(struct oonf_timer_instance *ptr __attribute__((unused))) {
+  _jobs++;
+  if (_phase == PHASE_INLINE) {
+    _cb_process_job(&_job);
+  }
+  else if (oonf_worker_is_busy(&_job)) {
+    /* previous update has not finished yet */
+    _skipped++;
+  }
+  else {
+    oonf_worker_submit(&_job);
+  }
+}
+
+static int
+_compare_samples(const void *p1, const void *p2) {
+  const uint64_t *s1 = p1, *s2 = p2;
+
+  return *s1 < *s2 ? -1 : (*s1 > *s2 ? 1 : 0);
+}
+
+static void
+_print_phase(const char *name) {
+  qsort(_samples, _sample_count, sizeof(_samples[0]), _compare_samples);
+
+  if (_sample_count == 0) {
+    printf("%-8s: no probes received\n", name);
+    return;
+  }
+  printf("%-8s: %5d probes, latency p50 %8.1f us, p99 %8.1f us,"
+      " p99.9 %8.1f us, max %8.1f us, %u jobs (%u skipped)\n",
+      name, _sample_count,
+      _samples[_sample_count / 2] / 1000.0,
+      _samples[_sample_count * 99 / 100] / 1000.0,
+      _samples[_sample_count * 999 / 1000] / 1000.0,
+      _samples[_sample_count - 1] / 1000.0,
+      _jobs, _skipped);
+}
+
+static void
+_cb_phase_timer(struct oonf_timer_instance *ptr __attribute__((unused))) {
+  struct oonf_worker_statistics stats;
+
+  if (_phase == PHASE_INLINE) {
+    _print_phase("inline");
+    _phase = PHASE_OFFLOAD;
+  }
+  else {
+    oonf_worker_get_statistics(&stats);
+
+    _print_phase("offload");
+    printf("worker  : %d threads, job runtime avg %.1f us, completion delay avg %.1f us\n",
+        oonf_worker_get_thread_count(),
+        latency_histogram_get_average(&stats.run_time) / 1000.0,
+        latency_histogram_get_average(&stats.completion_time) / 1000.0);
+    _phase = PHASE_END;
+    oonf_cfg_exit();
+  }
+
+  _sample_count = 0;
+  _jobs = 0;
+  _skipped = 0;
+}
+
+int
+main(int argc, char **argv) {
+  return oonf_main(argc, argv, &_appdata);
+}
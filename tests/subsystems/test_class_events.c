@@ -0,0 +1,363 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+
+#include <string.h>
+
+#include "common/common_types.h"
+#include "core/oonf_appdata.h"
+#include "core/oonf_cfg.h"
+#include "core/oonf_main.h"
+#include "core/oonf_subsystem.h"
+#include "subsystems/oonf_class.h"
+#include "subsystems/oonf_timer.h"
+
+#include "../cunit/cunit.h"
+
+/*
+ * Functional test of the deferred change events of oonf_class. Most
+ * checks call oonf_class_flush_events() directly, the last one lets
+ * the scheduler deliver the events at the end of its iteration.
+ */
+
+#define OBJECTS 3
+
+static int _init(void);
+static void _cleanup(void);
+static void _cb_run(struct oonf_timer_instance *);
+static void _cb_add(void *);
+static void _cb_change(void *);
+static void _cb_remove(void *);
+
+static struct oonf_appdata _appdata = {
+  .app_name = "test_class_events",
+  .versionstring_trailer = "",
+  .help_prefix = "",
+  .help_suffix = "",
+  .default_lockfile = "",
+  .default_cfg_handler = "",
+  .need_root = false,
+  .need_lock = false,
+};
+
+static const char *_dependencies[] = {
+  OONF_CLASS_SUBSYSTEM,
+  OONF_TIMER_SUBSYSTEM,
+};
+
+static struct oonf_subsystem _test_subsystem = {
+  .name = "test_class_events",
+  .dependencies = _dependencies,
+  .dependencies_count = ARRAYSIZE(_dependencies),
+  .init = _init,
+  .cleanup = _cleanup,
+};
+DECLARE_OONF_PLUGIN(_test_subsystem);
+
+/* test object, the listener can raise a change of another object */
+struct test_object {
+  int id;
+  struct test_object *next_change;
+};
+
+static struct oonf_class _test_class = {
+  .name = "test deferred class",
+  .size = sizeof(struct test_object),
+  .defer_changes = true,
+};
+
+static struct oonf_class_extension _test_listener = {
+  .ext_name = "test listener",
+  .class_name = "test deferred class",
+  .cb_add = _cb_add,
+  .cb_change = _cb_change,
+  .cb_remove = _cb_remove,
+};
+
+static struct oonf_timer_class _run_timer_class = {
+  .name = "test class events",
+  .callback = _cb_run,
+};
+
+static struct oonf_timer_instance _run_timer = {
+  .class = &_run_timer_class,
+};
+
+static struct test_object *_objects[OBJECTS];
+
+/* delivered events per object */
+static unsigned _added[OBJECTS], _changed[OBJECTS], _removed[OBJECTS];
+
+/* order of the delivered change events */
+static int _change_order[OBJECTS * 2];
+static unsigned _change_count;
+
+static bool _scheduler_step;
+
+/* change events delivered by the scheduler */
+static unsigned _scheduler_changed, _scheduler_change_count;
+
+static void
+clear_elements(void) {
+  int i;
+
+  /* deliver leftovers of the last test before clearing the counters */
+  oonf_class_flush_events();
+
+  for (i=0; i<OBJECTS; i++) {
+    if (_objects[i] != NULL) {
+      oonf_class_free(&_test_class, _objects[i]);
+    }
+    _objects[i] = oonf_class_malloc(&_test_class);
+    _objects[i]->id = i;
+  }
+
+  memset(_added, 0, sizeof(_added));
+  memset(_changed, 0, sizeof(_changed));
+  memset(_removed, 0, sizeof(_removed));
+  _change_count = 0;
+  _test_class._changes = 0;
+  _test_class._suppressed = 0;
+}
+
+static int
+_init(void) {
+  oonf_class_add(&_test_class);
+  if (oonf_class_extension_add(&_test_listener)) {
+    oonf_class_remove(&_test_class);
+    return -1;
+  }
+
+  oonf_timer_add(&_run_timer_class);
+  oonf_timer_set(&_run_timer, 1);
+  return 0;
+}
+
+static void
+_cleanup(void) {
+  int i;
+
+  oonf_timer_stop(&_run_timer);
+  oonf_timer_remove(&_run_timer_class);
+
+  for (i=0; i<OBJECTS; i++) {
+    if (_objects[i] != NULL) {
+      oonf_class_free(&_test_class, _objects[i]);
+      _objects[i] = NULL;
+    }
+  }
+  oonf_class_extension_remove(&_test_listener);
+  oonf_class_remove(&_test_class);
+}
+
+static void
+_cb_add(void *ptr) {
+  struct test_object *obj = ptr;
+  _added[obj->id]++;
+}
+
+static void
+_cb_change(void *ptr) {
+  struct test_object *obj = ptr;
+
+  _changed[obj->id]++;
+  if (_change_count < ARRAYSIZE(_change_order)) {
+    _change_order[_change_count] = obj->id;
+  }
+  _change_count++;
+
+  if (obj->next_change != NULL) {
+    /* raise a change while the events are flushed */
+    oonf_class_event(&_test_class, obj->next_change, OONF_OBJECT_CHANGED);
+    obj->next_change = NULL;
+  }
+}
+
+static void
+_cb_remove(void *ptr) {
+  struct test_object *obj = ptr;
+  _removed[obj->id]++;
+}
+
+static void
+test_coalesce(void) {
+  int i;
+
+  START_TEST();
+
+  for (i=0; i<5; i++) {
+    oonf_class_event(&_test_class, _objects[0], OONF_OBJECT_CHANGED);
+  }
+  oonf_class_event(&_test_class, _objects[1], OONF_OBJECT_CHANGED);
+  oonf_class_event(&_test_class, _objects[0], OONF_OBJECT_CHANGED);
+
+  CHECK_TRUE(_change_count == 0, "%u change events delivered before flush", _change_count);
+
+  oonf_class_flush_events();
+
+  CHECK_TRUE(_changed[0] == 1, "object 0 got %u change events", _changed[0]);
+  CHECK_TRUE(_changed[1] == 1, "object 1 got %u change events", _changed[1]);
+  CHECK_TRUE(_changed[2] == 0, "object 2 got %u change events", _changed[2]);
+  CHECK_TRUE(_change_count == 2 && _change_order[0] == 0 && _change_order[1] == 1,
+      "change events not delivered in order of the first change");
+  CHECK_TRUE(oonf_class_get_change_events(&_test_class) == 7,
+      "%u change events counted", oonf_class_get_change_events(&_test_class));
+  CHECK_TRUE(oonf_class_get_suppressed_events(&_test_class) == 5,
+      "%u change events suppressed", oonf_class_get_suppressed_events(&_test_class));
+
+  /* nothing left for a second flush */
+  oonf_class_flush_events();
+  CHECK_TRUE(_change_count == 2, "%u change events after second flush", _change_count);
+
+  /* after the flush the object can be queued again */
+  oonf_class_event(&_test_class, _objects[0], OONF_OBJECT_CHANGED);
+  oonf_class_flush_events();
+  CHECK_TRUE(_changed[0] == 2, "object 0 got %u change events", _changed[0]);
+
+  END_TEST();
+}
+
+static void
+test_cancel(void) {
+  START_TEST();
+
+  oonf_class_event(&_test_class, _objects[0], OONF_OBJECT_CHANGED);
+  oonf_class_event(&_test_class, _objects[1], OONF_OBJECT_CHANGED);
+  oonf_class_event(&_test_class, _objects[2], OONF_OBJECT_CHANGED);
+
+  /* freed object loses its pending change */
+  oonf_class_free(&_test_class, _objects[0]);
+  _objects[0] = NULL;
+
+  /* removed event is delivered at once and drops the pending change */
+  oonf_class_event(&_test_class, _objects[1], OONF_OBJECT_REMOVED);
+  CHECK_TRUE(_removed[1] == 1, "object 1 got %u remove events", _removed[1]);
+
+  oonf_class_flush_events();
+
+  CHECK_TRUE(_changed[1] == 0, "removed object got %u change events", _changed[1]);
+  CHECK_TRUE(_changed[2] == 1, "object 2 got %u change events", _changed[2]);
+  CHECK_TRUE(_change_count == 1, "%u change events delivered", _change_count);
+  CHECK_TRUE(oonf_class_get_suppressed_events(&_test_class) == 2,
+      "%u change events suppressed", oonf_class_get_suppressed_events(&_test_class));
+
+  /* added events are never deferred */
+  oonf_class_event(&_test_class, _objects[2], OONF_OBJECT_ADDED);
+  CHECK_TRUE(_added[2] == 1, "object 2 got %u add events", _added[2]);
+
+  END_TEST();
+}
+
+static void
+test_change_during_flush(void) {
+  START_TEST();
+
+  /* object 0 changes object 1, object 1 changes object 0 again */
+  _objects[0]->next_change = _objects[1];
+  _objects[1]->next_change = _objects[0];
+  oonf_class_event(&_test_class, _objects[0], OONF_OBJECT_CHANGED);
+
+  oonf_class_flush_events();
+
+  CHECK_TRUE(_changed[0] == 2, "object 0 got %u change events", _changed[0]);
+  CHECK_TRUE(_changed[1] == 1, "object 1 got %u change events", _changed[1]);
+  CHECK_TRUE(_change_count == 3 && _change_order[0] == 0
+      && _change_order[1] == 1 && _change_order[2] == 0,
+      "change events raised during flush delivered in wrong order");
+
+  /* everything was delivered in one flush */
+  oonf_class_flush_events();
+  CHECK_TRUE(_change_count == 3, "%u change events after second flush", _change_count);
+
+  END_TEST();
+}
+
+static void
+test_scheduler_flush(void) {
+  START_TEST();
+
+  /* the scheduler flushed the change raised by the last timer callback */
+  CHECK_TRUE(_scheduler_changed == 1, "object 2 got %u change events", _scheduler_changed);
+  CHECK_TRUE(_scheduler_change_count == 1,
+      "%u change events delivered", _scheduler_change_count);
+
+  END_TEST();
+}
+
+static void
+_cb_run(struct oonf_timer_instance *ptr __attribute__((unused))) {
+  if (!_scheduler_step) {
+    test_coalesce();
+    test_cancel();
+    test_change_during_flush();
+
+    clear_elements();
+
+    /* leave this change to the scheduler */
+    oonf_class_event(&_test_class, _objects[2], OONF_OBJECT_CHANGED);
+    _scheduler_step = true;
+    oonf_timer_set(&_run_timer, 1);
+    return;
+  }
+
+  /* starting the test flushes and clears the counters */
+  _scheduler_changed = _changed[2];
+  _scheduler_change_count = _change_count;
+
+  test_scheduler_flush();
+  oonf_cfg_exit();
+}
+
+int
+main(int argc __attribute__((unused)), char **argv) {
+  char *args[] = { argv[0], NULL };
+
+  BEGIN_TESTING(clear_elements);
+
+  if (oonf_main(ARRAYSIZE(args) - 1, args, &_appdata)) {
+    return 1;
+  }
+
+  return FINISH_TESTING();
+}
@@ -0,0 +1,364 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+
+#include <string.h>
+
+#include "common/common_types.h"
+#include "common/netaddr.h"
+#include "core/oonf_appdata.h"
+#include "core/oonf_cfg.h"
+#include "core/oonf_main.h"
+#include "core/oonf_subsystem.h"
+#include "subsystems/oonf_clock.h"
+#include "subsystems/oonf_duplicate_set.h"
+#include "subsystems/oonf_timer.h"
+
+#include "../cunit/cunit.h"
+
+/*
+ * Functional test of the duplicate set. It runs on the simulated clock,
+ * so the test can wait for the expiry timer of the set without
+ * sleeping.
+ */
+
+#define MSG_TYPE         1
+
+/* number of originators to force the hash table to grow */
+#define ORIGINATORS   1000
+
+/* validity time of short living entries */
+#define VTIME         2000
+
+/* validity time of the entry that must survive the expiry */
+#define LONG_VTIME  600000
+
+/* time to wait for the expiry of the short living entries */
+#define EXPIRY_WAIT  10000
+
+static int _init(void);
+static void _cleanup(void);
+static void _cb_run(struct oonf_timer_instance *);
+
+static struct oonf_appdata _appdata = {
+  .app_name = "test_duplicate_set",
+  .versionstring_trailer = "",
+  .help_prefix = "",
+  .help_suffix = "",
+  .default_lockfile = "",
+  .default_cfg_handler = "",
+  .need_root = false,
+  .need_lock = false,
+};
+
+static const char *_dependencies[] = {
+  OONF_CLOCK_SUBSYSTEM,
+  OONF_DUPSET_SUBSYSTEM,
+  OONF_TIMER_SUBSYSTEM,
+};
+
+static struct oonf_subsystem _test_subsystem = {
+  .name = "test_duplicate_set",
+  .dependencies = _dependencies,
+  .dependencies_count = ARRAYSIZE(_dependencies),
+  .init = _init,
+  .cleanup = _cleanup,
+};
+DECLARE_OONF_PLUGIN(_test_subsystem);
+
+static struct oonf_timer_class _run_timer_class = {
+  .name = "test duplicate set",
+  .callback = _cb_run,
+};
+
+static struct oonf_timer_instance _run_timer = {
+  .class = &_run_timer_class,
+};
+
+static struct oonf_duplicate_set _set;
+static struct netaddr _originators[ORIGINATORS];
+
+/* state of the hash table before the expiry */
+static uint32_t _grown_size, _grown_count;
+static uint64_t _expiry_start;
+
+static void
+_set_originator(struct netaddr *addr, int i) {
+  uint8_t bin[4] = { 10, 0, 0, 0 };
+
+  bin[2] = i >> 8;
+  bin[3] = i;
+  netaddr_from_binary(addr, bin, sizeof(bin), AF_INET);
+}
+
+static int
+_init(void) {
+  int i;
+
+  for (i=0; i<ORIGINATORS; i++) {
+    _set_originator(&_originators[i], i);
+  }
+
+  oonf_duplicate_set_add(&_set, OONF_DUPSET_16BIT);
+  oonf_timer_add(&_run_timer_class);
+  oonf_timer_set(&_run_timer, 1);
+  return 0;
+}
+
+static void
+_cleanup(void) {
+  oonf_timer_stop(&_run_timer);
+  oonf_timer_remove(&_run_timer_class);
+  oonf_duplicate_set_remove(&_set);
+}
+
+static void
+test_results(void) {
+  struct netaddr *orig = &_originators[0];
+  enum oonf_duplicate_result result;
+
+  START_TEST();
+
+  result = oonf_duplicate_test(&_set, MSG_TYPE, orig, 100);
+  CHECK_TRUE(result == OONF_DUPSET_FIRST, "unknown originator: %s",
+      oonf_duplicate_get_result_str(result));
+
+  result = oonf_duplicate_entry_add(&_set, MSG_TYPE, orig, 100, VTIME);
+  CHECK_TRUE(result == OONF_DUPSET_FIRST, "first seqno: %s",
+      oonf_duplicate_get_result_str(result));
+
+  result = oonf_duplicate_entry_add(&_set, MSG_TYPE, orig, 100, VTIME);
+  CHECK_TRUE(result == OONF_DUPSET_CURRENT, "same seqno: %s",
+      oonf_duplicate_get_result_str(result));
+
+  /* testing does not add the sequence number */
+  result = oonf_duplicate_test(&_set, MSG_TYPE, orig, 102);
+  CHECK_TRUE(result == OONF_DUPSET_NEWEST, "test newer seqno: %s",
+      oonf_duplicate_get_result_str(result));
+
+  result = oonf_duplicate_entry_add(&_set, MSG_TYPE, orig, 102, VTIME);
+  CHECK_TRUE(result == OONF_DUPSET_NEWEST, "newer seqno: %s",
+      oonf_duplicate_get_result_str(result));
+
+  result = oonf_duplicate_entry_add(&_set, MSG_TYPE, orig, 101, VTIME);
+  CHECK_TRUE(result == OONF_DUPSET_NEW, "missing seqno: %s",
+      oonf_duplicate_get_result_str(result));
+
+  result = oonf_duplicate_entry_add(&_set, MSG_TYPE, orig, 101, VTIME);
+  CHECK_TRUE(result == OONF_DUPSET_DUPLICATE, "repeated seqno: %s",
+      oonf_duplicate_get_result_str(result));
+
+  result = oonf_duplicate_entry_add(&_set, MSG_TYPE, orig, 100, VTIME);
+  CHECK_TRUE(result == OONF_DUPSET_DUPLICATE, "first seqno again: %s",
+      oonf_duplicate_get_result_str(result));
+
+  result = oonf_duplicate_entry_add(&_set, MSG_TYPE, orig, 102 - 40, VTIME);
+  CHECK_TRUE(result == OONF_DUPSET_TOO_OLD, "old seqno: %s",
+      oonf_duplicate_get_result_str(result));
+
+  /* another message type has its own sequence numbers */
+  result = oonf_duplicate_entry_add(&_set, MSG_TYPE + 1, orig, 101, VTIME);
+  CHECK_TRUE(result == OONF_DUPSET_FIRST, "other message type: %s",
+      oonf_duplicate_get_result_str(result));
+
+  /* 16 bit sequence number wraps around */
+  orig = &_originators[1];
+  oonf_duplicate_entry_add(&_set, MSG_TYPE, orig, 65535, VTIME);
+  result = oonf_duplicate_entry_add(&_set, MSG_TYPE, orig, 0, VTIME);
+  CHECK_TRUE(result == OONF_DUPSET_NEWEST, "seqno after wrap around: %s",
+      oonf_duplicate_get_result_str(result));
+  result = oonf_duplicate_entry_add(&_set, MSG_TYPE, orig, 65535, VTIME);
+  CHECK_TRUE(result == OONF_DUPSET_DUPLICATE, "seqno before wrap around: %s",
+      oonf_duplicate_get_result_str(result));
+
+  END_TEST();
+}
+
+static void
+test_too_old_reset(void) {
+  struct netaddr *orig = &_originators[2];
+  enum oonf_duplicate_result result;
+  uint16_t seqno;
+
+  START_TEST();
+
+  oonf_duplicate_entry_add(&_set, MSG_TYPE, orig, 30000, VTIME);
+
+  /* peeking does not count towards the reset */
+  for (seqno = 1; seqno <= OONF_DUPSET_MAXIMUM_TOO_OLD + 1; seqno++) {
+    result = oonf_duplicate_peek(&_set, MSG_TYPE, orig, seqno);
+    CHECK_TRUE(result == OONF_DUPSET_TOO_OLD, "peek seqno %u: %s",
+        seqno, oonf_duplicate_get_result_str(result));
+  }
+
+  /* originator restarted with a low sequence number */
+  for (seqno = 1; seqno <= OONF_DUPSET_MAXIMUM_TOO_OLD; seqno++) {
+    result = oonf_duplicate_entry_add(&_set, MSG_TYPE, orig, seqno, VTIME);
+    CHECK_TRUE(result == OONF_DUPSET_TOO_OLD, "seqno %u: %s",
+        seqno, oonf_duplicate_get_result_str(result));
+  }
+
+  result = oonf_duplicate_entry_add(&_set, MSG_TYPE, orig, seqno, VTIME);
+  CHECK_TRUE(result == OONF_DUPSET_NEWEST, "seqno %u resets entry: %s",
+      seqno, oonf_duplicate_get_result_str(result));
+
+  result = oonf_duplicate_entry_add(&_set, MSG_TYPE, orig, seqno, VTIME);
+  CHECK_TRUE(result == OONF_DUPSET_CURRENT, "seqno %u after reset: %s",
+      seqno, oonf_duplicate_get_result_str(result));
+
+  result = oonf_duplicate_entry_add(&_set, MSG_TYPE, orig, seqno + 1, VTIME);
+  CHECK_TRUE(result == OONF_DUPSET_NEWEST, "seqno %u after reset: %s",
+      seqno + 1, oonf_duplicate_get_result_str(result));
+
+  /* the history starts again with the reset */
+  result = oonf_duplicate_entry_add(&_set, MSG_TYPE, orig, 1, VTIME);
+  CHECK_TRUE(result == OONF_DUPSET_NEW, "seqno 1 after reset: %s",
+      oonf_duplicate_get_result_str(result));
+
+  END_TEST();
+}
+
+static void
+test_resize(void) {
+  enum oonf_duplicate_result result;
+  uint32_t size;
+  int i, first, current;
+
+  START_TEST();
+
+  size = _set._size;
+  first = 0;
+  for (i=0; i<ORIGINATORS; i++) {
+    result = oonf_duplicate_entry_add(&_set, MSG_TYPE + 2, &_originators[i], i, VTIME);
+    if (result == OONF_DUPSET_FIRST) {
+      first++;
+    }
+  }
+
+  CHECK_TRUE(first == ORIGINATORS, "%d of %d originators were new", first, ORIGINATORS);
+  CHECK_TRUE(_set._size > size, "table did not grow from %u slots", size);
+  CHECK_TRUE(_set._count * 4 <= _set._size * 3,
+      "%u entries in %u slots", _set._count, _set._size);
+
+  /* all entries must survive the resize */
+  current = 0;
+  for (i=0; i<ORIGINATORS; i++) {
+    if (oonf_duplicate_test(&_set, MSG_TYPE + 2, &_originators[i], i) == OONF_DUPSET_CURRENT) {
+      current++;
+    }
+  }
+  CHECK_TRUE(current == ORIGINATORS, "%d of %d entries found after resize",
+      current, ORIGINATORS);
+
+  /* one entry lives much longer than all others */
+  oonf_duplicate_entry_add(&_set, MSG_TYPE + 3, &_originators[0], 1, LONG_VTIME);
+
+  END_TEST();
+}
+
+static void
+test_expiry(void) {
+  enum oonf_duplicate_result result;
+  int i, first;
+
+  START_TEST();
+
+  CHECK_TRUE(oonf_clock_getNow() - _expiry_start >= EXPIRY_WAIT,
+      "only %"PRIu64" ms passed", oonf_clock_getNow() - _expiry_start);
+
+  /* the expiry timer removed everything except the long living entry */
+  CHECK_TRUE(_set._count == 1, "%u entries left instead of 1 (%u before expiry)",
+      _set._count, _grown_count);
+  CHECK_TRUE(_set._size < _grown_size, "table did not shrink from %u slots", _grown_size);
+  CHECK_TRUE(oonf_timer_is_active(&_set._expiry_timer),
+      "expiry timer for long living entry is not active");
+
+  first = 0;
+  for (i=0; i<ORIGINATORS; i++) {
+    if (oonf_duplicate_test(&_set, MSG_TYPE + 2, &_originators[i], i) == OONF_DUPSET_FIRST) {
+      first++;
+    }
+  }
+  CHECK_TRUE(first == ORIGINATORS, "%d of %d entries expired", first, ORIGINATORS);
+
+  result = oonf_duplicate_test(&_set, MSG_TYPE + 3, &_originators[0], 1);
+  CHECK_TRUE(result == OONF_DUPSET_CURRENT, "long living entry: %s",
+      oonf_duplicate_get_result_str(result));
+
+  END_TEST();
+}
+
+static void
+_cb_run(struct oonf_timer_instance *ptr __attribute__((unused))) {
+  if (_expiry_start == 0) {
+    test_results();
+    test_too_old_reset();
+    test_resize();
+
+    /* wait for the expiry timer of the set */
+    _grown_size = _set._size;
+    _grown_count = _set._count;
+    _expiry_start = oonf_clock_getNow();
+    oonf_timer_set(&_run_timer, EXPIRY_WAIT);
+    return;
+  }
+
+  test_expiry();
+  oonf_cfg_exit();
+}
+
+int
+main(int argc __attribute__((unused)), char **argv) {
+  char set_arg[] = "--set";
+  char simulation_arg[] = "clock.simulation=true";
+  char *args[] = { argv[0], set_arg, simulation_arg, NULL };
+
+  BEGIN_TESTING(NULL);
+
+  if (oonf_main(ARRAYSIZE(args) - 1, args, &_appdata)) {
+    return 1;
+  }
+
+  return FINISH_TESTING();
+}
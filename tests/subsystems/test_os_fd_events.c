@@ -0,0 +1,227 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include "common/common_types.h"
+#include "subsystems/os_fd.h"
+
+#include "cunit/cunit.h"
+
+/*
+ * Tests for the socket event handler: growth of the event array and
+ * edge triggered events. The tests run with the epoll backend and
+ * with the io_uring backend if it was enabled during the build.
+ */
+
+#define SOCKET_COUNT 64
+
+static struct os_fd _rx[SOCKET_COUNT];
+static union netaddr_socket _rx_addr[SOCKET_COUNT];
+static struct os_fd _tx;
+
+static struct os_fd_select _sel;
+static bool _io_uring;
+
+static void
+clear_elements(void) {
+}
+
+static int
+_send_to(int idx) {
+  static uint8_t packet[32];
+
+  return sendto(_tx.fd, packet, sizeof(packet), 0,
+      &_rx_addr[idx].std, sizeof(_rx_addr[idx].v4)) == sizeof(packet) ? 0 : -1;
+}
+
+static int
+_wait(void) {
+  /* all tests only wait for sockets that are already readable */
+  os_fd_event_set_deadline(&_sel, oonf_clock_getNow() + 100);
+  return os_fd_event_wait(&_sel);
+}
+
+static void
+test_event_array_growth(void) {
+  uint8_t buf[64];
+  int i, n, size;
+
+  START_TEST();
+
+  CHECK_TRUE(os_fd_linux_event_add_backend(&_sel, _io_uring) == 0,
+      "cannot create %s event handler", _io_uring ? "io_uring" : "epoll");
+  CHECK_TRUE(os_fd_event_get_size(&_sel) == OS_FD_EVENT_DEFAULT_SIZE,
+      "initial size %d != %d", os_fd_event_get_size(&_sel), OS_FD_EVENT_DEFAULT_SIZE);
+  os_fd_event_set_max_events(&_sel, SOCKET_COUNT);
+
+  for (i=0; i<SOCKET_COUNT; i++) {
+    os_fd_event_socket_add(&_sel, &_rx[i]);
+    os_fd_event_socket_read(&_sel, &_rx[i], true);
+    CHECK_TRUE(_send_to(i) == 0, "cannot send to socket %d: %s", i, strerror(errno));
+  }
+
+  /* the sockets are never read, so every wait fills the array until the maximum */
+  size = OS_FD_EVENT_DEFAULT_SIZE;
+  for (i=0; i<4; i++) {
+    n = _wait();
+    CHECK_TRUE(os_fd_event_get_size(&_sel) == size,
+        "wait %d: size %d != %d", i, os_fd_event_get_size(&_sel), size);
+    CHECK_TRUE(n == size, "wait %d: %d events, expected %d", i, n, size);
+
+    if (size < SOCKET_COUNT) {
+      size *= 2;
+    }
+  }
+  CHECK_TRUE(os_fd_event_get_size(&_sel) == SOCKET_COUNT,
+      "array did not reach maximum: %d", os_fd_event_get_size(&_sel));
+
+  /* a lower maximum shrinks the array during the next wait */
+  os_fd_event_set_max_events(&_sel, 24);
+  n = _wait();
+  CHECK_TRUE(n == 24, "%d events after lowering the maximum", n);
+  CHECK_TRUE(os_fd_event_get_size(&_sel) == 24, "size %d after lowering the maximum",
+      os_fd_event_get_size(&_sel));
+
+  for (i=0; i<SOCKET_COUNT; i++) {
+    os_fd_event_socket_remove(&_sel, &_rx[i]);
+    CHECK_TRUE(recv(_rx[i].fd, buf, sizeof(buf), 0) > 0, "cannot read socket %d", i);
+  }
+  os_fd_event_remove(&_sel);
+
+  END_TEST();
+}
+
+static void
+test_edge_triggered(void) {
+  uint8_t buf[64];
+  int n;
+
+  START_TEST();
+
+  CHECK_TRUE(os_fd_linux_event_add_backend(&_sel, _io_uring) == 0,
+      "cannot create %s event handler", _io_uring ? "io_uring" : "epoll");
+  os_fd_event_socket_add(&_sel, &_rx[0]);
+  os_fd_event_socket_read(&_sel, &_rx[0], true);
+  os_fd_event_socket_edge_triggered(&_sel, &_rx[0], true);
+  CHECK_TRUE(os_fd_event_is_edge_triggered(&_rx[0]), "socket is not edge triggered");
+
+  CHECK_TRUE(_send_to(0) == 0, "cannot send first datagram");
+  CHECK_TRUE(_send_to(0) == 0, "cannot send second datagram");
+
+  n = _wait();
+  CHECK_TRUE(n == 1 && os_fd_event_get(&_sel, 0) == &_rx[0], "no event for new data");
+
+  /* read only one datagram, no new edge */
+  CHECK_TRUE(recv(_rx[0].fd, buf, sizeof(buf), 0) > 0, "cannot read datagram");
+  n = _wait();
+  CHECK_TRUE(n == 0, "%d events without new data", n);
+
+  /* new data is a new edge, the old datagram is still waiting */
+  CHECK_TRUE(_send_to(0) == 0, "cannot send third datagram");
+  n = _wait();
+  CHECK_TRUE(n == 1, "%d events for third datagram", n);
+
+  CHECK_TRUE(recv(_rx[0].fd, buf, sizeof(buf), 0) > 0, "cannot read second datagram");
+  CHECK_TRUE(recv(_rx[0].fd, buf, sizeof(buf), 0) > 0, "cannot read third datagram");
+  CHECK_TRUE(recv(_rx[0].fd, buf, sizeof(buf), 0) < 0 && errno == EAGAIN,
+      "socket not drained");
+
+  os_fd_event_socket_edge_triggered(&_sel, &_rx[0], false);
+  os_fd_event_socket_remove(&_sel, &_rx[0]);
+  os_fd_event_remove(&_sel);
+
+  END_TEST();
+}
+
+int
+main(int argc __attribute__ ((unused)), char **argv __attribute__ ((unused))) {
+  socklen_t len;
+  int i, fd, result;
+
+  for (i=0; i<SOCKET_COUNT; i++) {
+    fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) {
+      return 1;
+    }
+
+    memset(&_rx_addr[i], 0, sizeof(_rx_addr[i]));
+    _rx_addr[i].v4.sin_family = AF_INET;
+    _rx_addr[i].v4.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    len = sizeof(_rx_addr[i]);
+    if (bind(fd, &_rx_addr[i].std, sizeof(_rx_addr[i].v4))
+        || getsockname(fd, &_rx_addr[i].std, &len)
+        || fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK)) {
+      return 1;
+    }
+    os_fd_init(&_rx[i], fd);
+  }
+  os_fd_init(&_tx, socket(AF_INET, SOCK_DGRAM, 0));
+
+  BEGIN_TESTING(clear_elements);
+
+  test_event_array_growth();
+  test_edge_triggered();
+
+#ifdef OONF_IO_URING
+  _io_uring = true;
+  test_event_array_growth();
+  test_edge_triggered();
+#endif
+
+  result = FINISH_TESTING();
+
+  for (i=0; i<SOCKET_COUNT; i++) {
+    os_fd_close(&_rx[i]);
+  }
+  os_fd_close(&_tx);
+  return result;
+}
@@ -0,0 +1,399 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "common/common_types.h"
+#include "common/netaddr.h"
+#include "core/oonf_appdata.h"
+#include "core/oonf_cfg.h"
+#include "core/oonf_main.h"
+#include "core/oonf_subsystem.h"
+#include "subsystems/oonf_clock.h"
+#include "subsystems/oonf_packet_socket.h"
+#include "subsystems/oonf_timer.h"
+
+#include "../cunit/cunit.h"
+
+/*
+ * Runs two nodes for one hour of protocol time on a packet bus with
+ * the virtual clock. Each node multicasts a hello every two seconds and
+ * answers every tenth hello of its neighbor with a unicast.
+ *
+ * A second bus checks that receive callbacks can remove other sockets
+ * of the bus and the bus itself while a datagram is delivered.
+ */
+
+#define NODES                2
+#define PORT               269
+#define BUS_LATENCY          5
+#define HELLO_INTERVAL    2000
+#define ACK_EVERY           10
+#define SIMULATION_TIME 3600000
+#define REMOVAL_SOCKETS      4
+
+struct _node {
+  struct oonf_packet_socket socket;
+  struct oonf_timer_instance hello_timer;
+
+  uint32_t seqno;
+
+  uint32_t hellos;
+  uint32_t acks;
+  uint32_t unicast_hellos;
+  uint32_t bad_latency;
+  uint32_t bad_interval;
+  uint64_t last_hello;
+};
+
+static int _init(void);
+static void _cleanup(void);
+static void _cb_receive(struct oonf_packet_socket *,
+    union netaddr_socket *from, void *ptr, size_t length);
+static void _cb_receive_removal(struct oonf_packet_socket *,
+    union netaddr_socket *from, void *ptr, size_t length);
+static void _cb_hello(struct oonf_timer_instance *);
+static void _cb_stop(struct oonf_timer_instance *);
+
+static struct oonf_appdata _appdata = {
+  .app_name = "test_packet_bus",
+  .versionstring_trailer = "",
+  .help_prefix = "",
+  .help_suffix = "",
+  .default_lockfile = "",
+  .default_cfg_handler = "",
+  .need_root = false,
+  .need_lock = false,
+};
+
+static const char *_dependencies[] = {
+  OONF_CLOCK_SUBSYSTEM,
+  OONF_PACKET_SUBSYSTEM,
+  OONF_TIMER_SUBSYSTEM,
+};
+
+static struct oonf_subsystem _test_subsystem = {
+  .name = "test_packet_bus",
+  .dependencies = _dependencies,
+  .dependencies_count = ARRAYSIZE(_dependencies),
+  .init = _init,
+  .cleanup = _cleanup,
+};
+DECLARE_OONF_PLUGIN(_test_subsystem);
+
+static struct oonf_timer_class _hello_timer_class = {
+  .name = "test hello",
+  .callback = _cb_hello,
+  .periodic = true,
+};
+
+static struct oonf_timer_class _stop_timer_class = {
+  .name = "test stop",
+  .callback = _cb_stop,
+};
+
+static struct oonf_timer_instance _stop_timer = {
+  .class = &_stop_timer_class,
+};
+
+static struct oonf_packet_bus _bus = {
+  .name = "test",
+  .latency = BUS_LATENCY,
+};
+
+static struct oonf_packet_bus _removal_bus = {
+  .name = "removal",
+};
+
+static struct _node _nodes[NODES];
+static union netaddr_socket _multicast;
+
+static struct oonf_packet_socket _removal_sockets[REMOVAL_SOCKETS];
+static uint32_t _removal_received[REMOVAL_SOCKETS];
+
+static uint64_t _start_time, _stop_time;
+static uint64_t _wallclock_ns;
+static uint32_t _bus_sent, _bus_delivered, _bus_lost;
+static bool _stopped;
+
+static uint64_t
+_get_ns(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static int
+_init(void) {
+  union netaddr_socket local;
+  struct netaddr addr;
+  uint8_t ip[4] = { 10, 0, 0, 0 };
+  int i;
+
+  netaddr_from_binary(&addr, (uint8_t []){ 224, 0, 0, 109 }, 4, AF_INET);
+  netaddr_socket_init(&_multicast, &addr, PORT, 0);
+
+  oonf_timer_add(&_hello_timer_class);
+  oonf_timer_add(&_stop_timer_class);
+  oonf_packet_bus_add(&_bus);
+
+  for (i=0; i<NODES; i++) {
+    ip[3] = i + 1;
+    netaddr_from_binary(&addr, ip, 4, AF_INET);
+    netaddr_socket_init(&local, &addr, PORT, 0);
+
+    _nodes[i].socket.config.receive_data = _cb_receive;
+    oonf_packet_bus_socket_add(&_nodes[i].socket, &_bus, &local);
+
+    /* the second node starts a bit later */
+    _nodes[i].hello_timer.class = &_hello_timer_class;
+    oonf_timer_start_ext(&_nodes[i].hello_timer, 1 + i * 700, HELLO_INTERVAL);
+  }
+
+  /*
+   * the last socket sends "remove peer", the first receiver removes the
+   * second one. The third receiver answers with "remove bus" and the first
+   * receiver removes the bus before the third one gets it.
+   */
+  oonf_packet_bus_add(&_removal_bus);
+  for (i=0; i<REMOVAL_SOCKETS; i++) {
+    ip[3] = i + 1;
+    netaddr_from_binary(&addr, ip, 4, AF_INET);
+    netaddr_socket_init(&local, &addr, PORT, 0);
+
+    _removal_sockets[i].config.receive_data = _cb_receive_removal;
+    oonf_packet_bus_socket_add(&_removal_sockets[i], &_removal_bus, &local);
+  }
+  oonf_packet_send(&_removal_sockets[REMOVAL_SOCKETS - 1], &_multicast, "remove peer", 11);
+
+  _start_time = oonf_clock_getNow();
+  _wallclock_ns = _get_ns();
+  oonf_timer_set(&_stop_timer, SIMULATION_TIME);
+  return 0;
+}
+
+static void
+_cleanup(void) {
+  int i;
+
+  for (i=0; i<NODES; i++) {
+    oonf_timer_stop(&_nodes[i].hello_timer);
+  }
+  oonf_timer_stop(&_stop_timer);
+  oonf_packet_bus_remove(&_bus);
+  oonf_packet_bus_remove(&_removal_bus);
+  oonf_timer_remove(&_stop_timer_class);
+  oonf_timer_remove(&_hello_timer_class);
+}
+
+static void
+_cb_hello(struct oonf_timer_instance *ptr) {
+  struct _node *node;
+  char buffer[64];
+  int len;
+
+  node = container_of(ptr, struct _node, hello_timer);
+  len = snprintf(buffer, sizeof(buffer), "hello %u %"PRIu64,
+      ++node->seqno, oonf_clock_getNow());
+  oonf_packet_send(&node->socket, &_multicast, buffer, len);
+}
+
+static void
+_cb_receive(struct oonf_packet_socket *pktsocket,
+    union netaddr_socket *from, void *ptr, size_t length) {
+  struct _node *node;
+  const char *msg = ptr;
+  uint64_t sent;
+  uint32_t seqno;
+
+  node = container_of(pktsocket, struct _node, socket);
+
+  /* receive buffer must be null terminated */
+  if (msg[length] != 0) {
+    return;
+  }
+
+  if (strcmp(msg, "ack") == 0) {
+    node->acks++;
+    return;
+  }
+
+  if (sscanf(msg, "hello %u %"SCNu64, &seqno, &sent) != 2) {
+    return;
+  }
+
+  if (netaddr_socket_get_port(from) != PORT) {
+    return;
+  }
+  node->hellos++;
+
+  /* timers fire at the next timeslice */
+  if (oonf_clock_getNow() < sent + BUS_LATENCY
+      || oonf_clock_getNow() > sent + BUS_LATENCY + OONF_TIMER_SLICE) {
+    node->bad_latency++;
+  }
+  if (node->last_hello != 0 && (sent < node->last_hello + HELLO_INTERVAL
+      || sent > node->last_hello + HELLO_INTERVAL + OONF_TIMER_SLICE)) {
+    node->bad_interval++;
+  }
+  node->last_hello = sent;
+
+  if (seqno % ACK_EVERY == 0) {
+    oonf_packet_send(pktsocket, from, "ack", 3);
+  }
+}
+
+static void
+_cb_receive_removal(struct oonf_packet_socket *pktsocket,
+    union netaddr_socket *from __attribute__((unused)),
+    void *ptr, size_t length) {
+  const char *msg = ptr;
+  int idx;
+
+  idx = pktsocket - _removal_sockets;
+  _removal_received[idx]++;
+
+  if (length == 11 && strcmp(msg, "remove peer") == 0) {
+    if (idx == 0) {
+      oonf_packet_remove(&_removal_sockets[1], true);
+    }
+    else if (idx == 2) {
+      oonf_packet_send(pktsocket, &_multicast, "remove bus", 10);
+    }
+  }
+  else if (length == 10 && strcmp(msg, "remove bus") == 0 && idx == 0) {
+    oonf_packet_bus_remove(&_removal_bus);
+  }
+}
+
+static void
+_cb_stop(struct oonf_timer_instance *ptr __attribute__((unused))) {
+  int i;
+
+  _stop_time = oonf_clock_getNow();
+  _wallclock_ns = _get_ns() - _wallclock_ns;
+  _bus_sent = _bus.sent;
+  _bus_delivered = _bus.delivered;
+  _bus_lost = _bus.lost;
+
+  for (i=0; i<NODES; i++) {
+    oonf_timer_stop(&_nodes[i].hello_timer);
+  }
+  _stopped = true;
+  oonf_cfg_exit();
+}
+
+static void
+test_simulation(void) {
+  uint32_t expected;
+  int i;
+
+  START_TEST();
+
+  CHECK_TRUE(_stopped, "simulation did not finish");
+  CHECK_TRUE(_stop_time - _start_time >= SIMULATION_TIME
+      && _stop_time - _start_time <= SIMULATION_TIME + OONF_TIMER_SLICE,
+      "virtual clock advanced %"PRIu64" ms instead of %d ms",
+      _stop_time - _start_time, SIMULATION_TIME);
+  CHECK_TRUE(_wallclock_ns < 10000000000ull,
+      "simulation of %d ms took %"PRIu64" ms of realtime",
+      SIMULATION_TIME, _wallclock_ns / 1000000);
+
+  for (i=0; i<NODES; i++) {
+    /* each node receives all hellos its neighbor sent */
+    expected = _nodes[(i + 1) % NODES].seqno;
+    CHECK_TRUE(_nodes[i].seqno >= SIMULATION_TIME / (HELLO_INTERVAL + OONF_TIMER_SLICE),
+        "node %d sent only %u hellos", i, _nodes[i].seqno);
+    CHECK_TRUE(_nodes[i].hellos == expected,
+        "node %d received %u hellos instead of %u", i, _nodes[i].hellos, expected);
+    CHECK_TRUE(_nodes[i].acks == _nodes[i].seqno / ACK_EVERY,
+        "node %d received %u unicast acks instead of %u",
+        i, _nodes[i].acks, _nodes[i].seqno / ACK_EVERY);
+    CHECK_TRUE(_nodes[i].bad_latency == 0,
+        "node %d received %u hellos with wrong latency", i, _nodes[i].bad_latency);
+    CHECK_TRUE(_nodes[i].bad_interval == 0,
+        "node %d received %u hellos with wrong interval", i, _nodes[i].bad_interval);
+  }
+
+  CHECK_TRUE(_bus_delivered == _bus_sent,
+      "bus delivered %u of %u datagrams", _bus_delivered, _bus_sent);
+  CHECK_TRUE(_bus_lost == 0, "bus lost %u datagrams", _bus_lost);
+
+  END_TEST();
+}
+
+static void
+test_remove_during_delivery(void) {
+  START_TEST();
+
+  CHECK_TRUE(_removal_received[0] == 2,
+      "first socket received %u datagrams instead of 2", _removal_received[0]);
+  CHECK_TRUE(_removal_received[1] == 0,
+      "removed socket received %u datagrams", _removal_received[1]);
+  CHECK_TRUE(_removal_received[2] == 1,
+      "third socket received %u datagrams instead of 1", _removal_received[2]);
+  CHECK_TRUE(_removal_received[3] == 0,
+      "sender received %u datagrams", _removal_received[3]);
+  CHECK_TRUE(list_is_empty(&_removal_bus._sockets), "sockets left on removed bus");
+
+  END_TEST();
+}
+
+int
+main(int argc __attribute__((unused)), char **argv) {
+  char set_arg[] = "--set";
+  char simulation_arg[] = "clock.simulation=true";
+  char *args[] = { argv[0], set_arg, simulation_arg, NULL };
+
+  BEGIN_TESTING(NULL);
+
+  if (oonf_main(ARRAYSIZE(args) - 1, args, &_appdata)) {
+    return 1;
+  }
+
+  test_simulation();
+  test_remove_during_delivery();
+  return FINISH_TESTING();
+}
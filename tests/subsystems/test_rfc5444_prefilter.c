@@ -0,0 +1,280 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+#include <string.h>
+
+#include "common/common_types.h"
+#include "common/netaddr.h"
+#include "core/oonf_appdata.h"
+#include "core/oonf_cfg.h"
+#include "core/oonf_main.h"
+#include "core/oonf_subsystem.h"
+#include "rfc5444/rfc5444_iana.h"
+#include "rfc5444/rfc5444_reader.h"
+#include "subsystems/oonf_duplicate_set.h"
+#include "subsystems/oonf_rfc5444.h"
+#include "subsystems/oonf_timer.h"
+
+#include "../cunit/cunit.h"
+
+/*
+ * Feeds TC messages through the reader of a RFC5444 protocol. The
+ * message prefilter of the protocol checks the processed set before
+ * the message consumer adds the message to it, like the OLSRv2 reader
+ * does with olsrv2_mpr_shall_process(). Checks sequence number wrap
+ * around and an originator reboot.
+ */
+
+#define MAX_PROCESSED 64
+
+/* validity time of the processed set entries */
+#define VTIME 60000
+
+static int _init(void);
+static void _cleanup(void);
+static void _cb_run(struct oonf_timer_instance *);
+static enum rfc5444_result _cb_message(struct rfc5444_reader_tlvblock_context *);
+
+static struct oonf_appdata _appdata = {
+  .app_name = "test_rfc5444_prefilter",
+  .versionstring_trailer = "",
+  .help_prefix = "",
+  .help_suffix = "",
+  .default_lockfile = "",
+  .default_cfg_handler = "",
+  .need_root = false,
+  .need_lock = false,
+};
+
+static const char *_dependencies[] = {
+  OONF_DUPSET_SUBSYSTEM,
+  OONF_RFC5444_SUBSYSTEM,
+  OONF_TIMER_SUBSYSTEM,
+};
+
+static struct oonf_subsystem _test_subsystem = {
+  .name = "test_rfc5444_prefilter",
+  .dependencies = _dependencies,
+  .dependencies_count = ARRAYSIZE(_dependencies),
+  .init = _init,
+  .cleanup = _cleanup,
+};
+DECLARE_OONF_PLUGIN(_test_subsystem);
+
+static struct oonf_timer_class _test_timer_class = {
+  .name = "test prefilter",
+  .callback = _cb_run,
+};
+
+static struct oonf_timer_instance _run_timer = {
+  .class = &_test_timer_class,
+};
+
+static struct rfc5444_reader_tlvblock_consumer _tc_consumer = {
+  .order = 1,
+  .msg_id = RFC7181_MSGTYPE_TC,
+  .start_callback = _cb_message,
+};
+
+static struct oonf_rfc5444_protocol *_protocol;
+
+/* sequence numbers of the processed messages */
+static uint16_t _processed[MAX_PROCESSED];
+static unsigned _processed_count;
+
+/* number of parsed messages that were not processed */
+static unsigned _rejected_count;
+
+static void
+clear_elements(void) {
+  _processed_count = 0;
+  _rejected_count = 0;
+}
+
+static int
+_init(void) {
+  _protocol = oonf_rfc5444_add_protocol("test_prefilter", false);
+  if (_protocol == NULL) {
+    return -1;
+  }
+
+  rfc5444_reader_add_message_consumer(&_protocol->reader, &_tc_consumer, NULL, 0);
+
+  oonf_timer_add(&_test_timer_class);
+  oonf_timer_set(&_run_timer, 100);
+  return 0;
+}
+
+static void
+_cleanup(void) {
+  oonf_timer_stop(&_run_timer);
+  oonf_timer_remove(&_test_timer_class);
+  rfc5444_reader_remove_message_consumer(&_protocol->reader, &_tc_consumer);
+  oonf_rfc5444_remove_protocol(_protocol);
+}
+
+static enum rfc5444_result
+_cb_message(struct rfc5444_reader_tlvblock_context *context) {
+  enum oonf_duplicate_result result;
+
+  /* same processed set handling as olsrv2_mpr_shall_process() */
+  result = oonf_duplicate_entry_add(&_protocol->processed_set,
+      context->msg_type, &context->orig_addr, context->seqno, VTIME);
+  if (!oonf_duplicate_is_new(result)) {
+    _rejected_count++;
+    return RFC5444_DROP_MESSAGE;
+  }
+
+  if (_processed_count < MAX_PROCESSED) {
+    _processed[_processed_count] = context->seqno;
+  }
+  _processed_count++;
+  return RFC5444_OKAY;
+}
+
+/**
+ * Send a TC without TLVs and a hoplimit of 1 through the reader
+ * @param originator last byte of the IPv4 originator
+ * @param seqno message sequence number
+ */
+static void
+_receive_tc(uint8_t originator, uint16_t seqno) {
+  uint8_t packet[] = {
+    /* packet without tlvblock and sequence number */
+    0x00,
+    /* TC with originator, hoplimit and sequence number */
+    RFC7181_MSGTYPE_TC,
+    RFC5444_MSG_FLAG_ORIGINATOR | RFC5444_MSG_FLAG_HOPLIMIT | RFC5444_MSG_FLAG_SEQNO | 0x03,
+    0, 13,
+    10, 0, 0, originator,
+    1,
+    seqno >> 8, seqno & 255,
+    /* empty message tlvblock */
+    0, 0,
+  };
+
+  rfc5444_reader_handle_packet(&_protocol->reader, packet, sizeof(packet));
+}
+
+static void
+test_seqno_wrap(void) {
+  static const uint16_t expected[] = { 65534, 65535, 0, 1 };
+  unsigned i;
+
+  START_TEST();
+
+  _receive_tc(1, 65534);
+  _receive_tc(1, 65535);
+  _receive_tc(1, 0);
+  _receive_tc(1, 1);
+
+  /* duplicates are skipped by the prefilter before they are parsed */
+  _receive_tc(1, 65535);
+  _receive_tc(1, 0);
+  _receive_tc(1, 1);
+
+  CHECK_TRUE(_processed_count == ARRAYSIZE(expected),
+      "%u messages processed instead of %u", _processed_count, (unsigned)ARRAYSIZE(expected));
+  for (i=0; i<ARRAYSIZE(expected) && i<_processed_count; i++) {
+    CHECK_TRUE(_processed[i] == expected[i],
+        "message %u has seqno %u instead of %u", i, _processed[i], expected[i]);
+  }
+  CHECK_TRUE(_rejected_count == 0,
+      "%u duplicates reached the consumer", _rejected_count);
+
+  END_TEST();
+}
+
+static void
+test_reboot(void) {
+  uint16_t seqno;
+
+  START_TEST();
+
+  _receive_tc(2, 30000);
+
+  /* originator restarts with a low sequence number */
+  for (seqno = 1; seqno <= OONF_DUPSET_MAXIMUM_TOO_OLD + 3; seqno++) {
+    _receive_tc(2, seqno);
+  }
+
+  /*
+   * each too old message is counted once by the processed set, the
+   * message after OONF_DUPSET_MAXIMUM_TOO_OLD of them resets the entry
+   */
+  CHECK_TRUE(_rejected_count == OONF_DUPSET_MAXIMUM_TOO_OLD,
+      "%u too old messages rejected instead of %u",
+      _rejected_count, (unsigned)OONF_DUPSET_MAXIMUM_TOO_OLD);
+  CHECK_TRUE(_processed_count == 4,
+      "%u messages processed instead of 4", _processed_count);
+  if (_processed_count == 4) {
+    CHECK_TRUE(_processed[0] == 30000, "first message has seqno %u", _processed[0]);
+    CHECK_TRUE(_processed[1] == OONF_DUPSET_MAXIMUM_TOO_OLD + 1,
+        "first message after reboot has seqno %u instead of %u",
+        _processed[1], OONF_DUPSET_MAXIMUM_TOO_OLD + 1);
+    CHECK_TRUE(_processed[3] == OONF_DUPSET_MAXIMUM_TOO_OLD + 3,
+        "last message has seqno %u instead of %u",
+        _processed[3], OONF_DUPSET_MAXIMUM_TOO_OLD + 3);
+  }
+
+  END_TEST();
+}
+
+static void
+_cb_run(struct oonf_timer_instance *ptr __attribute__((unused))) {
+  test_seqno_wrap();
+  test_reboot();
+
+  oonf_cfg_exit();
+}
+
+int
+main(int argc __attribute__((unused)), char **argv) {
+  char *args[] = { argv[0], NULL };
+
+  BEGIN_TESTING(clear_elements);
+
+  if (oonf_main(ARRAYSIZE(args) - 1, args, &_appdata)) {
+    return 1;
+  }
+
+  return FINISH_TESTING();
+}
@@ -0,0 +1,397 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+
+/* for sendmmsg() */
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "common/common_types.h"
+#include "common/netaddr.h"
+#include "common/netaddr_acl.h"
+#include "core/oonf_appdata.h"
+#include "core/oonf_cfg.h"
+#include "core/oonf_main.h"
+#include "core/oonf_subsystem.h"
+#include "rfc5444/rfc5444_iana.h"
+#include "subsystems/oonf_packet_socket.h"
+#include "subsystems/oonf_rfc5444.h"
+#include "subsystems/oonf_timer.h"
+
+#include "../cunit/cunit.h"
+
+/*
+ * Congests the loopback socket of the RFC5444 subsystem and checks that
+ * the queued packets are sent in order of their transmit class once the
+ * socket accepts data again and that the mesh agregation_interval is the
+ * default of the transmit classes. The test replaces sendmsg() and sendmmsg()
+ * of the C library to simulate the congested socket.
+ */
+
+/* the loopback interface exists on every test machine */
+#define TEST_INTERFACE "lo"
+
+#define MSGTYPE_TC   201
+#define HELLOS         6
+#define MAX_SENT      16
+
+/* mesh.agregation_interval set by the command line */
+#define AGGREGATION  300
+
+/* number of 100 ms intervals to wait for the interface socket */
+#define ACTIVATION_WAIT 50
+
+static int _init(void);
+static void _cleanup(void);
+static void _cb_timer(struct oonf_timer_instance *);
+static void _cb_congest(struct oonf_timer_instance *);
+static void _cb_check(struct oonf_timer_instance *);
+
+static struct oonf_appdata _appdata = {
+  .app_name = "test_rfc5444_tx_class",
+  .versionstring_trailer = "",
+  .help_prefix = "",
+  .help_suffix = "",
+  .default_lockfile = "",
+  .default_cfg_handler = "",
+  .need_root = false,
+  .need_lock = false,
+};
+
+static const char *_dependencies[] = {
+  OONF_PACKET_SUBSYSTEM,
+  OONF_RFC5444_SUBSYSTEM,
+  OONF_TIMER_SUBSYSTEM,
+};
+
+static struct oonf_subsystem _test_subsystem = {
+  .name = "test_rfc5444_tx_class",
+  .dependencies = _dependencies,
+  .dependencies_count = ARRAYSIZE(_dependencies),
+  .init = _init,
+  .cleanup = _cleanup,
+};
+DECLARE_OONF_PLUGIN(_test_subsystem);
+
+static struct oonf_timer_class _test_timer_class = {
+  .name = "test tx class",
+  .callback = _cb_timer,
+};
+
+static struct oonf_timer_instance _congest_timer = {
+  .class = &_test_timer_class,
+};
+
+static struct oonf_timer_instance _check_timer = {
+  .class = &_test_timer_class,
+};
+
+static struct oonf_rfc5444_protocol *_protocol;
+static struct oonf_rfc5444_interface *_interface;
+static struct oonf_rfc5444_target *_target;
+
+/* simulated socket state */
+static bool _intercept;
+static unsigned _accept_count;
+
+/* type and id of the first message of every sent packet */
+static uint8_t _sent_type[MAX_SENT];
+static uint8_t _sent_id[MAX_SENT];
+static unsigned _sent_count;
+
+static bool _target_active, _checked;
+static unsigned _activation_wait;
+static uint32_t _hello_queue, _hello_dropped, _originated_queue;
+static uint32_t _queue_after_drain;
+static uint64_t _aggregation[OONF_RFC5444_TX_CLASS_COUNT];
+
+static bool
+_is_test_socket(int fd) {
+  return _intercept && _interface != NULL
+      && (fd == _interface->_socket.socket_v4.scheduler_entry.fd.fd
+          || fd == _interface->_socket.socket_v6.scheduler_entry.fd.fd);
+}
+
+static int
+_record_packet(const struct msghdr *msg) {
+  uint8_t buffer[256];
+  size_t length, offset;
+  size_t i;
+
+  length = 0;
+  for (i=0; i<msg->msg_iovlen; i++) {
+    if (length + msg->msg_iov[i].iov_len > sizeof(buffer)) {
+      return -1;
+    }
+    memcpy(&buffer[length], msg->msg_iov[i].iov_base, msg->msg_iov[i].iov_len);
+    length += msg->msg_iov[i].iov_len;
+  }
+
+  /* skip packet header and sequence number */
+  offset = (buffer[0] & RFC5444_PKT_FLAG_SEQNO) != 0 ? 3 : 1;
+  if (_sent_count < MAX_SENT && length >= offset + 10) {
+    /* message type and value of the single message TLV */
+    _sent_type[_sent_count] = buffer[offset];
+    _sent_id[_sent_count] = buffer[offset + 9];
+    _sent_count++;
+  }
+  return (int)length;
+}
+
+ssize_t
+sendmsg(int fd, const struct msghdr *msg, int flags) {
+  if (!_is_test_socket(fd)) {
+    return syscall(SYS_sendmsg, fd, msg, flags);
+  }
+  if (_accept_count == 0) {
+    errno = EAGAIN;
+    return -1;
+  }
+  _accept_count--;
+  return _record_packet(msg);
+}
+
+int
+sendmmsg(int fd, struct mmsghdr *msgvec, unsigned int vlen, int flags) {
+  unsigned int i;
+
+  if (!_is_test_socket(fd)) {
+    return syscall(SYS_sendmmsg, fd, msgvec, vlen, flags);
+  }
+
+  for (i=0; i<vlen && _accept_count > 0; i++) {
+    _accept_count--;
+    msgvec[i].msg_len = _record_packet(&msgvec[i].msg_hdr);
+  }
+  if (i == 0) {
+    errno = EAGAIN;
+    return -1;
+  }
+  return i;
+}
+
+static bool
+_cb_select_target(struct rfc5444_writer *writer __attribute__((unused)),
+    struct rfc5444_writer_target *target, void *ptr __attribute__((unused))) {
+  return target == &_target->rfc5444_target;
+}
+
+static void
+_send_message(uint8_t type, uint8_t id) {
+  /* message without address, one message TLV of type 1 with the id as value */
+  uint8_t msg[] = { type, 0x03, 0, 10, 0, 4, 1, RFC5444_TLV_FLAG_VALUE, 1, id };
+
+  oonf_rfc5444_send_all_binary(_protocol, msg, sizeof(msg), _cb_select_target);
+  oonf_rfc5444_flush_target(_target, false);
+}
+
+static int
+_init(void) {
+  struct netaddr dst;
+
+  _protocol = oonf_rfc5444_get_default_protocol();
+  _interface = oonf_rfc5444_add_interface(_protocol, NULL, TEST_INTERFACE);
+  if (_interface == NULL) {
+    return -1;
+  }
+
+  netaddr_from_binary(&dst, (uint8_t []){ 192, 0, 2, 1 }, 4, AF_INET);
+  _target = oonf_rfc5444_add_target(_interface, &dst);
+  if (_target == NULL) {
+    oonf_rfc5444_remove_interface(_interface, NULL);
+    return -1;
+  }
+
+  oonf_timer_add(&_test_timer_class);
+  oonf_timer_set(&_congest_timer, 100);
+  return 0;
+}
+
+static void
+_cleanup(void) {
+  _intercept = false;
+  oonf_timer_stop(&_congest_timer);
+  oonf_timer_stop(&_check_timer);
+  oonf_timer_remove(&_test_timer_class);
+  oonf_rfc5444_remove_target(_target);
+  oonf_rfc5444_remove_interface(_interface, NULL);
+}
+
+static void
+_cb_timer(struct oonf_timer_instance *ptr) {
+  if (ptr == &_congest_timer) {
+    _cb_congest(ptr);
+  }
+  else {
+    _cb_check(ptr);
+  }
+}
+
+static void
+_cb_congest(struct oonf_timer_instance *ptr __attribute__((unused))) {
+  int i;
+
+  /* the interface sockets are opened after the interface listener fired */
+  _target_active = oonf_rfc5444_is_target_active(_target);
+  if (!_target_active) {
+    if (++_activation_wait < ACTIVATION_WAIT) {
+      oonf_timer_set(&_congest_timer, 100);
+    }
+    else {
+      oonf_cfg_exit();
+    }
+    return;
+  }
+
+  for (i=0; i<OONF_RFC5444_TX_CLASS_COUNT; i++) {
+    _aggregation[i] = _interface->tx_class[i].aggregation_interval;
+  }
+
+  /* congested socket, the first packet goes into the socket queue */
+  _intercept = true;
+  _accept_count = 0;
+
+  _send_message(MSGTYPE_TC, 1);
+  _send_message(MSGTYPE_TC, 2);
+  _send_message(MSGTYPE_TC, 3);
+  for (i=0; i<HELLOS; i++) {
+    _send_message(RFC6130_MSGTYPE_HELLO, 10 + i);
+  }
+
+  _hello_queue = _interface->tx_class[OONF_RFC5444_TX_HELLO]._queue_count;
+  _hello_dropped = _interface->tx_class[OONF_RFC5444_TX_HELLO].stats.dropped;
+  _originated_queue = _interface->tx_class[OONF_RFC5444_TX_ORIGINATED]._queue_count;
+
+  /* socket accepts three packets, then it is congested again */
+  _accept_count = 3;
+  oonf_timer_set(&_check_timer, 100);
+}
+
+static void
+_cb_check(struct oonf_timer_instance *ptr __attribute__((unused))) {
+  if (!_checked) {
+    /* the drain stopped at the congested socket, accept everything now */
+    _queue_after_drain = _interface->tx_class[OONF_RFC5444_TX_HELLO]._queue_count
+        + _interface->tx_class[OONF_RFC5444_TX_ORIGINATED]._queue_count;
+    _checked = true;
+    _accept_count = MAX_SENT;
+    oonf_timer_set(&_check_timer, 100);
+    return;
+  }
+
+  _intercept = false;
+  oonf_cfg_exit();
+}
+
+static void
+test_aggregation_default(void) {
+  START_TEST();
+
+  /* the interface section does not set the aggregation intervals */
+  CHECK_TRUE(_aggregation[OONF_RFC5444_TX_HELLO] == 50,
+      "HELLO aggregation is %"PRIu64" ms", _aggregation[OONF_RFC5444_TX_HELLO]);
+  CHECK_TRUE(_aggregation[OONF_RFC5444_TX_ORIGINATED] == AGGREGATION,
+      "originated aggregation is %"PRIu64" ms", _aggregation[OONF_RFC5444_TX_ORIGINATED]);
+  CHECK_TRUE(_aggregation[OONF_RFC5444_TX_FORWARDED] == AGGREGATION,
+      "forwarded aggregation is %"PRIu64" ms", _aggregation[OONF_RFC5444_TX_FORWARDED]);
+
+  END_TEST();
+}
+
+static void
+test_priority_drain(void) {
+  /* TC 1 was in the socket queue, the two oldest HELLOs have been dropped */
+  static const uint8_t types[] = {
+      MSGTYPE_TC, RFC6130_MSGTYPE_HELLO, RFC6130_MSGTYPE_HELLO,
+      RFC6130_MSGTYPE_HELLO, RFC6130_MSGTYPE_HELLO, MSGTYPE_TC, MSGTYPE_TC };
+  static const uint8_t ids[] = { 1, 12, 13, 14, 15, 2, 3 };
+  unsigned i, count;
+
+  START_TEST();
+
+  CHECK_TRUE(_target_active, "target on interface "TEST_INTERFACE" is not active");
+  CHECK_TRUE(_hello_queue == 4, "%u HELLO packets queued instead of 4", _hello_queue);
+  CHECK_TRUE(_hello_dropped == 2, "%u HELLO packets dropped instead of 2", _hello_dropped);
+  CHECK_TRUE(_originated_queue == 2,
+      "%u originated packets queued instead of 2", _originated_queue);
+  /* TC 1 and two HELLOs were sent, the third HELLO waits in the socket queue */
+  CHECK_TRUE(_queue_after_drain == 3,
+      "%u packets left in class queues after congestion instead of 3", _queue_after_drain);
+
+  count = _sent_count;
+  CHECK_TRUE(count == ARRAYSIZE(types),
+      "%u packets sent instead of %u", count, (unsigned)ARRAYSIZE(types));
+  if (count > ARRAYSIZE(types)) {
+    count = ARRAYSIZE(types);
+  }
+  for (i=0; i<count; i++) {
+    CHECK_TRUE(_sent_type[i] == types[i] && _sent_id[i] == ids[i],
+        "packet %u is message %u/%u instead of %u/%u",
+        i, _sent_type[i], _sent_id[i], types[i], ids[i]);
+  }
+
+  END_TEST();
+}
+
+int
+main(int argc __attribute__((unused)), char **argv) {
+  char set_arg[] = "--set";
+  char port_arg[] = "mesh.port=32269";
+  char aggregation_arg[] = "mesh.agregation_interval=0.300";
+  char if_arg[] = "interface[" TEST_INTERFACE "].bindto=" ACL_DEFAULT_ACCEPT;
+  char *args[] = { argv[0], set_arg, port_arg, set_arg, aggregation_arg,
+      set_arg, if_arg, NULL };
+
+  BEGIN_TESTING(NULL);
+
+  if (oonf_main(ARRAYSIZE(args) - 1, args, &_appdata)) {
+    return 1;
+  }
+
+  test_aggregation_default();
+  test_priority_drain();
+  return FINISH_TESTING();
+}
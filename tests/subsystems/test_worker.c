@@ -0,0 +1,489 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+
+#include "common/common_types.h"
+#include "common/container_of.h"
+#include "config/cfg_db.h"
+#include "core/oonf_appdata.h"
+#include "core/oonf_cfg.h"
+#include "core/oonf_main.h"
+#include "core/oonf_subsystem.h"
+#include "subsystems/oonf_timer.h"
+#include "subsystems/oonf_worker.h"
+
+#include "../cunit/cunit.h"
+
+/*
+ * Functional test of the worker subsystem. A periodic timer walks
+ * through the steps of the test, each step waits until the finished
+ * callbacks of the last one have been delivered by the main loop.
+ */
+
+#define JOBS             3
+#define DEFAULT_THREADS  2
+#define SLOW_JOB_MS    100
+#define MAX_TICKS     5000
+
+enum _step {
+  STEP_SUBMIT,
+  STEP_COMPLETION,
+  STEP_CANCEL,
+  STEP_CANCEL_CHECK,
+  STEP_RECONFIGURE,
+  STEP_RECONFIGURE_CHECK,
+  STEP_INLINE,
+  STEP_INLINE_CHECK,
+  STEP_SHUTDOWN,
+  STEP_END,
+};
+
+/* worker job with the results of its callbacks */
+struct test_job {
+  struct oonf_worker_job job;
+
+  /* time the process callback sleeps */
+  uint32_t sleep_ms;
+
+  /* set by the process callback when it starts and when it ends */
+  volatile bool started, processed;
+
+  /* thread of the process callback */
+  pthread_t thread;
+
+  /* number of finished callbacks and thread of the last one */
+  unsigned finished;
+  pthread_t finished_thread;
+};
+
+static int _init(void);
+static void _cleanup(void);
+static void _cb_step(struct oonf_timer_instance *);
+static void _cb_process(struct oonf_worker_job *);
+static void _cb_finished(struct oonf_worker_job *);
+
+static struct oonf_appdata _appdata = {
+  .app_name = "test_worker",
+  .versionstring_trailer = "",
+  .help_prefix = "",
+  .help_suffix = "",
+  .default_lockfile = "",
+  .default_cfg_handler = "",
+  .need_root = false,
+  .need_lock = false,
+};
+
+static const char *_dependencies[] = {
+  OONF_TIMER_SUBSYSTEM,
+  OONF_WORKER_SUBSYSTEM,
+};
+
+static struct oonf_subsystem _test_subsystem = {
+  .name = "test_worker",
+  .dependencies = _dependencies,
+  .dependencies_count = ARRAYSIZE(_dependencies),
+  .init = _init,
+  .cleanup = _cleanup,
+};
+DECLARE_OONF_PLUGIN(_test_subsystem);
+
+static struct oonf_timer_class _step_timer_class = {
+  .name = "test worker",
+  .callback = _cb_step,
+  .periodic = true,
+};
+
+static struct oonf_timer_instance _step_timer = {
+  .class = &_step_timer_class,
+};
+
+static struct test_job _jobs[JOBS] = {
+  { .job = { .name = "test job 1", .process = _cb_process, .finished = _cb_finished } },
+  { .job = { .name = "test job 2", .process = _cb_process, .finished = _cb_finished } },
+  { .job = { .name = "test job 3", .process = _cb_process, .finished = _cb_finished } },
+};
+
+static pthread_t _main_thread;
+static enum _step _step;
+static unsigned _ticks;
+
+/* keeps the process callbacks running until the cleanup of the test */
+static volatile bool _hold_jobs;
+
+static int
+_init(void) {
+  _main_thread = pthread_self();
+
+  oonf_timer_add(&_step_timer_class);
+  oonf_timer_set(&_step_timer, 1);
+  return 0;
+}
+
+static void
+_cleanup(void) {
+  /* the worker subsystem is cleaned up after this, while the job runs */
+  _hold_jobs = false;
+
+  oonf_timer_stop(&_step_timer);
+  oonf_timer_remove(&_step_timer_class);
+}
+
+static void
+_sleep_ms(uint32_t ms) {
+  struct timespec delay = { ms / 1000, (ms % 1000) * 1000000l };
+
+  nanosleep(&delay, NULL);
+}
+
+static void
+_cb_process(struct oonf_worker_job *ptr) {
+  struct test_job *tjob = container_of(ptr, struct test_job, job);
+
+  tjob->thread = pthread_self();
+  tjob->started = true;
+  while (_hold_jobs) {
+    _sleep_ms(1);
+  }
+  _sleep_ms(tjob->sleep_ms);
+  tjob->processed = true;
+}
+
+static void
+_cb_finished(struct oonf_worker_job *ptr) {
+  struct test_job *tjob = container_of(ptr, struct test_job, job);
+
+  tjob->finished++;
+  tjob->finished_thread = pthread_self();
+}
+
+static int
+_submit(struct test_job *tjob, uint32_t sleep_ms) {
+  tjob->sleep_ms = sleep_ms;
+  tjob->started = false;
+  tjob->processed = false;
+  tjob->finished = 0;
+  return oonf_worker_submit(&tjob->job);
+}
+
+static bool
+_wait_started(struct test_job *tjob) {
+  int i;
+
+  for (i=0; i<1000 && !tjob->started; i++) {
+    _sleep_ms(1);
+  }
+  return tjob->started;
+}
+
+static void
+_set_threads(const char *threads) {
+  cfg_db_overwrite_entry(oonf_cfg_get_rawdb(),
+      OONF_WORKER_SUBSYSTEM, NULL, "threads", threads);
+  oonf_cfg_trigger_commit();
+}
+
+static void
+test_submit(void) {
+  struct oonf_worker_statistics stats;
+
+  START_TEST();
+
+  oonf_worker_clear_statistics();
+  CHECK_TRUE(oonf_worker_get_thread_count() == DEFAULT_THREADS,
+      "%d worker threads running", oonf_worker_get_thread_count());
+
+  CHECK_TRUE(_submit(&_jobs[0], 0) == 0, "submit failed");
+  CHECK_TRUE(oonf_worker_is_busy(&_jobs[0].job), "submitted job is not busy");
+  CHECK_TRUE(_jobs[0].finished == 0, "finished callback called during submit");
+
+  /* a busy job cannot be submitted again */
+  CHECK_TRUE(oonf_worker_submit(&_jobs[0].job) == -1, "busy job submitted twice");
+
+  oonf_worker_get_statistics(&stats);
+  CHECK_TRUE(stats.submitted == 1, "%u jobs submitted", stats.submitted);
+
+  END_TEST();
+}
+
+static void
+test_completion(void) {
+  struct oonf_worker_statistics stats;
+
+  START_TEST();
+
+  CHECK_TRUE(_jobs[0].processed, "job was not processed");
+  CHECK_TRUE(!pthread_equal(_jobs[0].thread, _main_thread),
+      "job was processed in the main thread");
+  CHECK_TRUE(_jobs[0].finished == 1, "%u finished callbacks", _jobs[0].finished);
+  CHECK_TRUE(pthread_equal(_jobs[0].finished_thread, _main_thread),
+      "finished callback not called from the main loop");
+  CHECK_TRUE(!oonf_worker_is_busy(&_jobs[0].job), "finished job is still busy");
+
+  oonf_worker_get_statistics(&stats);
+  CHECK_TRUE(stats.completed == 1, "%u jobs completed", stats.completed);
+  CHECK_TRUE(stats.run_time.count == 1, "%u run times recorded",
+      (unsigned)stats.run_time.count);
+
+  END_TEST();
+}
+
+static void
+test_cancel_running(void) {
+  struct oonf_worker_statistics stats;
+
+  START_TEST();
+
+  CHECK_TRUE(_submit(&_jobs[0], SLOW_JOB_MS) == 0, "submit failed");
+  CHECK_TRUE(_wait_started(&_jobs[0]), "job was not started");
+
+  /* cancel waits for the end of the process callback */
+  oonf_worker_cancel(&_jobs[0].job);
+  CHECK_TRUE(_jobs[0].processed, "cancel returned during processing");
+  CHECK_TRUE(!oonf_worker_is_busy(&_jobs[0].job), "cancelled job is still busy");
+
+  oonf_worker_get_statistics(&stats);
+  CHECK_TRUE(stats.cancelled == 1, "%u jobs cancelled", stats.cancelled);
+
+  /* a cancelled job can be submitted again */
+  CHECK_TRUE(_submit(&_jobs[1], 0) == 0, "submit after cancel failed");
+
+  END_TEST();
+}
+
+static void
+test_cancel_no_completion(void) {
+  struct oonf_worker_statistics stats;
+
+  START_TEST();
+
+  CHECK_TRUE(_jobs[0].finished == 0, "cancelled job got %u finished callbacks",
+      _jobs[0].finished);
+  CHECK_TRUE(_jobs[1].finished == 1, "%u finished callbacks", _jobs[1].finished);
+
+  oonf_worker_get_statistics(&stats);
+  CHECK_TRUE(stats.completed == 2, "%u jobs completed", stats.completed);
+
+  END_TEST();
+}
+
+static void
+test_reconfigure_start(void) {
+  int i;
+
+  START_TEST();
+
+  /* two jobs keep the threads busy, the third one waits in the queue */
+  for (i=0; i<JOBS; i++) {
+    CHECK_TRUE(_submit(&_jobs[i], SLOW_JOB_MS) == 0, "submit of job %d failed", i);
+  }
+  CHECK_TRUE(_wait_started(&_jobs[0]), "job 1 was not started");
+  CHECK_TRUE(_wait_started(&_jobs[1]), "job 2 was not started");
+
+  /* applied by the main loop after this iteration */
+  _set_threads("0");
+
+  END_TEST();
+}
+
+static void
+test_reconfigure(void) {
+  int i;
+
+  START_TEST();
+
+  CHECK_TRUE(oonf_worker_get_thread_count() == 0,
+      "%d worker threads running", oonf_worker_get_thread_count());
+
+  for (i=0; i<JOBS; i++) {
+    CHECK_TRUE(_jobs[i].processed, "job %d was not processed", i);
+    CHECK_TRUE(_jobs[i].finished == 1, "job %d got %u finished callbacks",
+        i, _jobs[i].finished);
+  }
+
+  CHECK_TRUE(!pthread_equal(_jobs[0].thread, _main_thread)
+      && !pthread_equal(_jobs[1].thread, _main_thread),
+      "running jobs were not finished by their worker threads");
+  CHECK_TRUE(pthread_equal(_jobs[2].thread, _main_thread),
+      "waiting job was not processed in the main loop");
+
+  END_TEST();
+}
+
+static void
+test_inline(void) {
+  START_TEST();
+
+  CHECK_TRUE(_submit(&_jobs[0], 0) == 0, "submit failed");
+  CHECK_TRUE(_jobs[0].processed, "job was not processed during submit");
+  CHECK_TRUE(pthread_equal(_jobs[0].thread, _main_thread),
+      "job was not processed in the main thread");
+
+  /* the finished callback is still called from the main loop */
+  CHECK_TRUE(_jobs[0].finished == 0, "finished callback called during submit");
+  CHECK_TRUE(oonf_worker_is_busy(&_jobs[0].job), "processed job is not busy");
+
+  END_TEST();
+}
+
+static void
+test_inline_completion(void) {
+  START_TEST();
+
+  CHECK_TRUE(_jobs[0].finished == 1, "%u finished callbacks", _jobs[0].finished);
+  CHECK_TRUE(!oonf_worker_is_busy(&_jobs[0].job), "finished job is still busy");
+
+  END_TEST();
+}
+
+static void
+test_shutdown_start(void) {
+  START_TEST();
+
+  CHECK_TRUE(oonf_worker_get_thread_count() == DEFAULT_THREADS,
+      "%d worker threads running", oonf_worker_get_thread_count());
+
+  /* job runs until the test subsystem is cleaned up */
+  _hold_jobs = true;
+  CHECK_TRUE(_submit(&_jobs[0], SLOW_JOB_MS) == 0, "submit failed");
+  CHECK_TRUE(_wait_started(&_jobs[0]), "job was not started");
+
+  END_TEST();
+}
+
+static void
+test_shutdown(void) {
+  START_TEST();
+
+  /* the cleanup of the worker subsystem joins the running job */
+  CHECK_TRUE(_jobs[0].processed, "running job was not finished on shutdown");
+  CHECK_TRUE(_jobs[0].finished == 0, "finished callback called on shutdown");
+  CHECK_TRUE(!oonf_worker_is_busy(&_jobs[0].job), "job is still busy after shutdown");
+  CHECK_TRUE(oonf_worker_get_thread_count() == 0,
+      "%d worker threads after shutdown", oonf_worker_get_thread_count());
+
+  END_TEST();
+}
+
+static bool
+_all_finished(void) {
+  int i;
+
+  for (i=0; i<JOBS; i++) {
+    if (oonf_worker_is_busy(&_jobs[i].job)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void
+_cb_step(struct oonf_timer_instance *ptr __attribute__((unused))) {
+  if (++_ticks > MAX_TICKS) {
+    CHECK_TRUE(false, "test step %d timed out", _step);
+    oonf_cfg_exit();
+    return;
+  }
+
+  if (_step == STEP_END) {
+    /* wait for the end of the scheduler */
+    return;
+  }
+  if (!_all_finished()) {
+    /* wait for the finished callbacks */
+    return;
+  }
+
+  switch (_step) {
+    case STEP_SUBMIT:
+      test_submit();
+      break;
+    case STEP_COMPLETION:
+      test_completion();
+      break;
+    case STEP_CANCEL:
+      test_cancel_running();
+      break;
+    case STEP_CANCEL_CHECK:
+      test_cancel_no_completion();
+      break;
+    case STEP_RECONFIGURE:
+      test_reconfigure_start();
+      break;
+    case STEP_RECONFIGURE_CHECK:
+      test_reconfigure();
+      break;
+    case STEP_INLINE:
+      test_inline();
+      break;
+    case STEP_INLINE_CHECK:
+      test_inline_completion();
+      _set_threads("2");
+      break;
+    case STEP_SHUTDOWN:
+    default:
+      test_shutdown_start();
+      oonf_cfg_exit();
+      break;
+  }
+  _step++;
+}
+
+int
+main(int argc __attribute__((unused)), char **argv) {
+  char *args[] = { argv[0], NULL };
+
+  BEGIN_TESTING(NULL);
+
+  if (oonf_main(ARRAYSIZE(args) - 1, args, &_appdata)) {
+    return 1;
+  }
+
+  test_shutdown();
+
+  return FINISH_TESTING();
+}